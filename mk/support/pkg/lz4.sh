@@ -0,0 +1,16 @@
+
+version=r131
+
+src_url=https://github.com/Cyan4973/lz4/archive/$version.tar.gz
+
+pkg_install-include () {
+    mkdir -p "$install_dir/include"
+    cp "$src_dir/lib/lz4.h" "$install_dir/include"
+}
+
+pkg_install () {
+    pkg_copy_src_to_build
+    mkdir -p "$install_dir/lib"
+    in_dir "$build_dir/lib" ${CC:-cc} ${CFLAGS:-} -O3 -c lz4.c -o lz4.o
+    in_dir "$build_dir/lib" ${AR:-ar} rcs "$install_dir/lib/liblz4.a" lz4.o
+}
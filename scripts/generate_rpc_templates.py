@@ -76,8 +76,10 @@ def generate_async_message_template(nargs):
     print "    typedef mailbox_addr_t< void(%s) > address_t;" % csep("arg#_t")
     print
     print "    mailbox_t(mailbox_manager_t *manager,"
-    print "              const std::function< void(signal_t *%s)> &f) :" % cpre("arg#_t")
-    print "        reader(this), fun(f), mailbox(manager, &reader)"
+    print "              const std::function< void(signal_t *%s)> &f," % cpre("arg#_t")
+    print "              cluster_traffic_class_t traffic_class ="
+    print "                  cluster_traffic_class_t::replication) :"
+    print "        reader(this), fun(f), mailbox(manager, &reader, traffic_class)"
     print "        { }"
     print
     print "    void begin_shutdown() {"
@@ -3,6 +3,7 @@
 
 #include <string.h>
 
+#include "arch/runtime/thread_pool.hpp"
 #include "config/args.hpp"
 #include "utils.hpp"
 
@@ -98,6 +99,21 @@ blocker_pool_t::blocker_pool_t(int nthreads, linux_event_queue_t *_queue)
         // fails.
         UNUSED int ignored_res = pthread_attr_setstacksize(&attr, COROUTINE_STACK_SIZE);
 
+#ifdef _GNU_SOURCE
+        // Threads inherit the affinity of the thread that starts them, which for a
+        // pinned event loop thread would put all of our threads on a single CPU.
+        // Give them the whole NUMA node of that thread instead, so that they stay
+        // close to the event queue that they deliver their completions to.
+        linux_thread_pool_t *thread_pool = linux_thread_pool_t::get_thread_pool();
+        int thread_id = linux_thread_pool_t::get_thread_id();
+        if (thread_pool != NULL && thread_id >= 0
+            && thread_pool->thread_numa_nodes[thread_id] != -1) {
+            res = pthread_attr_setaffinity_np(&attr, sizeof(cpu_set_t),
+                                              &thread_pool->thread_node_cpus[thread_id]);
+            guarantee_xerr(res == 0, res, "Could not set blocker-pool thread affinity.");
+        }
+#endif
+
         res = pthread_create(&threads[i], &attr,
             &blocker_pool_t::event_loop, reinterpret_cast<void*>(this));
         guarantee_xerr(res == 0, res, "Could not create blocker-pool thread.");
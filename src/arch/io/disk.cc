@@ -17,6 +17,7 @@
 #include "arch/runtime/thread_pool.hpp"
 #include "arch/runtime/runtime.hpp"
 #include "arch/io/disk/filestat.hpp"
+#include "arch/io/disk/io_uring.hpp"
 #include "arch/io/disk/pool.hpp"
 #include "arch/io/disk/conflict_resolving.hpp"
 #include "arch/io/disk/stats.hpp"
@@ -46,12 +47,12 @@ public:
     linux_disk_manager_t(linux_event_queue_t *queue,
                          int batch_factor,
                          int max_concurrent_io_requests,
+                         file_io_backend_t io_backend,
                          perfmon_collection_t *stats) :
         stack_stats(stats, "stack"),
         conflict_resolver(stats),
         accounter(batch_factor),
         backend_stats(stats, "backend", accounter.producer),
-        backend(queue, backend_stats.producer, max_concurrent_io_requests),
         outstanding_txn(0)
     {
         /* Hook up the `submit_fun`s of the parts of the IO stack that are above the
@@ -62,8 +63,31 @@ public:
         conflict_resolver.submit_fun = std::bind(&accounting_diskmgr_t::submit,
                                                  &accounter, ph::_1);
 
+        /* Pick the backend that pops operations off the queue. */
+        if (io_backend == file_io_backend_t::io_uring
+            && !io_uring_diskmgr_t::is_supported()) {
+            logWRN("io_uring is not available on this system. Falling back to "
+                   "the blocker pool for disk I/O.");
+            io_backend = file_io_backend_t::blocker_pool;
+        }
+
         /* Hook up everything's `done_fun`. */
-        backend.done_fun = std::bind(&stats_diskmgr_2_t::done, &backend_stats, ph::_1);
+        switch (io_backend) {
+        case file_io_backend_t::blocker_pool:
+            pool_backend.init(new pool_diskmgr_t(queue, backend_stats.producer,
+                                                 max_concurrent_io_requests));
+            pool_backend->done_fun = std::bind(&stats_diskmgr_2_t::done,
+                                               &backend_stats, ph::_1);
+            break;
+        case file_io_backend_t::io_uring:
+            io_uring_backend.init(new io_uring_diskmgr_t(queue, backend_stats.producer,
+                                                         max_concurrent_io_requests));
+            io_uring_backend->done_fun = std::bind(&stats_diskmgr_2_t::done,
+                                                   &backend_stats, ph::_1);
+            break;
+        default:
+            unreachable();
+        }
         backend_stats.done_fun = std::bind(&accounting_diskmgr_t::done, &accounter, ph::_1);
         accounter.done_fun = std::bind(&conflict_resolving_diskmgr_t::done,
                                        &conflict_resolver, ph::_1);
@@ -188,13 +212,17 @@ private:
     will tell you how many IO operations are queued. The "backend stats" will tell you
     how long the OS takes to perform the operations. Note that it's not perfect, because
     it counts operations that have been queued by the backend but not sent to the OS yet
-    as having been sent to the OS. */
+    as having been sent to the OS.
+
+    Exactly one of `pool_backend` and `io_uring_backend` is initialized, depending on
+    the `file_io_backend_t` the disk manager was constructed with. */
 
     stats_diskmgr_t stack_stats;
     conflict_resolving_diskmgr_t conflict_resolver;
     accounting_diskmgr_t accounter;
     stats_diskmgr_2_t backend_stats;
-    pool_diskmgr_t backend;
+    scoped_ptr_t<pool_diskmgr_t> pool_backend;
+    scoped_ptr_t<io_uring_diskmgr_t> io_uring_backend;
 
 
     intptr_t outstanding_txn;
@@ -203,11 +231,14 @@ private:
 };
 
 io_backender_t::io_backender_t(file_direct_io_mode_t _direct_io_mode,
-                               int max_concurrent_io_requests)
+                               int max_concurrent_io_requests,
+                               file_io_backend_t io_backend)
     : direct_io_mode(_direct_io_mode),
+      stats_membership(&get_global_perfmon_collection(), &stats, "io"),
       diskmgr(new linux_disk_manager_t(&linux_thread_pool_t::get_thread()->queue,
                                        DEFAULT_IO_BATCH_FACTOR,
                                        max_concurrent_io_requests,
+                                       io_backend,
                                        &stats)) { }
 
 io_backender_t::~io_backender_t() { }
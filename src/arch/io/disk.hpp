@@ -29,7 +29,8 @@ public:
     // stops us from specifying this on a file-by-file basis, but right now there's no desire for
     // that.  See https://github.com/rethinkdb/rethinkdb/issues/97#issuecomment-19778177 .
     io_backender_t(file_direct_io_mode_t direct_io_mode,
-                   int max_concurrent_io_requests = DEFAULT_MAX_CONCURRENT_IO_REQUESTS);
+                   int max_concurrent_io_requests = DEFAULT_MAX_CONCURRENT_IO_REQUESTS,
+                   file_io_backend_t io_backend = file_io_backend_t::blocker_pool);
     ~io_backender_t();
     linux_disk_manager_t *get_diskmgr_ptr() { return diskmgr.get(); }
     file_direct_io_mode_t get_direct_io_mode() const;
@@ -37,6 +38,7 @@ public:
 protected:
     const file_direct_io_mode_t direct_io_mode;
     perfmon_collection_t stats;
+    perfmon_membership_t stats_membership;
     scoped_ptr_t<linux_disk_manager_t> diskmgr;
 
 private:
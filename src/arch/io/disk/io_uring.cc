@@ -0,0 +1,275 @@
+// Copyright 2010-2015 RethinkDB, all rights reserved.
+#include "arch/io/disk/io_uring.hpp"
+
+#include <limits.h>
+#include <signal.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#if USE_IO_URING
+#include <linux/io_uring.h>
+#endif
+
+#include <utility>
+#include <vector>
+
+#include "config/args.hpp"
+#include "utils.hpp"
+
+#if USE_IO_URING
+
+namespace {
+
+int sys_io_uring_setup(unsigned int entries, io_uring_params *params) {
+    return syscall(__NR_io_uring_setup, entries, params);
+}
+
+int sys_io_uring_enter(int fd, unsigned int to_submit, unsigned int min_complete,
+                       unsigned int flags) {
+    return syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags,
+                   NULL, _NSIG / 8);
+}
+
+int sys_io_uring_register(int fd, unsigned int opcode, const void *arg,
+                          unsigned int nr_args) {
+    return syscall(__NR_io_uring_register, fd, opcode, arg, nr_args);
+}
+
+void *map_ring(int fd, size_t size, int64_t offset) {
+    void *res = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                     fd, offset);
+    guarantee_err(res != MAP_FAILED, "Could not map io_uring ring");
+    return res;
+}
+
+template <class T>
+T *ring_field(void *ring, uint32_t offset) {
+    return reinterpret_cast<T *>(static_cast<char *>(ring) + offset);
+}
+
+unsigned int ring_entries_for(int max_concurrent_io_requests) {
+    // io_uring rounds the number of entries up to a power of two anyway; we do it
+    // ourselves so that `queue_depth` matches the size of the submission queue.
+    unsigned int entries = 1;
+    while (entries < static_cast<unsigned int>(max_concurrent_io_requests)) {
+        entries *= 2;
+    }
+    return std::min<unsigned int>(entries, 4096);
+}
+
+}  // namespace
+
+bool io_uring_diskmgr_t::is_supported() {
+    io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    int res = sys_io_uring_setup(1, &params);
+    if (res == -1) {
+        return false;
+    }
+    scoped_fd_t fd(res);
+    return true;
+}
+
+io_uring_diskmgr_t::io_uring_diskmgr_t(linux_event_queue_t *_queue,
+                                       passive_producer_t<action_t *> *_source,
+                                       int max_concurrent_io_requests)
+    : queue(_queue),
+      source(_source),
+      n_pending(0),
+      fallback(_queue, &fallback_queue, IO_URING_FALLBACK_THREADS) {
+    guarantee(max_concurrent_io_requests > 0);
+
+    io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    int res = sys_io_uring_setup(ring_entries_for(max_concurrent_io_requests),
+                                 &params);
+    guarantee_err(res != -1, "Could not set up io_uring");
+    ring_fd.reset(res);
+    queue_depth = params.sq_entries;
+
+    sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+    sq_ring = map_ring(ring_fd.get(), sq_ring_size, IORING_OFF_SQ_RING);
+    cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    cq_ring = map_ring(ring_fd.get(), cq_ring_size, IORING_OFF_CQ_RING);
+    sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+    sqes = static_cast<io_uring_sqe *>(
+        map_ring(ring_fd.get(), sqes_size, IORING_OFF_SQES));
+
+    sq_tail = ring_field<unsigned int>(sq_ring, params.sq_off.tail);
+    sq_ring_mask = ring_field<unsigned int>(sq_ring, params.sq_off.ring_mask);
+    sq_array = ring_field<unsigned int>(sq_ring, params.sq_off.array);
+    cq_head = ring_field<unsigned int>(cq_ring, params.cq_off.head);
+    cq_tail = ring_field<unsigned int>(cq_ring, params.cq_off.tail);
+    cq_ring_mask = ring_field<unsigned int>(cq_ring, params.cq_off.ring_mask);
+    cqes = ring_field<io_uring_cqe>(cq_ring, params.cq_off.cqes);
+
+    // The kernel signals the eventfd whenever it posts a completion.
+    const int efd = completion_event.get_notify_fd();
+    res = sys_io_uring_register(ring_fd.get(), IORING_REGISTER_EVENTFD, &efd, 1);
+    guarantee_err(res == 0, "Could not register eventfd with io_uring");
+    queue->watch_resource(completion_event.get_notify_fd(), poll_event_in, this);
+
+    fallback.done_fun = std::bind(&io_uring_diskmgr_t::fallback_done, this, ph::_1);
+
+    if (source->available->get()) { pump(); }
+    source->available->set_callback(this);
+}
+
+io_uring_diskmgr_t::~io_uring_diskmgr_t() {
+    assert_thread();
+    rassert(n_pending == 0);
+    source->available->unset_callback();
+    queue->forget_resource(completion_event.get_notify_fd(), this);
+
+    munmap(sqes, sqes_size);
+    munmap(cq_ring, cq_ring_size);
+    munmap(sq_ring, sq_ring_size);
+    // `ring_fd`'s destructor closes the ring.
+}
+
+void io_uring_diskmgr_t::on_source_availability_changed() {
+    assert_thread();
+    if (source->available->get()) pump();
+}
+
+void io_uring_diskmgr_t::fill_sqe(io_uring_sqe *sqe, action_t *a) {
+    iovec *vecs;
+    size_t vecs_len;
+    a->get_bufs(&vecs, &vecs_len);
+
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = a->get_is_read() ? IORING_OP_READV : IORING_OP_WRITEV;
+    sqe->fd = a->get_fd();
+    sqe->off = a->get_offset();
+    sqe->addr = reinterpret_cast<uintptr_t>(vecs);
+    sqe->len = vecs_len;
+    sqe->user_data = reinterpret_cast<uintptr_t>(a);
+}
+
+void io_uring_diskmgr_t::pump() {
+    assert_thread();
+    unsigned int to_submit = 0;
+    while (source->available->get() && n_pending < queue_depth) {
+        action_t *a = source->pop();
+
+        iovec *vecs;
+        size_t vecs_len;
+        a->get_bufs(&vecs, &vecs_len);
+        if (a->get_is_resize() || a->wrap_in_datasyncs || vecs_len > IOV_MAX) {
+            run_in_fallback(a);
+            continue;
+        }
+
+        // We are the only producer, so the tail doesn't need an atomic load.
+        const unsigned int tail = *sq_tail;
+        const unsigned int index = tail & *sq_ring_mask;
+        fill_sqe(&sqes[index], a);
+        sq_array[index] = index;
+        __atomic_store_n(sq_tail, tail + 1, __ATOMIC_RELEASE);
+
+        ++n_pending;
+        ++to_submit;
+    }
+
+    if (to_submit > 0) {
+        submit_pending(to_submit);
+    }
+}
+
+void io_uring_diskmgr_t::submit_pending(unsigned int to_submit) {
+    while (to_submit > 0) {
+        int res = sys_io_uring_enter(ring_fd.get(), to_submit, 0, 0);
+        if (res == -1) {
+            if (get_errno() == EINTR) {
+                continue;
+            }
+            guarantee_err(get_errno() == EAGAIN || get_errno() == EBUSY,
+                          "io_uring_enter failed");
+            // The kernel is short on resources; wait for something to complete
+            // before trying again. Completions are still reaped through the
+            // eventfd.
+            res = sys_io_uring_enter(ring_fd.get(), 0, 1, IORING_ENTER_GETEVENTS);
+            guarantee_err(res != -1 || get_errno() == EINTR, "io_uring_enter failed");
+            continue;
+        }
+        rassert(static_cast<unsigned int>(res) <= to_submit);
+        to_submit -= res;
+    }
+}
+
+void io_uring_diskmgr_t::on_event(DEBUG_VAR int events) {
+    assert_thread();
+    rassert(events == poll_event_in);
+    completion_event.consume_wakey_wakeys();
+    reap_completions();
+}
+
+void io_uring_diskmgr_t::reap_completions() {
+    std::vector<std::pair<action_t *, int32_t> > completed;
+
+    // We are the only consumer, so the head doesn't need an atomic load.
+    unsigned int head = *cq_head;
+    const unsigned int tail = __atomic_load_n(cq_tail, __ATOMIC_ACQUIRE);
+    completed.reserve(tail - head);
+    for (; head != tail; ++head) {
+        const io_uring_cqe *cqe = &cqes[head & *cq_ring_mask];
+        completed.push_back(std::make_pair(
+            reinterpret_cast<action_t *>(static_cast<uintptr_t>(cqe->user_data)),
+            cqe->res));
+    }
+    // Hand the slots back to the kernel before running any callbacks, which might
+    // submit more operations.
+    __atomic_store_n(cq_head, head, __ATOMIC_RELEASE);
+
+    rassert(n_pending >= completed.size());
+    n_pending -= completed.size();
+    pump();
+
+    for (auto it = completed.begin(); it != completed.end(); ++it) {
+        action_t *a = it->first;
+        const int32_t res = it->second;
+        if (res == -EINTR || res == -EAGAIN
+            || (res >= 0 && static_cast<size_t>(res) < a->get_count())) {
+            // A short transfer or a transient error.  Reads and writes of the
+            // same buffers at the same offset are idempotent, so we let the
+            // fallback pool redo the whole operation, which already knows how to
+            // retry and how to report a full disk.
+            run_in_fallback(a);
+        } else {
+            a->io_result = res;
+            done_fun(a);
+        }
+    }
+}
+
+void io_uring_diskmgr_t::run_in_fallback(action_t *a) {
+    fallback_queue.push(a);
+}
+
+void io_uring_diskmgr_t::fallback_done(action_t *a) {
+    done_fun(a);
+}
+
+#else  // USE_IO_URING
+
+bool io_uring_diskmgr_t::is_supported() {
+    return false;
+}
+
+io_uring_diskmgr_t::io_uring_diskmgr_t(linux_event_queue_t *_queue,
+                                       passive_producer_t<action_t *> *_source,
+                                       int)
+    : queue(_queue),
+      source(_source),
+      fallback(_queue, &fallback_queue, IO_URING_FALLBACK_THREADS) {
+    crash("io_uring is not supported on this platform.");
+}
+
+io_uring_diskmgr_t::~io_uring_diskmgr_t() { }
+
+void io_uring_diskmgr_t::on_source_availability_changed() { unreachable(); }
+void io_uring_diskmgr_t::on_event(int) { unreachable(); }
+
+#endif  // USE_IO_URING
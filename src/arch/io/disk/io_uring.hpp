@@ -0,0 +1,102 @@
+// Copyright 2010-2015 RethinkDB, all rights reserved.
+#ifndef ARCH_IO_DISK_IO_URING_HPP_
+#define ARCH_IO_DISK_IO_URING_HPP_
+
+#if defined(__linux) && !defined(NO_IO_URING) && !defined(NO_EVENTFD)
+#include <sys/syscall.h>
+#ifdef __NR_io_uring_setup
+#define USE_IO_URING 1
+#endif
+#endif
+
+#ifndef USE_IO_URING
+#define USE_IO_URING 0
+#endif
+
+#include <functional>
+
+#include "arch/io/disk/pool.hpp"
+#include "arch/io/io_utils.hpp"
+#include "arch/runtime/event_queue.hpp"
+#include "arch/runtime/system_event.hpp"
+#include "concurrency/queue/passive_producer.hpp"
+#include "concurrency/queue/unlimited_fifo.hpp"
+#include "containers/scoped.hpp"
+
+struct io_uring_sqe;
+struct io_uring_cqe;
+
+/* The io_uring disk manager submits reads and writes to the kernel through an
+io_uring submission queue directly from the thread that owns it, instead of handing
+each one to a blocker pool thread. Completions are signalled on an eventfd that is
+registered with the `linux_event_queue_t`, so they are reaped on the owning thread
+in batches.
+
+It consumes the same `pool_diskmgr_t::action_t`s as `pool_diskmgr_t` and sits at
+the same place in the IO stack. Operations that io_uring can't do for us in one
+step (resizes, writes wrapped in datasyncs, short reads or writes) are handed to an
+internal `pool_diskmgr_t`, which runs them with blocking syscalls as before. */
+
+class io_uring_diskmgr_t : private availability_callback_t,
+                           private linux_event_callback_t,
+                           public home_thread_mixin_debug_only_t {
+public:
+    typedef pool_diskmgr_t::action_t action_t;
+
+    /* Returns true if the running kernel lets us set up an io_uring. */
+    static bool is_supported();
+
+    /* Like `pool_diskmgr_t`, the `io_uring_diskmgr_t` draws actions from `source`
+    and calls `done_fun` on each one when it's done. At most `queue_depth` actions
+    are in flight in the kernel at once. */
+    io_uring_diskmgr_t(linux_event_queue_t *queue,
+                       passive_producer_t<action_t *> *source,
+                       int max_concurrent_io_requests);
+    std::function<void(action_t *)> done_fun;
+    ~io_uring_diskmgr_t();
+
+private:
+    void on_source_availability_changed();
+    void on_event(int events);
+
+    void pump();
+    void submit_pending(unsigned int to_submit);
+    void reap_completions();
+    void fill_sqe(io_uring_sqe *sqe, action_t *a);
+
+    void run_in_fallback(action_t *a);
+    void fallback_done(action_t *a);
+
+    linux_event_queue_t *const queue;
+    passive_producer_t<action_t *> *const source;
+
+    scoped_fd_t ring_fd;
+    system_event_t completion_event;
+
+    /* The submission and completion rings are shared with the kernel through
+    these mappings. */
+    void *sq_ring;
+    size_t sq_ring_size;
+    void *cq_ring;
+    size_t cq_ring_size;
+    io_uring_sqe *sqes;
+    size_t sqes_size;
+
+    unsigned int *sq_tail;
+    unsigned int *sq_ring_mask;
+    unsigned int *sq_array;
+    unsigned int *cq_head;
+    unsigned int *cq_tail;
+    unsigned int *cq_ring_mask;
+    io_uring_cqe *cqes;
+
+    unsigned int queue_depth;
+    unsigned int n_pending;
+
+    unlimited_fifo_queue_t<action_t *> fallback_queue;
+    pool_diskmgr_t fallback;
+
+    DISABLE_COPYING(io_uring_diskmgr_t);
+};
+
+#endif /* ARCH_IO_DISK_IO_URING_HPP_ */
@@ -19,6 +19,7 @@
 #endif
 
 struct iovec;
+class io_uring_diskmgr_t;
 class pool_diskmgr_t;
 class printf_buffer_t;
 
@@ -97,6 +98,7 @@ struct pool_diskmgr_action_t
 
 private:
     friend class pool_diskmgr_t;
+    friend class io_uring_diskmgr_t;
     pool_diskmgr_t *parent;
 
     enum action_type_t {ACTION_READ, ACTION_WRITE, ACTION_RESIZE};
@@ -5,10 +5,13 @@ stats_diskmgr_t::stats_diskmgr_t(perfmon_collection_t *stats, const std::string
     write_sampler(secs_to_ticks(1)),
     stats_membership(stats,
                      &read_sampler, (name + "_read").c_str(),
-                     &write_sampler, (name + "_write").c_str()) { }
+                     &write_sampler, (name + "_write").c_str(),
+                     &read_latency, (name + "_read_latency").c_str(),
+                     &write_latency, (name + "_write_latency").c_str()) { }
 
 
 void stats_diskmgr_t::submit(action_t *a) {
+    a->submit_time = get_ticks();
     if (a->get_is_read()) {
         read_sampler.begin(&a->start_time);
     } else {
@@ -19,10 +22,13 @@ void stats_diskmgr_t::submit(action_t *a) {
 
 void stats_diskmgr_t::done(conflict_resolving_diskmgr_action_t *p) {
     action_t *a = static_cast<action_t *>(p);
+    const ticks_t latency = get_ticks() - a->submit_time;
     if (a->get_is_read()) {
         read_sampler.end(&a->start_time);
+        read_latency.record(latency);
     } else {
         write_sampler.end(&a->start_time);
+        write_latency.record(latency);
     }
     done_fun(a);
 }
@@ -96,6 +96,7 @@ linux_tcp_conn_t::linux_tcp_conn_t(const ip_address_t &peer,
         sock(create_socket_wrapper(peer.get_address_family())),
         event_watcher(new linux_event_watcher_t(sock.get(), this)),
         read_in_progress(false), write_in_progress(false),
+        read_buffer_offset(0),
         write_handler(this),
         write_queue_limiter(WRITE_QUEUE_MAX_SIZE),
         write_coro_pool(1, &write_queue, &write_handler),
@@ -148,6 +149,7 @@ linux_tcp_conn_t::linux_tcp_conn_t(fd_t s) :
     sock(s),
     event_watcher(new linux_event_watcher_t(sock.get(), this)),
     read_in_progress(false), write_in_progress(false),
+    read_buffer_offset(0),
     write_handler(this),
     write_queue_limiter(WRITE_QUEUE_MAX_SIZE),
     write_coro_pool(1, &write_queue, &write_handler),
@@ -243,16 +245,52 @@ size_t linux_tcp_conn_t::read_internal(void *buffer, size_t size) THROWS_ONLY(tc
     }
 }
 
+size_t linux_tcp_conn_t::consume_read_buffer(void *buf, size_t size) {
+    size_t bytes = std::min(read_buffer_size(), size);
+    memcpy(buf, read_buffer_data(), bytes);
+    read_buffer_offset += bytes;
+    return bytes;
+}
+
+void linux_tcp_conn_t::fill_read_buffer() THROWS_ONLY(tcp_conn_read_closed_exc_t) {
+    const size_t unconsumed = read_buffer_size();
+    if (unconsumed == 0) {
+        read_buffer.clear();
+        read_buffer_offset = 0;
+    } else if (read_buffer_offset >= unconsumed) {
+        /* Moving the unconsumed data to the front costs no more than consuming the
+        data in front of it did. */
+        memmove(read_buffer.data(), read_buffer_data(), unconsumed);
+        read_buffer.resize(unconsumed);
+        read_buffer_offset = 0;
+    }
+
+    size_t old_size = read_buffer.size();
+    read_buffer.resize(old_size + IO_BUFFER_SIZE);
+    size_t delta;
+    try {
+        delta = read_internal(read_buffer.data() + old_size, IO_BUFFER_SIZE);
+    } catch (const tcp_conn_read_closed_exc_t &) {
+        read_buffer.resize(old_size);
+        throw;
+    }
+
+    read_buffer.resize(old_size + delta);
+}
+
 size_t linux_tcp_conn_t::read_some(void *buf, size_t size, signal_t *closer) THROWS_ONLY(tcp_conn_read_closed_exc_t) {
     rassert(size > 0);
     read_op_wrapper_t sentry(this, closer);
 
-    if (read_buffer.size()) {
+    if (read_buffer_size() == 0 && size < IO_BUFFER_SIZE) {
+        /* Small reads (e.g. of message headers) go through the peek buffer, so
+        that a run of them costs one system call instead of one each. */
+        fill_read_buffer();
+    }
+
+    if (read_buffer_size() != 0) {
         /* Return the data from the peek buffer */
-        size_t read_buffer_bytes = std::min(read_buffer.size(), size);
-        memcpy(buf, read_buffer.data(), read_buffer_bytes);
-        read_buffer.erase(read_buffer.begin(), read_buffer.begin() + read_buffer_bytes);
-        return read_buffer_bytes;
+        return consume_read_buffer(buf, size);
     } else {
         /* Go to the kernel _once_. */
         return read_internal(buf, size);
@@ -263,15 +301,21 @@ void linux_tcp_conn_t::read(void *buf, size_t size, signal_t *closer) THROWS_ONL
     read_op_wrapper_t sentry(this, closer);
 
     /* First, consume any data in the peek buffer */
-    int read_buffer_bytes = std::min(read_buffer.size(), size);
-    memcpy(buf, read_buffer.data(), read_buffer_bytes);
-    read_buffer.erase(read_buffer.begin(), read_buffer.begin() + read_buffer_bytes);
+    size_t read_buffer_bytes = consume_read_buffer(buf, size);
     buf = reinterpret_cast<void *>(reinterpret_cast<char *>(buf) + read_buffer_bytes);
     size -= read_buffer_bytes;
 
-    /* Now go to the kernel for any more data that we need */
+    /* Now go to the kernel for any more data that we need. Small reads go through
+    the peek buffer, so pipelined messages don't cost a system call each; large
+    ones go straight into `buf`. */
     while (size > 0) {
-        size_t delta = read_internal(buf, size);
+        size_t delta;
+        if (size < IO_BUFFER_SIZE) {
+            fill_read_buffer();
+            delta = consume_read_buffer(buf, size);
+        } else {
+            delta = read_internal(buf, size);
+        }
         rassert(delta <= size);
         buf = reinterpret_cast<void *>(reinterpret_cast<char *>(buf) + delta);
         size -= delta;
@@ -281,11 +325,7 @@ void linux_tcp_conn_t::read(void *buf, size_t size, signal_t *closer) THROWS_ONL
 void linux_tcp_conn_t::read_more_buffered(signal_t *closer) THROWS_ONLY(tcp_conn_read_closed_exc_t) {
     read_op_wrapper_t sentry(this, closer);
 
-    size_t old_size = read_buffer.size();
-    read_buffer.resize(old_size + IO_BUFFER_SIZE);
-    size_t delta = read_internal(read_buffer.data() + old_size, IO_BUFFER_SIZE);
-
-    read_buffer.resize(old_size + delta);
+    fill_read_buffer();
 }
 
 const_charslice linux_tcp_conn_t::peek() const THROWS_ONLY(tcp_conn_read_closed_exc_t) {
@@ -293,14 +333,14 @@ const_charslice linux_tcp_conn_t::peek() const THROWS_ONLY(tcp_conn_read_closed_
     rassert(!read_in_progress);   // Is there a read already in progress?
     if (read_closed.is_pulsed()) throw tcp_conn_read_closed_exc_t();
 
-    return const_charslice(read_buffer.data(), read_buffer.data() + read_buffer.size());
+    return const_charslice(read_buffer_data(), read_buffer_data() + read_buffer_size());
 }
 
 const_charslice linux_tcp_conn_t::peek(size_t size, signal_t *closer) THROWS_ONLY(tcp_conn_read_closed_exc_t) {
-    while (read_buffer.size() < size) {
+    while (read_buffer_size() < size) {
         read_more_buffered(closer);
     }
-    return const_charslice(read_buffer.data(), read_buffer.data() + size);
+    return const_charslice(read_buffer_data(), read_buffer_data() + size);
 }
 
 void linux_tcp_conn_t::pop(size_t len, signal_t *closer) THROWS_ONLY(tcp_conn_read_closed_exc_t) {
@@ -309,7 +349,7 @@ void linux_tcp_conn_t::pop(size_t len, signal_t *closer) THROWS_ONLY(tcp_conn_re
     if (read_closed.is_pulsed()) throw tcp_conn_read_closed_exc_t();
 
     peek(len, closer);
-    read_buffer.erase(read_buffer.begin(), read_buffer.begin() + len);  // INEFFICIENT
+    read_buffer_offset += len;
 }
 
 void linux_tcp_conn_t::shutdown_read() {
@@ -337,7 +377,9 @@ linux_tcp_conn_t::write_handler_t::write_handler_t(linux_tcp_conn_t *_parent) :
 { }
 
 void linux_tcp_conn_t::write_handler_t::coro_pool_callback(write_queue_op_t *operation, UNUSED signal_t *interruptor) {
-    if (operation->buffer != NULL) {
+    if (operation->iovcnt != 0) {
+        parent->perform_writev(operation->iov, operation->iovcnt);
+    } else if (operation->buffer != NULL) {
         parent->perform_write(operation->buffer, operation->size);
         if (operation->dealloc != NULL) {
             parent->release_write_buffer(operation->dealloc);
@@ -362,6 +404,8 @@ void linux_tcp_conn_t::internal_flush_write_buffer() {
     released once the write is over. */
     op->buffer = current_write_buffer->buffer;
     op->size = current_write_buffer->size;
+    op->iov = NULL;
+    op->iovcnt = 0;
     op->dealloc = current_write_buffer.release();
     op->cond = NULL;
     op->keepalive = auto_drainer_t::lock_t(drainer.get());
@@ -377,6 +421,13 @@ void linux_tcp_conn_t::internal_flush_write_buffer() {
 }
 
 void linux_tcp_conn_t::perform_write(const void *buf, size_t size) {
+    iovec iov;
+    iov.iov_base = const_cast<void *>(buf);
+    iov.iov_len = size;
+    perform_writev(&iov, 1);
+}
+
+void linux_tcp_conn_t::perform_writev(const iovec *iov, size_t iovcnt) {
     assert_thread();
 
     if (write_closed.is_pulsed()) {
@@ -386,8 +437,26 @@ void linux_tcp_conn_t::perform_write(const void *buf, size_t size) {
         return;
     }
 
-    while (size > 0) {
-        ssize_t res = ::write(sock.get(), buf, size);
+    /* `iov[next]` is the first buffer that hasn't been completely written, and
+    `offset` is how much of it has been. */
+    size_t next = 0;
+    size_t offset = 0;
+    while (next < iovcnt) {
+        if (iov[next].iov_len == offset) {
+            ++next;
+            offset = 0;
+            continue;
+        }
+
+        iovec batch[WRITEV_MAX_IOVECS];
+        size_t batch_size = std::min(iovcnt - next, WRITEV_MAX_IOVECS);
+        for (size_t i = 0; i < batch_size; ++i) {
+            batch[i] = iov[next + i];
+        }
+        batch[0].iov_base = reinterpret_cast<char *>(batch[0].iov_base) + offset;
+        batch[0].iov_len -= offset;
+
+        ssize_t res = ::writev(sock.get(), batch, batch_size);
 
         if (res == -1 && (get_errno() == EAGAIN || get_errno() == EWOULDBLOCK)) {
             /* Wait for a notification from the event queue, or for an order to
@@ -425,15 +494,33 @@ void linux_tcp_conn_t::perform_write(const void *buf, size_t size) {
             break;
 
         } else {
-            rassert(res <= static_cast<ssize_t>(size));
-            buf = reinterpret_cast<const void *>(reinterpret_cast<const char *>(buf) + res);
-            size -= res;
             if (write_perfmon) write_perfmon->record(res);
+            /* Skip past what was written. */
+            size_t written = res;
+            while (written > 0) {
+                rassert(next < iovcnt);
+                size_t left = iov[next].iov_len - offset;
+                if (written < left) {
+                    offset += written;
+                    written = 0;
+                } else {
+                    written -= left;
+                    ++next;
+                    offset = 0;
+                }
+            }
         }
     }
 }
 
 void linux_tcp_conn_t::write(const void *buf, size_t size, signal_t *closer) THROWS_ONLY(tcp_conn_write_closed_exc_t) {
+    iovec iov;
+    iov.iov_base = const_cast<void *>(buf);
+    iov.iov_len = size;
+    writev(&iov, 1, closer);
+}
+
+void linux_tcp_conn_t::writev(const iovec *iov, size_t iovcnt, signal_t *closer) THROWS_ONLY(tcp_conn_write_closed_exc_t) {
     write_op_wrapper_t sentry(this, closer);
 
     write_queue_op_t op;
@@ -446,8 +533,10 @@ void linux_tcp_conn_t::write(const void *buf, size_t size, signal_t *closer) THR
     until the write is done anyway */
 
     /* Enqueue the write so it will happen eventually */
-    op.buffer = buf;
-    op.size = size;
+    op.buffer = NULL;
+    op.size = 0;
+    op.iov = iov;
+    op.iovcnt = iovcnt;
     op.dealloc = NULL;
     op.cond = &to_signal_when_done;
     write_queue.push(&op);
@@ -507,6 +596,8 @@ void linux_tcp_conn_t::flush_buffer(signal_t *closer) THROWS_ONLY(tcp_conn_write
     write_queue_op_t op;
     cond_t to_signal_when_done;
     op.buffer = NULL;
+    op.iov = NULL;
+    op.iovcnt = 0;
     op.dealloc = NULL;
     op.cond = &to_signal_when_done;
     write_queue.push(&op);
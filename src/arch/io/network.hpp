@@ -5,6 +5,7 @@
 #include <stdarg.h>
 #include <unistd.h>
 #include <sys/types.h>
+#include <sys/uio.h>
 #include <ifaddrs.h>
 #include <arpa/inet.h>
 #include <netinet/in.h>
@@ -105,6 +106,11 @@ public:
     pipe and throws `tcp_conn_write_closed_exc_t`. */
     void write(const void *buf, size_t size, signal_t *closer) THROWS_ONLY(tcp_conn_write_closed_exc_t);
 
+    /* writev() is like write(), but writes the `iovcnt` buffers in `iov` one after
+    the other. It hands them to the socket with `::writev()` instead of copying them
+    together first. */
+    void writev(const iovec *iov, size_t iovcnt, signal_t *closer) THROWS_ONLY(tcp_conn_write_closed_exc_t);
+
     /* write_buffered() is like write(), but it might not send the data until
     flush_buffer*() or write() is called. Internally, it bundles together the
     buffered writes; this may improve performance. */
@@ -223,8 +229,26 @@ private:
     /* These are pulsed if and only if the read/write end of the connection has been closed. */
     cond_t read_closed, write_closed;
 
-    /* Holds data that we read from the socket but hasn't been consumed yet */
+    /* Holds data that we read from the socket but hasn't been consumed yet, which
+    is `read_buffer[read_buffer_offset, read_buffer.size())`. Consuming data just
+    advances `read_buffer_offset`; the consumed bytes at the front are only
+    reclaimed by `read_more_buffered()` once they outnumber the unconsumed ones, so
+    consuming many small messages takes linear rather than quadratic time. */
     std::vector<char> read_buffer;
+    size_t read_buffer_offset;
+
+    size_t read_buffer_size() const {
+        return read_buffer.size() - read_buffer_offset;
+    }
+    const char *read_buffer_data() const {
+        return read_buffer.data() + read_buffer_offset;
+    }
+    /* Copies up to `size` bytes out of `read_buffer` and consumes them. Returns the
+    number of bytes copied. */
+    size_t consume_read_buffer(void *buf, size_t size);
+
+    /* Reads more data into `read_buffer` with one call to `read_internal()`. */
+    void fill_read_buffer() THROWS_ONLY(tcp_conn_read_closed_exc_t);
 
     /* Reads up to the given number of bytes, but not necessarily that many. Simple wrapper around
     ::read(). Returns the number of bytes read or throws tcp_conn_read_closed_exc_t. Bypasses read_buffer. */
@@ -232,6 +256,8 @@ private:
 
     static const size_t WRITE_QUEUE_MAX_SIZE = 128 * KILOBYTE;
     static const size_t WRITE_CHUNK_SIZE = 8 * KILOBYTE;
+    /* The most buffers we pass to a single `::writev()` call. */
+    static const size_t WRITEV_MAX_IOVECS = 64;
 
     /* Structs to avoid over-using dynamic allocation */
     struct write_buffer_t : public intrusive_list_node_t<write_buffer_t> {
@@ -241,8 +267,12 @@ private:
 
     struct write_queue_op_t : public intrusive_list_node_t<write_queue_op_t> {
         write_buffer_t *dealloc;
+        /* Either `buffer` and `size`, or `iov` and `iovcnt` (if `iovcnt` isn't
+        zero) describe the data to write. */
         const void *buffer;
         size_t size;
+        const iovec *iov;
+        size_t iovcnt;
         cond_t *cond;
         auto_drainer_t::lock_t keepalive;
     };
@@ -301,6 +331,9 @@ private:
     `size` bytes from `buffer` to the socket. */
     void perform_write(const void *buffer, size_t size);
 
+    /* Like `perform_write()`, but writes the `iovcnt` buffers in `iov`. */
+    void perform_writev(const iovec *iov, size_t iovcnt);
+
     scoped_ptr_t<auto_drainer_t> drainer;
 };
 
@@ -11,6 +11,10 @@ threadnum_t get_thread_id();
 
 int get_num_threads();
 
+// Returns the NUMA node that the given thread has been pinned to, or -1 if threads
+// haven't been pinned.
+int get_thread_numa_node(threadnum_t thread);
+
 #ifndef NDEBUG
 void assert_good_thread_id(threadnum_t thread);
 #else
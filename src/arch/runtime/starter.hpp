@@ -8,8 +8,10 @@
 
 /* `run_in_thread_pool()` starts a RethinkDB thread pool, runs the given
 function in a coroutine inside of it, waits for the function to return, and then
-shuts down the thread pool. */
+shuts down the thread pool. If `pin_threads` is true, each thread is pinned to a
+CPU, and the threads are spread evenly over the machine's NUMA nodes. */
 
-void run_in_thread_pool(const std::function<void()> &fun, int worker_threads);
+void run_in_thread_pool(const std::function<void()> &fun, int worker_threads,
+                        bool pin_threads = false);
 
 #endif  // ARCH_RUNTIME_STARTER_HPP_
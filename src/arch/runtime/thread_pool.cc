@@ -2,11 +2,15 @@
 #include "arch/runtime/thread_pool.hpp"
 
 #include <errno.h>
+#include <sched.h>
 #include <signal.h>
+#include <stdio.h>
 #include <string.h>
 #include <unistd.h>
 #include <sys/time.h>
 
+#include <vector>
+
 #include "arch/barrier.hpp"
 #include "arch/os_signal.hpp"
 #include "arch/io/timer_provider.hpp"
@@ -55,6 +59,10 @@ linux_thread_pool_t::linux_thread_pool_t(int worker_threads, bool _do_set_affini
     rassert(n_threads > 1);             // we want at least one non-utility thread
     rassert(n_threads <= MAX_THREADS);
 
+    for (int i = 0; i < MAX_THREADS; ++i) {
+        thread_numa_nodes[i] = -1;
+    }
+
     int res;
 
     res = pthread_cond_init(&shutdown_cond, NULL);
@@ -177,6 +185,95 @@ void *linux_thread_pool_t::start_thread(void *arg) {
     return NULL;
 }
 
+std::vector<int> parse_cpu_list(const char *list) {
+    std::vector<int> cpus;
+    const char *p = list;
+    while (*p != '\0' && *p != '\n') {
+        char *end;
+        long first = strtol(p, &end, 10);
+        if (end == p) {
+            break;
+        }
+        long last = first;
+        p = end;
+        if (*p == '-') {
+            ++p;
+            last = strtol(p, &end, 10);
+            if (end == p) {
+                break;
+            }
+            p = end;
+        }
+        for (long cpu = first; cpu <= last; ++cpu) {
+            cpus.push_back(cpu);
+        }
+        if (*p == ',') {
+            ++p;
+        }
+    }
+    return cpus;
+}
+
+#ifdef _GNU_SOURCE
+// Returns the CPUs of each NUMA node, as reported by sysfs. Machines (or kernels)
+// that don't report any nodes look like a single node with all CPUs on it. Only
+// the CPUs that the process is allowed to run on (e.g. under `taskset` or a
+// cpuset cgroup) are returned, and nodes without any of them are left out. If
+// there are none at all, the result is empty and threads shouldn't be pinned.
+static std::vector<std::vector<int> > get_numa_topology() {
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) {
+        logWRN("Could not get the CPU affinity of the process (%s), so threads "
+               "will not be pinned to CPUs.", errno_string(get_errno()).c_str());
+        return std::vector<std::vector<int> >();
+    }
+    auto is_allowed = [&allowed](int cpu) {
+        return cpu >= 0 && cpu < CPU_SETSIZE && CPU_ISSET(cpu, &allowed);
+    };
+
+    std::vector<std::vector<int> > nodes;
+    for (int node = 0; ; ++node) {
+        std::string path = strprintf("/sys/devices/system/node/node%d/cpulist", node);
+        FILE *file = fopen(path.c_str(), "r");
+        if (file == NULL) {
+            break;
+        }
+        char buf[4096];
+        char *line = fgets(buf, sizeof(buf), file);
+        fclose(file);
+        std::vector<int> cpus;
+        if (line != NULL) {
+            for (int cpu : parse_cpu_list(line)) {
+                if (is_allowed(cpu)) {
+                    cpus.push_back(cpu);
+                }
+            }
+        }
+        // Nodes with memory but without (allowed) CPUs are of no use for pinning
+        // threads.
+        if (!cpus.empty()) {
+            nodes.push_back(cpus);
+        }
+    }
+    if (nodes.empty()) {
+        std::vector<int> cpus;
+        for (int cpu = 0; cpu < get_cpu_count(); ++cpu) {
+            if (is_allowed(cpu)) {
+                cpus.push_back(cpu);
+            }
+        }
+        if (cpus.empty()) {
+            logWRN("None of the CPUs that the process is allowed to run on were "
+                   "found, so threads will not be pinned to CPUs.");
+        } else {
+            nodes.push_back(cpus);
+        }
+    }
+    return nodes;
+}
+#endif  // _GNU_SOURCE
+
 #ifndef NDEBUG
 void linux_thread_pool_t::enable_coroutine_summary() {
     coroutine_summary = true;
@@ -189,6 +286,19 @@ void linux_thread_pool_t::run_thread_pool(linux_thread_message_t *initial_messag
     // Start child threads
     thread_barrier_t barrier(n_threads + 1);
 
+    // On Apple, the thread affinity API has awful documentation, so we don't even
+    // bother.
+#ifdef _GNU_SOURCE
+    std::vector<std::vector<int> > numa_nodes;
+    // The next CPU to hand out on each node.
+    std::vector<size_t> next_cpu_on_node;
+    if (do_set_affinity) {
+        numa_nodes = get_numa_topology();
+        next_cpu_on_node.resize(numa_nodes.size(), 0);
+    }
+    const bool pin_threads = do_set_affinity && !numa_nodes.empty();
+#endif
+
     for (int i = 0; i < n_threads; i++) {
         thread_data_t *tdata = new thread_data_t();
         tdata->barrier = &barrier;
@@ -197,21 +307,36 @@ void linux_thread_pool_t::run_thread_pool(linux_thread_message_t *initial_messag
         // The initial message gets sent to thread zero.
         tdata->initial_message = (i == 0) ? initial_message : NULL;
 
-        int res = pthread_create(&pthreads[i], NULL, &start_thread, tdata);
-        guarantee_xerr(res == 0, res, "Could not create thread");
+        pthread_attr_t attr;
+        int res = pthread_attr_init(&attr);
+        guarantee_xerr(res == 0, res, "pthread_attr_init failed");
 
-        if (do_set_affinity) {
-            // On Apple, the thread affinity API has awful documentation, so we don't even bother.
 #ifdef _GNU_SOURCE
-            // Distribute threads evenly among CPUs
-            int ncpus = get_cpu_count();
+        if (pin_threads) {
+            // Distribute threads evenly among the NUMA nodes, and among the CPUs
+            // of each node. The affinity is set before the thread starts, so that
+            // everything it allocates while starting up is already node-local.
+            const int node = i % numa_nodes.size();
+            const std::vector<int> &cpus = numa_nodes[node];
+            thread_numa_nodes[i] = node;
+            CPU_ZERO(&thread_node_cpus[i]);
+            for (size_t j = 0; j < cpus.size(); ++j) {
+                CPU_SET(cpus[j], &thread_node_cpus[i]);
+            }
             cpu_set_t mask;
             CPU_ZERO(&mask);
-            CPU_SET(i % ncpus, &mask);
-            res = pthread_setaffinity_np(pthreads[i], sizeof(cpu_set_t), &mask);
+            CPU_SET(cpus[next_cpu_on_node[node] % cpus.size()], &mask);
+            ++next_cpu_on_node[node];
+            res = pthread_attr_setaffinity_np(&attr, sizeof(cpu_set_t), &mask);
             guarantee_xerr(res == 0, res, "Could not set thread affinity");
-#endif
         }
+#endif
+
+        res = pthread_create(&pthreads[i], &attr, &start_thread, tdata);
+        guarantee_xerr(res == 0, res, "Could not create thread");
+
+        res = pthread_attr_destroy(&attr);
+        guarantee_xerr(res == 0, res, "pthread_attr_destroy failed");
     }
 
     // Mark the main thread (for use in assertions etc.)
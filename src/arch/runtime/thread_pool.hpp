@@ -6,6 +6,7 @@
 
 #include <map>
 #include <string>
+#include <vector>
 
 #include "config/args.hpp"
 #include "arch/runtime/event_queue.hpp"
@@ -32,6 +33,9 @@ struct coro_runtime_t {
 #endif
 };
 
+// Parses a list of CPUs in the format of /sys/devices/system/node/node*/cpulist,
+// e.g. "0-7,16-23".  Stops at the first thing that isn't part of the list.
+std::vector<int> parse_cpu_list(const char *list);
 
 /* A thread pool represents a group of threads, each of which is associated with an
 event queue. There is one thread pool per server. It is responsible for starting up
@@ -92,6 +96,19 @@ public:
     int n_threads;
     bool do_set_affinity;
 
+    // If `do_set_affinity` is set, the NUMA node each thread has been pinned to.
+    // Threads are spread over the nodes round-robin, and each one gets a CPU of its
+    // own on its node where possible. Otherwise (or if we couldn't read the
+    // topology, or the process may not run on any of its CPUs), every entry is -1.
+    int thread_numa_nodes[MAX_THREADS];
+#ifdef _GNU_SOURCE
+    // The CPUs of the node each thread is pinned to, limited to the ones that the
+    // process is allowed to run on. Blocker pool threads that a pinned thread
+    // starts get this affinity, so that blocking calls and disk I/O run (and
+    // allocate their buffers) close to the thread that waits on them.
+    cpu_set_t thread_node_cpus[MAX_THREADS];
+#endif
+
     // Non-inlinable getters and setters for the thread local variables.
     // See thread_local.hpp for an explanation of why these must not be
     // inlined.
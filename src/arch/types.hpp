@@ -101,6 +101,15 @@ enum class file_direct_io_mode_t {
     buffered_desired
 };
 
+// Which mechanism the disk manager uses to hand I/O operations to the kernel.
+enum class file_io_backend_t {
+    // Blocking syscalls run on a pool of blocker threads.
+    blocker_pool,
+    // Batched submissions through an io_uring owned by the disk manager's thread.
+    // Falls back to `blocker_pool` if the kernel doesn't support io_uring.
+    io_uring
+};
+
 class semantic_checking_file_t {
 public:
     semantic_checking_file_t() { }
@@ -1,12 +1,27 @@
 // Copyright 2010-2014 RethinkDB, all rights reserved.
 #include "backfill_progress.hpp"
 
+#include <algorithm>
 #include <functional>
 
 #include "concurrency/pmap.hpp"
 #include "containers/scoped.hpp"
 #include "utils.hpp"
 
+progress_completion_fraction_t counted_traversal_progress_t::guess_completion() const {
+    assert_thread();
+    const int scale = 1000;
+    if (expected_total < 0) {
+        return progress_completion_fraction_t();
+    } else if (expected_total == 0) {
+        return progress_completion_fraction_t(scale, scale);
+    }
+    // The total is only an estimate, so we might visit more items than expected.
+    const int64_t clamped_done = std::min(done, expected_total);
+    return progress_completion_fraction_t(
+        static_cast<int>(clamped_done * scale / expected_total), scale);
+}
+
 traversal_progress_combiner_t::~traversal_progress_combiner_t() {
     guarantee(!is_destructing);
     is_destructing = true;
@@ -38,6 +53,11 @@ progress_completion_fraction_t traversal_progress_combiner_t::guess_completion()
     assert_thread();
     guarantee(!is_destructing);
 
+    // There is nothing to estimate until a traversal has started.
+    if (constituents.empty()) {
+        return progress_completion_fraction_t();
+    }
+
     int released = 0, total = 0;
 
     std::vector<progress_completion_fraction_t> fractions(constituents.size(), progress_completion_fraction_t());
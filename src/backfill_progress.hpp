@@ -44,6 +44,30 @@ private:
     DISABLE_COPYING(traversal_progress_t);
 };
 
+/* Progress of a traversal that knows up front roughly how many items it is going to
+visit, such as a backfill that visits every key of a btree in key order. It reports
+thousandths of the expected total, so that the node counts that
+`traversal_progress_combiner_t` adds up can't overflow. */
+class counted_traversal_progress_t : public traversal_progress_t {
+public:
+    // A negative `_expected_total` means that we don't know how many items there are.
+    explicit counted_traversal_progress_t(int64_t _expected_total)
+        : expected_total(_expected_total), done(0) { }
+
+    void add_done(int64_t count) {
+        assert_thread();
+        done += count;
+    }
+
+    progress_completion_fraction_t guess_completion() const;
+
+private:
+    int64_t expected_total;
+    int64_t done;
+
+    DISABLE_COPYING(counted_traversal_progress_t);
+};
+
 class traversal_progress_combiner_t : public traversal_progress_t {
 public:
     explicit traversal_progress_combiner_t(threadnum_t specified_home_thread)
@@ -152,17 +152,10 @@ struct backfill_traversal_helper_t : public btree_traversal_helper_t, public hom
         : callback_(callback), since_when_(since_when), sizer_(sizer), key_range_(key_range) { }
 };
 
-void do_agnostic_btree_backfill(value_sizer_t *sizer,
-                                const key_range_t &key_range,
-                                repli_timestamp_t since_when,
-                                agnostic_backfill_callback_t *callback,
-                                superblock_t *superblock,
-                                buf_lock_t *sindex_block,
-                                parallel_traversal_progress_t *p,
-                                signal_t *interruptor)
+void backfill_live_sindexes(buf_lock_t *sindex_block,
+                            agnostic_backfill_callback_t *callback,
+                            signal_t *interruptor)
         THROWS_ONLY(interrupted_exc_t) {
-    rassert(coro_t::self());
-
     std::map<sindex_name_t, secondary_index_t> sindexes;
     get_secondary_indexes(sindex_block, &sindexes);
     std::map<std::string, secondary_index_t> live_sindexes;
@@ -174,6 +167,20 @@ void do_agnostic_btree_backfill(value_sizer_t *sizer,
         }
     }
     callback->on_sindexes(live_sindexes, interruptor);
+}
+
+void do_agnostic_btree_backfill(value_sizer_t *sizer,
+                                const key_range_t &key_range,
+                                repli_timestamp_t since_when,
+                                agnostic_backfill_callback_t *callback,
+                                superblock_t *superblock,
+                                buf_lock_t *sindex_block,
+                                parallel_traversal_progress_t *p,
+                                signal_t *interruptor)
+        THROWS_ONLY(interrupted_exc_t) {
+    rassert(coro_t::self());
+
+    backfill_live_sindexes(sindex_block, callback, interruptor);
 
     backfill_traversal_helper_t helper(callback, since_when, sizer, key_range);
     helper.progress = p;
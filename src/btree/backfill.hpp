@@ -15,6 +15,10 @@
 // each not too much larger than this value.
 #define BACKFILL_MAX_KVPAIRS_SIZE (1024 * 64)
 
+// Backfills that send their keys in order tell the receiver how far they have
+// gotten about this often, so that it can resume from there if it gets interrupted.
+#define BACKFILL_CHECKPOINT_INTERVAL_MS (10 * 1000)
+
 class buf_parent_t;
 class buf_lock_t;
 struct btree_key_t;
@@ -40,6 +44,13 @@ public:
     virtual ~agnostic_backfill_callback_t() { }
 };
 
+/* Passes the secondary indexes that aren't being deleted to
+`callback->on_sindexes()`. Every backfill starts with this. */
+void backfill_live_sindexes(buf_lock_t *sindex_block,
+                            agnostic_backfill_callback_t *callback,
+                            signal_t *interruptor)
+    THROWS_ONLY(interrupted_exc_t);
+
 /* `do_agnostic_btree_backfill()` is guaranteed to find all changes whose
 timestamps are greater than or equal than `since_when` but which reached the
 tree before `btree_backfill()` was called. It may also find changes that
@@ -0,0 +1,176 @@
+// Copyright 2010-2015 RethinkDB, all rights reserved.
+#include "btree/bulk_load.hpp"
+
+#include "btree/internal_node.hpp"
+#include "btree/leaf_node.hpp"
+#include "btree/node.hpp"
+#include "btree/operations.hpp"
+
+btree_bulk_loader_t::btree_bulk_loader_t(value_sizer_t *sizer,
+                                         repli_timestamp_t timestamp)
+    : sizer_(sizer), timestamp_(timestamp), max_recency_(timestamp), num_pairs_(0),
+      checkpoint_root_(NULL_BLOCK_ID), checkpoint_num_pairs_(0), finished_(false) { }
+
+void btree_bulk_loader_t::append(txn_t *txn,
+                                 const btree_key_t *key,
+                                 const void *value) {
+    append(txn, key, value, timestamp_);
+}
+
+void btree_bulk_loader_t::append(txn_t *txn,
+                                 const btree_key_t *key,
+                                 const void *value,
+                                 repli_timestamp_t recency) {
+    guarantee(!finished_);
+    guarantee(num_pairs_ == 0
+              || btree_key_cmp(last_key_.btree_key(), key) < 0,
+              "Keys passed to the bulk loader must be in ascending order.");
+    max_recency_ = superceding_recency(max_recency_, recency);
+
+    if (right_edge_.empty()) {
+        right_edge_.emplace_back();
+        create_leaf(txn, &right_edge_[0]);
+    } else {
+        bool leaf_is_full;
+        {
+            buf_read_t read(acquire(txn, &right_edge_[0]));
+            leaf_is_full = leaf::is_full(
+                sizer_, static_cast<const leaf_node_t *>(read.get_data_read()),
+                key, value);
+        }
+        if (leaf_is_full) {
+            const block_id_t full_leaf = right_edge_[0].block_id;
+            right_edge_[0] = open_node_t();
+            create_leaf(txn, &right_edge_[0]);
+            add_child(txn, 1, full_leaf, last_key_, right_edge_[0].block_id);
+        }
+    }
+
+    {
+        buf_write_t write(acquire(txn, &right_edge_[0]));
+        leaf::insert(sizer_, static_cast<leaf_node_t *>(write.get_data_write()),
+                     key, value, recency, key_modification_proof_t::real_proof());
+    }
+    last_key_.assign(key);
+    ++num_pairs_;
+}
+
+void btree_bulk_loader_t::release_nodes() {
+    for (auto &node : right_edge_) {
+        node.buf.reset_buf_lock();
+    }
+}
+
+void btree_bulk_loader_t::checkpoint(superblock_t *superblock) {
+    guarantee(!finished_);
+    guarantee(superblock->get_root_block_id() == checkpoint_root_,
+              "The bulk loader can only build a B-tree that nobody else writes to.");
+    if (!right_edge_.empty() && right_edge_.back().block_id != checkpoint_root_) {
+        checkpoint_root_ = right_edge_.back().block_id;
+        superblock->set_root_block_id(checkpoint_root_);
+    }
+    add_to_population(superblock, num_pairs_ - checkpoint_num_pairs_);
+    checkpoint_num_pairs_ = num_pairs_;
+    release_nodes();
+}
+
+void btree_bulk_loader_t::finish(superblock_t *superblock) {
+    checkpoint(superblock);
+    finished_ = true;
+}
+
+void btree_bulk_loader_t::add_child(txn_t *txn, size_t height,
+                                    block_id_t left_child,
+                                    const store_key_t &left_last_key,
+                                    block_id_t child) {
+    if (height == right_edge_.size()) {
+        // `left_child` was the root, so the tree gets a new one.
+        right_edge_.emplace_back();
+        create_internal(txn, &right_edge_[height]);
+    }
+    open_node_t *node = &right_edge_[height];
+
+    bool node_is_full;
+    {
+        buf_read_t read(acquire(txn, node));
+        node_is_full = internal_node::is_full(
+            static_cast<const internal_node_t *>(read.get_data_read()));
+    }
+    if (node_is_full) {
+        // Move `left_child` over into a new node together with `child`, so that
+        // the new node has two children like every internal node.
+        block_id_t full_node_last_child;
+        store_key_t full_node_last_key;
+        {
+            buf_write_t write(acquire(txn, node));
+            auto node_data = static_cast<internal_node_t *>(write.get_data_write());
+            guarantee(node_data->npairs >= 3);
+            const btree_internal_pair *pair =
+                internal_node::get_pair_by_index(node_data, node_data->npairs - 2);
+            full_node_last_child = pair->lnode;
+            full_node_last_key.assign(&pair->key);
+            rassert(internal_node::get_pair_by_index(
+                node_data, node_data->npairs - 1)->lnode == left_child);
+            internal_node::remove(sizer_->block_size(), node_data,
+                                  left_last_key.btree_key());
+        }
+        const block_id_t full_node = node->block_id;
+        *node = open_node_t();
+        create_internal(txn, node);
+        add_child(txn, height + 1, full_node, full_node_last_key, node->block_id);
+    }
+
+    {
+        buf_write_t write(acquire(txn, node));
+        DEBUG_VAR bool success = internal_node::insert(
+            static_cast<internal_node_t *>(write.get_data_write()),
+            left_last_key.btree_key(), left_child, child);
+        rassert(success, "could not insert internal btree node");
+    }
+}
+
+void btree_bulk_loader_t::add_to_population(superblock_t *superblock,
+                                            int64_t num_pairs) {
+    const block_id_t stat_block_id = superblock->get_stat_block_id();
+    if (stat_block_id != NULL_BLOCK_ID && num_pairs != 0) {
+        txn_t *txn = superblock->expose_buf().txn();
+        buf_lock_t stat_block(buf_parent_t(txn), stat_block_id, access_t::write);
+        buf_write_t stat_block_write(&stat_block);
+        auto stat_block_buf = static_cast<btree_statblock_t *>(
+                stat_block_write.get_data_write(BTREE_STATBLOCK_SIZE));
+        stat_block_buf->population += num_pairs;
+    }
+}
+
+buf_lock_t *btree_bulk_loader_t::acquire(txn_t *txn, open_node_t *node) {
+    guarantee(node->block_id != NULL_BLOCK_ID);
+    if (node->buf.empty()) {
+        node->buf = buf_lock_t(buf_parent_t(txn), node->block_id, access_t::write);
+    }
+    touch(node);
+    return &node->buf;
+}
+
+void btree_bulk_loader_t::create_leaf(txn_t *txn, open_node_t *node) {
+    create(txn, node);
+    buf_write_t write(&node->buf);
+    leaf::init(sizer_, static_cast<leaf_node_t *>(write.get_data_write()));
+}
+
+void btree_bulk_loader_t::create_internal(txn_t *txn, open_node_t *node) {
+    create(txn, node);
+    buf_write_t write(&node->buf);
+    internal_node::init(sizer_->block_size(),
+                        static_cast<internal_node_t *>(write.get_data_write()));
+}
+
+void btree_bulk_loader_t::create(txn_t *txn, open_node_t *node) {
+    node->buf = buf_lock_t(buf_parent_t(txn), alt_create_t::create);
+    node->block_id = node->buf.block_id();
+    touch(node);
+}
+
+void btree_bulk_loader_t::touch(open_node_t *node) {
+    node->buf.manually_touch_recency(
+        superceding_recency(node->buf.get_recency(), max_recency_));
+}
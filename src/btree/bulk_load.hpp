@@ -0,0 +1,107 @@
+// Copyright 2010-2015 RethinkDB, all rights reserved.
+#ifndef BTREE_BULK_LOAD_HPP_
+#define BTREE_BULK_LOAD_HPP_
+
+#include <deque>
+
+#include "btree/keys.hpp"
+#include "buffer_cache/alt.hpp"
+#include "containers/scoped.hpp"
+#include "repli_timestamp.hpp"
+
+class superblock_t;
+class value_sizer_t;
+
+/* `btree_bulk_loader_t` builds a B-tree bottom-up from key/value pairs that are
+passed to it in ascending key order. Instead of descending from the root and
+splitting nodes for every key, it fills one leaf node after the other and adds each
+new node to the rightmost internal node above it. An internal node that is full gets
+split right before its last child, which moves into the new node together with the
+node that is being added. Every node except for the ones on the right edge of the
+tree ends up full.
+
+Every node is linked into the tree as soon as it is created, so the tree is complete
+whenever a transaction ends. It becomes visible when `checkpoint()` or `finish()`
+makes its root the superblock's root, which requires the superblock to not have a
+root yet. Nobody else may write to the tree until `finish()`, because the loader
+keeps writing to the nodes on its right edge. In between, `release_nodes()` can be
+used to let go of the nodes between write transactions. This keeps the transactions
+(and the number of dirty blocks in the cache) small; the next call picks the nodes
+up again in its own transaction. Nodes that have been added since the last
+`checkpoint()` are only unreachable if the tree has grown a new root since then.
+
+Values are copied into the leaves as they are. If a value refers to blocks of its
+own (such as a blob), the caller creates them with `buf_parent_t(txn)` as their
+parent. */
+class btree_bulk_loader_t {
+public:
+    // Pairs that are appended without a recency of their own get `timestamp`.
+    // Nodes get the most recent of `timestamp` and the recencies of their pairs.
+    btree_bulk_loader_t(value_sizer_t *sizer, repli_timestamp_t timestamp);
+
+    // `key` must be greater than any key that was appended before.
+    void append(txn_t *txn, const btree_key_t *key, const void *value);
+    void append(txn_t *txn, const btree_key_t *key, const void *value,
+                repli_timestamp_t recency);
+
+    // Releases all nodes, so that the current transaction can be committed.
+    void release_nodes();
+
+    // Makes the tree the root of `superblock` and adds the pairs that were appended
+    // since the last checkpoint to the population in its stat block (if it has
+    // one). `superblock` must not have a root, or have the root that the previous
+    // checkpoint gave it. Releases all nodes like `release_nodes()`.
+    void checkpoint(superblock_t *superblock);
+
+    // Like `checkpoint()`, but the loader can't be used afterwards.
+    void finish(superblock_t *superblock);
+
+    int64_t num_pairs() const { return num_pairs_; }
+
+private:
+    // A node on the right edge of the tree. The block is acquired lazily, so that it
+    // can be released between transactions.
+    struct open_node_t {
+        open_node_t() : block_id(NULL_BLOCK_ID) { }
+        block_id_t block_id;
+        buf_lock_t buf;
+    };
+
+    buf_lock_t *acquire(txn_t *txn, open_node_t *node);
+    void create_leaf(txn_t *txn, open_node_t *node);
+    void create_internal(txn_t *txn, open_node_t *node);
+    void create(txn_t *txn, open_node_t *node);
+    void touch(open_node_t *node);
+
+    // Adds `child` to the node on the right edge at `height` (the leaf nodes are at
+    // height 0), next to its current last child `left_child`. `left_last_key` is
+    // the largest key in the subtree of `left_child`.
+    void add_child(txn_t *txn, size_t height, block_id_t left_child,
+                   const store_key_t &left_last_key, block_id_t child);
+    void add_to_population(superblock_t *superblock, int64_t num_pairs);
+
+    value_sizer_t *const sizer_;
+    const repli_timestamp_t timestamp_;
+    // The most recent recency of any pair appended so far. Every node that we write
+    // to gets at least this recency, so that a node is never older than any of the
+    // nodes and pairs below it.
+    repli_timestamp_t max_recency_;
+
+    // The rightmost node on every level of the tree, starting with the leaf node.
+    // The last one is the root. `std::deque` because `add_child()` adds levels while
+    // we hold pointers to lower ones.
+    std::deque<open_node_t> right_edge_;
+    store_key_t last_key_;
+    int64_t num_pairs_;
+
+    // The root that the last checkpoint gave the superblock, and the number of pairs
+    // that were in the tree at that point.
+    block_id_t checkpoint_root_;
+    int64_t checkpoint_num_pairs_;
+
+    bool finished_;
+
+    DISABLE_COPYING(btree_bulk_loader_t);
+};
+
+#endif  // BTREE_BULK_LOAD_HPP_
@@ -90,6 +90,10 @@ public:
         return cb_->is_range_interesting(left_excl_or_null, right_incl_or_null);
     }
 
+    virtual size_t get_max_read_ahead_nodes() {
+        return cb_->get_max_read_ahead_nodes();
+    }
+
     virtual profile::trace_t *get_trace() THROWS_NOTHING {
         return cb_->get_trace();
     }
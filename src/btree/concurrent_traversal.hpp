@@ -45,6 +45,9 @@ public:
         return true;
     }
 
+    // See `depth_first_traversal_callback_t::get_max_read_ahead_nodes()`.
+    virtual size_t get_max_read_ahead_nodes() { return 0; }
+
     virtual profile::trace_t *get_trace() THROWS_NOTHING { return NULL; }
 
 protected:
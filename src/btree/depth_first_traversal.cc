@@ -1,8 +1,11 @@
 // Copyright 2010-2014 RethinkDB, all rights reserved.
 #include "btree/depth_first_traversal.hpp"
 
+#include <deque>
+
 #include "btree/internal_node.hpp"
 #include "btree/operations.hpp"
+#include "config/args.hpp"
 #include "rdb_protocol/profile.hpp"
 
 class counted_buf_lock_t : public buf_lock_t,
@@ -48,6 +51,11 @@ buf_parent_t scoped_key_value_t::expose_buf() {
     return buf_parent_t(buf_.get());
 }
 
+repli_timestamp_t scoped_key_value_t::leaf_recency() const {
+    guarantee(buf_.has());
+    return buf_.get()->get_recency();
+}
+
 // Releases the hold on the buf_lock_t, after which key(), value(), and expose_buf()
 // may not be used.
 void scoped_key_value_t::reset() {
@@ -59,6 +67,7 @@ void scoped_key_value_t::reset() {
 /* Returns `true` if we reached the end of the subtree or range, and `false` if
 `cb->handle_value()` returned `false`. */
 bool btree_depth_first_traversal(counted_t<counted_buf_lock_t> block,
+                                 counted_t<counted_buf_read_t> read,
                                  const key_range_t &range,
                                  depth_first_traversal_callback_t *cb,
                                  direction_t direction,
@@ -94,8 +103,9 @@ bool btree_depth_first_traversal(superblock_t *superblock,
             // profiling information is correct.
             root_block->read_acq_signal()->wait();
         }
-        return btree_depth_first_traversal(std::move(root_block), range, cb,
-                                           direction, NULL, NULL);
+        return btree_depth_first_traversal(std::move(root_block),
+                                           counted_t<counted_buf_read_t>(),
+                                           range, cb, direction, NULL, NULL);
     }
 }
 
@@ -122,13 +132,27 @@ void get_child_key_range(const internal_node_t *inode,
     }
 }
 
+// A child node that has been acquired before we get to traversing into it.  Its
+// block might already be loading.
+struct acquired_child_t {
+    // The position of the child among the children we visit, in traversal order.
+    int position;
+    const btree_key_t *left_excl_or_null;
+    const btree_key_t *right_incl_or_null;
+    counted_t<counted_buf_lock_t> lock;
+    counted_t<counted_buf_read_t> read;
+};
+
 bool btree_depth_first_traversal(counted_t<counted_buf_lock_t> block,
+                                 counted_t<counted_buf_read_t> read,
                                  const key_range_t &range,
                                  depth_first_traversal_callback_t *cb,
                                  direction_t direction,
                                  const btree_key_t *left_excl_or_null,
                                  const btree_key_t *right_incl_or_null) {
-    auto read = make_counted<counted_buf_read_t>(block.get());
+    if (!read.has()) {
+        read = make_counted<counted_buf_read_t>(block.get());
+    }
     const node_t *node = static_cast<const node_t *>(read->get_data_read());
     if (node::is_internal(node)) {
         const internal_node_t *inode = reinterpret_cast<const internal_node_t *>(node);
@@ -141,31 +165,65 @@ bool btree_depth_first_traversal(counted_t<counted_buf_lock_t> block,
             r.decrement();
             end_index = internal_node::get_offset_index(inode, r.btree_key()) + 1;
         }
-        for (int i = 0; i < end_index - start_index; ++i) {
-            int true_index = (direction == FORWARD ? start_index + i : (end_index - 1) - i);
-            const btree_internal_pair *pair = internal_node::get_pair_by_index(inode, true_index);
-
-            // Get the child key range
-            const btree_key_t *child_left_excl_or_null;
-            const btree_key_t *child_right_incl_or_null;
-            get_child_key_range(inode, true_index,
-                                left_excl_or_null, right_incl_or_null,
-                                &child_left_excl_or_null, &child_right_incl_or_null);
-
-            if (cb->is_range_interesting(child_left_excl_or_null, child_right_incl_or_null)) {
-                counted_t<counted_buf_lock_t> lock;
-                {
+        const int num_children = end_index - start_index;
+
+        // Children that we've acquired ahead of time, in traversal order.  Only
+        // children at positions before `next_position` have been considered so far.
+        // Read locks on siblings don't keep anybody out that our lock on `block`
+        // doesn't already keep out.
+        std::deque<acquired_child_t> acquired;
+        int next_position = 0;
+        for (int i = 0; i < num_children; ++i) {
+            const int read_ahead = std::min<size_t>(cb->get_max_read_ahead_nodes(),
+                                                    BTREE_MAX_READ_AHEAD_NODES);
+            for (; next_position < num_children && next_position <= i + read_ahead;
+                 ++next_position) {
+                int true_index = (direction == FORWARD
+                                  ? start_index + next_position
+                                  : (end_index - 1) - next_position);
+                const btree_internal_pair *pair =
+                    internal_node::get_pair_by_index(inode, true_index);
+
+                // Get the child key range
+                acquired_child_t child;
+                child.position = next_position;
+                get_child_key_range(inode, true_index,
+                                    left_excl_or_null, right_incl_or_null,
+                                    &child.left_excl_or_null,
+                                    &child.right_incl_or_null);
+
+                if (cb->is_range_interesting(child.left_excl_or_null,
+                                             child.right_incl_or_null)) {
                     profile::starter_t starter("Acquire block for read.", cb->get_trace());
-                    lock = make_counted<counted_buf_lock_t>(block.get(), pair->lnode,
-                                                            access_t::read);
+                    child.lock = make_counted<counted_buf_lock_t>(block.get(), pair->lnode,
+                                                                  access_t::read);
+                    child.read = make_counted<counted_buf_read_t>(child.lock.get());
+                    acquired.push_back(std::move(child));
                 }
-                if (!btree_depth_first_traversal(std::move(lock),
-                                                 range, cb, direction,
-                                                 child_left_excl_or_null,
-                                                 child_right_incl_or_null)) {
-                    return false;
+            }
+
+            if (acquired.empty() || acquired.front().position != i) {
+                continue;
+            }
+
+            // Start loading this child and the ones after it, so that their reads
+            // are in flight while we're busy with this one.  `start_loading` is
+            // cheap if the load has already been started.
+            for (auto it = acquired.begin(); it != acquired.end(); ++it) {
+                if (!it->read->start_loading()) {
+                    break;
                 }
             }
+
+            acquired_child_t child = std::move(acquired.front());
+            acquired.pop_front();
+            if (!btree_depth_first_traversal(std::move(child.lock),
+                                             std::move(child.read),
+                                             range, cb, direction,
+                                             child.left_excl_or_null,
+                                             child.right_incl_or_null)) {
+                return false;
+            }
         }
         return true;
     } else {
@@ -6,6 +6,7 @@
 #include "btree/types.hpp"
 #include "containers/archive/archive.hpp"
 #include "containers/counted.hpp"
+#include "repli_timestamp.hpp"
 
 namespace profile { class trace_t; }
 
@@ -36,6 +37,10 @@ public:
     }
     buf_parent_t expose_buf();
 
+    // The recency of the leaf node that contains the pair. The pair itself may have
+    // been written earlier than that.
+    repli_timestamp_t leaf_recency() const;
+
     // Releases the hold on the buf_lock_t, after which key(), value(), and
     // expose_buf() may not be used.
     void reset();
@@ -62,6 +67,12 @@ public:
                                       UNUSED const btree_key_t *right_incl_or_null) {
         return true;
     }
+    /* How many of the sibling nodes following the one being traversed may be
+    acquired and loaded ahead of time, so that a cold scan has more than one read
+    in flight. Capped at `BTREE_MAX_READ_AHEAD_NODES`. Asked again before every
+    child, so it can shrink as the callback gets closer to being done. The default
+    of 0 disables read-ahead, which suits traversals that stop early. */
+    virtual size_t get_max_read_ahead_nodes() { return 0; }
     virtual profile::trace_t *get_trace() THROWS_NOTHING { return NULL; }
 protected:
     virtual ~depth_first_traversal_callback_t() { }
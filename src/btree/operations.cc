@@ -355,6 +355,26 @@ void check_and_handle_underfull(value_sizer_t *sizer,
     }
 }
 
+// Which keys can be in the subtree of the child of `parent` that `key` belongs into,
+// given the same for `parent`.
+void get_child_right_bound(buf_lock_t *parent,
+                           bool parent_is_rightmost,
+                           const store_key_t &parent_right_bound,
+                           const btree_key_t *key,
+                           bool *is_rightmost_out,
+                           store_key_t *right_bound_out) {
+    buf_read_t read(parent);
+    auto node = static_cast<const internal_node_t *>(read.get_data_read());
+    const int index = internal_node::get_offset_index(node, key);
+    if (index + 1 < node->npairs) {
+        *is_rightmost_out = false;
+        right_bound_out->assign(&internal_node::get_pair_by_index(node, index)->key);
+    } else {
+        *is_rightmost_out = parent_is_rightmost;
+        *right_bound_out = parent_right_bound;
+    }
+}
+
 /* Passing in a pass_back_superblock parameter will cause this function to
  * return the superblock after it's no longer needed (rather than releasing
  * it). Notice the superblock is not guaranteed to be returned until the
@@ -378,6 +398,9 @@ void find_keyvalue_location_for_write(
 
     buf_lock_t last_buf;
     buf_lock_t buf;
+    // Which keys can be in the subtree of `last_buf`. The root has no upper bound.
+    bool last_buf_is_rightmost = true;
+    store_key_t last_buf_right_bound;
     {
         // KSI: We can't acquire the block for write here -- we could, but it would
         // worsen the performance of the program -- sometimes we only end up using
@@ -408,6 +431,19 @@ void find_keyvalue_location_for_write(
                                        balancing_detacher);
         }
 
+        // Splitting or merging `buf` changes which keys can be in its subtree.
+        // Merging it might also have made it the root, in which case `last_buf`
+        // is gone.
+        bool buf_is_rightmost = true;
+        store_key_t buf_right_bound;
+        if (!last_buf.empty()
+            && (keyvalue_location_out->superblock == NULL
+                || superblock->get_root_block_id() != buf.block_id())) {
+            get_child_right_bound(&last_buf, last_buf_is_rightmost,
+                                  last_buf_right_bound, key,
+                                  &buf_is_rightmost, &buf_right_bound);
+        }
+
         // Release the superblock, if we've gone past the root (and haven't
         // already released it). If we're still at the root or at one of
         // its direct children, we might still want to replace the root, so
@@ -441,6 +477,8 @@ void find_keyvalue_location_for_write(
             last_buf = std::move(buf);
             buf = std::move(tmp);
         }
+        last_buf_is_rightmost = buf_is_rightmost;
+        last_buf_right_bound = buf_right_bound;
     }
 
     {
@@ -458,9 +496,65 @@ void find_keyvalue_location_for_write(
     }
 
     keyvalue_location_out->last_buf.swap(last_buf);
+    keyvalue_location_out->last_buf_is_rightmost = last_buf_is_rightmost;
+    keyvalue_location_out->last_buf_right_bound = last_buf_right_bound;
     keyvalue_location_out->buf.swap(buf);
 }
 
+bool find_keyvalue_location_in_same_leaf(
+        value_sizer_t *sizer,
+        const btree_key_t *last_key,
+        const btree_key_t *key,
+        keyvalue_location_t *kv_loc) {
+    rassert(btree_key_cmp(last_key, key) <= 0);
+    guarantee(!kv_loc->buf.empty());
+
+    // If the leaf node is the root, every key belongs into it.
+    if (!kv_loc->last_buf.empty()) {
+        // We still hold the superblock if the parent is the root. Merging the leaf
+        // node might have made it the root instead.
+        if (kv_loc->superblock != NULL
+            && kv_loc->superblock->get_root_block_id() != kv_loc->last_buf.block_id()) {
+            return false;
+        }
+
+        bool is_rightmost;
+        store_key_t right_bound;
+        get_child_right_bound(&kv_loc->last_buf, kv_loc->last_buf_is_rightmost,
+                              kv_loc->last_buf_right_bound, last_key,
+                              &is_rightmost, &right_bound);
+        if (!is_rightmost && btree_key_cmp(key, right_bound.btree_key()) > 0) {
+            return false;
+        }
+
+        // `find_keyvalue_location_for_write()` makes sure that the parent can take
+        // one more key, or lose one without becoming underfull. Changes to the leaf
+        // node might have used that up. (The root is never underfull.)
+        buf_read_t read(&kv_loc->last_buf);
+        auto parent = static_cast<const internal_node_t *>(read.get_data_read());
+        if (internal_node::is_full(parent)
+            || (kv_loc->superblock == NULL
+                && internal_node::is_underfull(sizer->block_size(), parent))) {
+            return false;
+        }
+    }
+
+    scoped_malloc_t<void> tmp(sizer->max_possible_size());
+    bool key_found;
+    {
+        buf_read_t read(&kv_loc->buf);
+        auto node = static_cast<const leaf_node_t *>(read.get_data_read());
+        key_found = leaf::lookup(sizer, node, key, tmp.get());
+    }
+    kv_loc->there_originally_was_value = key_found;
+    if (key_found) {
+        kv_loc->value = std::move(tmp);
+    } else {
+        kv_loc->value.reset();
+    }
+    return true;
+}
+
 void find_keyvalue_location_for_read(
         value_sizer_t *sizer,
         superblock_t *superblock, const btree_key_t *key,
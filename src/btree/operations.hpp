@@ -101,6 +101,7 @@ class keyvalue_location_t {
 public:
     keyvalue_location_t()
         : superblock(NULL), pass_back_superblock(NULL),
+          last_buf_is_rightmost(true),
           there_originally_was_value(false), stat_block(NULL_BLOCK_ID),
           stats(NULL) { }
 
@@ -117,6 +118,11 @@ public:
     // The parent buf of buf, if buf is not the root node.  This is hacky.
     buf_lock_t last_buf;
 
+    // Whether `last_buf` is on the right edge of the tree. If it isn't,
+    // `last_buf_right_bound` is the largest key that can be in its subtree.
+    bool last_buf_is_rightmost;
+    store_key_t last_buf_right_bound;
+
     // The buf owning the leaf node which contains the value.
     buf_lock_t buf;
 
@@ -203,6 +209,20 @@ void find_keyvalue_location_for_write(
         profile::trace_t *trace,
         promise_t<superblock_t *> *pass_back_superblock = NULL) THROWS_NOTHING;
 
+/* Points `kv_loc`, which `find_keyvalue_location_for_write()` has found for
+`last_key` (and which `apply_keyvalue_change()` might have been used on since), at
+`key` instead, if `key` belongs into the same leaf node. This saves descending from
+the root again. `key` must not be smaller than `last_key`. Returns false, leaving
+`kv_loc` as it is, if `key` might belong into a different leaf node, or if the
+leaf node's parent might not be able to take another split or merge of the leaf
+node. In that case, `kv_loc` has to be released and the key looked up with
+`find_keyvalue_location_for_write()`, which prepares the parent for that. */
+bool find_keyvalue_location_in_same_leaf(
+        value_sizer_t *sizer,
+        const btree_key_t *last_key,
+        const btree_key_t *key,
+        keyvalue_location_t *kv_loc);
+
 void find_keyvalue_location_for_read(
         value_sizer_t *sizer,
         superblock_t *superblock, const btree_key_t *key,
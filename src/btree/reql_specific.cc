@@ -534,6 +534,7 @@ void get_btree_superblock_and_txn_for_backfilling(
     txn_t *txn = new txn_t(cache_conn, read_access_t::read);
     txn_out->init(txn);
     txn->set_account(backfill_account);
+    txn->set_access_hint(cache_access_hint_t::scan);
 
     get_btree_superblock(txn, access_t::read, got_superblock_out);
     (*got_superblock_out)->get()->snapshot_subdag();
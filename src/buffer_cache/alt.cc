@@ -6,6 +6,7 @@
 #include "arch/runtime/coroutines.hpp"
 #include "buffer_cache/stats.hpp"
 #include "concurrency/auto_drainer.hpp"
+#include "config/args.hpp"
 #include "utils.hpp"
 
 #define ALT_DEBUG 0
@@ -87,10 +88,12 @@ cache_t::cache_t(serializer_t *serializer,
                  perfmon_collection_t *perfmon_collection)
     : throttler_(MINIMUM_SOFT_UNWRITTEN_CHANGES_LIMIT),
       page_cache_(serializer, balancer, &throttler_),
-      stats_(make_scoped<alt_cache_stats_t>(&page_cache_, perfmon_collection)) { }
+      stats_(make_scoped<alt_cache_stats_t>(&page_cache_, perfmon_collection)),
+      read_ahead_blocks_(0) { }
 
 cache_t::~cache_t() {
     guarantee(snapshot_nodes_by_block_id_.empty());
+    guarantee(read_ahead_blocks_ == 0);
 }
 
 cache_account_t cache_t::create_cache_account(int priority) {
@@ -172,6 +175,7 @@ txn_t::txn_t(cache_conn_t *cache_conn,
              read_access_t)
     : cache_(cache_conn->cache()),
       cache_account_(cache_->page_cache_.default_reads_account()),
+      access_hint_(cache_access_hint_t::normal),
       access_(access_t::read),
       durability_(write_durability_t::SOFT) {
     // Right now, cache_conn is only used to control flushing of write txns.  When we
@@ -187,6 +191,7 @@ txn_t::txn_t(cache_conn_t *cache_conn,
              int64_t expected_change_count)
     : cache_(cache_conn->cache()),
       cache_account_(cache_->page_cache_.default_reads_account()),
+      access_hint_(cache_access_hint_t::normal),
       access_(access_t::write),
       durability_(durability) {
 
@@ -246,6 +251,10 @@ void txn_t::set_account(cache_account_t *cache_account) {
     cache_account_ = cache_account;
 }
 
+void txn_t::set_access_hint(cache_access_hint_t access_hint) {
+    access_hint_ = access_hint;
+}
+
 
 alt_snapshot_node_t::alt_snapshot_node_t(scoped_ptr_t<current_page_acq_t> &&acq)
     : current_page_acq_(std::move(acq)), ref_count_(0) { }
@@ -743,21 +752,48 @@ page_t *buf_lock_t::get_held_page_for_write() {
 }
 
 buf_read_t::buf_read_t(buf_lock_t *lock)
-    : lock_(lock) {
+    : lock_(lock), reading_ahead_(false) {
     guarantee(!lock_->empty());
     lock_->access_ref_count_++;
 }
 
 buf_read_t::~buf_read_t() {
     guarantee(!lock_->empty());
+    finish_read_ahead();
     lock_->access_ref_count_--;
 }
 
+bool buf_read_t::start_loading() {
+    if (page_acq_.has()) {
+        return true;
+    }
+    cache_t *cache = lock_->cache();
+    if (!lock_->read_acq_signal()->is_pulsed()
+        || cache->read_ahead_blocks_ >= CACHE_READ_AHEAD_BUDGET_BLOCKS) {
+        return false;
+    }
+    // Doesn't block, because the read acquisition signal is already pulsed.
+    page_t *page = lock_->get_held_page_for_read();
+    page_acq_.init(page, &cache->page_cache_,
+                   lock_->txn()->account(), lock_->txn()->access_hint());
+    reading_ahead_ = true;
+    ++cache->read_ahead_blocks_;
+    return true;
+}
+
+void buf_read_t::finish_read_ahead() {
+    if (reading_ahead_) {
+        reading_ahead_ = false;
+        --lock_->cache()->read_ahead_blocks_;
+    }
+}
+
 const void *buf_read_t::get_data_read(uint32_t *block_size_out) {
+    finish_read_ahead();
     page_t *page = lock_->get_held_page_for_read();
     if (!page_acq_.has()) {
         page_acq_.init(page, &lock_->cache()->page_cache_,
-                       lock_->txn()->account());
+                       lock_->txn()->account(), lock_->txn()->access_hint());
     }
     page_acq_.buf_ready_signal()->wait();
     *block_size_out = page_acq_.get_buf_size().value();
@@ -779,7 +815,7 @@ void *buf_write_t::get_data_write(uint32_t block_size) {
     page_t *page = lock_->get_held_page_for_write();
     if (!page_acq_.has()) {
         page_acq_.init(page, &lock_->cache()->page_cache_,
-                       lock_->txn()->account());
+                       lock_->txn()->account(), lock_->txn()->access_hint());
     }
     page_acq_.buf_ready_signal()->wait();
     return page_acq_.get_buf_write(block_size_t::make_from_cache(block_size));
@@ -54,6 +54,10 @@ public:
     // might consider supporting a mem_cap paremeter.
     cache_account_t create_cache_account(int priority);
 
+    // The number of blocks that are being read ahead right now (see
+    // `buf_read_t::start_loading()`).
+    int64_t read_ahead_blocks() const { return read_ahead_blocks_; }
+
 private:
     friend class txn_t;
     friend class buf_read_t;
@@ -75,6 +79,12 @@ private:
     std::map<block_id_t, intrusive_list_t<alt_snapshot_node_t> >
         snapshot_nodes_by_block_id_;
 
+    // The number of buf_read_t's that have started loading their block ahead of
+    // time but haven't been read from yet.  Bounded by
+    // CACHE_READ_AHEAD_BUDGET_BLOCKS, so that many concurrent scans can't pin most
+    // of the cache with blocks they might never get to.
+    int64_t read_ahead_blocks_;
+
     DISABLE_COPYING(cache_t);
 };
 
@@ -97,6 +107,10 @@ public:
     void set_account(cache_account_t *cache_account);
     cache_account_t *account() { return cache_account_; }
 
+    // Pages acquired after this is called get acquired with the given hint.
+    void set_access_hint(cache_access_hint_t access_hint);
+    cache_access_hint_t access_hint() const { return access_hint_; }
+
 private:
     // Resets the *throttler_acq parameter.
     static void inform_tracker(cache_t *cache,
@@ -118,6 +132,9 @@ private:
     // set_account().
     cache_account_t *cache_account_;
 
+    // Initialized to cache_access_hint_t::normal, and modified by set_access_hint().
+    cache_access_hint_t access_hint_;
+
     const access_t access_;
 
     // Only applicable if access_ == write.
@@ -315,6 +332,12 @@ public:
     explicit buf_read_t(buf_lock_t *lock);
     ~buf_read_t();
 
+    // Starts loading the block, without waiting for it, if the lock has already
+    // been read-acquired and the cache's read-ahead budget allows it.  Returns true
+    // if the load was started (or the block was already requested).  A later
+    // get_data_read() then finds the block loaded, or at least on its way.
+    bool start_loading();
+
     const void *get_data_read(uint32_t *block_size_out);
     const void *get_data_read() {
         uint32_t block_size;
@@ -324,8 +347,12 @@ public:
     }
 
 private:
+    void finish_read_ahead();
+
     buf_lock_t *lock_;
     alt::page_acq_t page_acq_;
+    // True if start_loading() counted this against the cache's read-ahead budget.
+    bool reading_ahead_;
 
     DISABLE_COPYING(buf_read_t);
 };
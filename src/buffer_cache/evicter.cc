@@ -4,6 +4,7 @@
 #include "buffer_cache/page.hpp"
 #include "buffer_cache/page_cache.hpp"
 #include "buffer_cache/cache_balancer.hpp"
+#include "config/args.hpp"
 
 namespace alt {
 
@@ -153,7 +154,9 @@ void evicter_t::add_to_evictable_unbacked(page_t *page) {
 void evicter_t::add_to_evictable_disk_backed(page_t *page) {
     assert_thread();
     guarantee(initialized_);
-    evictable_disk_backed_.add(page, page->hypothetical_memory_usage(page_cache_));
+    // Read-ahead pages haven't been acquired yet.
+    rassert(!page->is_protected());
+    evictable_probationary_.add(page, page->hypothetical_memory_usage(page_cache_));
     evict_if_necessary();
     notify_bytes_loading(page->hypothetical_memory_usage(page_cache_));
 }
@@ -164,7 +167,8 @@ void evicter_t::move_unevictable_to_evictable(page_t *page) {
     rassert(unevictable_.has_page(page));
     unevictable_.remove(page, page->hypothetical_memory_usage(page_cache_));
     eviction_bag_t *new_bag = correct_eviction_category(page);
-    rassert(new_bag == &evictable_disk_backed_
+    rassert(new_bag == &evictable_probationary_
+            || new_bag == &evictable_protected_
             || new_bag == &evictable_unbacked_);
     new_bag->add(page, page->hypothetical_memory_usage(page_cache_));
     evict_if_necessary();
@@ -189,7 +193,7 @@ eviction_bag_t *evicter_t::correct_eviction_category(page_t *page) {
     } else if (!page->is_loaded()) {
         return &evicted_;
     } else if (page->is_disk_backed()) {
-        return &evictable_disk_backed_;
+        return page->is_protected() ? &evictable_protected_ : &evictable_probationary_;
     } else {
         return &evictable_unbacked_;
     }
@@ -208,10 +212,25 @@ uint64_t evicter_t::in_memory_size() const {
     assert_thread();
     guarantee(initialized_);
     return unevictable_.size()
-        + evictable_disk_backed_.size()
+        + evictable_probationary_.size()
+        + evictable_protected_.size()
         + evictable_unbacked_.size();
 }
 
+void evicter_t::demote_protected_if_necessary() {
+    const uint64_t protected_limit
+        = memory_limit_ / 100 * CACHE_PROTECTED_SEGMENT_PERCENT;
+    page_t *page;
+    while (evictable_protected_.size() > protected_limit
+           && evictable_protected_.remove_oldish(&page, access_time_counter_,
+                                                 page_cache_)) {
+        // The page has to be used once more to get protected again.
+        page->is_protected_ = false;
+        evictable_probationary_.add(page,
+                                    page->hypothetical_memory_usage(page_cache_));
+    }
+}
+
 void evicter_t::evict_if_necessary() THROWS_NOTHING {
     assert_thread();
     guarantee(initialized_);
@@ -228,10 +247,14 @@ void evicter_t::evict_if_necessary() THROWS_NOTHING {
     // currently being written for the purpose of eviction.
 
     evict_if_necessary_active_ = true;
+    demote_protected_if_necessary();
     page_t *page;
+    // We only evict protected pages once there are no probationary ones left.
     while (in_memory_size() > memory_limit_
-           && evictable_disk_backed_.remove_oldish(&page, access_time_counter_,
-                                                   page_cache_)) {
+           && (evictable_probationary_.remove_oldish(&page, access_time_counter_,
+                                                     page_cache_)
+               || evictable_protected_.remove_oldish(&page, access_time_counter_,
+                                                     page_cache_))) {
         evicted_.add(page, page->hypothetical_memory_usage(page_cache_));
         page->evict_self(page_cache_);
         page_cache_->consider_evicting_current_page(page->block_id());
@@ -71,6 +71,10 @@ private:
     // Evicts any evictable pages until under the memory limit
     void evict_if_necessary() THROWS_NOTHING;
 
+    // Moves oldish pages from the protected segment to the probationary segment
+    // until the protected segment fits in its share of the memory limit.
+    void demote_protected_if_necessary();
+
     bool initialized_;
     page_cache_t *page_cache_;
     cache_balancer_t *balancer_;
@@ -93,9 +97,16 @@ private:
     // It avoids reentrant calls to that function.
     bool evict_if_necessary_active_;
 
-    // These track every page's eviction status.
+    // These track every page's eviction status.  Evictable disk-backed pages are
+    // split into two segments, so that a scan loading lots of pages that are used
+    // once can't push out the pages that get used over and over again.  Pages start
+    // out probationary and are protected once they've been acquired twice (see
+    // page_t::add_waiter).  We evict probationary pages first, and the protected
+    // segment is kept to CACHE_PROTECTED_SEGMENT_PERCENT of the memory limit by
+    // demoting its oldish pages back to probation.
     eviction_bag_t unevictable_;
-    eviction_bag_t evictable_disk_backed_;
+    eviction_bag_t evictable_probationary_;
+    eviction_bag_t evictable_protected_;
     eviction_bag_t evictable_unbacked_;
     eviction_bag_t evicted_;
 
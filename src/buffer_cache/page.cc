@@ -56,6 +56,8 @@ page_t::page_t(block_id_t block_id, page_cache_t *page_cache)
     : block_id_(block_id),
       loader_(NULL),
       access_time_(page_cache->evicter().next_access_time()),
+      was_accessed_(false),
+      is_protected_(false),
       snapshot_refcount_(0) {
     page_cache->evicter().add_deferred_loaded(this);
 
@@ -70,6 +72,8 @@ page_t::page_t(block_id_t block_id, page_cache_t *page_cache,
     : block_id_(block_id),
       loader_(NULL),
       access_time_(page_cache->evicter().next_access_time()),
+      was_accessed_(false),
+      is_protected_(false),
       snapshot_refcount_(0) {
     page_cache->evicter().add_not_yet_loaded(this);
 
@@ -86,6 +90,8 @@ page_t::page_t(block_id_t block_id, buf_ptr_t buf,
       loader_(NULL),
       buf_(std::move(buf)),
       access_time_(page_cache->evicter().next_access_time()),
+      was_accessed_(false),
+      is_protected_(false),
       snapshot_refcount_(0) {
     rassert(buf_.has());
     page_cache->evicter().add_to_evictable_unbacked(this);
@@ -100,6 +106,8 @@ page_t::page_t(block_id_t block_id,
       buf_(std::move(buf)),
       block_token_(block_token),
       access_time_(READ_AHEAD_ACCESS_TIME),
+      was_accessed_(false),
+      is_protected_(false),
       snapshot_refcount_(0) {
     rassert(buf_.has());
     page_cache->evicter().add_to_evictable_disk_backed(this);
@@ -109,6 +117,8 @@ page_t::page_t(page_t *copyee, page_cache_t *page_cache, cache_account_t *accoun
     : block_id_(copyee->block_id_),
       loader_(NULL),
       access_time_(page_cache->evicter().next_access_time()),
+      was_accessed_(false),
+      is_protected_(false),
       snapshot_refcount_(0) {
     page_cache->evicter().add_not_yet_loaded(this);
     coro_t::spawn_now_dangerously(std::bind(&page_t::load_from_copyee,
@@ -146,7 +156,8 @@ void page_t::load_from_copyee(page_t *page, page_t *copyee,
     // Okay, it's safe to block.
     {
         page_acq_t acq;
-        acq.init(copyee, page_cache, account);
+        // Copying the page for a writer isn't another use of the old version.
+        acq.init(copyee, page_cache, account, cache_access_hint_t::scan);
         acq.buf_ready_signal()->wait();
 
         ASSERT_FINITE_CORO_WAITING;
@@ -268,11 +279,15 @@ void page_t::catch_up_with_deferred_load(
         // We use the fact that on_thread_t preserves order with the on_thread_t in
         // deferred_load_with_block_id.  This means that it's already run its section
         // on the serializer thread, and has initialized block_token_ptr->token.
-        on_thread_t th(serializer->home_thread());
-        // Now finish what the rest of load_with_block_id would do.
-        rassert(block_token_ptr->token.has());
-        buf = serializer->block_read(block_token_ptr->token,
-                                     account->get());
+        const ticks_t start_time = get_ticks();
+        {
+            on_thread_t th(serializer->home_thread());
+            // Now finish what the rest of load_with_block_id would do.
+            rassert(block_token_ptr->token.has());
+            buf = serializer->block_read(block_token_ptr->token,
+                                         account->get());
+        }
+        page_cache->miss_latency()->record(get_ticks() - start_time);
     }
 
     ASSERT_FINITE_CORO_WAITING;
@@ -351,11 +366,15 @@ void page_t::load_with_block_id(page_t *page, block_id_t block_id,
 
     {
         serializer_t *const serializer = page_cache->serializer();
-        on_thread_t th(serializer->home_thread());
-        block_token = serializer->index_read(block_id);
-        rassert(block_token.has());
-        buf = serializer->block_read(block_token,
-                                     account->get());
+        const ticks_t start_time = get_ticks();
+        {
+            on_thread_t th(serializer->home_thread());
+            block_token = serializer->index_read(block_id);
+            rassert(block_token.has());
+            buf = serializer->block_read(block_token,
+                                         account->get());
+        }
+        page_cache->miss_latency()->record(get_ticks() - start_time);
     }
 
     ASSERT_FINITE_CORO_WAITING;
@@ -410,11 +429,21 @@ void page_t::pulse_waiters_or_make_evictable(page_cache_t *page_cache) {
     }
 }
 
-void page_t::add_waiter(page_acq_t *acq, cache_account_t *account) {
+void page_t::add_waiter(page_acq_t *acq, cache_account_t *account,
+                        cache_access_hint_t hint) {
     eviction_bag_t *old_bag
         = acq->page_cache()->evicter().correct_eviction_category(this);
     waiters_.push_front(acq);
     acq->page_cache()->evicter().change_to_correct_eviction_bag(old_bag, this);
+    // We're in the unevictable bag now, so promoting the page doesn't change its
+    // eviction bag until the last waiter goes away.
+    if (hint == cache_access_hint_t::normal) {
+        if (was_accessed_) {
+            is_protected_ = true;
+        } else {
+            was_accessed_ = true;
+        }
+    }
     if (buf_.has()) {
         acq->buf_ready_signal_.pulse();
     } else if (loader_ != NULL) {
@@ -449,9 +478,13 @@ void page_t::load_using_block_token(page_t *page, page_cache_t *page_cache,
     {
         serializer_t *const serializer = page_cache->serializer();
 
-        on_thread_t th(serializer->home_thread());
-        buf = serializer->block_read(block_token,
-                                     account->get());
+        const ticks_t start_time = get_ticks();
+        {
+            on_thread_t th(serializer->home_thread());
+            buf = serializer->block_read(block_token,
+                                         account->get());
+        }
+        page_cache->miss_latency()->record(get_ticks() - start_time);
     }
 
     ASSERT_FINITE_CORO_WAITING;
@@ -575,13 +608,13 @@ page_acq_t::page_acq_t() : page_(NULL), page_cache_(NULL) {
 }
 
 void page_acq_t::init(page_t *page, page_cache_t *page_cache,
-                      cache_account_t *account) {
+                      cache_account_t *account, cache_access_hint_t hint) {
     rassert(page_ == NULL);
     rassert(page_cache_ == NULL);
     rassert(!buf_ready_signal_.is_pulsed());
     page_ = page;
     page_cache_ = page_cache;
-    page_->add_waiter(this, account);
+    page_->add_waiter(this, account, hint);
 }
 
 page_acq_t::~page_acq_t() {
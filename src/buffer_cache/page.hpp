@@ -1,6 +1,7 @@
 #ifndef BUFFER_CACHE_PAGE_HPP_
 #define BUFFER_CACHE_PAGE_HPP_
 
+#include "buffer_cache/types.hpp"
 #include "concurrency/cond_var.hpp"
 #include "containers/backindex_bag.hpp"
 #include "containers/half_intrusive_list.hpp"
@@ -39,7 +40,8 @@ public:
 
     page_t *make_copy(page_cache_t *page_cache, cache_account_t *account);
 
-    void add_waiter(page_acq_t *acq, cache_account_t *account);
+    void add_waiter(page_acq_t *acq, cache_account_t *account,
+                    cache_access_hint_t hint);
     void remove_waiter(page_acq_t *acq);
 
     // These may not be called until the page_acq_t's buf_ready_signal is pulsed.
@@ -55,6 +57,7 @@ public:
 
     uint32_t hypothetical_memory_usage(page_cache_t *page_cache) const;
     uint64_t access_time() const { return access_time_; }
+    bool is_protected() const { return is_protected_; }
 
     bool is_loading() const {
         return loader_ != NULL && page_t::loader_is_loading(loader_);
@@ -83,6 +86,8 @@ public:
 private:
     friend class page_ptr_t;
     friend class deferred_page_loader_t;
+    // Demotes pages from the protected segment.
+    friend class evicter_t;
     static bool loader_is_loading(page_loader_t *loader);
     void add_snapshotter();
     void remove_snapshotter(page_cache_t *page_cache);
@@ -132,6 +137,14 @@ private:
 
     uint64_t access_time_;
 
+    // Set the first time the page gets acquired without a scan hint.  The next such
+    // acquisition sets is_protected_, which moves the page into the evicter's
+    // protected segment (once it becomes evictable again).  Both flags outlive the
+    // page's buffer being evicted, so a page that was in use when it got evicted
+    // is protected again as soon as it's reloaded and used.
+    bool was_accessed_;
+    bool is_protected_;
+
     // How many page_ptr_t's point at this page, expecting nothing to modify it,
     // other than themselves.
     size_t snapshot_refcount_;
@@ -146,11 +159,12 @@ private:
     // if loader_ is non-null:  unevictable_pages_
     // else if waiters_ is non-empty: unevictable_pages_
     // else if buf_ is null: evicted_pages_ (and block_token_ is non-null)
-    // else if block_token_ is non-null: evictable_disk_backed_pages_
+    // else if block_token_ is non-null: evictable_protected_pages_ if
+    //     is_protected_ is true, evictable_probationary_pages_ otherwise
     // else: evictable_unbacked_pages_ (buf_ is non-null, block_token_ is null)
     //
-    // So, when loader_, waiters_, buf_, or block_token_ is touched, we might
-    // need to change this page's eviction bag.
+    // So, when loader_, waiters_, buf_, block_token_, or is_protected_ is touched, we
+    // might need to change this page's eviction bag.
     //
     // The logic above is implemented in page_cache_t::correct_eviction_category.
     backindex_bag_index_t eviction_index_;
@@ -227,7 +241,8 @@ public:
     page_acq_t();
     ~page_acq_t();
 
-    void init(page_t *page, page_cache_t *page_cache, cache_account_t *account);
+    void init(page_t *page, page_cache_t *page_cache, cache_account_t *account,
+              cache_access_hint_t hint);
 
     page_cache_t *page_cache() const {
         rassert(page_cache_ != NULL);
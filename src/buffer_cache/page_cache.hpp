@@ -22,6 +22,7 @@
 #include "containers/backindex_bag.hpp"
 #include "containers/intrusive_list.hpp"
 #include "containers/segmented_vector.hpp"
+#include "perfmon/perfmon.hpp"
 #include "repli_timestamp.hpp"
 #include "serializer/types.hpp"
 
@@ -349,6 +350,8 @@ public:
 
     evicter_t &evicter() { return evicter_; }
 
+    perfmon_histogram_t *miss_latency() { return &miss_latency_; }
+
     auto_drainer_t::lock_t drainer_lock() { return drainer_->lock(); }
     serializer_t *serializer() { return serializer_; }
 
@@ -443,6 +446,10 @@ private:
 
     evicter_t evicter_;
 
+    // How long it takes to read a page from the serializer on a cache miss.  This
+    // must outlive `drainer_`, because loading pages hold a lock on it.
+    perfmon_histogram_t miss_latency_;
+
     // KSI: I bet this read_ahead_cb_ and read_ahead_cb_existence_ type could be
     // packaged in some new cross_thread_ptr type.
     page_read_ahead_cb_t *read_ahead_cb_;
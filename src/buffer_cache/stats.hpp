@@ -28,6 +28,8 @@ public:
     perfmon_value_t in_use_bytes;
     perfmon_membership_t in_use_bytes_membership;
 
+    perfmon_membership_t miss_latency_membership;
+
 
     perfmon_multi_membership_t cache_collection_membership;
 };
@@ -14,6 +14,12 @@ ARCHIVE_PRIM_MAKE_RANGED_SERIALIZABLE(write_durability_t, int8_t,
                                       write_durability_t::SOFT,
                                       write_durability_t::HARD);
 
+// How a transaction's acquisitions should count towards the cache keeping pages
+// around.  Pages acquired more than once with `normal` are moved into the
+// evicter's protected segment.  Range scans and backfills touch most of the pages
+// they read exactly once, so they use `scan` so that they don't push the working
+// set of the other queries out of the cache.
+enum class cache_access_hint_t { normal, scan };
 
 typedef uint32_t block_magic_comparison_t;
 
@@ -657,6 +657,7 @@ void run_rethinkdb_create(const base_path_t &base_path,
                           boost::optional<uint64_t> total_cache_size,
                           const file_direct_io_mode_t direct_io_mode,
                           const int max_concurrent_io_requests,
+                          const file_io_backend_t io_backend,
                           bool *const result_out) {
     server_id_t our_server_id = generate_uuid();
 
@@ -673,7 +674,7 @@ void run_rethinkdb_create(const base_path_t &base_path,
     cluster_metadata.servers.servers.insert(
         std::make_pair(our_server_id, make_deletable(server_semilattice_metadata)));
 
-    io_backender_t io_backender(direct_io_mode, max_concurrent_io_requests);
+    io_backender_t io_backender(direct_io_mode, max_concurrent_io_requests, io_backend);
 
     perfmon_collection_t metadata_perfmon_collection;
     perfmon_membership_t metadata_perfmon_membership(&get_global_perfmon_collection(), &metadata_perfmon_collection, "metadata");
@@ -724,6 +725,7 @@ void run_rethinkdb_serve(const base_path_t &base_path,
                          serve_info_t *serve_info,
                          const file_direct_io_mode_t direct_io_mode,
                          const int max_concurrent_io_requests,
+                         const file_io_backend_t io_backend,
                          const boost::optional<boost::optional<uint64_t> >
                             &total_cache_size,
                          const server_id_t *our_server_id,
@@ -736,7 +738,7 @@ void run_rethinkdb_serve(const base_path_t &base_path,
 
     logNTC("Loading data from directory %s\n", base_path.path().c_str());
 
-    io_backender_t io_backender(direct_io_mode, max_concurrent_io_requests);
+    io_backender_t io_backender(direct_io_mode, max_concurrent_io_requests, io_backend);
 
     perfmon_collection_t metadata_perfmon_collection;
     perfmon_membership_t metadata_perfmon_membership(&get_global_perfmon_collection(), &metadata_perfmon_collection, "metadata");
@@ -810,6 +812,7 @@ void run_rethinkdb_porcelain(const base_path_t &base_path,
                              const std::set<name_string_t> &server_tag_names,
                              const file_direct_io_mode_t direct_io_mode,
                              const int max_concurrent_io_requests,
+                             const file_io_backend_t io_backend,
                              const boost::optional<boost::optional<uint64_t> >
                                 &total_cache_size,
                              const bool new_directory,
@@ -818,7 +821,7 @@ void run_rethinkdb_porcelain(const base_path_t &base_path,
                              bool *const result_out) {
     if (!new_directory) {
         run_rethinkdb_serve(base_path, serve_info, direct_io_mode,
-                            max_concurrent_io_requests, total_cache_size,
+                            max_concurrent_io_requests, io_backend, total_cache_size,
                             NULL, NULL, data_directory_lock,
                             result_out);
     } else {
@@ -860,7 +863,7 @@ void run_rethinkdb_porcelain(const base_path_t &base_path,
         }
 
         run_rethinkdb_serve(base_path, serve_info, direct_io_mode,
-                            max_concurrent_io_requests,
+                            max_concurrent_io_requests, io_backend,
                             boost::optional<boost::optional<uint64_t> >(),
                             &our_server_id, &cluster_metadata,
                             data_directory_lock, result_out);
@@ -919,6 +922,17 @@ options::help_section_t get_file_options(std::vector<options::option_t> *options
                                              strprintf("%d", DEFAULT_MAX_CONCURRENT_IO_REQUESTS)));
     help.add("--io-threads n",
              "how many simultaneous I/O operations can happen at the same time");
+    options_out->push_back(options::option_t(options::names_t("--io-backend"),
+                                             options::OPTIONAL,
+                                             "pool"));
+    help.add("--io-backend {pool | io_uring}",
+             "how disk I/O is submitted to the kernel: through a pool of blocking "
+             "threads, or through io_uring (Linux only; works best with --direct-io)");
+    options_out->push_back(options::option_t(options::names_t("--block-compression"),
+                                             options::OPTIONAL,
+                                             "none"));
+    help.add("--block-compression {none | lz4}",
+             "how newly written table data blocks are compressed on disk");
     options_out->push_back(options::option_t(options::names_t("--no-direct-io"),
                                              options::OPTIONAL_NO_PARAMETER));
     // `--no-direct-io` is deprecated (it's now the default). Not adding to help.
@@ -1104,6 +1118,10 @@ options::help_section_t get_cpu_options(std::vector<options::option_t> *options_
                                              options::OPTIONAL,
                                              strprintf("%d", get_cpu_count())));
     help.add("-c [ --cores ] n", "the number of cores to use");
+    options_out->push_back(options::option_t(options::names_t("--pin-threads"),
+                                             options::OPTIONAL_NO_PARAMETER));
+    help.add("--pin-threads", "pin each thread to a core, spread the threads evenly "
+             "over the NUMA nodes, and keep each table's shards on a single node");
     return help;
 }
 
@@ -1266,6 +1284,35 @@ MUST_USE bool parse_io_threads_option(const std::map<std::string, options::value
     return true;
 }
 
+MUST_USE bool parse_io_backend_option(const std::map<std::string, options::values_t> &opts,
+                                      file_io_backend_t *io_backend_out) {
+    const std::string io_backend = get_single_option(opts, "--io-backend");
+    if (io_backend == "pool") {
+        *io_backend_out = file_io_backend_t::blocker_pool;
+    } else if (io_backend == "io_uring") {
+        *io_backend_out = file_io_backend_t::io_uring;
+    } else {
+        fprintf(stderr, "ERROR: io-backend must be either 'pool' or 'io_uring'\n");
+        return false;
+    }
+    return true;
+}
+
+MUST_USE bool parse_block_compression_option(
+        const std::map<std::string, options::values_t> &opts,
+        block_compression_t *block_compression_out) {
+    const std::string block_compression = get_single_option(opts, "--block-compression");
+    if (block_compression == "none") {
+        *block_compression_out = block_compression_t::none;
+    } else if (block_compression == "lz4") {
+        *block_compression_out = block_compression_t::lz4;
+    } else {
+        fprintf(stderr, "ERROR: block-compression must be either 'none' or 'lz4'\n");
+        return false;
+    }
+    return true;
+}
+
 update_check_t parse_update_checking_option(const std::map<std::string, options::values_t> &opts) {
     return exists_option(opts, "--no-update-check")
         ? update_check_t::do_not_perform
@@ -1312,6 +1359,11 @@ int main_rethinkdb_create(int argc, char *argv[]) {
             return EXIT_FAILURE;
         }
 
+        file_io_backend_t io_backend;
+        if (!parse_io_backend_option(opts, &io_backend)) {
+            return EXIT_FAILURE;
+        }
+
         const int num_workers = get_cpu_count();
 
         bool is_new_directory = false;
@@ -1337,6 +1389,7 @@ int main_rethinkdb_create(int argc, char *argv[]) {
                                      total_cache_size,
                                      direct_io_mode,
                                      max_concurrent_io_requests,
+                                     io_backend,
                                      &result),
                            num_workers);
 
@@ -1427,6 +1480,16 @@ int main_rethinkdb_serve(int argc, char *argv[]) {
             return EXIT_FAILURE;
         }
 
+        file_io_backend_t io_backend;
+        if (!parse_io_backend_option(opts, &io_backend)) {
+            return EXIT_FAILURE;
+        }
+
+        block_compression_t block_compression;
+        if (!parse_block_compression_option(opts, &block_compression)) {
+            return EXIT_FAILURE;
+        }
+
         update_check_t do_update_checking = parse_update_checking_option(opts);
 
         boost::optional<boost::optional<uint64_t> > total_cache_size =
@@ -1463,7 +1526,8 @@ int main_rethinkdb_serve(int argc, char *argv[]) {
                                 do_update_checking,
                                 address_ports,
                                 get_optional_option(opts, "--config-file"),
-                                std::vector<std::string>(argv, argv + argc));
+                                std::vector<std::string>(argv, argv + argc),
+                                block_compression);
 
         const file_direct_io_mode_t direct_io_mode = parse_direct_io_mode_option(opts);
 
@@ -1473,12 +1537,14 @@ int main_rethinkdb_serve(int argc, char *argv[]) {
                                      &serve_info,
                                      direct_io_mode,
                                      max_concurrent_io_requests,
+                                     io_backend,
                                      total_cache_size,
                                      static_cast<server_id_t*>(NULL),
                                      static_cast<cluster_semilattice_metadata_t*>(NULL),
                                      &data_directory_lock,
                                      &result),
-                           num_workers);
+                           num_workers,
+                           exists_option(opts, "--pin-threads"));
         return result ? EXIT_SUCCESS : EXIT_FAILURE;
     } catch (const options::named_error_t &ex) {
         output_named_error(ex, help);
@@ -1546,7 +1612,8 @@ int main_rethinkdb_proxy(int argc, char *argv[]) {
                                 update_check_t::do_not_perform,
                                 address_ports,
                                 get_optional_option(opts, "--config-file"),
-                                std::vector<std::string>(argv, argv + argc));
+                                std::vector<std::string>(argv, argv + argc),
+                                block_compression_t::none);
 
         bool result;
         run_in_thread_pool(std::bind(&run_rethinkdb_proxy, &serve_info, &result),
@@ -1657,6 +1724,16 @@ int main_rethinkdb_porcelain(int argc, char *argv[]) {
             return EXIT_FAILURE;
         }
 
+        file_io_backend_t io_backend;
+        if (!parse_io_backend_option(opts, &io_backend)) {
+            return EXIT_FAILURE;
+        }
+
+        block_compression_t block_compression;
+        if (!parse_block_compression_option(opts, &block_compression)) {
+            return EXIT_FAILURE;
+        }
+
         update_check_t do_update_checking = parse_update_checking_option(opts);
 
         // Attempt to create the directory early so that the log file can use it.
@@ -1713,7 +1790,8 @@ int main_rethinkdb_porcelain(int argc, char *argv[]) {
                                 do_update_checking,
                                 address_ports,
                                 get_optional_option(opts, "--config-file"),
-                                std::vector<std::string>(argv, argv + argc));
+                                std::vector<std::string>(argv, argv + argc),
+                                block_compression);
 
         const file_direct_io_mode_t direct_io_mode = parse_direct_io_mode_option(opts);
 
@@ -1724,12 +1802,14 @@ int main_rethinkdb_porcelain(int argc, char *argv[]) {
                                      server_tag_names,
                                      direct_io_mode,
                                      max_concurrent_io_requests,
+                                     io_backend,
                                      total_cache_size,
                                      is_new_directory,
                                      &serve_info,
                                      &data_directory_lock,
                                      &result),
-                           num_workers);
+                           num_workers,
+                           exists_option(opts, "--pin-threads"));
 
         return result ? EXIT_SUCCESS : EXIT_FAILURE;
     } catch (const options::named_error_t &ex) {
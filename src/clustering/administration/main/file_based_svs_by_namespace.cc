@@ -123,10 +123,14 @@ file_based_svs_by_namespace_t::get_svs(
         = stores_out->stores();
     stores_out_stores->init(num_stores);
 
+    // The stores all share the serializer, and each store's cache is allocated on
+    // its own thread. So if threads are pinned, we keep them all on the serializer
+    // thread's NUMA node.
     const threadnum_t serializer_thread = next_thread(num_db_threads);
+    const int numa_node = get_thread_numa_node(serializer_thread);
     std::vector<threadnum_t> store_threads;
     for (int i = 0; i < num_stores; ++i) {
-        store_threads.push_back(next_thread(num_db_threads));
+        store_threads.push_back(next_thread_on_numa_node(num_db_threads, numa_node));
     }
 
     scoped_ptr_t<serializer_t> serializer;
@@ -143,6 +147,8 @@ file_based_svs_by_namespace_t::get_svs(
                                 serializers_perfmon_collection, ctx,
                                 &outdated_index_tracker, namespace_id);
         filepath_file_opener_t file_opener(serializer_filepath, io_backender_);
+        standard_serializer_t::dynamic_config_t serializer_config;
+        serializer_config.compression = block_compression_;
         if (res == 0) {
             // TODO: Could we handle failure when loading the serializer?  Right
             // now, we don't.
@@ -150,11 +156,12 @@ file_based_svs_by_namespace_t::get_svs(
             {
                 scoped_ptr_t<serializer_t> ser
                     = make_scoped<standard_serializer_t>(
-                        standard_serializer_t::dynamic_config_t(),
+                        serializer_config,
                         &file_opener,
                         serializers_perfmon_collection);
                 ser = make_scoped<merger_serializer_t>(std::move(ser),
-                                                       MERGER_SERIALIZER_MAX_ACTIVE_WRITES);
+                                                       MERGER_SERIALIZER_MAX_ACTIVE_WRITES,
+                                                       serializers_perfmon_collection);
                 serializer = std::move(ser);
             }
 
@@ -176,11 +183,12 @@ file_based_svs_by_namespace_t::get_svs(
             {
                 scoped_ptr_t<serializer_t> ser
                     = make_scoped<standard_serializer_t>(
-                        standard_serializer_t::dynamic_config_t(),
+                        serializer_config,
                         &file_opener,
                         serializers_perfmon_collection);
                 ser = make_scoped<merger_serializer_t>(std::move(ser),
-                                                       MERGER_SERIALIZER_MAX_ACTIVE_WRITES);
+                                                       MERGER_SERIALIZER_MAX_ACTIVE_WRITES,
+                                                       serializers_perfmon_collection);
                 serializer = std::move(ser);
             }
 
@@ -242,3 +250,14 @@ threadnum_t file_based_svs_by_namespace_t::next_thread(int num_db_threads) {
     thread_counter_ = (thread_counter_ + 1) % num_db_threads;
     return threadnum_t(thread_counter_);
 }
+
+threadnum_t file_based_svs_by_namespace_t::next_thread_on_numa_node(int num_db_threads,
+                                                                    int numa_node) {
+    for (int i = 0; i < num_db_threads; ++i) {
+        threadnum_t thread = next_thread(num_db_threads);
+        if (numa_node == -1 || get_thread_numa_node(thread) == numa_node) {
+            return thread;
+        }
+    }
+    return next_thread(num_db_threads);
+}
@@ -6,6 +6,7 @@
 
 #include "clustering/administration/reactor_driver.hpp"
 #include "clustering/administration/issues/outdated_index.hpp"
+#include "serializer/log/block_compression.hpp"
 
 class cache_balancer_t;
 class rdb_context_t;
@@ -15,9 +16,11 @@ public:
     file_based_svs_by_namespace_t(io_backender_t *io_backender,
                                   cache_balancer_t *balancer,
                                   const base_path_t& base_path,
-                                  local_issue_aggregator_t *local_issue_aggregator)
+                                  local_issue_aggregator_t *local_issue_aggregator,
+                                  block_compression_t block_compression)
         : io_backender_(io_backender), balancer_(balancer),
-          base_path_(base_path), thread_counter_(0),
+          base_path_(base_path), block_compression_(block_compression),
+          thread_counter_(0),
           outdated_index_tracker(local_issue_aggregator) { }
 
     void get_svs(perfmon_collection_t *serializers_perfmon_collection,
@@ -34,8 +37,12 @@ private:
     io_backender_t *io_backender_;
     cache_balancer_t *balancer_;
     const base_path_t base_path_;
+    const block_compression_t block_compression_;
 
     threadnum_t next_thread(int num_db_threads);
+    // Like `next_thread`, but skips threads that aren't on the given NUMA node
+    // (unless `numa_node` is -1, or there are no such threads).
+    threadnum_t next_thread_on_numa_node(int num_db_threads, int numa_node);
     int thread_counter_; // should only be used by `next_thread`
 
     outdated_index_issue_tracker_t outdated_index_tracker;
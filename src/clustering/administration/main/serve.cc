@@ -115,7 +115,7 @@ bool do_serve(io_backender_t *io_backender,
 
         connectivity_cluster_t connectivity_cluster;
 
-        mailbox_manager_t mailbox_manager(&connectivity_cluster, 'M');
+        mailbox_manager_t mailbox_manager(&connectivity_cluster, 'M', 'B');
 
         semilattice_manager_t<cluster_semilattice_metadata_t>
             semilattice_manager_cluster(&connectivity_cluster, 'S', cluster_metadata);
@@ -275,7 +275,9 @@ bool do_serve(io_backender_t *io_backender,
                               NULL,   /* we'll fill this in later */
                               semilattice_manager_auth.get_root_view(),
                               &get_global_perfmon_collection(),
-                              serve_info.reql_http_proxy);
+                              serve_info.reql_http_proxy,
+                              io_backender,
+                              base_path);
         jobs_manager.set_rdb_context(&rdb_ctx);
 
         real_reql_cluster_interface_t real_reql_cluster_interface(
@@ -331,7 +333,7 @@ bool do_serve(io_backender_t *io_backender,
             if (i_am_a_server) {
                 rdb_svs_source.init(new file_based_svs_by_namespace_t(
                     io_backender, cache_balancer.get(), base_path,
-                    &local_issue_aggregator));
+                    &local_issue_aggregator, serve_info.block_compression));
                 rdb_reactor_driver.init(new reactor_driver_t(
                         base_path,
                         io_backender,
@@ -11,6 +11,7 @@
 #include "clustering/administration/persist.hpp"
 #include "clustering/administration/main/version_check.hpp"
 #include "arch/address.hpp"
+#include "serializer/log/block_compression.hpp"
 
 class os_signal_cond_t;
 
@@ -95,14 +96,16 @@ public:
                  update_check_t _do_version_checking,
                  service_address_ports_t _ports,
                  boost::optional<std::string> _config_file,
-                 std::vector<std::string> &&_argv) :
+                 std::vector<std::string> &&_argv,
+                 block_compression_t _block_compression) :
         joins(std::move(_joins)),
         reql_http_proxy(std::move(_reql_http_proxy)),
         web_assets(std::move(_web_assets)),
         do_version_checking(_do_version_checking),
         ports(_ports),
         config_file(_config_file),
-        argv(std::move(_argv))
+        argv(std::move(_argv)),
+        block_compression(_block_compression)
     { }
 
     void look_up_peers() {
@@ -119,6 +122,8 @@ public:
     /* The original arguments, so we can display them in `server_status`. All the
     argument parsing has already been completed at this point. */
     std::vector<std::string> argv;
+    /* How the serializers of the tables on this server compress new data blocks. */
+    block_compression_t block_compression;
 };
 
 /* This has been factored out from `command_line.hpp` because it takes a very
@@ -33,10 +33,34 @@ RDB_IMPL_SEMILATTICE_JOINABLE_3(cluster_semilattice_metadata_t,
 RDB_IMPL_EQUALITY_COMPARABLE_3(cluster_semilattice_metadata_t,
                                rdb_namespaces, servers, databases);
 
+cluster_semilattice_metadata_t semilattice_delta(
+        const cluster_semilattice_metadata_t &old_value,
+        const cluster_semilattice_metadata_t &new_value) {
+    cluster_semilattice_metadata_t delta;
+    // If nobody changed the tables, the two still share the same copy.
+    if (old_value.rdb_namespaces.get() != new_value.rdb_namespaces.get()) {
+        namespaces_semilattice_metadata_t namespaces;
+        namespaces.namespaces = semilattice_map_delta(
+            old_value.rdb_namespaces->namespaces, new_value.rdb_namespaces->namespaces);
+        delta.rdb_namespaces.set(namespaces);
+    }
+    delta.servers.servers = semilattice_map_delta(
+        old_value.servers.servers, new_value.servers.servers);
+    delta.databases.databases = semilattice_map_delta(
+        old_value.databases.databases, new_value.databases.databases);
+    return delta;
+}
+
 RDB_IMPL_SERIALIZABLE_1_SINCE_v1_13(auth_semilattice_metadata_t, auth_key);
 RDB_IMPL_SEMILATTICE_JOINABLE_1(auth_semilattice_metadata_t, auth_key);
 RDB_IMPL_EQUALITY_COMPARABLE_1(auth_semilattice_metadata_t, auth_key);
 
+auth_semilattice_metadata_t semilattice_delta(
+        UNUSED const auth_semilattice_metadata_t &old_value,
+        const auth_semilattice_metadata_t &new_value) {
+    return new_value;
+}
+
 RDB_IMPL_SERIALIZABLE_18_FOR_CLUSTER(cluster_directory_metadata_t,
      server_id,
      peer_id,
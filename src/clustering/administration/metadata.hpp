@@ -35,6 +35,10 @@ public:
 RDB_DECLARE_SERIALIZABLE(cluster_semilattice_metadata_t);
 RDB_DECLARE_SEMILATTICE_JOINABLE(cluster_semilattice_metadata_t);
 RDB_DECLARE_EQUALITY_COMPARABLE(cluster_semilattice_metadata_t);
+/* Only the tables, servers and databases that differ between the two. */
+cluster_semilattice_metadata_t semilattice_delta(
+        const cluster_semilattice_metadata_t &old_value,
+        const cluster_semilattice_metadata_t &new_value);
 
 class auth_semilattice_metadata_t {
 public:
@@ -46,6 +50,10 @@ public:
 RDB_DECLARE_SERIALIZABLE(auth_semilattice_metadata_t);
 RDB_DECLARE_SEMILATTICE_JOINABLE(auth_semilattice_metadata_t);
 RDB_DECLARE_EQUALITY_COMPARABLE(auth_semilattice_metadata_t);
+/* The auth metadata is tiny, so this is just `new_value`. */
+auth_semilattice_metadata_t semilattice_delta(
+        const auth_semilattice_metadata_t &old_value,
+        const auth_semilattice_metadata_t &new_value);
 
 enum cluster_directory_peer_type_t {
     SERVER_PEER,
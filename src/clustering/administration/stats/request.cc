@@ -26,6 +26,13 @@ const char *table_server_stats_request_t::table_server_request_type = "table_ser
     (BUILDER).overwrite(#NAME, ql::datum_t( \
         (STATS).accumulate_table(TABLE, &parsed_stats_t::table_stats_t::NAME)));
 
+#define ADD_LATENCY_STAT(BUILDER, SUB_STATS, NAME) \
+    (BUILDER).overwrite(#NAME, (SUB_STATS).NAME.to_datum(false))
+
+#define ADD_CLUSTER_LATENCY_STAT(BUILDER, STATS, NAME) \
+    (BUILDER).overwrite(#NAME, \
+        (STATS).accumulate(&parsed_stats_t::server_stats_t::NAME).to_datum(false))
+
 #define ADD_SERVER_STAT(BUILDER, STATS, SERVER, NAME) \
     (BUILDER).overwrite(#NAME, ql::datum_t( \
         (STATS).accumulate_server(SERVER, &parsed_stats_t::table_stats_t::NAME)));
@@ -64,6 +71,8 @@ parsed_stats_t::parsed_stats_t(const std::vector<ql::datum_t> &stats) {
             std::pair<datum_string_t, ql::datum_t> perf_pair = s.get_pair(i);
             if (perf_pair.first == "query_engine") {
                 store_query_engine_stats(perf_pair.second, &serv_stats);
+            } else if (perf_pair.first == "io") {
+                store_io_stats(perf_pair.second, &serv_stats);
             } else {
                 namespace_id_t table_id;
                 res = str_to_uuid(perf_pair.first.to_std(), &table_id);
@@ -100,6 +109,17 @@ void parsed_stats_t::add_perfmon_value(const ql::datum_t &perf,
     }
 }
 
+void parsed_stats_t::add_perfmon_histogram(const ql::datum_t &perf,
+                                           const std::string &key,
+                                           latency_histogram_t *histogram_out) {
+    ql::datum_t v = perf.get_field(key.c_str(), ql::throw_bool_t::NOTHROW);
+    // As above, a missing value means that the stat wasn't requested.
+    if (v.has()) {
+        bool res = histogram_out->merge_datum(v);
+        r_sanity_check(res);
+    }
+}
+
 void parsed_stats_t::store_shard_values(const ql::datum_t &shard_perf,
                                         table_stats_t *stats_out) {
     r_sanity_check(shard_perf.get_type() == ql::datum_t::R_OBJECT);
@@ -124,6 +144,8 @@ void parsed_stats_t::store_shard_values(const ql::datum_t &shard_perf,
                 } else if (key == "cache") {
                     add_perfmon_value(sub_pair.second, "in_use_bytes",
                                       &stats_out->in_use_bytes);
+                    add_perfmon_histogram(sub_pair.second, "miss_latency",
+                                          &stats_out->cache_miss_latency);
                 }
             }
         }
@@ -165,6 +187,19 @@ void parsed_stats_t::store_query_engine_stats(const ql::datum_t &qe_perf,
     store_perfmon_value(qe_perf, "queries_total", &stats_out->queries_total);
     store_perfmon_value(qe_perf, "client_connections", &stats_out->client_connections);
     store_perfmon_value(qe_perf, "clients_active", &stats_out->clients_active);
+    add_perfmon_histogram(qe_perf, "query_latency", &stats_out->query_latency);
+    add_perfmon_histogram(qe_perf, "read_round_trip", &stats_out->read_round_trip);
+    add_perfmon_histogram(qe_perf, "write_round_trip", &stats_out->write_round_trip);
+}
+
+void parsed_stats_t::store_io_stats(const ql::datum_t &io_perf,
+                                    server_stats_t *stats_out) {
+    r_sanity_check(io_perf.get_type() == ql::datum_t::R_OBJECT);
+    // The "stack" stats cover the whole life of a disk operation, including the
+    // time it spends queued up behind other operations.
+    add_perfmon_histogram(io_perf, "stack_read_latency", &stats_out->disk_read_latency);
+    add_perfmon_histogram(io_perf, "stack_write_latency",
+                          &stats_out->disk_write_latency);
 }
 
 void parsed_stats_t::store_table_stats(const namespace_id_t &table_id,
@@ -205,6 +240,15 @@ double parsed_stats_t::accumulate(double table_stats_t::*field) const {
     return res;
 }
 
+latency_histogram_t parsed_stats_t::accumulate(
+        latency_histogram_t server_stats_t::*field) const {
+    latency_histogram_t res;
+    for (auto const &pair : servers) {
+        res.merge(pair.second.*field);
+    }
+    return res;
+}
+
 double parsed_stats_t::accumulate_table(const namespace_id_t &table_id,
                                         double table_stats_t::*field) const {
     double res = 0;
@@ -251,6 +295,7 @@ bool add_table_fields(const namespace_id_t &table_id,
 std::set<std::vector<std::string> > stats_request_t::global_stats_filter() {
     return std::set<std::vector<std::string> >(
         { {"query_engine"},
+          {"io", "stack_.*_latency"},
           {"[0-9A-Fa-f-]+", "serializers" } });
 }
 
@@ -313,6 +358,9 @@ bool cluster_stats_request_t::to_datum(const parsed_stats_t &stats,
     ADD_CLUSTER_SERVER_STAT(qe_builder, stats, clients_active);
     ADD_CLUSTER_TABLE_STAT(qe_builder, stats, read_docs_per_sec);
     ADD_CLUSTER_TABLE_STAT(qe_builder, stats, written_docs_per_sec);
+    ADD_CLUSTER_LATENCY_STAT(qe_builder, stats, query_latency);
+    ADD_CLUSTER_LATENCY_STAT(qe_builder, stats, read_round_trip);
+    ADD_CLUSTER_LATENCY_STAT(qe_builder, stats, write_round_trip);
     row_builder.overwrite("query_engine", std::move(qe_builder).to_datum());
 
     *result_out = std::move(row_builder).to_datum();
@@ -413,6 +461,7 @@ server_stats_request_t::server_stats_request_t(const server_id_t &_server_id) :
 std::set<std::vector<std::string> > server_stats_request_t::get_filter() const {
     return std::set<std::vector<std::string> >(
         { {"query_engine"},
+          {"io", "stack_.*_latency"},
           {".*", "serializers", "shard_[0-9]+", "btree-.*" } });
 }
 
@@ -466,7 +515,19 @@ bool server_stats_request_t::to_datum(const parsed_stats_t &stats,
         ADD_SERVER_STAT(qe_builder, stats, server_id, read_docs_total);
         ADD_SERVER_STAT(qe_builder, stats, server_id, written_docs_per_sec);
         ADD_SERVER_STAT(qe_builder, stats, server_id, written_docs_total);
+        ADD_LATENCY_STAT(qe_builder, server_stats, query_latency);
+        ADD_LATENCY_STAT(qe_builder, server_stats, read_round_trip);
+        ADD_LATENCY_STAT(qe_builder, server_stats, write_round_trip);
         row_builder.overwrite("query_engine", std::move(qe_builder).to_datum());
+
+        ql::datum_object_builder_t se_disk_builder;
+        se_disk_builder.overwrite("read_latency",
+                                  server_stats.disk_read_latency.to_datum(false));
+        se_disk_builder.overwrite("write_latency",
+                                  server_stats.disk_write_latency.to_datum(false));
+        ql::datum_object_builder_t se_builder;
+        se_builder.overwrite("disk", std::move(se_disk_builder).to_datum());
+        row_builder.overwrite("storage_engine", std::move(se_builder).to_datum());
     }
     *result_out = std::move(row_builder).to_datum();
     return true;
@@ -572,6 +633,8 @@ bool table_server_stats_request_t::to_datum(const parsed_stats_t &stats,
 
         ql::datum_object_builder_t se_cache_builder;
         ADD_STAT(se_cache_builder, table_stats, in_use_bytes);
+        se_cache_builder.overwrite("miss_latency",
+                                   table_stats.cache_miss_latency.to_datum(false));
 
         ql::datum_object_builder_t se_disk_space_builder;
         ADD_STAT(se_disk_space_builder, table_stats, metadata_bytes);
@@ -9,6 +9,7 @@
 
 #include "clustering/administration/metadata.hpp"
 #include "containers/uuid.hpp"
+#include "perfmon/perfmon.hpp"
 #include "rdb_protocol/datum.hpp"
 
 class server_config_client_t;
@@ -35,6 +36,7 @@ public:
         double read_bytes_total;
         double written_bytes_per_sec;
         double written_bytes_total;
+        latency_histogram_t cache_miss_latency;
     };
 
     struct server_stats_t {
@@ -45,6 +47,11 @@ public:
         double queries_total;
         double client_connections;
         double clients_active;
+        latency_histogram_t query_latency;
+        latency_histogram_t read_round_trip;
+        latency_histogram_t write_round_trip;
+        latency_histogram_t disk_read_latency;
+        latency_histogram_t disk_write_latency;
 
         std::map<namespace_id_t, table_stats_t> tables;
     };
@@ -57,6 +64,9 @@ public:
     // Accumulate a field in all tables (across all servers)
     double accumulate(double table_stats_t::*field) const;
 
+    // Merge a latency histogram from all servers
+    latency_histogram_t accumulate(latency_histogram_t server_stats_t::*field) const;
+
     // Accumulate a field in a specific table (across all servers)
     double accumulate_table(const namespace_id_t &table_id,
                             double table_stats_t::*field) const;
@@ -80,6 +90,12 @@ private:
                              const std::string &key,
                              double *value_out);
 
+    // Merges a latency histogram produced by a `perfmon_histogram_t` into an
+    // existing histogram.
+    void add_perfmon_histogram(const ql::datum_t &perf,
+                               const std::string &key,
+                               latency_histogram_t *histogram_out);
+
     void store_shard_values(const ql::datum_t &shard_perf,
                             table_stats_t *stats_out);
 
@@ -89,6 +105,9 @@ private:
     void store_query_engine_stats(const ql::datum_t &qe_perf,
                                   server_stats_t *stats_out);
 
+    void store_io_stats(const ql::datum_t &io_perf,
+                        server_stats_t *stats_out);
+
     void store_table_stats(const namespace_id_t &table_id,
                            const ql::datum_t &table_perf,
                            server_stats_t *stats_out);
@@ -52,11 +52,15 @@ class chunk_callback_t : public coro_pool_callback_t<backfill_queue_entry_t>,
 public:
     chunk_callback_t(
             store_view_t *_svs,
+            const region_map_t<version_range_t> *_end_point,
+            order_source_t *_order_source,
             fifo_enforcer_queue_t<backfill_queue_entry_t> *_chunk_queue,
             mailbox_manager_t *_mbox_manager,
             mailbox_addr_t<void(int)> _allocation_mailbox,
             double *_progress_out) :
         svs(_svs),
+        end_point(_end_point),
+        order_source(_order_source),
         chunk_queue(_chunk_queue),
         mbox_manager(_mbox_manager),
         allocation_mailbox(_allocation_mailbox),
@@ -67,21 +71,41 @@ public:
     { }
 
     void apply_backfill_chunk(fifo_enforcer_write_token_t chunk_token, const backfill_chunk_t& chunk, signal_t *interruptor) {
+        const backfill_chunk_t::checkpoint_t *checkpoint =
+            boost::get<backfill_chunk_t::checkpoint_t>(&chunk.val);
+
         // No re-ordering must happen up to the point where we obtain a
         // token from the store.
         // This is also asserted by `chunk_queue->finish_write(chunk_token)`.
-        try {
-            svs->throttle_backfill_chunk(interruptor);
-        } catch (const interrupted_exc_t &) {
-            chunk_queue->finish_write(chunk_token);
-            throw;
+        if (checkpoint == NULL) {
+            try {
+                svs->throttle_backfill_chunk(interruptor);
+            } catch (const interrupted_exc_t &) {
+                chunk_queue->finish_write(chunk_token);
+                throw;
+            }
         }
 
         write_token_t token;
         svs->new_write_token(&token);
         chunk_queue->finish_write(chunk_token);
 
-        svs->receive_backfill(chunk, &token, interruptor);
+        if (checkpoint != NULL) {
+            /* The chunks before this one got their write tokens first, so the
+            store applies them first. After that, the checkpointed range is at
+            the end point. Recording that in the metainfo lets the next backfill
+            skip it if this one gets interrupted. */
+            svs->set_metainfo(
+                region_map_transform<version_range_t, binary_blob_t>(
+                    end_point->mask(checkpoint->range),
+                    &binary_blob_t::make<version_range_t>),
+                order_source->check_in("backfillee(checkpoint)"),
+                &token,
+                interruptor);
+        } else {
+            svs->receive_backfill(end_point->get_domain(), chunk, &token,
+                                  interruptor);
+        }
     }
 
     void coro_pool_callback(backfill_queue_entry_t chunk, signal_t *interruptor) {
@@ -152,6 +176,8 @@ public:
 
 private:
     store_view_t *svs;
+    const region_map_t<version_range_t> *end_point;
+    order_source_t *order_source;
     fifo_enforcer_queue_t<backfill_queue_entry_t> *chunk_queue;
     mailbox_manager_t *mbox_manager;
     mailbox_addr_t<void(int)> allocation_mailbox;
@@ -228,7 +254,8 @@ void backfillee(
             });
 
         /* The backfiller will send individual chunks of the backfill to
-        `chunk_mailbox`. */
+        `chunk_mailbox`. The chunks can be large, so they travel in the bulk class;
+        `chunk_queue` puts them back in order with the messages to `done_mailbox`. */
         mailbox_t<void(backfill_chunk_t, double, fifo_enforcer_write_token_t)>
             chunk_mailbox(
                 mailbox_manager,
@@ -240,7 +267,8 @@ void backfillee(
                     // (note how `chunk_queue` is a `fifo_enforcer_queue_t`)
                     chunk_queue.push(token,
                         backfill_queue_entry_t(true, chunk, progress, token));
-                });
+                },
+                cluster_traffic_class_t::bulk);
 
         /* The backfiller will register for allocations on the allocation
          * registration box. */
@@ -358,7 +386,8 @@ void backfillee(
             interruptor);
 
         chunk_callback_t chunk_callback(
-            svs, &chunk_queue, mailbox_manager, allocation_mailbox, progress_out);
+            svs, &end_point, &order_source, &chunk_queue, mailbox_manager,
+            allocation_mailbox, progress_out);
 
         coro_pool_t<backfill_queue_entry_t> backfill_workers(CHUNK_PROCESSING_CONCURRENCY,
                                                              &chunk_queue, &chunk_callback);
@@ -378,6 +407,15 @@ void backfillee(
         backfiller_notifier.fun = 0;
     }
 
+    /* The store might have put off some of the work of applying the chunks, for
+    example building its btree bottom-up from them. That has to be done before the
+    metainfo claims that the backfill is complete. */
+    {
+        write_token_t write_token;
+        svs->new_write_token(&write_token);
+        svs->finish_backfill(&write_token, interruptor);
+    }
+
     /* Update the metadata to indicate that the backfill occurred */
     write_token_t write_token;
     svs->new_write_token(&write_token);
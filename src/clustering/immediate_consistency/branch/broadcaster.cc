@@ -424,7 +424,8 @@ void broadcaster_t::listener_read(
             [&](signal_t *, const read_response_t &resp) {
                 *response = resp;
                 resp_cond.pulse();
-            });
+            },
+            r.response_traffic_class());
 
         send(mailbox_manager, mirror->read_mailbox, r, token, resp_mailbox.get_address());
 
@@ -8,6 +8,7 @@
 #include "arch/timing.hpp"
 #include "concurrency/promise.hpp"
 #include "containers/archive/boost_types.hpp"
+#include "perfmon/perfmon.hpp"
 #include "rdb_protocol/protocol.hpp"
 
 // TODO: Was this macro supposed to be used?
@@ -16,9 +17,13 @@
 master_access_t::master_access_t(
         mailbox_manager_t *mm,
         const clone_ptr_t<watchable_t<boost::optional<boost::optional<master_business_card_t> > > > &master,
-        signal_t *interruptor)
+        signal_t *interruptor,
+        perfmon_histogram_t *_read_round_trip,
+        perfmon_histogram_t *_write_round_trip)
         THROWS_ONLY(interrupted_exc_t, resource_lost_exc_t) :
     mailbox_manager(mm),
+    read_round_trip(_read_round_trip),
+    write_round_trip(_write_round_trip),
     multi_throttling_client(
         mailbox_manager,
         master->subview(&master_access_t::extract_multi_throttling_business_card),
@@ -55,7 +60,8 @@ void master_access_t::read(
             mailbox_manager,
             [&](signal_t *, const boost::variant<read_response_t, std::string> &res) {
                 result_or_failure.pulse(res);
-            });
+            },
+            read.response_traffic_class());
 
     wait_interruptible(token, interruptor);
     fifo_enforcer_read_token_t token_for_master = source_for_master.enter_read();
@@ -71,10 +77,14 @@ void master_access_t::read(
         token_for_master,
         result_or_failure_mailbox.get_address());
 
+    const ticks_t start_time = get_ticks();
     multi_throttling_client.spawn_request(read_request, &ticket, interruptor);
 
     wait_any_t waiter(result_or_failure.get_ready_signal(), get_failed_signal());
     wait_interruptible(&waiter, interruptor);
+    if (read_round_trip != NULL && result_or_failure.get_ready_signal()->is_pulsed()) {
+        read_round_trip->record(get_ticks() - start_time);
+    }
 
     if (result_or_failure.is_pulsed()) {
         if (const std::string *error
@@ -126,10 +136,14 @@ void master_access_t::write(
         token_for_master,
         result_or_failure_mailbox.get_address());
 
+    const ticks_t start_time = get_ticks();
     multi_throttling_client.spawn_request(write_request, &ticket, interruptor);
 
     wait_any_t waiter(result_or_failure.get_ready_signal(), get_failed_signal());
     wait_interruptible(&waiter, interruptor);
+    if (write_round_trip != NULL && result_or_failure.get_ready_signal()->is_pulsed()) {
+        write_round_trip->record(get_ticks() - start_time);
+    }
 
     if (result_or_failure.get_ready_signal()->is_pulsed()) {
         if (const std::string *error = boost::get<std::string>(&result_or_failure.wait())) {
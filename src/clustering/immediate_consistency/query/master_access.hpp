@@ -8,6 +8,7 @@
 #include "clustering/generic/multi_throttling_client.hpp"
 #include "clustering/generic/registrant.hpp"
 #include "clustering/immediate_consistency/query/master_metadata.hpp"
+#include "perfmon/types.hpp"
 #include "protocol_api.hpp"
 
 /* `master_access_t` is responsible for sending queries to `master_t`. It is
@@ -21,7 +22,11 @@ public:
     master_access_t(
             mailbox_manager_t *mm,
             const clone_ptr_t<watchable_t<boost::optional<boost::optional<master_business_card_t> > > > &master,
-            signal_t *interruptor)
+            signal_t *interruptor,
+            /* If these are non-NULL, the time from sending each read or write to
+            the master until its response arrives gets recorded in them. */
+            perfmon_histogram_t *_read_round_trip = NULL,
+            perfmon_histogram_t *_write_round_trip = NULL)
             THROWS_ONLY(interrupted_exc_t, resource_lost_exc_t);
 
     region_t get_region() {
@@ -74,6 +79,8 @@ private:
     void on_allocation(int);
 
     mailbox_manager_t *mailbox_manager;
+    perfmon_histogram_t *read_round_trip;
+    perfmon_histogram_t *write_round_trip;
 
     region_t region;
     fifo_enforcer_source_t internal_fifo_source;
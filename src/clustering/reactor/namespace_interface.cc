@@ -336,7 +336,8 @@ void cluster_namespace_interface_t::perform_outdated_read(
             [&](signal_t *, const read_response_t &res) {
                 results->at(i) = res;
                 done.pulse();
-            });
+            },
+            direct_reader_to_contact->sharded_op.response_traffic_class());
 
         send(mailbox_manager, direct_reader_to_contact->direct_reader_access->access().read_mailbox, direct_reader_to_contact->sharded_op, cont.get_address());
         wait_any_t waiter(direct_reader_to_contact->direct_reader_access->get_failed_signal(), &done);
@@ -505,7 +506,9 @@ void cluster_namespace_interface_t::relationship_coroutine(peer_id_t peer_id, re
                 get_watchable_for_key(directory_view, peer_id)->subview(std::bind(
                     &cluster_namespace_interface_t::extract_master_business_card,
                     ph::_1, activity_id)),
-                    lock.get_drain_signal()));
+                lock.get_drain_signal(),
+                &ctx->stats.read_round_trip,
+                &ctx->stats.write_round_trip));
             direct_reader_access.init(
                 new resource_access_t<direct_reader_business_card_t>(
                     get_watchable_for_key(directory_view, peer_id)->subview(std::bind(
@@ -3,14 +3,21 @@
 
 #include "errors.hpp"
 #include "arch/runtime/coroutines.hpp"
+#include "arch/timing.hpp"
+#include "concurrency/wait_any.hpp"
 
 
 throttled_committer_t::throttled_committer_t(const std::function<void()> &_commit_cb,
-                                             int _max_active_commits) :
+                                             int _max_active_commits,
+                                             int64_t _group_window_ms) :
     on_next_commit_complete(new counted_cond_t()),
     unhandled_commit_waiter_exists(false),
     num_active_commits(0),
     max_active_commits(_max_active_commits),
+    group_window_ms(_group_window_ms),
+    group_window_closer(NULL),
+    syncs_for_next_commit(0),
+    last_commit_had_company(false),
     commit_cb(_commit_cb) { }
 
 throttled_committer_t::~throttled_committer_t() {
@@ -27,32 +34,58 @@ void throttled_committer_t::sync() {
     // up to this call to `sync()` has been completed.
     counted_t<counted_cond_t> commit_complete = on_next_commit_complete;
     unhandled_commit_waiter_exists = true;
+    ++syncs_for_next_commit;
 
     // Check if we can initiate a new commit
     if (num_active_commits < max_active_commits) {
+        // Only open a group window if we're idle and other syncs are likely to
+        // join. Otherwise the commits that are already active do the grouping for
+        // us, or there is nothing to group.
+        const bool wait_for_group = num_active_commits == 0 && last_commit_had_company;
         ++num_active_commits;
-        do_commit();
+        do_commit(wait_for_group);
     }
 
     // Wait for the commit to complete
     commit_complete->wait_lazily_unordered();
 }
 
-void throttled_committer_t::do_commit() {
+void throttled_committer_t::close_group_window() {
+    assert_thread();
+    if (group_window_closer != NULL) {
+        group_window_closer->pulse_if_not_already_pulsed();
+    }
+}
+
+void throttled_committer_t::do_commit(bool wait_for_group) {
     assert_thread();
     rassert(num_active_commits <= max_active_commits);
 
+    // Syncs that come in while we wait are still captured by the current
+    // on_next_commit_complete, so they get committed (and notified) with us.
+    if (wait_for_group && group_window_ms > 0 && group_window_closer == NULL) {
+        cond_t closer;
+        assignment_sentry_t<cond_t *> closer_sentry(&group_window_closer, &closer);
+        signal_timer_t window_timer(group_window_ms);
+        wait_any_t window_over(&closer, &window_timer);
+        window_over.wait_lazily_unordered();
+    }
+
     // Swap out the on_next_commit_complete signal so subsequent syncs
     // can be captured by the next round of do_commit().
     counted_t<counted_cond_t> sync_complete(new counted_cond_t());
+    int64_t syncs_in_commit;
     {
         ASSERT_NO_CORO_WAITING;
         sync_complete.swap(on_next_commit_complete);
         unhandled_commit_waiter_exists = false;
+        syncs_in_commit = syncs_for_next_commit;
+        syncs_for_next_commit = 0;
     }
 
     // Actually perform the commit
     commit_cb();
+    last_commit_had_company = syncs_in_commit > 1 || unhandled_commit_waiter_exists;
 
     // Tell the sync waiters that the commit is done
     sync_complete->pulse();
@@ -62,6 +95,7 @@ void throttled_committer_t::do_commit() {
     rassert(num_active_commits < max_active_commits);
     if (unhandled_commit_waiter_exists) {
         ++num_active_commits;
-        coro_t::spawn_sometime(std::bind(&throttled_committer_t::do_commit, this));
+        coro_t::spawn_sometime(std::bind(&throttled_committer_t::do_commit, this,
+                                         false));
     }
 }
@@ -17,21 +17,36 @@
  * whenever the individual commits take longer than the rate at which new changes
  * are coming in. This assumes that each call of `_commit_cb` always flushes
  * all changes that have accumulated up to that point, not only the latest changes.
+ *
+ * Changes that come in while no commit is active would each get a commit of their
+ * own. With a nonzero `group_window_ms`, such a commit first waits that long (or
+ * until `close_group_window()` is called), so that changes arriving shortly after
+ * each other are grouped into one commit. It only waits if the previous commit
+ * showed that changes are coming in concurrently, i.e. if it covered more than one
+ * `sync()` or another `sync()` came in while it ran. That way a lone writer
+ * doesn't pay for a window that nobody else is going to join. Commits that start
+ * right after another one finished never wait, because changes have had time to
+ * accumulate already.
  */
 
 class throttled_committer_t : public home_thread_mixin_debug_only_t {
 public:
     // Unless _max_active_commits == 1, _commit_cb must be reentrant safe.
     throttled_committer_t(const std::function<void()> &_commit_cb,
-                          int _max_active_commits);
+                          int _max_active_commits,
+                          int64_t _group_window_ms = 0);
     ~throttled_committer_t();
 
     // Waits until the first commit completes that has been started after
     // entering this function.
     void sync();
 
+    // Starts the commit that's waiting for its group window to end (if there is
+    // one) right away. Call this once enough changes have been grouped together.
+    void close_group_window();
+
 private:
-    void do_commit();
+    void do_commit(bool wait_for_group);
 
     // Syncs which are currently waiting for a commit keep a pointer to this condition.
     // It is pulsed once the corresponding commit completes.
@@ -44,6 +59,15 @@ private:
     int num_active_commits;
     int max_active_commits;
 
+    int64_t group_window_ms;
+    // Non-NULL while a commit is waiting for its group window to end.
+    cond_t *group_window_closer;
+    // The number of `sync()` calls that the next commit is going to cover.
+    int64_t syncs_for_next_commit;
+    // Whether the last commit to finish saw concurrent `sync()` calls, which is
+    // what makes it worth opening a group window.
+    bool last_commit_had_company;
+
     std::function<void()> commit_cb;
 
     DISABLE_COPYING(throttled_committer_t);
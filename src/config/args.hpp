@@ -51,6 +51,11 @@
 // useful.
 #define DEFAULT_IO_BATCH_FACTOR                   1
 
+// The io_uring disk backend runs the operations it can't submit to the kernel
+// directly (resizes, datasync-wrapped metablock writes, short transfers) on a
+// small blocker pool of this many threads.
+#define IO_URING_FALLBACK_THREADS                 2
+
 // I/O priority of index writes in the log serializer
 #define INDEX_WRITE_IO_PRIORITY                   128
 
@@ -73,6 +78,29 @@
 // 0 = minimal priority
 #define SINDEX_POST_CONSTRUCTION_CACHE_PRIORITY   5
 
+// Secondary index post construction splits the primary key space into this many
+// ranges and traverses them concurrently. Each range collects up to about
+// SINDEX_POST_CONSTRUCTION_SORT_BUFFER index entries and sorts them by index key
+// before writing them, so that the writes to the index btree are mostly in order.
+#define SINDEX_POST_CONSTRUCTION_RANGES           4
+#define SINDEX_POST_CONSTRUCTION_SORT_BUFFER      1024
+
+// The percentage of a cache's memory limit that pages which have been used more
+// than once (the "protected" segment) may occupy before the evicter starts demoting
+// them back to the probationary segment.  What's left over is where pages that have
+// only been touched once, such as those loaded by a scan, compete with each other.
+#define CACHE_PROTECTED_SEGMENT_PERCENT           80
+
+// How many sibling nodes a btree range scan may start loading ahead of the node
+// it's currently processing, and how many read-ahead blocks may be outstanding in
+// one cache at a time (across all scans).
+#define BTREE_MAX_READ_AHEAD_NODES                16
+#define CACHE_READ_AHEAD_BUDGET_BLOCKS            256
+
+// How many rows a range read collects before applying its leading `map` and
+// `filter` transforms to all of them at once.
+#define RGET_ROWWISE_BATCH_SIZE                   128
+
 // Size of the buffer used to perform IO operations (in bytes).
 #define IO_BUFFER_SIZE                            (4 * KILOBYTE)
 
@@ -102,6 +130,14 @@
 // small values of this variable.
 #define MERGER_SERIALIZER_MAX_ACTIVE_WRITES       1
 
+// How long an index write that comes in while the merger serializer is idle waits
+// for index writes from other transactions to join it, and how many bytes of block
+// writes may pile up before it stops waiting early.  It only waits if the previous
+// index write was shared by several transactions.  This trades a little latency
+// for far fewer fdatasyncs under many small concurrent hard durability writes.
+#define MERGER_GROUP_COMMIT_WINDOW_MS             1
+#define MERGER_GROUP_COMMIT_MAX_BYTES             (4 * MEGABYTE)
+
 // I/O priority of block writes in the merger_serializer_t
 #define MERGER_BLOCK_WRITE_IO_PRIORITY            64
 
@@ -183,6 +219,16 @@
 // that the event we are waiting for has occurred in the meantime.
 #define REACTOR_RUN_UNTIL_SATISFIED_NAP           100
 
+// How many TCP connections we open to every other server. Each traffic class
+// (see `cluster_traffic_class_t`) uses its own connection, so more than three
+// are never used. If the two servers ask for different numbers, they use the
+// smaller one.
+#define CLUSTER_STREAMS_PER_PEER                  3
+
+// How long (in ms) we wait for the additional connections to a server to come up
+// before we give up on connecting to it.
+#define CLUSTER_STREAM_SETUP_TIMEOUT_MS           (10 * THOUSAND)
+
 
 /**
  * Message scheduler configuration
@@ -84,10 +84,10 @@ size_t write_message_t::size() const {
     return ret;
 }
 
-int send_write_message(write_stream_t *s, const write_message_t *wm) {
+int write_stream_t::write_message(const write_message_t *wm) {
     intrusive_list_t<write_buffer_t> *list = const_cast<write_message_t *>(wm)->unsafe_expose_buffers();
     for (write_buffer_t *p = list->head(); p; p = list->next(p)) {
-        int64_t res = s->write(p->data, p->size);
+        int64_t res = write(p->data, p->size);
         if (res == -1) {
             return -1;
         }
@@ -96,6 +96,10 @@ int send_write_message(write_stream_t *s, const write_message_t *wm) {
     return 0;
 }
 
+int send_write_message(write_stream_t *s, const write_message_t *wm) {
+    return s->write_message(wm);
+}
+
 // You MUST NOT change the behavior of serialize_universal and deserialize_universal
 // functions!  (You could find a way to remove their callers and remove them though.)
 void serialize_universal(write_message_t *wm, const uuid_u &uuid) {
@@ -80,11 +80,17 @@ private:
 // non-negative value less than n upon EOF.
 MUST_USE int64_t force_read(read_stream_t *s, void *p, int64_t n);
 
+class write_message_t;
+
 class write_stream_t {
 public:
     write_stream_t() { }
     // Returns n, or -1 upon error. Blocks until all bytes are written.
     virtual MUST_USE int64_t write(const void *p, int64_t n) = 0;
+    // Writes all the buffers of `wm`.  Returns 0 upon success, -1 upon failure.
+    // This calls `write()` once per buffer; streams that can hand all the buffers
+    // over at once override it.
+    virtual MUST_USE int write_message(const write_message_t *wm);
 protected:
     virtual ~write_stream_t() { }
 private:
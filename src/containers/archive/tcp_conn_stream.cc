@@ -39,6 +39,34 @@ int64_t tcp_conn_stream_t::write(const void *p, int64_t n) {
     }
 }
 
+int tcp_conn_stream_t::write_message(const write_message_t *wm) {
+    intrusive_list_t<write_buffer_t> *list =
+        const_cast<write_message_t *>(wm)->unsafe_expose_buffers();
+    std::vector<iovec> iov;
+    for (write_buffer_t *p = list->head(); p; p = list->next(p)) {
+        iovec v;
+        v.iov_base = p->data;
+        v.iov_len = p->size;
+        iov.push_back(v);
+    }
+    return writev(iov.data(), iov.size()) == -1 ? -1 : 0;
+}
+
+int64_t tcp_conn_stream_t::writev(const iovec *iov, size_t iovcnt) {
+    int64_t n = 0;
+    for (size_t i = 0; i < iovcnt; ++i) {
+        n += iov[i].iov_len;
+    }
+    try {
+        // writev writes everything or throws an exception.
+        cond_t non_closer;
+        conn_->writev(iov, iovcnt, &non_closer);
+        return n;
+    } catch (const tcp_conn_write_closed_exc_t &) {
+        return -1;
+    }
+}
+
 void tcp_conn_stream_t::rethread(threadnum_t new_thread) {
     conn_->rethread(new_thread);
 }
@@ -98,6 +126,14 @@ int64_t keepalive_tcp_conn_stream_t::write(const void *p, int64_t n) {
     return tcp_conn_stream_t::write(p, n);
 }
 
+int64_t keepalive_tcp_conn_stream_t::writev(const iovec *iov, size_t iovcnt) {
+    if (keepalive_callback != NULL) {
+        keepalive_callback->keepalive_write();
+    }
+
+    return tcp_conn_stream_t::writev(iov, iovcnt);
+}
+
 rethread_tcp_conn_stream_t::rethread_tcp_conn_stream_t(tcp_conn_stream_t *conn, threadnum_t thread)
     : conn_(conn), old_thread_(conn->home_thread()), new_thread_(thread) {
     conn->rethread(thread);
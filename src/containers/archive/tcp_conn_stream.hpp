@@ -2,6 +2,8 @@
 #ifndef CONTAINERS_ARCHIVE_TCP_CONN_STREAM_HPP_
 #define CONTAINERS_ARCHIVE_TCP_CONN_STREAM_HPP_
 
+#include <sys/uio.h>
+
 #include "arch/address.hpp"
 #include "arch/types.hpp"
 #include "containers/archive/archive.hpp"
@@ -19,6 +21,11 @@ public:
 
     virtual MUST_USE int64_t read(void *p, int64_t n);
     virtual MUST_USE int64_t write(const void *p, int64_t n);
+    // Hands all of `wm`'s buffers to `writev()`.
+    virtual MUST_USE int write_message(const write_message_t *wm);
+    // Writes the `iovcnt` buffers in `iov` one after the other, without copying
+    // them.  Returns the total number of bytes, or -1 upon error.
+    virtual MUST_USE int64_t writev(const iovec *iov, size_t iovcnt);
 
     void rethread(threadnum_t new_thread);
 
@@ -58,6 +65,7 @@ public:
 
     virtual MUST_USE int64_t read(void *p, int64_t n);
     virtual MUST_USE int64_t write(const void *p, int64_t n);
+    virtual MUST_USE int64_t writev(const iovec *iov, size_t iovcnt);
 
 private:
     keepalive_callback_t *keepalive_callback;
@@ -121,6 +121,15 @@ public:
         internal_.push(wm);
     }
 
+    // Pushes all of `ts` in one transaction.
+    void push(const std::vector<T> &ts) {
+        scoped_array_t<write_message_t> wms(ts.size());
+        for (size_t i = 0; i < ts.size(); ++i) {
+            serialize<cluster_version_t::LATEST_OVERALL>(&wms[i], ts[i]);
+        }
+        internal_.push(wms);
+    }
+
     void pop(T *out) {
         deserializing_viewer_t<T> viewer(out);
         internal_.pop(&viewer);
@@ -13,6 +13,7 @@
 #include "extproc/extproc_job.hpp"
 #include "http/http_parser.hpp"
 #include "rdb_protocol/env.hpp"
+#include "rdb_protocol/json_parser.hpp"
 
 #define RETHINKDB_USER_AGENT (SOFTWARE_NAME_STRING "/" RETHINKDB_VERSION)
 
@@ -859,9 +860,9 @@ void json_to_datum(const std::string &json,
                    reql_version_t reql_version,
                    attach_json_to_error_t attach_json,
                    http_result_t *res_out) {
-    scoped_cJSON_t cjson(cJSON_Parse(json.c_str()));
-    if (cjson.get() != NULL) {
-        res_out->body = ql::to_datum(cjson.get(), limits, reql_version);
+    ql::datum_t parsed;
+    if (ql::parse_json(json.c_str(), limits, reql_version, &parsed)) {
+        res_out->body = std::move(parsed);
     } else {
         res_out->error.assign("failed to parse JSON response");
         if (attach_json == attach_json_to_error_t::YES) {
@@ -118,6 +118,7 @@ public:
 enum js_task_t {
     TASK_EVAL,
     TASK_CALL,
+    TASK_CALL_BATCH,
     TASK_RELEASE,
     TASK_EXIT
 };
@@ -176,6 +177,38 @@ js_result_t js_job_t::call(js_id_t id, const std::vector<ql::datum_t> &args) {
     return result;
 }
 
+std::vector<js_result_t> js_job_t::call_batch(
+        js_id_t id, const std::vector<std::vector<ql::datum_t> > &args_batch) {
+    js_task_t task = js_task_t::TASK_CALL_BATCH;
+    write_message_t wm;
+    wm.append(&task, sizeof(task));
+    serialize<cluster_version_t::LATEST_OVERALL>(&wm, id);
+    serialize<cluster_version_t::LATEST_OVERALL>(&wm, args_batch);
+    serialize<cluster_version_t::LATEST_OVERALL>(&wm, limits);
+    {
+        int res = send_write_message(extproc_job.write_stream(), &wm);
+        if (res != 0) {
+            throw extproc_worker_exc_t("failed to send data to the worker");
+        }
+    }
+
+    std::vector<js_result_t> results;
+    archive_result_t res
+        = deserialize<cluster_version_t::LATEST_OVERALL>(extproc_job.read_stream(),
+                                                         &results);
+    if (bad(res)) {
+        throw extproc_worker_exc_t(strprintf("failed to deserialize call batch result "
+                                             "from worker (%s)",
+                                             archive_result_as_str(res)));
+    }
+    if (results.size() > args_batch.size()
+        || (results.size() < args_batch.size()
+            && (results.empty() || boost::get<std::string>(&results.back()) == NULL))) {
+        throw extproc_worker_exc_t("worker returned the wrong number of call results");
+    }
+    return results;
+}
+
 void js_job_t::release(js_id_t id) {
     js_task_t task = js_task_t::TASK_RELEASE;
     write_message_t wm;
@@ -308,6 +341,55 @@ bool run_call(read_stream_t *stream_in,
     return send_js_result(stream_out, js_result);
 }
 
+bool run_call_batch(read_stream_t *stream_in,
+                    write_stream_t *stream_out,
+                    js_env_t *js_env,
+                    uint64_t task_counter) {
+    js_id_t id;
+    std::vector<std::vector<ql::datum_t> > args_batch;
+    ql::configured_limits_t limits;
+    {
+        archive_result_t res
+            = deserialize<cluster_version_t::LATEST_OVERALL>(stream_in, &id);
+        if (bad(res)) { return false; }
+        res = deserialize<cluster_version_t::LATEST_OVERALL>(stream_in, &args_batch);
+        if (bad(res)) { return false; }
+        res = deserialize<cluster_version_t::LATEST_OVERALL>(stream_in, &limits);
+        if (bad(res)) { return false; }
+    }
+
+    // Stop at the first error, just like the caller would if it made the calls
+    // one at a time.
+    std::vector<js_result_t> js_results;
+    js_results.reserve(args_batch.size());
+    for (auto it = args_batch.begin(); it != args_batch.end(); ++it) {
+        js_result_t js_result;
+        try {
+            js_result = js_env->call(id, *it, limits);
+        } catch (const std::exception &e) {
+            js_result = e.what();
+        } catch (...) {
+            js_result = std::string("encountered an unknown exception");
+        }
+        // Batches are only used where a value is expected, so nobody is going to
+        // call a function returned here; don't keep it around.
+        if (const js_id_t *sub_id = boost::get<js_id_t>(&js_result)) {
+            js_env->release(*sub_id);
+        }
+        js_results.push_back(js_result);
+        if (boost::get<std::string>(&js_results.back()) != NULL) {
+            break;
+        }
+    }
+
+    js_env->run_other_tasks(task_counter);
+
+    write_message_t wm;
+    serialize<cluster_version_t::LATEST_OVERALL>(&wm, js_results);
+    int res = send_write_message(stream_out, &wm);
+    return res == 0;
+}
+
 bool run_release(read_stream_t *stream_in,
                  write_stream_t *stream_out,
                  js_env_t *js_env,
@@ -352,6 +434,11 @@ bool js_job_t::worker_fn(read_stream_t *stream_in, write_stream_t *stream_out) {
                 return false;
             }
             break;
+        case TASK_CALL_BATCH:
+            if (!run_call_batch(stream_in, stream_out, &js_env, task_counter)) {
+                return false;
+            }
+            break;
         case TASK_RELEASE:
             if (!run_release(stream_in, stream_out, &js_env, task_counter)) {
                 return false;
@@ -219,6 +219,58 @@ js_result_t js_runner_t::call(const std::string &source,
     return result;
 }
 
+bool js_runner_t::call_batch(
+        const std::string &source,
+        const std::vector<std::vector<ql::datum_t> > &args_batch,
+        const req_config_t &config,
+        std::vector<js_result_t> *results_out) {
+    assert_thread();
+    guarantee(job_data.has());
+
+    results_out->clear();
+    if (args_batch.empty()) {
+        return true;
+    }
+
+    // This will retrieve the function from the cache if it's there, or re-eval it
+    js_result_t fn = eval(source, config);
+    js_id_t *fn_id = boost::get<js_id_t>(&fn);
+    guarantee(fn_id != NULL);
+
+    object_buffer_t<js_timeout_t::sentry_t> sentry;
+    sentry.create(&job_data->js_timeout, config.timeout_ms);
+
+    bool is_timeout = false;
+    try {
+        try {
+            *results_out = job_data->js_job.call_batch(*fn_id, args_batch);
+        } catch (...) {
+            // See `call` above.
+            is_timeout = job_data->js_timeout.get_signal()->is_pulsed();
+
+            // Sentry must be destroyed before the js_timeout
+            sentry.reset();
+            job_data->js_job.worker_error();
+            job_data.reset();
+
+            throw;
+        }
+    } catch (interrupted_exc_t const &e) {
+        if (is_timeout) {
+            // We can't tell whether one of the calls took too long or there were
+            // just a lot of them, so the caller has to find out call by call.
+            results_out->clear();
+            return false;
+        } else {
+            throw;
+        }
+    }
+
+    // Unlike `call`, we don't cache functions returned by the calls; the worker
+    // has already released them.
+    return true;
+}
+
 void js_runner_t::cache_id(js_id_t id, const std::string &source) {
     guarantee(job_data.has());
     guarantee(id != INVALID_ID);
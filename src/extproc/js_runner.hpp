@@ -59,6 +59,20 @@ public:
                      const std::vector<ql::datum_t> &args,
                      const req_config_t &config);
 
+    // Calls a previously compiled function once for each argument list in
+    // `args_batch`, in a single round trip to the worker process, and sets
+    // `*results_out` to the results.  Evaluation stops at the first call that fails,
+    // so the results may be shorter than `args_batch`; if so, the last one is the
+    // error.  The worker can't time the calls one by one, so the whole batch gets
+    // `config.timeout_ms`.  If it takes longer than that, the worker is killed and
+    // `call_batch` returns false; the caller should then retry with smaller batches
+    // to find out whether one of the calls took too long.
+    MUST_USE bool call_batch(
+        const std::string &source,
+        const std::vector<std::vector<ql::datum_t> > &args_batch,
+        const req_config_t &config,
+        std::vector<js_result_t> *results_out);
+
 private:
     static const size_t CACHE_SIZE;
 
@@ -1,8 +1,11 @@
 // Copyright 2010-2014 RethinkDB, all rights reserved.
 #include "http/json.hpp"
 
+#include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
+#include <cmath>
 #include <set>
 #include <vector>
 
@@ -164,6 +167,139 @@ std::string cJSON_print_unformatted_std_string(cJSON *json) THROWS_NOTHING {
     return res;
 }
 
+void json_append_string(const char *str, size_t size, std::string *out) {
+    out->push_back('"');
+    const char *const end = str + size;
+    const char *run = str;
+    for (const char *p = str; p < end; ++p) {
+        const unsigned char c = *p;
+        if (c > 31 && c != '"' && c != '\\') {
+            continue;
+        }
+        out->append(run, p - run);
+        run = p + 1;
+        out->push_back('\\');
+        switch (c) {
+        case '\\': out->push_back('\\'); break;
+        case '"': out->push_back('"'); break;
+        case '\b': out->push_back('b'); break;
+        case '\f': out->push_back('f'); break;
+        case '\n': out->push_back('n'); break;
+        case '\r': out->push_back('r'); break;
+        case '\t': out->push_back('t'); break;
+        default: {
+            char escape[6];
+            snprintf(escape, sizeof(escape), "u%04x", c);
+            out->append(escape, 5);
+        } break;
+        }
+    }
+    out->append(run, end - run);
+    out->push_back('"');
+}
+
+void json_append_number(double d, std::string *out) {
+    guarantee(risfinite(d));
+    if (d == 0.0 && std::signbit(d)) {
+        out->append("-0.0");
+    } else {
+        char buf[64];
+        const int size = snprintf(buf, sizeof(buf), "%.20g", d);
+        guarantee(size > 0 && static_cast<size_t>(size) < sizeof(buf));
+        out->append(buf, size);
+    }
+}
+
+namespace {
+
+bool parse_hex4(const char **pos, unsigned int *out) {
+    const char *p = *pos;
+    unsigned int ret = 0;
+    for (int i = 0; i < 4; ++i, ++p) {
+        ret <<= 4;
+        if (*p >= '0' && *p <= '9') {
+            ret += *p - '0';
+        } else if (*p >= 'A' && *p <= 'F') {
+            ret += 10 + *p - 'A';
+        } else if (*p >= 'a' && *p <= 'f') {
+            ret += 10 + *p - 'a';
+        } else {
+            return false;
+        }
+    }
+    *pos = p;
+    *out = ret;
+    return true;
+}
+
+void append_utf8(unsigned int uc, std::string *out) {
+    if (uc < 0x80) {
+        out->push_back(uc);
+    } else if (uc < 0x800) {
+        out->push_back(0xC0 | (uc >> 6));
+        out->push_back(0x80 | (uc & 0x3F));
+    } else if (uc < 0x10000) {
+        out->push_back(0xE0 | (uc >> 12));
+        out->push_back(0x80 | ((uc >> 6) & 0x3F));
+        out->push_back(0x80 | (uc & 0x3F));
+    } else {
+        out->push_back(0xF0 | (uc >> 18));
+        out->push_back(0x80 | ((uc >> 12) & 0x3F));
+        out->push_back(0x80 | ((uc >> 6) & 0x3F));
+        out->push_back(0x80 | (uc & 0x3F));
+    }
+}
+
+}  // namespace
+
+bool json_parse_string(const char **pos, std::string *out) {
+    const char *p = *pos;
+    if (*p != '"') {
+        return false;
+    }
+    ++p;
+    for (;;) {
+        // `strcspn` is vectorized in glibc, and most strings have no escapes.
+        const char *run = p;
+        p += strcspn(p, "\"\\");
+        out->append(run, p - run);
+        if (*p == '"') {
+            *pos = p + 1;
+            return true;
+        } else if (*p == '\0') {
+            return false;
+        }
+
+        ++p;
+        switch (*p) {
+        case 'b': out->push_back('\b'); ++p; break;
+        case 'f': out->push_back('\f'); ++p; break;
+        case 'n': out->push_back('\n'); ++p; break;
+        case 'r': out->push_back('\r'); ++p; break;
+        case 't': out->push_back('\t'); ++p; break;
+        case 'u': {
+            ++p;
+            unsigned int uc;
+            if (!parse_hex4(&p, &uc)) return false;
+            // Fail on invalid Unicode characters, like our cJSON does.
+            if ((uc >= 0xDC00 && uc <= 0xDFFF) || uc == 0) return false;
+            if (uc >= 0xD800 && uc <= 0xDBFF) {
+                // A UTF-16 surrogate pair.
+                if (p[0] != '\\' || p[1] != 'u') return false;
+                p += 2;
+                unsigned int uc2;
+                if (!parse_hex4(&p, &uc2)) return false;
+                if (uc2 < 0xDC00 || uc2 > 0xDFFF) return false;
+                uc = 0x10000 + (((uc & 0x3FF) << 10) | (uc2 & 0x3FF));
+            }
+            append_utf8(uc, out);
+        } break;
+        case '\0': return false;
+        default: out->push_back(*p); ++p; break;
+        }
+    }
+}
+
 void project(cJSON *json, std::set<std::string> keys) {
     guarantee(json);
     guarantee(json->type == cJSON_Object);
@@ -24,6 +24,20 @@ std::string cJSON_print_std_string(cJSON *json) THROWS_NOTHING;
 std::string cJSON_print_unformatted_std_string(cJSON *json) THROWS_NOTHING;
 const char *cJSON_type_to_string(int type);
 
+// These append JSON text onto `out` exactly the way `cJSON_PrintUnformatted` would
+// print a string or a number, for code that writes JSON without building a cJSON
+// tree first.  Unlike cJSON, `json_append_string` escapes embedded NUL characters
+// instead of stopping at them.
+void json_append_string(const char *str, size_t size, std::string *out);
+void json_append_number(double d, std::string *out);
+
+// Reads the JSON string whose opening quote is at `*pos`, appends its unescaped
+// contents to `out` and moves `*pos` past the closing quote.  Escapes are handled
+// like `cJSON_Parse` handles them (`\x` is `x`, `\u0000` is rejected), except that
+// unpaired UTF-16 surrogates are rejected instead of dropped.  Returns false if the
+// string is malformed or unterminated.
+MUST_USE bool json_parse_string(const char **pos, std::string *out);
+
 class scoped_cJSON_t {
 private:
     cJSON *val;
@@ -18,6 +18,7 @@ static const char *stat_per_sec = "per_sec";
 static const char *stat_count = "count";
 static const char *stat_mean = "mean";
 static const char *stat_std_dev = "std_dev";
+static const char *stat_buckets = "buckets";
 
 
 #ifdef FULL_PERFMON
@@ -241,6 +242,210 @@ void perfmon_stddev_t::record(double value) {
     thread_data[get_thread_id().threadnum].value.add(value);
 }
 
+/* perfmon_histogram_t */
+
+latency_histogram_t::latency_histogram_t()
+    : total(0), max_duration(0), sum_secs(0) {
+    std::fill(counts, counts + NUM_BUCKETS, 0);
+}
+
+size_t latency_histogram_t::bucket_for_duration(ticks_t duration) {
+    const ticks_t sub_buckets = 1 << SUB_BUCKET_BITS;
+    duration = std::min<ticks_t>(duration, (static_cast<ticks_t>(1) << MAX_DURATION_BITS) - 1);
+    if (duration < sub_buckets) {
+        return duration;
+    }
+    // The highest set bit picks the power of two, the next `SUB_BUCKET_BITS` bits
+    // pick the sub-bucket within it.
+    const int high_bit = 63 - __builtin_clzll(duration);
+    const size_t sub_bucket = (duration >> (high_bit - SUB_BUCKET_BITS)) & (sub_buckets - 1);
+    return ((high_bit - SUB_BUCKET_BITS + 1) << SUB_BUCKET_BITS) + sub_bucket;
+}
+
+ticks_t latency_histogram_t::bucket_max_duration(size_t bucket) {
+    rassert(bucket < NUM_BUCKETS);
+    const size_t group = bucket >> SUB_BUCKET_BITS;
+    if (group == 0) {
+        return bucket;
+    }
+    const ticks_t sub_bucket = bucket & ((1 << SUB_BUCKET_BITS) - 1);
+    const ticks_t min_duration = ((1 << SUB_BUCKET_BITS) + sub_bucket) << (group - 1);
+    return min_duration + (static_cast<ticks_t>(1) << (group - 1)) - 1;
+}
+
+void latency_histogram_t::record(ticks_t duration) {
+    ++counts[bucket_for_duration(duration)];
+    ++total;
+    max_duration = std::max(max_duration, duration);
+    sum_secs += ticks_to_secs(duration);
+}
+
+void latency_histogram_t::merge(const latency_histogram_t &other) {
+    if (other.total == 0) {
+        return;
+    }
+    for (size_t i = 0; i < NUM_BUCKETS; ++i) {
+        counts[i] += other.counts[i];
+    }
+    total += other.total;
+    max_duration = std::max(max_duration, other.max_duration);
+    sum_secs += other.sum_secs;
+}
+
+ticks_t latency_histogram_t::percentile(double q) const {
+    if (total == 0) {
+        return 0;
+    }
+    const uint64_t rank = std::min<uint64_t>(
+        total, std::max<uint64_t>(1, static_cast<uint64_t>(ceil(q * total))));
+    uint64_t seen = 0;
+    for (size_t i = 0; i < NUM_BUCKETS; ++i) {
+        seen += counts[i];
+        if (seen >= rank) {
+            return std::min(bucket_max_duration(i), max_duration);
+        }
+    }
+    unreachable();
+}
+
+static const struct {
+    const char *name;
+    double q;
+} histogram_percentiles[] = {
+    { "p50", 0.5 }, { "p90", 0.9 }, { "p99", 0.99 }, { "p999", 0.999 }
+};
+
+ql::datum_t latency_histogram_t::to_datum(bool include_buckets) const {
+    ql::datum_object_builder_t builder;
+
+    builder.overwrite(stat_count, ql::datum_t(static_cast<double>(total)));
+    if (total > 0) {
+        builder.overwrite(stat_mean, ql::datum_t(sum_secs / total));
+        builder.overwrite(stat_max, ql::datum_t(ticks_to_secs(max_duration)));
+        for (const auto &p : histogram_percentiles) {
+            builder.overwrite(p.name, ql::datum_t(ticks_to_secs(percentile(p.q))));
+        }
+    } else {
+        builder.overwrite(stat_mean, ql::datum_t::null());
+        builder.overwrite(stat_max, ql::datum_t::null());
+        for (const auto &p : histogram_percentiles) {
+            builder.overwrite(p.name, ql::datum_t::null());
+        }
+    }
+
+    if (include_buckets) {
+        // Stored as a flat list of (bucket, count) pairs, skipping empty buckets.
+        ql::datum_array_builder_t buckets(ql::configured_limits_t::unlimited);
+        for (size_t i = 0; i < NUM_BUCKETS; ++i) {
+            if (counts[i] != 0) {
+                buckets.add(ql::datum_t(static_cast<double>(i)));
+                buckets.add(ql::datum_t(static_cast<double>(counts[i])));
+            }
+        }
+        builder.overwrite(stat_buckets, std::move(buckets).to_datum());
+    }
+
+    return std::move(builder).to_datum();
+}
+
+bool latency_histogram_t::merge_datum(const ql::datum_t &datum) {
+    if (datum.get_type() != ql::datum_t::R_OBJECT) {
+        return false;
+    }
+    ql::datum_t buckets = datum.get_field(stat_buckets, ql::throw_bool_t::NOTHROW);
+    if (!buckets.has() || buckets.get_type() != ql::datum_t::R_ARRAY
+        || buckets.arr_size() % 2 != 0) {
+        return false;
+    }
+
+    latency_histogram_t other;
+    for (size_t i = 0; i < buckets.arr_size(); i += 2) {
+        ql::datum_t bucket = buckets.get(i);
+        ql::datum_t count = buckets.get(i + 1);
+        if (bucket.get_type() != ql::datum_t::R_NUM
+            || count.get_type() != ql::datum_t::R_NUM
+            || bucket.as_num() < 0 || bucket.as_num() >= NUM_BUCKETS
+            || count.as_num() < 0) {
+            return false;
+        }
+        const uint64_t n = static_cast<uint64_t>(count.as_num());
+        other.counts[static_cast<size_t>(bucket.as_num())] += n;
+        other.total += n;
+    }
+    if (other.total > 0) {
+        ql::datum_t mean = datum.get_field(stat_mean, ql::throw_bool_t::NOTHROW);
+        ql::datum_t max = datum.get_field(stat_max, ql::throw_bool_t::NOTHROW);
+        if (!mean.has() || mean.get_type() != ql::datum_t::R_NUM
+            || !max.has() || max.get_type() != ql::datum_t::R_NUM) {
+            return false;
+        }
+        other.sum_secs = mean.as_num() * other.total;
+        other.max_duration = static_cast<ticks_t>(max.as_num() * BILLION + 0.5);
+    }
+
+    merge(other);
+    return true;
+}
+
+perfmon_histogram_t::perfmon_histogram_t(ticks_t _length)
+    : perfmon_perthread_t<latency_histogram_t>(), length(_length) {
+    std::fill(thread_data, thread_data + MAX_THREADS, nullptr);
+}
+
+perfmon_histogram_t::~perfmon_histogram_t() {
+    for (int i = 0; i < MAX_THREADS; ++i) {
+        delete thread_data[i];
+    }
+}
+
+perfmon_histogram_t::thread_info_t *perfmon_histogram_t::get_thread_info(ticks_t now) {
+    const int64_t interval = now / length;
+    rassert(get_thread_id().threadnum >= 0);
+    thread_info_t *&thread = thread_data[get_thread_id().threadnum];
+    if (thread == nullptr) {
+        thread = new thread_info_t;
+        thread->current_interval = interval;
+    }
+
+    if (thread->current_interval == interval) {
+        /* We're up to date; nothing to do */
+    } else if (thread->current_interval + 1 == interval) {
+        /* We're one step behind */
+        thread->last_histogram = thread->current_histogram;
+        thread->current_histogram = latency_histogram_t();
+        thread->current_interval++;
+    } else {
+        /* We're more than one step behind */
+        thread->last_histogram = thread->current_histogram = latency_histogram_t();
+        thread->current_interval = interval;
+    }
+    return thread;
+}
+
+void perfmon_histogram_t::record(ticks_t duration) {
+    get_thread_info(get_ticks())->current_histogram.record(duration);
+}
+
+void perfmon_histogram_t::get_thread_stat(latency_histogram_t *stat) {
+    /* Like `perfmon_sampler_t`, report the last complete interval. */
+    rassert(get_thread_id().threadnum >= 0);
+    if (thread_data[get_thread_id().threadnum] != nullptr) {
+        *stat = get_thread_info(get_ticks())->last_histogram;
+    }
+}
+
+latency_histogram_t perfmon_histogram_t::combine_stats(const latency_histogram_t *stats) {
+    latency_histogram_t combined;
+    for (int i = 0; i < get_num_threads(); ++i) {
+        combined.merge(stats[i]);
+    }
+    return combined;
+}
+
+ql::datum_t perfmon_histogram_t::output_stat(const latency_histogram_t &combined) {
+    return combined.to_datum(true);
+}
+
 /* perfmon_rate_monitor_t */
 
 perfmon_rate_monitor_t::perfmon_rate_monitor_t(ticks_t _length)
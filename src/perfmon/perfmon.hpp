@@ -188,6 +188,80 @@ private:
     cache_line_padded_t<stddev_t> thread_data[MAX_THREADS];
 };
 
+/* `latency_histogram_t` counts durations in log-linear buckets: every power of two
+ * is split into 2^SUB_BUCKET_BITS equal sub-buckets, so a percentile read off the
+ * histogram is within 1/16 of the true value. Unlike averages, histograms from
+ * different threads (or different servers) can be merged exactly, which is what
+ * lets us report percentiles for the whole cluster.
+ */
+class latency_histogram_t {
+public:
+    static const int SUB_BUCKET_BITS = 4;
+    // Durations of 2^MAX_DURATION_BITS ticks (about 18 minutes) or more all end up
+    // in the last bucket.
+    static const int MAX_DURATION_BITS = 40;
+    static const size_t NUM_BUCKETS =
+        (MAX_DURATION_BITS - SUB_BUCKET_BITS + 1) << SUB_BUCKET_BITS;
+
+    latency_histogram_t();
+
+    void record(ticks_t duration);
+    void merge(const latency_histogram_t &other);
+
+    uint64_t count() const { return total; }
+    // Returns the largest duration that falls into the same bucket as the
+    // `q`-quantile of the recorded durations, for 0 < q <= 1.
+    ticks_t percentile(double q) const;
+
+    // Produces the count, mean, max and a few percentiles, in seconds. If
+    // `include_buckets` is true it also produces the non-empty buckets, so that
+    // `merge_datum` can reconstruct the histogram on another server.
+    ql::datum_t to_datum(bool include_buckets) const;
+    // Merges in the result of `to_datum(true)`. Returns false if `datum` doesn't
+    // look like one.
+    bool merge_datum(const ql::datum_t &datum);
+
+    static size_t bucket_for_duration(ticks_t duration);
+    static ticks_t bucket_max_duration(size_t bucket);
+
+private:
+    uint64_t counts[NUM_BUCKETS];
+    uint64_t total;
+    ticks_t max_duration;
+    double sum_secs;
+};
+
+/* `perfmon_histogram_t` reports percentiles of the durations recorded in the last
+ * complete interval of `length` ticks. Each thread records into its own histogram
+ * without any synchronization; the histograms are merged when the stats are
+ * collected. The per-thread histograms are allocated the first time a thread
+ * records something, because most perfmons are only ever touched by a few threads.
+ */
+class perfmon_histogram_t : public perfmon_perthread_t<latency_histogram_t> {
+public:
+    explicit perfmon_histogram_t(ticks_t _length = secs_to_ticks(10));
+    virtual ~perfmon_histogram_t();
+    void record(ticks_t duration);
+
+protected:
+    void get_thread_stat(latency_histogram_t *);
+    latency_histogram_t combine_stats(const latency_histogram_t *);
+    ql::datum_t output_stat(const latency_histogram_t &);
+
+private:
+    struct thread_info_t {
+        latency_histogram_t current_histogram, last_histogram;
+        int64_t current_interval;
+    };
+
+    thread_info_t *get_thread_info(ticks_t now);
+
+    ticks_t length;
+    thread_info_t *thread_data[MAX_THREADS];
+
+    DISABLE_COPYING(perfmon_histogram_t);
+};
+
 /* `perfmon_rate_monitor_t` keeps track of the number of times some event
  * happens per second. It is different from `perfmon_sampler_t` in that it does
  * not associate a number with each event, but you can record many events at
@@ -6,6 +6,7 @@ class perfmon_collection_t;
 class perfmon_counter_t;
 class perfmon_sampler_t;
 struct perfmon_stddev_t;
+class perfmon_histogram_t;
 struct perfmon_duration_sampler_t;
 class perfmon_rate_monitor_t;
 struct perfmon_function_t;
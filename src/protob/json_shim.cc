@@ -1,6 +1,8 @@
 #include "protob/json_shim.hpp"
 
 #include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
 
 #include "debug.hpp"
 #include "http/json.hpp"
@@ -18,170 +20,220 @@ public:
     const char *what() const throw () { return "json_shim::exc_t"; }
 };
 
-template<class T>
-typename std::enable_if<!((std::is_enum<T>::value || std::is_fundamental<T>::value)
-                          && !std::is_same<T, bool>::value)>::type
-extract(cJSON *, T *);
+/* `query_parser_t` reads a query in the JSON wire format and builds the `Query`
+protobuf as it goes, without going through a cJSON tree first.  It accepts the same
+JSON that `cJSON_Parse()` does, with the same quirks (a number may be followed by
+garbage that the enclosing array or object then rejects, `\x` is `x`, and so on),
+except that it rejects unpaired UTF-16 surrogates instead of dropping them.
 
-template<class T>
-typename std::enable_if<(std::is_enum<T>::value || std::is_fundamental<T>::value)
-                        && !std::is_same<T, bool>::value>::type
-extract(cJSON *field, T *dest) {
-    if (field->type != cJSON_Number) throw exc_t();
-    T t = static_cast<T>(field->valuedouble);
-    if (static_cast<double>(t) != field->valuedouble) throw exc_t();
-    *dest = t;
-}
+The layout of a query is `[type, term, global_optargs]`, except for `EXECUTE`
+queries, which are `[type, prepared_token, [arg, ...], global_optargs]` with each
+argument a plain JSON value.  A term is either
+`[type, args, optargs]`, an object (which becomes a `MAKE_OBJ` term), or any other
+JSON value (which becomes a `DATUM` term). */
+class query_parser_t {
+public:
+    explicit query_parser_t(const char *str) : p(str) { }
 
-template<class T>
-void safe_extract(cJSON *json, T *t) {
-    if (json != NULL && t != NULL) {
-        extract(json, t);
+    void parse_query(Query *q) {
+        skip_whitespace();
+        size_t index = 0;
+        parse_container([&](const std::string *) {
+            // `EXECUTE` queries have an extra element before the global optargs.
+            const size_t optargs_index = q->type() == Query::EXECUTE ? 3 : 2;
+            if (index == 0) {
+                q->set_type(parse_enum<Query::QueryType>());
+            } else if (index == optargs_index) {
+                parse_container([&](const std::string *key) {
+                    if (key == NULL) throw exc_t();
+                    Query::AssocPair *ap = q->add_global_optargs();
+                    ap->set_key(*key);
+                    parse_term(ap->mutable_val());
+                });
+            } else if (index == 1 && q->type() == Query::EXECUTE) {
+                q->set_prepared_token(parse_integer());
+            } else if (index == 2 && q->type() == Query::EXECUTE) {
+                if (*p != '[') throw exc_t();
+                parse_container([&](const std::string *) {
+                    parse_datum(q->add_prepared_args());
+                });
+            } else if (index == 1) {
+                parse_term(q->mutable_query());
+            } else {
+                skip_value();
+            }
+            ++index;
+        });
+        skip_whitespace();
+        if (*p != '\0') throw exc_t();
     }
-}
 
-template<class T, class U>
-void transfer(cJSON *json, T *dest, void (T::*setter)(U)) {
-    U tmp;
-    if (json != NULL) {
-        safe_extract(json, &tmp);
-        (dest->*setter)(std::move(tmp));
+private:
+    void skip_whitespace() {
+        while (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n') ++p;
     }
-}
 
-template<class T, class U>
-void transfer(cJSON *json, T *dest, U *(T::*mut)()) {
-    if (json != NULL) {
-        safe_extract(json, (dest->*mut)());
+    bool is_container() const {
+        return *p == '[' || *p == '{';
     }
-}
 
-template<class T, class U>
-void transfer_arr(cJSON *arr, T *dest, U *(T::*adder)()) {
-    if (arr != NULL) {
-        if (arr->type != cJSON_Object && arr->type != cJSON_Array) throw exc_t();
-        for (cJSON *item = arr->head; item != NULL; item = item->next) {
-            safe_extract(item, (dest->*adder)());
+    // Calls `fn` once for every value in the array or object at `p`, with `p`
+    // pointing at the value.  `fn` must consume the value.  The key is passed for
+    // objects, and NULL for arrays.
+    template <class callable_t>
+    void parse_container(callable_t &&fn) {
+        const char close = *p == '[' ? ']' : '}';
+        if (!is_container()) throw exc_t();
+        ++p;
+        skip_whitespace();
+        if (*p == close) {
+            ++p;
+            return;
+        }
+        std::string key;
+        for (;;) {
+            skip_whitespace();
+            if (close == '}') {
+                key.clear();
+                parse_string(&key);
+                skip_whitespace();
+                if (*p != ':') throw exc_t();
+                ++p;
+                skip_whitespace();
+                fn(&key);
+            } else {
+                fn(static_cast<const std::string *>(NULL));
+            }
+            skip_whitespace();
+            if (*p == ',') {
+                ++p;
+            } else if (*p == close) {
+                ++p;
+                return;
+            } else {
+                throw exc_t();
+            }
         }
     }
-}
-
-template<>
-void extract(cJSON *field, std::string *s) {
-    if (field->type != cJSON_String) throw exc_t();
-    *s = field->valuestring;
-}
-
-template<>
-void extract(cJSON *field, bool *dest) {
-    if (field->type == cJSON_False) {
-        *dest = false;
-    } else if (field->type == cJSON_True) {
-        *dest = true;
-    } else {
-        throw exc_t();
-    }
-}
 
-template<>
-void extract(cJSON *json, Term *t) {
-    if (json->type == cJSON_Array) {
-        // It's ok to use the slow functions here, because the indexes are small
-        transfer(cJSON_slow_GetArrayItem(json, 0), t, &Term::set_type);
-        transfer_arr(cJSON_slow_GetArrayItem(json, 1), t, &Term::add_args);
-        transfer_arr(cJSON_slow_GetArrayItem(json, 2), t, &Term::add_optargs);
-    } else if (json->type == cJSON_Object) {
-        t->set_type(Term::MAKE_OBJ);
-        transfer_arr(json, t, &Term::add_optargs);
-    } else {
-        t->set_type(Term::DATUM);
-        transfer(json, t, &Term::mutable_datum);
+    void parse_term(Term *t) {
+        if (*p == '[') {
+            size_t index = 0;
+            parse_container([&](const std::string *) {
+                switch (index++) {
+                case 0: t->set_type(parse_enum<Term::TermType>()); break;
+                case 1: parse_container([&](const std::string *) {
+                            parse_term(t->add_args());
+                        });
+                    break;
+                case 2: parse_container([&](const std::string *key) {
+                            if (key == NULL) throw exc_t();
+                            Term::AssocPair *ap = t->add_optargs();
+                            ap->set_key(*key);
+                            parse_term(ap->mutable_val());
+                        });
+                    break;
+                default: skip_value(); break;
+                }
+            });
+        } else if (*p == '{') {
+            t->set_type(Term::MAKE_OBJ);
+            parse_container([&](const std::string *key) {
+                Term::AssocPair *ap = t->add_optargs();
+                ap->set_key(*key);
+                parse_term(ap->mutable_val());
+            });
+        } else {
+            t->set_type(Term::DATUM);
+            parse_datum(t->mutable_datum());
+        }
     }
-}
 
-template<>
-void extract(cJSON *json, Datum *d) {
-    switch (json->type) {
-    case cJSON_False:
-        d->set_type(Datum::R_BOOL);
-        d->set_r_bool(false);
-        break;
-    case cJSON_True:
-        d->set_type(Datum::R_BOOL);
-        d->set_r_bool(true);
-        break;
-    case cJSON_NULL:
-        d->set_type(Datum::R_NULL);
-        break;
-    case cJSON_Number:
-        d->set_type(Datum::R_NUM);
-        d->set_r_num(json->valuedouble);
-        break;
-    case cJSON_String:
-        d->set_type(Datum::R_STR);
-        d->set_r_str(json->valuestring);
-        break;
-    case cJSON_Array:
-        {
+    void parse_datum(Datum *d) {
+        if (strncmp(p, "null", 4) == 0) {
+            p += 4;
+            d->set_type(Datum::R_NULL);
+        } else if (strncmp(p, "false", 5) == 0) {
+            p += 5;
+            d->set_type(Datum::R_BOOL);
+            d->set_r_bool(false);
+        } else if (strncmp(p, "true", 4) == 0) {
+            p += 4;
+            d->set_type(Datum::R_BOOL);
+            d->set_r_bool(true);
+        } else if (*p == '"') {
+            d->set_type(Datum::R_STR);
+            parse_string(d->mutable_r_str());
+        } else if (*p == '[') {
             d->set_type(Datum::R_ARRAY);
-            for (cJSON *item = json->head; item != NULL; item = item->next) {
-                extract(item, d->add_r_array());
-            }
-        }
-        break;
-    case cJSON_Object:
-        {
+            parse_container([&](const std::string *) {
+                parse_datum(d->add_r_array());
+            });
+        } else if (*p == '{') {
             d->set_type(Datum::R_OBJECT);
-            for (cJSON *item = json->head; item != NULL; item = item->next) {
+            parse_container([&](const std::string *key) {
                 Datum::AssocPair *ap = d->add_r_object();
-                ap->set_key(item->string);
-                extract(item, ap->mutable_val());
-            }
+                ap->set_key(*key);
+                parse_datum(ap->mutable_val());
+            });
+        } else {
+            d->set_type(Datum::R_NUM);
+            d->set_r_num(parse_number());
         }
-        break;
-    default:
-        unreachable();
     }
-}
 
-template<>
-void extract(cJSON *json, Query::AssocPair *ap) {
-    if (json->string == NULL) throw exc_t();
-    ap->set_key(json->string);
-    extract(json, ap->mutable_val());
-}
+    void skip_value() {
+        Datum ignored;
+        parse_datum(&ignored);
+    }
 
-template<>
-void extract(cJSON *json, Term::AssocPair *ap) {
-    if (json->string == NULL) throw exc_t();
-    ap->set_key(json->string);
-    extract(json, ap->mutable_val());
-}
+    double parse_number() {
+        if (*p != '-' && !(*p >= '0' && *p <= '9')) throw exc_t();
+        // Like cJSON, we read `0x...` as a 0 followed by garbage, rather than
+        // letting `strtod` parse it as a hexadecimal float.
+        if (p[0] == '0' && (p[1] == 'x' || p[1] == 'X')) {
+            ++p;
+            return 0;
+        }
+        char *end;
+        const double ret = strtod(p, &end);
+        if (end == p) throw exc_t();
+        p = end;
+        return ret;
+    }
 
-template<>
-void extract(cJSON *json, Datum::AssocPair *ap) {
-    if (json->string == NULL) throw exc_t();
-    ap->set_key(json->string);
-    extract(json, ap->mutable_val());
-}
+    int64_t parse_integer() {
+        const double d = parse_number();
+        // Tokens above 2^53 can't be sent exactly as JSON numbers anyway.
+        if (d < -9007199254740992.0 || d > 9007199254740992.0) throw exc_t();
+        const int64_t i = static_cast<int64_t>(d);
+        if (static_cast<double>(i) != d) throw exc_t();
+        return i;
+    }
 
-template<>
-void extract(cJSON *json, Query *q) {
-    // It's ok to use the slow functions here, because the indexes are small
-    transfer(cJSON_slow_GetArrayItem(json, 0), q, &Query::set_type);
-    transfer(cJSON_slow_GetArrayItem(json, 1), q, &Query::mutable_query);
-    q->set_accepts_r_json(true);
-    transfer_arr(cJSON_slow_GetArrayItem(json, 2), q, &Query::add_global_optargs);
-}
+    template <class T>
+    T parse_enum() {
+        const double d = parse_number();
+        const int32_t i = static_cast<int32_t>(d);
+        if (static_cast<double>(i) != d) throw exc_t();
+        return static_cast<T>(i);
+    }
+
+    // Appends the unescaped string at `p` to `out`.
+    void parse_string(std::string *out) {
+        if (!json_parse_string(&p, out)) throw exc_t();
+    }
+
+    const char *p;
+};
 
 bool parse_json_pb(Query *q, int64_t token, const char *str) THROWS_NOTHING {
     try {
         q->Clear();
         q->set_token(token);
-        scoped_cJSON_t json_holder(cJSON_Parse(str));
-        cJSON *json = json_holder.get();
-        if (json == NULL) return false;
-        extract(json, q);
+        q->set_accepts_r_json(true);
+        query_parser_t parser(str);
+        parser.parse_query(q);
         return true;
     } catch (const exc_t &) {
         // This happens if the user provides bad JSON.  TODO: Give the user a
@@ -215,8 +267,7 @@ void write_json_pb(const Response &r, std::string *s) THROWS_NOTHING {
             if (d->type() == Datum::R_JSON) {
                 *s += d->r_str();
             } else if (d->type() == Datum::R_STR) {
-                scoped_cJSON_t tmp(cJSON_CreateString(d->r_str().c_str()));
-                *s += tmp.PrintUnformatted();
+                json_append_string(d->r_str().data(), d->r_str().size(), s);
             } else {
                 unreachable();
             }
@@ -10,6 +10,10 @@ class Response;
 template<class T>
 class scoped_array_t;
 
+// The JSON protocol still goes through the protobuf messages in both directions:
+// the ReQL compiler consumes `Term` protobufs, and the query cache fills in a
+// `Response`.  The rows of a JSON `Response` are `R_JSON` datums that already hold
+// their serialized text, so `write_json_pb` only copies them into place.
 namespace json_shim {
 MUST_USE bool parse_json_pb(Query *q, int64_t token, const char *str) THROWS_NOTHING;
 // `write_json_pb()` appends the encoded response onto out, leaving any existing
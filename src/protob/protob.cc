@@ -191,6 +191,13 @@ public:
         const size_t prefix_size = sizeof(token) + sizeof(data_size);
         // Reserve space for the token and the size
         std::string str(prefix_size, '\0');
+        // The rows of a JSON response are already serialized, so we can size the
+        // buffer up front instead of growing it row by row.
+        size_t expected_size = str.size() + 64;
+        for (int i = 0; i < response.response_size(); ++i) {
+            expected_size += response.response(i).r_str().size() + 1;
+        }
+        str.reserve(expected_size);
 
         json_shim::write_json_pb(response, &str);
         guarantee(str.size() >= prefix_size);
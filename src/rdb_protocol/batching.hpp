@@ -61,6 +61,9 @@ public:
         return end_time > cur_time ? end_time - cur_time : 0;
     }
     batch_type_t get_batch_type() { return batch_type; }
+    // The most elements the batch can still take; scans use this to bound how far
+    // ahead they read.
+    int64_t max_els_left() const { return els_left; }
 private:
     DISABLE_COPYING(batcher_t);
     friend class batchspec_t;
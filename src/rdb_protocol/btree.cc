@@ -1,6 +1,8 @@
 // Copyright 2010-2014 RethinkDB, all rights reserved.
 #include "rdb_protocol/btree.hpp"
 
+#include <algorithm>
+#include <exception>
 #include <functional>
 #include <iterator>
 #include <set>
@@ -12,14 +14,17 @@
 
 #include "btree/backfill.hpp"
 #include "btree/concurrent_traversal.hpp"
+#include "btree/depth_first_traversal.hpp"
 #include "btree/get_distribution.hpp"
+#include "btree/internal_node.hpp"
 #include "btree/operations.hpp"
 #include "btree/parallel_traversal.hpp"
 #include "btree/reql_specific.hpp"
 #include "btree/superblock.hpp"
 #include "buffer_cache/serialize_onto_blob.hpp"
-#include "concurrency/coro_pool.hpp"
-#include "concurrency/queue/unlimited_fifo.hpp"
+#include "concurrency/auto_drainer.hpp"
+#include "concurrency/pmap.hpp"
+#include "config/args.hpp"
 #include "containers/archive/boost_types.hpp"
 #include "containers/archive/buffer_group_stream.hpp"
 #include "containers/archive/buffer_stream.hpp"
@@ -34,6 +39,7 @@
 #include "rdb_protocol/serialize_datum_onto_blob.hpp"
 #include "rdb_protocol/shards.hpp"
 #include "rdb_protocol/table_common.hpp"
+#include "time.hpp"
 
 #include "debug.hpp"
 
@@ -209,36 +215,26 @@ kv_location_set(keyvalue_location_t *kv_location,
     return ql::serialization_result_t::SUCCESS;
 }
 
-batched_replace_response_t rdb_replace_and_return_superblock(
-    const btree_loc_info_t &info,
+/* Replaces the row in `kv_location`, which has been found for `key`. */
+batched_replace_response_t rdb_replace_at_location(
+    const btree_info_t &info,
+    const store_key_t &key,
+    keyvalue_location_t *kv_location,
     const btree_point_replacer_t *replacer,
     const deletion_context_t *deletion_context,
-    promise_t<superblock_t *> *superblock_promise,
-    rdb_modification_info_t *mod_info_out,
-    profile::trace_t *trace) {
+    rdb_modification_info_t *mod_info_out) {
     const return_changes_t return_changes = replacer->should_return_changes();
-    const datum_string_t &primary_key = info.btree->primary_key;
-    const store_key_t &key = *info.key;
+    const datum_string_t &primary_key = info.primary_key;
 
     try {
-        keyvalue_location_t kv_location;
-        rdb_value_sizer_t sizer(info.superblock->cache()->max_block_size());
-        find_keyvalue_location_for_write(&sizer, info.superblock,
-                                         info.key->btree_key(),
-                                         deletion_context->balancing_detacher(),
-                                         &kv_location,
-                                         &info.btree->slice->stats,
-                                         trace,
-                                         superblock_promise);
-
         ql::datum_t old_val;
-        if (!kv_location.value.has()) {
+        if (!kv_location->value.has()) {
             // If there's no entry with this key, pass NULL to the function.
             old_val = ql::datum_t::null();
         } else {
             // Otherwise pass the entry with this key to the function.
-            old_val = get_data(kv_location.value_as<rdb_value_t>(),
-                               buf_parent_t(&kv_location.buf));
+            old_val = get_data(kv_location->value_as<rdb_value_t>(),
+                               buf_parent_t(&kv_location->buf));
             guarantee(old_val.get_field(primary_key, ql::NOTHROW).has());
         }
         guarantee(old_val.has());
@@ -261,13 +257,13 @@ batched_replace_response_t rdb_replace_and_return_superblock(
 
             /* Now that the change has passed validation, write it to disk */
             if (new_val.get_type() == ql::datum_t::R_NULL) {
-                kv_location_delete(&kv_location, *info.key, info.btree->timestamp,
+                kv_location_delete(kv_location, key, info.timestamp,
                                    deletion_context, mod_info_out);
             } else {
                 r_sanity_check(new_val.get_field(primary_key, ql::NOTHROW).has());
                 ql::serialization_result_t res =
-                    kv_location_set(&kv_location, *info.key, new_val,
-                                    info.btree->timestamp, deletion_context,
+                    kv_location_set(kv_location, key, new_val,
+                                    info.timestamp, deletion_context,
                                     mod_info_out);
                 if (res & ql::serialization_result_t::ARRAY_TOO_BIG) {
                     rfail_typed_target(&new_val, "Array too large for disk writes "
@@ -324,37 +320,13 @@ private:
     const size_t index;
 };
 
-void do_a_replace_from_batched_replace(
+void do_a_mod_report_from_batched_replace(
     auto_drainer_t::lock_t,
-    fifo_enforcer_sink_t *batched_replaces_fifo_sink,
-    const fifo_enforcer_write_token_t &batched_replaces_fifo_token,
-    const btree_loc_info_t &info,
-    const one_replace_t one_replace,
-    const ql::configured_limits_t &limits,
-    promise_t<superblock_t *> *superblock_promise,
     rdb_modification_report_cb_t *sindex_cb,
+    const rdb_modification_report_t &mod_report,
     bool update_pkey_cfeeds,
-    batched_replace_response_t *stats_out,
-    profile::sampler_t *sampler,
-    profile::trace_t *trace,
-    std::set<std::string> *conditions)
-{
-    sampler->new_sample();
-    fifo_enforcer_sink_t::exit_write_t exiter(
-        batched_replaces_fifo_sink, batched_replaces_fifo_token);
-
-    rdb_live_deletion_context_t deletion_context;
-    rdb_modification_report_t mod_report(*info.key);
-    ql::datum_t res = rdb_replace_and_return_superblock(
-        info, &one_replace, &deletion_context, superblock_promise, &mod_report.info,
-        trace);
-    *stats_out = (*stats_out).merge(res, ql::stats_merge, limits, conditions);
-
-    // We wait to make sure we acquire `acq` in the same order we were
-    // originally called.
-    exiter.wait();
-    scoped_ptr_t<new_mutex_in_line_t> acq = sindex_cb->get_in_line();
-
+    new_mutex_in_line_t *spot) {
+    scoped_ptr_t<new_mutex_in_line_t> acq(spot);
     sindex_cb->on_mod_report(mod_report, update_pkey_cfeeds, acq.get());
 }
 
@@ -368,51 +340,71 @@ batched_replace_response_t rdb_batched_replace(
     profile::sampler_t *sampler,
     profile::trace_t *trace) {
 
-    fifo_enforcer_source_t source;
-    fifo_enforcer_sink_t sink;
-
     ql::datum_t stats = ql::datum_t::empty_object();
 
     std::set<std::string> conditions;
 
-    // We have to drain write operations before destructing everything above us,
+    // We apply the rows in the order of their keys. All the rows that belong into
+    // the same leaf node are then applied one after the other with a single descent
+    // from the root, while we hold on to the leaf node.
+    std::vector<size_t> order(keys.size());
+    for (size_t i = 0; i < order.size(); ++i) {
+        order[i] = i;
+    }
+    std::stable_sort(order.begin(), order.end(),
+                     [&](size_t a, size_t b) { return keys[a] < keys[b]; });
+
+    // We have to drain the sindex updates before destructing everything above us,
     // because the coroutines being drained use them.
     {
-        unlimited_fifo_queue_t<std::function<void()> > coro_queue;
-        struct callback_t : public coro_pool_callback_t<std::function<void()> > {
-            virtual void coro_pool_callback(std::function<void()> f, signal_t *) {
-                f();
-            }
-        } callback;
-        const size_t MAX_CONCURRENT_REPLACES = 8;
-        coro_pool_t<std::function<void()> > coro_pool(
-            MAX_CONCURRENT_REPLACES, &coro_queue, &callback);
         // We release the superblock either before or after draining on all the
-        // write operations depending on the presence of limit changefeeds.
+        // sindex updates depending on the presence of limit changefeeds.
         scoped_ptr_t<real_superblock_t> current_superblock(superblock->release());
         bool update_pkey_cfeeds = sindex_cb->has_pkey_cfeeds();
+        rdb_value_sizer_t sizer(current_superblock->cache()->max_block_size());
+        rdb_live_deletion_context_t deletion_context;
         {
             auto_drainer_t drainer;
-            for (size_t i = 0; i < keys.size(); ++i) {
+            size_t i = 0;
+            while (i < order.size()) {
+                std::vector<rdb_modification_report_t> mod_reports;
                 promise_t<superblock_t *> superblock_promise;
-                coro_queue.push(
-                    std::bind(
-                        &do_a_replace_from_batched_replace,
-                        auto_drainer_t::lock_t(&drainer),
-                        &sink,
-                        source.enter_write(),
-                        btree_loc_info_t(&info, current_superblock.release(), &keys[i]),
-                        one_replace_t(replacer, i),
-                        limits,
-                        &superblock_promise,
-                        sindex_cb,
-                        update_pkey_cfeeds,
-                        &stats,
-                        sampler,
-                        trace,
-                        &conditions));
+                {
+                    keyvalue_location_t kv_location;
+                    find_keyvalue_location_for_write(
+                        &sizer, current_superblock.release(),
+                        keys[order[i]].btree_key(),
+                        deletion_context.balancing_detacher(), &kv_location,
+                        &info.slice->stats, trace, &superblock_promise);
+                    do {
+                        sampler->new_sample();
+                        const size_t index = order[i];
+                        mod_reports.push_back(rdb_modification_report_t(keys[index]));
+                        one_replace_t one_replace(replacer, index);
+                        ql::datum_t res = rdb_replace_at_location(
+                            info, keys[index], &kv_location, &one_replace,
+                            &deletion_context, &mod_reports.back().info);
+                        stats = stats.merge(res, ql::stats_merge, limits, &conditions);
+                        ++i;
+                    } while (i < order.size()
+                             && find_keyvalue_location_in_same_leaf(
+                                 &sizer, keys[order[i - 1]].btree_key(),
+                                 keys[order[i]].btree_key(), &kv_location));
+                }
                 current_superblock.init(
                     static_cast<real_superblock_t *>(superblock_promise.wait()));
+
+                // The sindexes are updated in the background while we go on with
+                // the next leaf node. Getting in line here keeps them in order.
+                for (const rdb_modification_report_t &mod_report : mod_reports) {
+                    coro_t::spawn_sometime(
+                        std::bind(&do_a_mod_report_from_batched_replace,
+                                  auto_drainer_t::lock_t(&drainer),
+                                  sindex_cb,
+                                  mod_report,
+                                  update_pkey_cfeeds,
+                                  sindex_cb->get_in_line().release()));
+                }
             }
             if (!update_pkey_cfeeds) {
                 current_superblock.reset(); // Release the superblock early if
@@ -545,16 +537,205 @@ public:
     btree_slice_t *slice_;
 };
 
+/* Sends every key in the range in ascending order, for a backfill to a receiver
+that shares no history with us. Instead of the deletions that the leaf nodes
+remember, each chunk of pairs is preceded by the deletion of the key range that it
+covers, so that the receiver still drops any keys that it has and we don't. */
+class rdb_full_backfill_traversal_cb_t : public depth_first_traversal_callback_t {
+public:
+    rdb_full_backfill_traversal_cb_t(rdb_backfill_callback_t *cb,
+                                     const key_range_t &kr,
+                                     btree_slice_t *slice,
+                                     counted_traversal_progress_t *progress,
+                                     signal_t *interruptor)
+        : cb_(cb), kr_(kr), slice_(slice), progress_(progress),
+          interruptor_(interruptor), chunk_left_(kr.left), reached_end_(false),
+          current_chunk_size_(0), last_checkpoint_time_(current_microtime()) { }
+
+    done_traversing_t handle_pair(scoped_key_value_t &&keyvalue) {
+        backfill_atom_t atom;
+        atom.key.assign(keyvalue.key());
+        atom.value = get_data(static_cast<const rdb_value_t *>(keyvalue.value()),
+                              keyvalue.expose_buf());
+        // The leaf doesn't tell us when each of its pairs was written, but its own
+        // recency is an upper bound, which is all that the receiver needs.
+        atom.recency = keyvalue.leaf_recency();
+        current_chunk_size_ += static_cast<size_t>(atom.key.size())
+            + serialized_size<cluster_version_t::CLUSTER>(atom.value);
+        chunk_atoms_.push_back(std::move(atom));
+        progress_->add_done(1);
+
+        if (current_chunk_size_ >= BACKFILL_MAX_KVPAIRS_SIZE) {
+            send_chunk();
+        }
+        return done_traversing_t::NO;
+    }
+
+    size_t get_max_read_ahead_nodes() {
+        return BTREE_MAX_READ_AHEAD_NODES;
+    }
+
+    // Sends the remaining pairs, and the deletion of the part of the range that
+    // comes after them.
+    void finish() THROWS_ONLY(interrupted_exc_t) {
+        if (!chunk_atoms_.empty()) {
+            send_chunk();
+        }
+        if (!reached_end_) {
+            key_range_t rest = kr_;
+            rest.left = chunk_left_;
+            if (!rest.is_empty()) {
+                cb_->on_delete_range(rest, interruptor_);
+            }
+        }
+    }
+
+private:
+    void send_chunk() THROWS_ONLY(interrupted_exc_t) {
+        store_key_t last_key = chunk_atoms_.back().key;
+        cb_->on_delete_range(key_range_t(key_range_t::closed, chunk_left_,
+                                         key_range_t::closed, last_key),
+                             interruptor_);
+
+        slice_->stats.pm_keys_read.record(chunk_atoms_.size());
+        slice_->stats.pm_total_keys_read += chunk_atoms_.size();
+        cb_->on_keyvalues(std::move(chunk_atoms_), interruptor_);
+        chunk_atoms_ = std::vector<backfill_atom_t>();
+        current_chunk_size_ = 0;
+
+        chunk_left_ = last_key;
+        reached_end_ = !chunk_left_.increment();
+
+        const microtime_t now = current_microtime();
+        if (now >= last_checkpoint_time_ + BACKFILL_CHECKPOINT_INTERVAL_MS * 1000) {
+            last_checkpoint_time_ = now;
+            cb_->on_checkpoint(key_range_t(key_range_t::closed, kr_.left,
+                                           key_range_t::closed, last_key),
+                               interruptor_);
+        }
+    }
+
+    rdb_backfill_callback_t *const cb_;
+    const key_range_t kr_;
+    btree_slice_t *const slice_;
+    counted_traversal_progress_t *const progress_;
+    signal_t *const interruptor_;
+
+    // The left end of the key range that the next chunk covers.
+    store_key_t chunk_left_;
+    bool reached_end_;
+    std::vector<backfill_atom_t> chunk_atoms_;
+    size_t current_chunk_size_;
+    microtime_t last_checkpoint_time_;
+};
+
+class first_key_callback_t : public depth_first_traversal_callback_t {
+public:
+    first_key_callback_t() : found(false) { }
+
+    done_traversing_t handle_pair(scoped_key_value_t &&keyvalue) {
+        key = store_key_t(keyvalue.key());
+        found = true;
+        return done_traversing_t::YES;
+    }
+
+    bool found;
+    store_key_t key;
+};
+
+/* The number of keys a full backfill of `key_range` is going to send, for its progress
+estimate. That's the population in the btree's stat block if every key of the btree
+lies in `key_range`, which takes two root-to-leaf walks to find out. Returns -1 if
+some key lies outside of `key_range`. Writers update the stat block detached from
+the btree, so this might be off by the writes that are in flight. */
+int64_t estimate_full_backfill_population(superblock_t *superblock,
+                                          const key_range_t &key_range) {
+    const block_id_t stat_block_id = superblock->get_stat_block_id();
+    if (stat_block_id == NULL_BLOCK_ID) {
+        return -1;
+    }
+
+    first_key_callback_t first, last;
+    btree_depth_first_traversal(superblock, key_range_t::universe(), &first,
+                                direction_t::FORWARD, release_superblock_t::KEEP);
+    btree_depth_first_traversal(superblock, key_range_t::universe(), &last,
+                                direction_t::BACKWARD, release_superblock_t::KEEP);
+    if (first.found
+        && (!key_range.contains_key(first.key) || !key_range.contains_key(last.key))) {
+        return -1;
+    }
+
+    buf_lock_t stat_block(buf_parent_t(superblock->expose_buf().txn()),
+                          stat_block_id, access_t::read);
+    buf_read_t read(&stat_block);
+    uint32_t sb_size;
+    const btree_statblock_t *sb_data =
+        static_cast<const btree_statblock_t *>(read.get_data_read(&sb_size));
+    guarantee(sb_size == BTREE_STATBLOCK_SIZE);
+    return std::max<int64_t>(sb_data->population, 0);
+}
+
 void rdb_backfill(btree_slice_t *slice, const key_range_t& key_range,
                   repli_timestamp_t since_when, rdb_backfill_callback_t *callback,
                   refcount_superblock_t *superblock,
                   buf_lock_t *sindex_block,
-                  parallel_traversal_progress_t *p, signal_t *interruptor)
+                  traversal_progress_combiner_t *progress, signal_t *interruptor)
     THROWS_ONLY(interrupted_exc_t) {
     agnostic_rdb_backfill_callback_t agnostic_cb(callback, key_range, slice);
-    rdb_value_sizer_t sizer(superblock->cache()->max_block_size());
-    do_agnostic_btree_backfill(&sizer, key_range, since_when, &agnostic_cb,
-                               superblock, sindex_block, p, interruptor);
+
+    if (since_when != repli_timestamp_t::distant_past) {
+        parallel_traversal_progress_t *p = new parallel_traversal_progress_t;
+        scoped_ptr_t<traversal_progress_t> p_owned(p);
+        progress->add_constituent(&p_owned);
+
+        rdb_value_sizer_t sizer(superblock->cache()->max_block_size());
+        do_agnostic_btree_backfill(&sizer, key_range, since_when, &agnostic_cb,
+                                   superblock, sindex_block, p, interruptor);
+        return;
+    }
+
+    counted_traversal_progress_t *p = new counted_traversal_progress_t(
+        estimate_full_backfill_population(superblock, key_range));
+    scoped_ptr_t<traversal_progress_t> p_owned(p);
+    progress->add_constituent(&p_owned);
+
+    backfill_live_sindexes(sindex_block, &agnostic_cb, interruptor);
+
+    rdb_full_backfill_traversal_cb_t traversal_cb(callback, key_range, slice, p,
+                                                  interruptor);
+    btree_depth_first_traversal(superblock, key_range, &traversal_cb, FORWARD,
+                                release_superblock_t::RELEASE);
+    traversal_cb.finish();
+}
+
+rdb_backfill_bulk_loader_t::rdb_backfill_bulk_loader_t(max_block_size_t block_size)
+    : sizer(block_size), loader(&sizer, repli_timestamp_t::distant_past) { }
+
+bool rdb_backfill_bulk_loader_t::is_after_last_key(const store_key_t &key) const {
+    return !last_key || *last_key < key;
+}
+
+void rdb_backfill_bulk_loader_t::append(txn_t *txn, const backfill_atom_t &atom) {
+    const max_block_size_t block_size = txn->cache()->max_block_size();
+    scoped_malloc_t<rdb_value_t> value(blob::btree_maxreflen);
+    memset(value.get(), 0, blob::btree_maxreflen);
+    {
+        blob_t blob(block_size, value->value_ref(), blob::btree_maxreflen);
+        ql::serialization_result_t res
+            = datum_serialize_onto_blob(buf_parent_t(txn), &blob, atom.value);
+        // The value was read from the sender's btree, so it fits into ours.
+        guarantee(!bad(res));
+    }
+    loader.append(txn, atom.key.btree_key(), value.get(), atom.recency);
+    last_key = atom.key;
+}
+
+void rdb_backfill_bulk_loader_t::checkpoint(superblock_t *superblock) {
+    loader.checkpoint(superblock);
+}
+
+void rdb_backfill_bulk_loader_t::finish(superblock_t *superblock) {
+    loader.finish(superblock);
 }
 
 void rdb_delete(const store_key_t &key, btree_slice_t *slice,
@@ -666,12 +847,35 @@ public:
         scoped_key_value_t &&keyvalue,
         concurrent_traversal_fifo_enforcer_signal_t waiter)
         THROWS_ONLY(interrupted_exc_t);
+    virtual size_t get_max_read_ahead_nodes();
     void finish() THROWS_ONLY(interrupted_exc_t);
 private:
+    // Runs the transforms from `first_transform` on and then the accumulator on the
+    // row in `data`.  May throw `ql::exc_t` or `ql::datum_exc_t`.
+    done_traversing_t accumulate_row(ql::groups_t *data,
+                                     const store_key_t &key,
+                                     const ql::datum_t &sindex_val,
+                                     size_t first_transform);
+    size_t max_pending_rows();
+    done_traversing_t flush_pending_rows() THROWS_ONLY(interrupted_exc_t);
+
     const rget_io_data_t io; // How do get data in/out.
     job_data_t job; // What to do next (stateful).
     const boost::optional<rget_sindex_data_t> sindex; // Optional sindex information.
 
+    // If the transforms start with `map`s and `filter`s, rows are collected here
+    // and those transforms are applied to all of them at once, which lets
+    // JavaScript functions evaluate them in one round trip and simple functions
+    // skip the interpreter (see `func_t::call_batch`).  The rest of the
+    // transforms and the accumulator still see one row at a time, in order.
+    struct pending_row_t {
+        store_key_t key;
+        ql::datum_t val;
+        ql::datum_t sindex_val; // NULL if no sindex.
+    };
+    size_t num_rowwise_transforms;
+    std::vector<pending_row_t> pending_rows;
+
     // State for internal bookkeeping.
     bool bad_init;
     scoped_ptr_t<profile::disabler_t> disabler;
@@ -685,16 +889,39 @@ rget_cb_t::rget_cb_t(rget_io_data_t &&_io,
     : io(std::move(_io)),
       job(std::move(_job)),
       sindex(std::move(_sindex)),
+      num_rowwise_transforms(0),
       bad_init(false) {
     io.response->last_key = !reversed(job.sorting)
         ? range.left
         : (!range.right.unbounded ? range.right.key : store_key_t::max());
+    while (num_rowwise_transforms < job.transformers.size()
+           && job.transformers[num_rowwise_transforms]->is_rowwise()) {
+        ++num_rowwise_transforms;
+    }
     disabler.init(new profile::disabler_t(job.env->trace));
     sampler.init(new profile::sampler_t("Range traversal doc evaluation.",
                                         job.env->trace));
 }
 
+size_t rget_cb_t::get_max_read_ahead_nodes() {
+    // A node we read ahead gives us at least one more row (unless it's filtered
+    // out), so there's no point in reading further ahead than the batch can take.
+    // Terminals use `batchspec_t::all()`, so they read ahead as far as allowed.
+    int64_t els_left = job.batcher.max_els_left();
+    return els_left > 0 ? static_cast<uint64_t>(els_left) : 0;
+}
+
+size_t rget_cb_t::max_pending_rows() {
+    // Like with read-ahead, there's no point in collecting more rows than the
+    // batch can take, since every row that survives the transforms is an element.
+    int64_t els_left = job.batcher.max_els_left();
+    return std::max<int64_t>(1, std::min<int64_t>(els_left, RGET_ROWWISE_BATCH_SIZE));
+}
+
 void rget_cb_t::finish() THROWS_ONLY(interrupted_exc_t) {
+    if (!bad_init && boost::get<ql::exc_t>(&io.response->result) == NULL) {
+        flush_pending_rows();
+    }
     job.accumulator->finish(&io.response->result);
     if (job.accumulator->should_send_batch()) {
         io.response->truncated = true;
@@ -762,19 +989,21 @@ done_traversing_t rget_cb_t::handle_pair(
             }
         }
 
-        ql::groups_t data(optional_datum_less_t(job.env->reql_version()));
-        data = {{ql::datum_t(), ql::datums_t{val}}};
+        if (num_rowwise_transforms == 0) {
+            ql::groups_t data(optional_datum_less_t(job.env->reql_version()));
+            data = {{ql::datum_t(), ql::datums_t{val}}};
+            return accumulate_row(&data, key, sindex_val, 0);
+        }
 
-        for (auto it = job.transformers.begin(); it != job.transformers.end(); ++it) {
-            (**it)(job.env, &data, sindex_val);
-            //                     ^^^^^^^^^^ NULL if no sindex
+        pending_row_t row;
+        row.key = std::move(key);
+        row.val = std::move(val);
+        row.sindex_val = std::move(sindex_val);
+        pending_rows.push_back(std::move(row));
+        if (pending_rows.size() < max_pending_rows()) {
+            return done_traversing_t::NO;
         }
-        // We need lots of extra data for the accumulation because we might be
-        // accumulating `rget_item_t`s for a batch.
-        return (*job.accumulator)(job.env,
-                                  &data,
-                                  std::move(key),
-                                  std::move(sindex_val)); // NULL if no sindex
+        return flush_pending_rows();
     } catch (const ql::exc_t &e) {
         io.response->result = e;
         return done_traversing_t::YES;
@@ -788,6 +1017,92 @@ done_traversing_t rget_cb_t::handle_pair(
     }
 }
 
+done_traversing_t rget_cb_t::accumulate_row(ql::groups_t *data,
+                                             const store_key_t &key,
+                                             const ql::datum_t &sindex_val,
+                                             size_t first_transform) {
+    for (auto it = job.transformers.begin() + first_transform;
+         it != job.transformers.end();
+         ++it) {
+        (**it)(job.env, data, sindex_val);
+        //                    ^^^^^^^^^^ NULL if no sindex
+    }
+    // We need lots of extra data for the accumulation because we might be
+    // accumulating `rget_item_t`s for a batch.
+    return (*job.accumulator)(job.env, data, key, sindex_val); // NULL if no sindex
+}
+
+done_traversing_t rget_cb_t::flush_pending_rows() THROWS_ONLY(interrupted_exc_t) {
+    std::vector<pending_row_t> rows;
+    rows.swap(pending_rows);
+
+    // Apply the row-wise transforms to the whole batch.  `live` holds the indices
+    // of the rows that haven't been filtered out.  If a transform fails on a row,
+    // we only report that once we get to the row below: the accumulator might
+    // decide to stop before it, in which case the row is never really read.
+    std::vector<size_t> live(rows.size());
+    for (size_t i = 0; i < rows.size(); ++i) {
+        live[i] = i;
+    }
+    size_t failed_row = rows.size();
+    std::exception_ptr failure;
+    for (size_t t = 0; t < num_rowwise_transforms && !live.empty(); ++t) {
+        ql::datums_t vals;
+        vals.reserve(live.size());
+        for (auto it = live.begin(); it != live.end(); ++it) {
+            vals.push_back(std::move(rows[*it].val));
+        }
+        std::exception_ptr exc;
+        const size_t num_done = job.transformers[t]->apply_rowwise(job.env, &vals, &exc);
+        std::vector<size_t> survivors;
+        survivors.reserve(num_done);
+        for (size_t i = 0; i < num_done; ++i) {
+            if (vals[i].has()) {
+                rows[live[i]].val = std::move(vals[i]);
+                survivors.push_back(live[i]);
+            }
+        }
+        if (exc != std::exception_ptr()) {
+            failed_row = live[num_done];
+            failure = exc;
+        }
+        live.swap(survivors);
+    }
+
+    // Then feed the rows to the rest of the pipeline one at a time, in order, as
+    // if we had handled them as they came in.
+    size_t next_live = 0;
+    for (size_t i = 0; i < rows.size() && i <= failed_row; ++i) {
+        try {
+            if (i == failed_row) {
+                std::rethrow_exception(failure);
+            }
+            ql::groups_t data(optional_datum_less_t(job.env->reql_version()));
+            if (next_live < live.size() && live[next_live] == i) {
+                ++next_live;
+                data = {{ql::datum_t(), ql::datums_t{std::move(rows[i].val)}}};
+            }
+            if (accumulate_row(&data, rows[i].key, rows[i].sindex_val,
+                               num_rowwise_transforms) == done_traversing_t::YES) {
+                // The rows after this one were never considered.
+                io.response->last_key = rows[i].key;
+                return done_traversing_t::YES;
+            }
+        } catch (const ql::exc_t &e) {
+            io.response->result = e;
+            return done_traversing_t::YES;
+        } catch (const ql::datum_exc_t &e) {
+#ifndef NDEBUG
+            unreachable();
+#else
+            io.response->result = ql::exc_t(e, NULL);
+            return done_traversing_t::YES;
+#endif // NDEBUG
+        }
+    }
+    return done_traversing_t::NO;
+}
+
 // TODO: Having two functions which are 99% the same sucks.
 void rdb_rget_slice(
         btree_slice_t *slice,
@@ -802,6 +1117,7 @@ void rdb_rget_slice(
         release_superblock_t release_superblock) {
 
     r_sanity_check(boost::get<ql::exc_t>(&response->result) == NULL);
+
     profile::starter_t starter("Do range scan on primary index.", ql_env->trace);
     rget_cb_t callback(
         rget_io_data_t(response, slice),
@@ -1564,123 +1880,116 @@ void rdb_update_sindexes(
     }
 }
 
+/* Post construction splits the primary key space into a few ranges that are
+traversed concurrently. For each range, the secondary index entries of the rows
+are computed without holding any write locks, collected into a buffer and sorted
+by secondary index key. Then they are written to the index a chunk at a time, so
+that consecutive insertions mostly go into the same sindex leaf nodes. */
 class post_construct_traversal_helper_t : public btree_traversal_helper_t {
 public:
     post_construct_traversal_helper_t(
             store_t *store,
             const std::set<uuid_u> &sindexes_to_post_construct,
+            const std::map<uuid_u, sindex_disk_info_t> &sindex_infos,
+            const key_range_t &range,
             cond_t *interrupt_myself,
             signal_t *interruptor
             )
         : store_(store),
           sindexes_to_post_construct_(sindexes_to_post_construct),
+          sindex_infos_(sindex_infos),
+          range_(range),
           interrupt_myself_(interrupt_myself), interruptor_(interruptor)
     { }
 
     void process_a_leaf(buf_lock_t *leaf_node_buf,
                         const btree_key_t *, const btree_key_t *,
                         signal_t *, int *) THROWS_ONLY(interrupted_exc_t) {
-
-        scoped_ptr_t<txn_t> wtxn;
-        store_t::sindex_access_vector_t sindexes;
-
         buf_read_t leaf_read(leaf_node_buf);
         const leaf_node_t *leaf_node
             = static_cast<const leaf_node_t *>(leaf_read.get_data_read());
+        const max_block_size_t block_size = leaf_node_buf->cache()->max_block_size();
 
         // Number of key/value pairs we process before yielding
         const int MAX_CHUNK_SIZE = 10;
         int current_chunk_size = 0;
-        const rdb_post_construction_deletion_context_t deletion_context;
         for (auto it = leaf::begin(*leaf_node); it != leaf::end(*leaf_node); ++it) {
-            if (current_chunk_size == 0) {
-                // Start a write transaction and acquire the secondary index
-                // at the beginning of each chunk. We reset the transaction
-                // after each chunk because large write transactions can cause
-                // the cache to go into throttling, and that would interfere
-                // with other transactions on this table.
-                try {
-                    write_token_t token;
-                    store_->new_write_token(&token);
-
-                    scoped_ptr_t<real_superblock_t> superblock;
-
-                    // We use HARD durability because we want post construction
-                    // to be throttled if we insert data faster than it can
-                    // be written to disk. Otherwise we might exhaust the cache's
-                    // dirty page limit and bring down the whole table.
-                    // Other than that, the hard durability guarantee is not actually
-                    // needed here.
-                    store_->acquire_superblock_for_write(
-                            repli_timestamp_t::distant_past,
-                            2 + MAX_CHUNK_SIZE,
-                            write_durability_t::HARD,
-                            &token,
-                            &wtxn,
-                            &superblock,
-                            interruptor_);
-
-                    // Acquire the sindex block.
-                    const block_id_t sindex_block_id = superblock->get_sindex_block_id();
-
-                    buf_lock_t sindex_block(superblock->expose_buf(), sindex_block_id,
-                                            access_t::write);
-
-                    superblock.reset();
-
-                    store_->acquire_sindex_superblocks_for_write(
-                            sindexes_to_post_construct_,
-                            &sindex_block,
-                            &sindexes);
+            /* Grab relevant values from the leaf node. */
+            const btree_key_t *key = (*it).first;
+            const void *value = (*it).second;
+            guarantee(key);
 
-                    if (sindexes.empty()) {
-                        interrupt_myself_->pulse_if_not_already_pulsed();
-                        return;
-                    }
-                } catch (const interrupted_exc_t &e) {
-                    return;
-                }
+            // Leaf nodes on the boundary of our range are also visited by the
+            // traversal of the neighbouring range.
+            if (!range_.contains_key(key->contents, key->size)) {
+                continue;
             }
 
             store_->btree->stats.pm_keys_read.record();
             store_->btree->stats.pm_total_keys_read += 1;
 
-            /* Grab relevant values from the leaf node. */
-            const btree_key_t *key = (*it).first;
-            const void *value = (*it).second;
-            guarantee(key);
-
             const store_key_t pk(key);
-            rdb_modification_report_t mod_report(pk);
             const rdb_value_t *rdb_value = static_cast<const rdb_value_t *>(value);
-            const max_block_size_t block_size = leaf_node_buf->cache()->max_block_size();
-            mod_report.info.added
-                = std::make_pair(
-                    get_data(rdb_value, buf_parent_t(leaf_node_buf)),
-                    std::vector<char>(rdb_value->value_ref(),
-                        rdb_value->value_ref() + rdb_value->inline_size(block_size)));
-
-            rdb_update_sindexes(store_,
-                                sindexes,
-                                &mod_report,
-                                wtxn.get(),
-                                &deletion_context,
-                                NULL,
-                                NULL,
-                                NULL);
-            store_->btree->stats.pm_keys_set.record();
-            store_->btree->stats.pm_total_keys_set += 1;
+            ql::datum_t doc = get_data(rdb_value, buf_parent_t(leaf_node_buf));
+            std::vector<char> sindex_value(
+                rdb_value->value_ref(),
+                rdb_value->value_ref() + rdb_value->inline_size(block_size));
+
+            for (auto const &info : sindex_infos_) {
+                std::vector<std::pair<store_key_t, ql::datum_t> > keys;
+                try {
+                    compute_keys(pk, doc, info.second, &keys);
+                } catch (const ql::base_exc_t &) {
+                    // Do nothing (we just drop the row from the index, just like
+                    // `rdb_update_single_sindex` does).
+                    continue;
+                }
+                for (auto &pair : keys) {
+                    pending_entries_.push_back(
+                        pending_entry_t{info.first, std::move(pair.first),
+                                        sindex_value});
+                }
+            }
 
             ++current_chunk_size;
             if (current_chunk_size >= MAX_CHUNK_SIZE) {
                 current_chunk_size = 0;
-                // Release the write transaction and yield.
-                // We continue later where we have left off.
-                sindexes.clear();
-                wtxn.reset();
                 coro_t::yield();
             }
         }
+
+        if (pending_entries_.size() >= SINDEX_POST_CONSTRUCTION_SORT_BUFFER) {
+            flush_pending_entries();
+        }
+    }
+
+    // Writes out whatever is left in the buffer once the traversal is done.
+    void flush_pending_entries() {
+        if (interrupt_myself_->is_pulsed() || interruptor_->is_pulsed()) {
+            return;
+        }
+
+        // Other leaves keep adding to `pending_entries_` while we write.
+        std::vector<pending_entry_t> entries;
+        entries.swap(pending_entries_);
+        std::sort(entries.begin(), entries.end(),
+                  [](const pending_entry_t &a, const pending_entry_t &b) {
+                      return a.sindex_id < b.sindex_id
+                          || (a.sindex_id == b.sindex_id && a.key < b.key);
+                  });
+
+        // Number of sindex entries we write per write transaction. We reset the
+        // transaction after each chunk because large write transactions can cause
+        // the cache to go into throttling, and that would interfere with other
+        // transactions on this table.
+        const size_t MAX_CHUNK_SIZE = 100;
+        for (size_t begin = 0; begin < entries.size(); begin += MAX_CHUNK_SIZE) {
+            const size_t end = std::min(entries.size(), begin + MAX_CHUNK_SIZE);
+            if (!write_entries(entries.begin() + begin, entries.begin() + end)) {
+                return;
+            }
+            coro_t::yield();
+        }
     }
 
     void postprocess_internal_node(buf_lock_t *) { }
@@ -1689,7 +1998,12 @@ public:
                                      ranged_block_ids_t *ids_source,
                                      interesting_children_callback_t *cb) {
         for (int i = 0, e = ids_source->num_block_ids(); i < e; ++i) {
-            cb->receive_interesting_child(i);
+            block_id_t block_id;
+            const btree_key_t *left, *right;
+            ids_source->get_block_id_and_bounding_interval(i, &block_id, &left, &right);
+            if (child_overlaps_range(left, right)) {
+                cb->receive_interesting_child(i);
+            }
         }
         cb->no_more_interesting_children();
     }
@@ -1697,32 +2011,235 @@ public:
     access_t btree_superblock_mode() { return access_t::read; }
     access_t btree_node_mode() { return access_t::read; }
 
+private:
+    struct pending_entry_t {
+        uuid_u sindex_id;
+        store_key_t key;
+        std::vector<char> value;
+    };
+
+    // Checks whether the child covering `(left, right]` might contain keys in
+    // `range_`.
+    bool child_overlaps_range(const btree_key_t *left,
+                              const btree_key_t *right) const {
+        if (right != NULL
+            && sized_strcmp(right->contents, right->size,
+                            range_.left.contents(), range_.left.size()) < 0) {
+            return false;
+        }
+        if (left != NULL && !range_.right.unbounded
+            && sized_strcmp(left->contents, left->size,
+                            range_.right.key.contents(),
+                            range_.right.key.size()) >= 0) {
+            return false;
+        }
+        return true;
+    }
+
+    // Returns false if we should stop, either because we got interrupted or
+    // because all of the sindexes have been dropped.
+    bool write_entries(std::vector<pending_entry_t>::const_iterator begin,
+                       std::vector<pending_entry_t>::const_iterator end) {
+        scoped_ptr_t<txn_t> wtxn;
+        store_t::sindex_access_vector_t sindexes;
+        try {
+            write_token_t token;
+            store_->new_write_token(&token);
+
+            scoped_ptr_t<real_superblock_t> superblock;
+
+            // We use HARD durability because we want post construction
+            // to be throttled if we insert data faster than it can
+            // be written to disk. Otherwise we might exhaust the cache's
+            // dirty page limit and bring down the whole table.
+            // Other than that, the hard durability guarantee is not actually
+            // needed here.
+            store_->acquire_superblock_for_write(
+                    repli_timestamp_t::distant_past,
+                    2 + (end - begin),
+                    write_durability_t::HARD,
+                    &token,
+                    &wtxn,
+                    &superblock,
+                    interruptor_);
+
+            // Acquire the sindex block.
+            const block_id_t sindex_block_id = superblock->get_sindex_block_id();
+
+            buf_lock_t sindex_block(superblock->expose_buf(), sindex_block_id,
+                                    access_t::write);
+
+            superblock.reset();
+
+            store_->acquire_sindex_superblocks_for_write(
+                    sindexes_to_post_construct_,
+                    &sindex_block,
+                    &sindexes);
+
+            if (sindexes.empty()) {
+                interrupt_myself_->pulse_if_not_already_pulsed();
+                return false;
+            }
+        } catch (const interrupted_exc_t &e) {
+            return false;
+        }
+
+        const rdb_post_construction_deletion_context_t deletion_context;
+        while (begin != end) {
+            const uuid_u sindex_id = begin->sindex_id;
+            auto group_end = begin;
+            while (group_end != end && group_end->sindex_id == sindex_id) {
+                ++group_end;
+            }
+
+            const store_t::sindex_access_t *sindex = NULL;
+            for (const auto &access : sindexes) {
+                if (access->sindex.id == sindex_id) {
+                    sindex = access.get();
+                }
+            }
+            // If the secondary index has been dropped or is being deleted, we
+            // don't add any new values to the sindex tree (see
+            // `rdb_update_single_sindex`).
+            if (sindex != NULL && !sindex->sindex.being_deleted) {
+                insert_into_sindex(sindex, begin, group_end, &deletion_context);
+            }
+            begin = group_end;
+        }
+        return true;
+    }
+
+    void insert_into_sindex(const store_t::sindex_access_t *sindex,
+                            std::vector<pending_entry_t>::const_iterator begin,
+                            std::vector<pending_entry_t>::const_iterator end,
+                            const deletion_context_t *deletion_context) {
+        sindex_superblock_t *superblock = sindex->superblock.get();
+        rdb_value_sizer_t sizer(superblock->cache()->max_block_size());
+        for (auto it = begin; it != end; ++it) {
+            promise_t<superblock_t *> return_superblock_local;
+            {
+                keyvalue_location_t kv_location;
+                find_keyvalue_location_for_write(
+                    &sizer,
+                    superblock,
+                    it->key.btree_key(),
+                    deletion_context->balancing_detacher(),
+                    &kv_location,
+                    &sindex->btree->stats,
+                    nullptr,
+                    &return_superblock_local);
+
+                ql::serialization_result_t res =
+                    kv_location_set(&kv_location, it->key, it->value,
+                                    repli_timestamp_t::distant_past,
+                                    deletion_context);
+                // this particular context cannot fail AT THE MOMENT.
+                guarantee(!bad(res));
+                // The keyvalue location gets destroyed here.
+            }
+            superblock = static_cast<sindex_superblock_t *>(
+                return_superblock_local.wait());
+
+            store_->btree->stats.pm_keys_set.record();
+            store_->btree->stats.pm_total_keys_set += 1;
+        }
+    }
+
     store_t *store_;
     const std::set<uuid_u> &sindexes_to_post_construct_;
+    const std::map<uuid_u, sindex_disk_info_t> &sindex_infos_;
+    const key_range_t range_;
     cond_t *interrupt_myself_;
     signal_t *interruptor_;
+
+    std::vector<pending_entry_t> pending_entries_;
 };
 
+std::vector<key_range_t> split_for_post_construction(superblock_t *superblock,
+                                                     size_t num_ranges) {
+    std::vector<store_key_t> boundaries;
+    const block_id_t root_id = superblock->get_root_block_id();
+    if (root_id != NULL_BLOCK_ID) {
+        buf_lock_t root(superblock->expose_buf(), root_id, access_t::read);
+        buf_read_t root_read(&root);
+        const node_t *node = static_cast<const node_t *>(root_read.get_data_read());
+        if (node::is_internal(node)) {
+            const internal_node_t *internal_node =
+                reinterpret_cast<const internal_node_t *>(node);
+            // The key of the last pair is meaningless, so we only split after
+            // one of the first `npairs - 1` children.
+            for (size_t i = 1; i < num_ranges; ++i) {
+                const int index = (internal_node->npairs * i) / num_ranges - 1;
+                if (index < 0 || index >= internal_node->npairs - 1) {
+                    continue;
+                }
+                store_key_t boundary(
+                    &internal_node::get_pair_by_index(internal_node, index)->key);
+                // Child `index` covers keys up to and including its key.
+                if (!boundary.increment()) {
+                    continue;
+                }
+                if (boundaries.empty() || boundaries.back() < boundary) {
+                    boundaries.push_back(boundary);
+                }
+            }
+        }
+    }
+
+    std::vector<key_range_t> ranges;
+    store_key_t left = store_key_t::min();
+    for (const store_key_t &boundary : boundaries) {
+        ranges.push_back(
+            key_range_t(key_range_t::closed, left, key_range_t::open, boundary));
+        left = boundary;
+    }
+    ranges.push_back(
+        key_range_t(key_range_t::closed, left, key_range_t::none, store_key_t()));
+    return ranges;
+}
+
+void post_construct_range(
+        store_t *store,
+        const std::set<uuid_u> &sindexes_to_post_construct,
+        const std::map<uuid_u, sindex_disk_info_t> &sindex_infos,
+        const key_range_t &range,
+        superblock_t *superblock,
+        cond_t *local_interruptor,
+        signal_t *interruptor,
+        signal_t *traversal_interruptor,
+        parallel_traversal_progress_t *progress_tracker) {
+    post_construct_traversal_helper_t helper(store,
+            sindexes_to_post_construct, sindex_infos, range,
+            local_interruptor, interruptor);
+    helper.progress = progress_tracker;
+
+    try {
+        // All ranges share the same superblock, which
+        // `post_construct_secondary_indexes` releases once they are done.
+        btree_parallel_traversal(superblock, &helper, traversal_interruptor,
+                                 release_superblock_t::KEEP);
+    } catch (const interrupted_exc_t &) {
+        // `post_construct_secondary_indexes` checks the interruptor itself.
+        return;
+    }
+    helper.flush_pending_entries();
+}
+
 void post_construct_secondary_indexes(
         store_t *store,
         const std::set<uuid_u> &sindexes_to_post_construct,
         signal_t *interruptor,
-        parallel_traversal_progress_t *progress_tracker)
+        traversal_progress_combiner_t *progress_tracker)
     THROWS_ONLY(interrupted_exc_t) {
     cond_t local_interruptor;
 
     wait_any_t wait_any(&local_interruptor, interruptor);
 
-    post_construct_traversal_helper_t helper(store,
-            sindexes_to_post_construct, &local_interruptor, interruptor);
-    helper.progress = progress_tracker;
-
     read_token_t read_token;
     store->new_read_token(&read_token);
 
     // Mind the destructor ordering.
-    // The superblock must be released before txn (`btree_parallel_traversal`
-    // usually already takes care of that).
+    // The superblock must be released before txn.
     // The txn must be destructed before the cache_account.
     cache_account_t cache_account;
     scoped_ptr_t<txn_t> txn;
@@ -1738,8 +2255,51 @@ void post_construct_secondary_indexes(
     cache_account
         = txn->cache()->create_cache_account(SINDEX_POST_CONSTRUCTION_CACHE_PRIORITY);
     txn->set_account(&cache_account);
+    txn->set_access_hint(cache_access_hint_t::scan);
+
+    // Load the index functions up front, so that we can compute the secondary
+    // index keys without holding a write transaction.
+    std::map<uuid_u, sindex_disk_info_t> sindex_infos;
+    {
+        buf_lock_t sindex_block(superblock->expose_buf(),
+                                superblock->get_sindex_block_id(),
+                                access_t::read);
+        std::map<sindex_name_t, secondary_index_t> sindexes;
+        get_secondary_indexes(&sindex_block, &sindexes);
+        for (auto const &pair : sindexes) {
+            if (sindexes_to_post_construct.count(pair.second.id) == 0) {
+                continue;
+            }
+            sindex_disk_info_t info;
+            try {
+                deserialize_sindex_info(pair.second.opaque_definition, &info);
+            } catch (const archive_exc_t &e) {
+                crash("%s", e.what());
+            }
+            sindex_infos.insert(std::make_pair(pair.second.id, info));
+        }
+    }
 
-    btree_parallel_traversal(superblock.get(), &helper, &wait_any);
+    const std::vector<key_range_t> ranges =
+        split_for_post_construction(superblock.get(), SINDEX_POST_CONSTRUCTION_RANGES);
+    // Every traversal walks down from the root on its own, so each one needs its
+    // own progress estimate.  The combiner adds them up.
+    std::vector<parallel_traversal_progress_t *> range_progress;
+    for (size_t i = 0; i < ranges.size(); ++i) {
+        range_progress.push_back(new parallel_traversal_progress_t);
+        scoped_ptr_t<traversal_progress_t> constituent(range_progress.back());
+        progress_tracker->add_constituent(&constituent);
+    }
+    pmap(ranges.size(), [&](int64_t i) {
+        post_construct_range(store, sindexes_to_post_construct, sindex_infos,
+                             ranges[i], superblock.get(), &local_interruptor,
+                             interruptor, &wait_any, range_progress[i]);
+    });
+    superblock.reset();
+
+    if (interruptor->is_pulsed()) {
+        throw interrupted_exc_t();
+    }
 }
 
 void noop_value_deleter_t::delete_value(buf_parent_t, const void *) const { }
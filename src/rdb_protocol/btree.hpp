@@ -9,6 +9,7 @@
 #include <vector>
 
 #include "backfill_progress.hpp"
+#include "btree/bulk_load.hpp"
 #include "btree/types.hpp"
 #include "concurrency/auto_drainer.hpp"
 #include "rdb_protocol/datum.hpp"
@@ -78,20 +79,6 @@ struct btree_info_t {
     const datum_string_t primary_key;
 };
 
-struct btree_loc_info_t {
-    btree_loc_info_t(const btree_info_t *_btree,
-                     real_superblock_t *_superblock,
-                     const store_key_t *_key)
-        : btree(_btree), superblock(_superblock), key(_key) {
-        guarantee(btree != NULL);
-        guarantee(superblock != NULL);
-        guarantee(key != NULL);
-    }
-    const btree_info_t *const btree;
-    real_superblock_t *const superblock;
-    const store_key_t *const key;
-};
-
 struct btree_batched_replacer_t {
     virtual ~btree_batched_replacer_t() { }
     virtual ql::datum_t replace(
@@ -140,18 +127,57 @@ public:
     virtual void on_sindexes(
         const std::map<std::string, secondary_index_t> &sindexes,
         signal_t *interruptor) THROWS_ONLY(interrupted_exc_t) = 0;
+    // Everything in `range` has been passed to the other functions.
+    virtual void on_checkpoint(
+        const key_range_t &range,
+        signal_t *interruptor) THROWS_ONLY(interrupted_exc_t) = 0;
 protected:
     virtual ~rdb_backfill_callback_t() { }
 };
 
 
+/* Adds a constituent that tracks its progress to `progress`. If `since_when` is
+`distant_past`, the receiver shares no history with us and gets every key in
+`key_range`. In that case the keys are sent in ascending order, so that a receiver
+with an empty btree can use `rdb_backfill_bulk_loader_t`, and every
+`BACKFILL_CHECKPOINT_INTERVAL_MS` the part of `key_range` that has been sent so far
+is passed to `callback->on_checkpoint()`. */
 void rdb_backfill(btree_slice_t *slice, const key_range_t& key_range,
                   repli_timestamp_t since_when, rdb_backfill_callback_t *callback,
                   refcount_superblock_t *superblock,
                   buf_lock_t *sindex_block,
-                  parallel_traversal_progress_t *p, signal_t *interruptor)
+                  traversal_progress_combiner_t *progress, signal_t *interruptor)
     THROWS_ONLY(interrupted_exc_t);
 
+/* Builds the primary btree of a store that doesn't have any data yet from the key
+value pairs of a backfill, as long as they arrive in ascending key order. The pairs
+are written into new leaf nodes one after the other instead of being inserted one
+at a time, and the secondary indexes aren't updated. See `btree_bulk_loader_t`
+for who may write to the btree in the meantime. */
+class rdb_backfill_bulk_loader_t {
+public:
+    explicit rdb_backfill_bulk_loader_t(max_block_size_t block_size);
+
+    // Whether `key` is greater than every key that has been appended so far.
+    bool is_after_last_key(const store_key_t &key) const;
+
+    // The values' blobs are created in `txn`.
+    void append(txn_t *txn, const backfill_atom_t &atom);
+
+    void checkpoint(superblock_t *superblock);
+
+    void finish(superblock_t *superblock);
+
+    int64_t num_pairs() const { return loader.num_pairs(); }
+
+private:
+    rdb_value_sizer_t sizer;
+    btree_bulk_loader_t loader;
+    boost::optional<store_key_t> last_key;
+
+    DISABLE_COPYING(rdb_backfill_bulk_loader_t);
+};
+
 
 void rdb_delete(const store_key_t &key, btree_slice_t *slice, repli_timestamp_t
                 timestamp, real_superblock_t *superblock,
@@ -341,11 +367,17 @@ void rdb_update_sindexes(
     std::map<std::string, std::vector<ql::datum_t> > *old_keys_out,
     std::map<std::string, std::vector<ql::datum_t> > *new_keys_out);
 
+/* Splits the primary key space into at most `num_ranges` ranges that cover
+roughly the same number of children of the root node. */
+std::vector<key_range_t> split_for_post_construction(superblock_t *superblock,
+                                                     size_t num_ranges);
+
+// Adds a constituent to `progress_tracker` for each range that it traverses.
 void post_construct_secondary_indexes(
         store_t *store,
         const std::set<uuid_u> &sindexes_to_post_construct,
         signal_t *interruptor,
-        parallel_traversal_progress_t *progress_tracker)
+        traversal_progress_combiner_t *progress_tracker)
     THROWS_ONLY(interrupted_exc_t);
 
 /* This deleter actually deletes the value and all associated blocks. */
@@ -287,9 +287,14 @@ struct backfill_chunk_timestamp_t : public boost::static_visitor<repli_timestamp
     repli_timestamp_t operator()(const backfill_chunk_t::sindexes_t &) const {
         return repli_timestamp_t::distant_past;
     }
+
+    repli_timestamp_t operator()(const backfill_chunk_t::checkpoint_t &) const {
+        unreachable("The backfillee applies checkpoints to the metainfo.");
+    }
 };
 
 void store_t::receive_backfill(
+        const region_t &backfill_region,
         const backfill_chunk_t &chunk,
         write_token_t *token,
         signal_t *interruptor)
@@ -318,9 +323,35 @@ void store_t::receive_backfill(
     scoped_ptr_t<real_superblock_t> superblock(real_superblock.release());
     protocol_receive_backfill(std::move(superblock),
                               interruptor,
+                              backfill_region,
                               chunk);
 }
 
+void store_t::finish_backfill(write_token_t *token, signal_t *interruptor)
+        THROWS_ONLY(interrupted_exc_t) {
+    assert_thread();
+    with_priority_t p(CORO_PRIORITY_BACKFILL_RECEIVER);
+
+    scoped_ptr_t<txn_t> txn;
+    scoped_ptr_t<real_superblock_t> superblock;
+    acquire_superblock_for_write(repli_timestamp_t::distant_past,
+                                 2,
+                                 write_durability_t::SOFT,
+                                 token,
+                                 &txn,
+                                 &superblock,
+                                 interruptor);
+
+    // The backfill might have ended with a bulk load, whose secondary indexes
+    // still have to be post constructed.
+    if (backfill_bulk_loader.has()) {
+        buf_lock_t sindex_block(superblock->expose_buf(),
+                                superblock->get_sindex_block_id(),
+                                access_t::write);
+        finish_backfill_bulk_load(superblock.get(), &sindex_block);
+    }
+}
+
 void store_t::maybe_drop_all_sindexes(const binary_blob_t &zero_metainfo,
                                       const write_durability_t durability,
                                       signal_t *interruptor) {
@@ -403,6 +434,12 @@ void store_t::reset_data(
                                 superblock->get_sindex_block_id(),
                                 access_t::write);
 
+        // An interrupted backfill might have left keys in the bulk loader. They
+        // have to go into the btree so that we can erase them.
+        if (backfill_bulk_loader.has()) {
+            finish_backfill_bulk_load(superblock.get(), &sindex_block);
+        }
+
         /* Note we don't allow interruption during this step; it's too easy to end up in
         an inconsistent state. */
         cond_t non_interruptor;
@@ -7,6 +7,8 @@
 #include "concurrency/cross_thread_signal.hpp"
 #include "concurrency/interruptor.hpp"
 #include "containers/archive/boost_types.hpp"
+#include "containers/archive/vector_stream.hpp"
+#include "containers/archive/versioned.hpp"
 #include "rdb_protocol/artificial_table/backend.hpp"
 #include "rdb_protocol/btree.hpp"
 #include "rdb_protocol/env.hpp"
@@ -137,7 +139,8 @@ boost::optional<datum_t> apply_ops(
     const datum_t &val,
     const std::vector<scoped_ptr_t<op_t> > &ops,
     env_t *env,
-    const datum_t &key) THROWS_NOTHING {
+    const datum_t &key,
+    bool *failed_out) THROWS_NOTHING {
     try {
         groups_t groups{optional_datum_less_t(env->reql_version())};
         groups[datum_t()] = std::vector<datum_t>{val};
@@ -161,13 +164,17 @@ boost::optional<datum_t> apply_ops(
         // case, if you change the value of a row so that one of the
         // transformations errors on it, we report the row as being deleted from
         // the selection you asked for changes on.)
+        if (failed_out != NULL) {
+            *failed_out = true;
+        }
         return boost::none;
     }
 }
 
 server_t::client_info_t::client_info_t()
     : limit_clients(&opt_lt<std::string>),
-      limit_clients_lock(new rwlock_t()) { }
+      limit_clients_lock(new rwlock_t()),
+      flush_scheduled(false) { }
 
 server_t::server_t(mailbox_manager_t *_manager)
     : uuid(generate_uuid()),
@@ -240,12 +247,34 @@ void server_t::limit_stop_mailbox_cb(signal_t *,
     }
 }
 
-void server_t::add_client(const client_t::addr_t &addr, region_t region) {
+void server_t::add_client(const client_t::addr_t &addr,
+                          region_t region,
+                          rdb_context_t *ctx,
+                          std::map<std::string, wire_func_t> optargs,
+                          const std::vector<transform_variant_t> &transforms) {
     auto_drainer_t::lock_t lock(&drainer);
     rwlock_in_line_t spot(&clients_lock, access_t::write);
     spot.write_signal()->wait_lazily_unordered();
     client_info_t *info = &clients[addr];
 
+    // A client pushes the same transforms down to every shard, so we only need
+    // to set them up the first time.
+    if (!info->cond.has() && transforms.size() != 0) {
+        info->ops = std::make_shared<pushed_down_ops_t>();
+        // The final `NULL` argument means we don't profile any work done with
+        // this `env`.  The context is only missing in the unit tests.
+        info->ops->env = ctx == NULL
+            ? make_scoped<env_t>(drainer.get_drain_signal(),
+                                 return_empty_normal_batches_t::NO,
+                                 reql_version_t::LATEST)
+            : make_scoped<env_t>(ctx, return_empty_normal_batches_t::NO,
+                                 drainer.get_drain_signal(), std::move(optargs),
+                                 nullptr);
+        for (const auto &transform : transforms) {
+            info->ops->ops.push_back(make_op(transform));
+        }
+    }
+
     // We do this regardless of whether there's already an entry for this
     // address, because we might be subscribed to multiple regions if we're
     // oversharded.  This will have to become smarter once you can unsubscribe
@@ -317,6 +346,7 @@ void server_t::add_client_cb(signal_t *stopped, client_t::addr_t addr) {
     // We can be removed more than once safely (e.g. in the case of oversharding).
     if (it != clients.end()) {
         send_one_with_lock(coro_lock, &*it, msg_t(msg_t::stop_t()));
+        flush_with_lock(&*it);
     }
     coro_spot.write_signal()->wait_lazily_unordered();
     size_t erased = clients.erase(addr);
@@ -325,35 +355,131 @@ void server_t::add_client_cb(signal_t *stopped, client_t::addr_t addr) {
     guarantee(erased == 1);
 }
 
-struct stamped_msg_t {
-    stamped_msg_t() { }
-    stamped_msg_t(uuid_u _server_uuid, uint64_t _stamp, msg_t _submsg)
-        : server_uuid(std::move(_server_uuid)),
-          stamp(_stamp),
-          submsg(std::move(_submsg)) { }
-    uuid_u server_uuid;
-    uint64_t stamp;
-    msg_t submsg;
-};
+RDB_IMPL_SERIALIZABLE_3_FOR_CLUSTER(stamped_msg_t, server_uuid, stamp, submsg);
 
-RDB_MAKE_SERIALIZABLE_3(stamped_msg_t, server_uuid, stamp, submsg);
+// The most messages a `server_t` batches up for one client before sending them.
+const size_t MAX_BATCH_SIZE = 100;
 
 // This function takes a `lock_t` to make sure you have one.  (We can't just
 // always ackquire a drainer lock before sending because we sometimes send a
 // `stop_t` during destruction, and you can't acquire a drain lock on a draining
 // `auto_drainer_t`.)
 void server_t::send_one_with_lock(
-    const auto_drainer_t::lock_t &,
+    const auto_drainer_t::lock_t &lock,
     std::pair<const client_t::addr_t, client_info_t> *client,
     msg_t msg) {
-    uint64_t stamp;
+    client_info_t *info = &client->second;
     {
         // We don't need a write lock as long as we make sure the coroutine
         // doesn't block between reading and updating the stamp.
         ASSERT_NO_CORO_WAITING;
-        stamp = client->second.stamp++;
+        uint64_t stamp = info->stamp++;
+        info->batch.push_back(stamped_msg_t(uuid, stamp, std::move(msg)));
+        // If the client pushed transforms down, we leave it to `flush_cb` to send
+        // the batch, so that we don't evaluate them here on the write path.
+        if (info->batch.size() < MAX_BATCH_SIZE || info->ops) {
+            // Every message stamped before `flush_cb` runs goes out with this
+            // one.  Clients reorder messages by stamp, so it doesn't matter if
+            // an earlier batch arrives after this one.
+            if (!info->flush_scheduled) {
+                info->flush_scheduled = true;
+                coro_t::spawn_sometime(
+                    std::bind(&server_t::flush_cb, this, lock, client->first));
+            }
+            return;
+        }
+    }
+    flush_with_lock(client);
+}
+
+void server_t::flush_with_lock(
+    std::pair<const client_t::addr_t, client_info_t> *client) {
+    std::vector<stamped_msg_t> batch;
+    client->second.batch.swap(batch);
+    if (batch.size() != 0) {
+        send(manager, client->first, batch);
+    }
+}
+
+// Replaces `*msg` with what the client should get for it after `ops`.  If one of
+// `ops` fails on the change, we leave it alone: the client applies its own copy of
+// the transforms to changes that arrive untransformed, and decides what to do with
+// the error.
+void apply_pushed_down_ops(const std::vector<scoped_ptr_t<op_t> > &ops,
+                           env_t *env,
+                           msg_t *msg) {
+    msg_t::change_t *change = boost::get<msg_t::change_t>(&msg->op);
+    if (change == NULL) {
+        return;
     }
-    send(manager, client->first, stamped_msg_t(uuid, stamp, std::move(msg)));
+    datum_t null = datum_t::null();
+    datum_t old_val = null, new_val = null;
+    bool failed = false;
+    if (change->old_val.has()) {
+        if (boost::optional<datum_t> d =
+                apply_ops(change->old_val, ops, env, datum_t(), &failed)) {
+            old_val = *d;
+        }
+    }
+    if (change->new_val.has()) {
+        if (boost::optional<datum_t> d =
+                apply_ops(change->new_val, ops, env, datum_t(), &failed)) {
+            new_val = *d;
+        }
+    }
+    if (failed) {
+        return;
+    }
+    // This is the same check `range_sub_t` does when it applies its own
+    // transforms: if the transforms filtered out both values, or mapped them to
+    // the same thing, the client has nothing to report.
+    if (new_val == old_val) {
+        msg->op = msg_t::skip_t();
+        return;
+    }
+    msg_t::transformed_change_t transformed;
+    transformed.change.old_indexes = std::move(change->old_indexes);
+    transformed.change.new_indexes = std::move(change->new_indexes);
+    transformed.change.pkey = std::move(change->pkey);
+    transformed.change.old_val = std::move(old_val);
+    transformed.change.new_val = std::move(new_val);
+    msg->op = std::move(transformed);
+}
+
+void server_t::flush_cb(auto_drainer_t::lock_t lock, client_t::addr_t addr) {
+    std::vector<stamped_msg_t> batch;
+    std::shared_ptr<pushed_down_ops_t> ops;
+    {
+        rwlock_in_line_t spot(&clients_lock, access_t::read);
+        spot.read_signal()->wait_lazily_unordered();
+        auto it = clients.find(addr);
+        // The client might have been removed in the meantime, in which case
+        // `add_client_cb` already flushed its messages.
+        if (it == clients.end()) {
+            return;
+        }
+        it->second.flush_scheduled = false;
+        it->second.batch.swap(batch);
+        ops = it->second.ops;
+    }
+    if (batch.size() == 0) {
+        return;
+    }
+    if (ops) {
+        // Clients reorder messages by stamp, so batches may be transformed in
+        // any order, but not two at once in the same environment.
+        new_mutex_in_line_t mutex_spot(&ops->mutex);
+        try {
+            wait_interruptible(mutex_spot.acq_signal(), lock.get_drain_signal());
+            for (auto &&msg : batch) {
+                apply_pushed_down_ops(ops->ops, ops->env.get(), &msg.submsg);
+            }
+        } catch (const interrupted_exc_t &) {
+            // We're shutting down.  The client can handle whatever we didn't get
+            // to transform.
+        }
+    }
+    send(manager, addr, batch);
 }
 
 void server_t::send_all(const msg_t &msg, const store_key_t &key) {
@@ -991,6 +1117,10 @@ RDB_IMPL_SERIALIZABLE_5(
     old_indexes, new_indexes, pkey, old_val, new_val);
 INSTANTIATE_SERIALIZABLE_FOR_CLUSTER(msg_t::change_t);
 RDB_IMPL_SERIALIZABLE_0_SINCE_v1_13(msg_t::stop_t);
+RDB_IMPL_SERIALIZABLE_1(msg_t::transformed_change_t, change);
+INSTANTIATE_SERIALIZABLE_FOR_CLUSTER(msg_t::transformed_change_t);
+RDB_IMPL_SERIALIZABLE_0(msg_t::skip_t);
+INSTANTIATE_SERIALIZABLE_FOR_CLUSTER(msg_t::skip_t);
 
 enum class detach_t { NO, YES };
 
@@ -1176,28 +1306,32 @@ private:
 
 class real_feed_t : public feed_t {
 public:
+    // `transforms` and `optargs` are pushed down to the shards, which apply
+    // `transforms` to every change before sending it to us.
     real_feed_t(auto_drainer_t::lock_t client_lock,
                 client_t *client,
                 mailbox_manager_t *manager,
                 namespace_interface_t *ns_if,
-                uuid_u uuid,
+                client_t::feed_key_t key,
+                std::vector<transform_variant_t> transforms,
+                std::map<std::string, wire_func_t> optargs,
                 signal_t *interruptor);
     ~real_feed_t();
 
     client_t::addr_t get_addr() const;
 private:
     virtual auto_drainer_t::lock_t get_drainer_lock() { return drainer.lock(); }
-    virtual void maybe_remove_feed() { client->maybe_remove_feed(client_lock, uuid); }
+    virtual void maybe_remove_feed() { client->maybe_remove_feed(client_lock, key); }
     virtual void stop_limit_sub(limit_sub_t *sub);
 
-    void mailbox_cb(signal_t *interruptor, stamped_msg_t msg);
+    void mailbox_cb(signal_t *interruptor, std::vector<stamped_msg_t> msgs);
     void constructor_cb();
 
     auto_drainer_t::lock_t client_lock;
     client_t *client;
-    uuid_u uuid;
+    client_t::feed_key_t key;
     mailbox_manager_t *manager;
-    mailbox_t<void(stamped_msg_t)> mailbox;
+    mailbox_t<void(std::vector<stamped_msg_t>)> mailbox;
     std::vector<server_t::addr_t> stop_addrs;
     std::vector<scoped_ptr_t<disconnect_watcher_t> > disconnect_watchers;
 
@@ -1224,15 +1358,19 @@ real_feed_t::real_feed_t(auto_drainer_t::lock_t _client_lock,
                          client_t *_client,
                          mailbox_manager_t *_manager,
                          namespace_interface_t *ns_if,
-                         uuid_u _uuid,
+                         client_t::feed_key_t _key,
+                         std::vector<transform_variant_t> transforms,
+                         std::map<std::string, wire_func_t> optargs,
                          signal_t *interruptor)
     : client_lock(std::move(_client_lock)),
       client(_client),
-      uuid(_uuid),
+      key(std::move(_key)),
       manager(_manager),
       mailbox(manager, std::bind(&real_feed_t::mailbox_cb, this, ph::_1, ph::_2)) {
     try {
-        read_t read(changefeed_subscribe_t(mailbox.get_address()),
+        read_t read(changefeed_subscribe_t(mailbox.get_address(),
+                                           std::move(transforms),
+                                           std::move(optargs)),
                     profile_bool_t::DONT_PROFILE);
         read_response_t read_resp;
         ns_if->read(read, &read_resp, order_token_t::ignore, interruptor);
@@ -1308,7 +1446,7 @@ void real_feed_t::constructor_cb() {
     // longer than necessary.
     disconnect_watchers.clear();
     if (!detached) {
-        scoped_ptr_t<feed_t> self = client->detach_feed(client_lock, uuid);
+        scoped_ptr_t<feed_t> self = client->detach_feed(client_lock, key);
         detached = true;
         if (self.has()) {
             const char *msg = "Disconnected from peer.";
@@ -1897,49 +2035,7 @@ public:
                     old_val = change.old_val;
                 }
             }
-            boost::optional<std::string> sindex = sub->sindex();
-            if (sindex) {
-                size_t old_vals = 0, new_vals = 0;
-                auto old_it = change.old_indexes.find(*sindex);
-                if (old_it != change.old_indexes.end()) {
-                    for (const auto &idx : old_it->second) {
-                        if (sub->contains(idx)) {
-                            old_vals += 1;
-                        }
-                    }
-                }
-                auto new_it = change.new_indexes.find(*sindex);
-                if (new_it != change.new_indexes.end()) {
-                    for (const auto &idx : new_it->second) {
-                        if (sub->contains(idx)) {
-                            new_vals += 1;
-                        }
-                    }
-                }
-                while (new_vals > 0 && old_vals > 0) {
-                    sub->add_el(server_uuid, stamp, change.pkey,
-                                old_val, new_val, default_limits);
-                    --new_vals;
-                    --old_vals;
-                }
-                while (old_vals > 0) {
-                    guarantee(new_vals == 0);
-                    sub->add_el(server_uuid, stamp, change.pkey,
-                                old_val, null, default_limits);
-                    --old_vals;
-                }
-                while (new_vals > 0) {
-                    guarantee(old_vals == 0);
-                    sub->add_el(server_uuid, stamp, change.pkey,
-                                null, new_val, default_limits);
-                    --new_vals;
-                }
-            } else {
-                if (sub->contains(change.pkey)) {
-                    sub->add_el(server_uuid, stamp, change.pkey,
-                                old_val, new_val, default_limits);
-                }
-            }
+            add_range_change(sub, change, old_val, new_val);
         });
         feed->on_point_sub(
             change.pkey,
@@ -1953,6 +2049,18 @@ public:
                       change.new_val.has() ? change.new_val : null,
                       default_limits));
     }
+    void operator()(const msg_t::transformed_change_t &msg) const {
+        // The shard already applied our transforms (which only range
+        // subscriptions push down), so we pass the values on as they are.
+        feed->each_active_range_sub(*lock, [&](range_sub_t *sub) {
+            add_range_change(sub, msg.change,
+                             msg.change.old_val, msg.change.new_val);
+        });
+    }
+    void operator()(const msg_t::skip_t &) const {
+        // The shard's transforms filtered out the change, so we only needed the
+        // stamp.
+    }
     void operator()(const msg_t::stop_t &) const {
         const char *msg = "Changefeed aborted (table unavailable).";
         feed->each_sub(*lock,
@@ -1963,13 +2071,64 @@ public:
                                  detach_t::NO));
     }
 private:
+    void add_range_change(range_sub_t *sub,
+                          const msg_t::change_t &change,
+                          const datum_t &old_val,
+                          const datum_t &new_val) const {
+        configured_limits_t default_limits;
+        datum_t null = datum_t::null();
+        boost::optional<std::string> sindex = sub->sindex();
+        if (sindex) {
+            size_t old_vals = 0, new_vals = 0;
+            auto old_it = change.old_indexes.find(*sindex);
+            if (old_it != change.old_indexes.end()) {
+                for (const auto &idx : old_it->second) {
+                    if (sub->contains(idx)) {
+                        old_vals += 1;
+                    }
+                }
+            }
+            auto new_it = change.new_indexes.find(*sindex);
+            if (new_it != change.new_indexes.end()) {
+                for (const auto &idx : new_it->second) {
+                    if (sub->contains(idx)) {
+                        new_vals += 1;
+                    }
+                }
+            }
+            while (new_vals > 0 && old_vals > 0) {
+                sub->add_el(server_uuid, stamp, change.pkey,
+                            old_val, new_val, default_limits);
+                --new_vals;
+                --old_vals;
+            }
+            while (old_vals > 0) {
+                guarantee(new_vals == 0);
+                sub->add_el(server_uuid, stamp, change.pkey,
+                            old_val, null, default_limits);
+                --old_vals;
+            }
+            while (new_vals > 0) {
+                guarantee(old_vals == 0);
+                sub->add_el(server_uuid, stamp, change.pkey,
+                            null, new_val, default_limits);
+                --new_vals;
+            }
+        } else {
+            if (sub->contains(change.pkey)) {
+                sub->add_el(server_uuid, stamp, change.pkey,
+                            old_val, new_val, default_limits);
+            }
+        }
+    }
+
     feed_t *feed;
     const auto_drainer_t::lock_t *lock;
     uuid_u server_uuid;
     uint64_t stamp;
 };
 
-void real_feed_t::mailbox_cb(signal_t *, stamped_msg_t msg) {
+void real_feed_t::mailbox_cb(signal_t *, std::vector<stamped_msg_t> msgs) {
     // We stop receiving messages when detached (we're only receiving
     // messages because we haven't managed to get a message to the
     // stop mailboxes for some of the primary replicas yet).  This also stops
@@ -1985,7 +2144,10 @@ void real_feed_t::mailbox_cb(signal_t *, stamped_msg_t msg) {
         if (!lock.get_drain_signal()->is_pulsed()) {
             // We don't need a lock for this because the set of `uuid_u`s never
             // changes after it's initialized.
-            auto it = queues.find(msg.server_uuid);
+            // A `server_t` only batches up its own messages.
+            guarantee(msgs.size() != 0);
+            const uuid_u server_uuid = msgs[0].server_uuid;
+            auto it = queues.find(server_uuid);
             guarantee(it != queues.end());
             queue_t *queue = it->second.get();
             guarantee(queue != NULL);
@@ -1994,8 +2156,11 @@ void real_feed_t::mailbox_cb(signal_t *, stamped_msg_t msg) {
             spot.write_signal()->wait_lazily_unordered();
 
             // Add us to the queue.
-            guarantee(msg.stamp >= queue->next);
-            queue->map.push(std::move(msg));
+            for (auto &&msg : msgs) {
+                guarantee(msg.server_uuid == server_uuid);
+                guarantee(msg.stamp >= queue->next);
+                queue->map.push(std::move(msg));
+            }
 
             // Read as much as we can from the queue (this enforces ordering.)
             while (queue->map.size() != 0 && queue->map.top().stamp == queue->next) {
@@ -2476,6 +2641,31 @@ counted_t<datum_stream_t> client_t::new_stream(
         scoped_ptr_t<subscription_t> sub;
         boost::variant<scoped_ptr_t<range_sub_t>, scoped_ptr_t<point_sub_t> > presub;
         addr_t addr;
+
+        // Range subscriptions push their transforms down to the shards, which
+        // send the changes already transformed (see `server_t::flush_cb`).  They
+        // share a feed with the other subscriptions that push down the same
+        // transforms (with the same optargs), and keep their own copy of the
+        // transforms for the changes the shards couldn't transform.  (We can't
+        // do this with fake environments from the unit tests, because the
+        // shards need the optargs.)
+        std::vector<transform_variant_t> transforms;
+        std::map<std::string, wire_func_t> optargs;
+        feed_key_t key(uuid, std::vector<char>());
+        const keyspec_t::range_t *range = boost::get<keyspec_t::range_t>(&spec);
+        if (range != NULL && range->transforms.size() != 0
+            && env->get_rdb_ctx() != NULL) {
+            transforms = range->transforms;
+            optargs = env->get_all_optargs();
+            write_message_t wm;
+            serialize_for_version(cluster_version_t::CLUSTER, &wm, transforms);
+            serialize_for_version(cluster_version_t::CLUSTER, &wm, optargs);
+            vector_stream_t stream;
+            stream.reserve(wm.size());
+            int res = send_write_message(&stream, &wm);
+            guarantee(res == 0);
+            stream.swap(&key.second);
+        }
         {
             threadnum_t old_thread = get_thread_id();
             cross_thread_signal_t interruptor(env->interruptor, home_thread());
@@ -2485,7 +2675,7 @@ counted_t<datum_stream_t> client_t::new_stream(
             auto_drainer_t::lock_t lock(&drainer, throw_if_draining_t::YES);
             rwlock_in_line_t spot(&feeds_lock, access_t::write);
             spot.read_signal()->wait_lazily_unordered();
-            auto feed_it = feeds.find(uuid);
+            auto feed_it = feeds.find(key);
             if (feed_it == feeds.end()) {
                 spot.write_signal()->wait_lazily_unordered();
                 namespace_interface_access_t access =
@@ -2495,8 +2685,9 @@ counted_t<datum_stream_t> client_t::new_stream(
                 // only be run for the first one.  Rather than mess
                 // about, just use the defaults.
                 auto val = make_scoped<real_feed_t>(
-                    lock, this, manager, access.get(), uuid, &interruptor);
-                feed_it = feeds.insert(std::make_pair(uuid, std::move(val))).first;
+                    lock, this, manager, access.get(), key,
+                    std::move(transforms), std::move(optargs), &interruptor);
+                feed_it = feeds.insert(std::make_pair(key, std::move(val))).first;
             }
 
             // We need to do this while holding `feeds_lock` to make sure the
@@ -2517,13 +2708,13 @@ counted_t<datum_stream_t> client_t::new_stream(
 }
 
 void client_t::maybe_remove_feed(
-    const auto_drainer_t::lock_t &lock, const uuid_u &uuid) {
+    const auto_drainer_t::lock_t &lock, const feed_key_t &key) {
     assert_thread();
     lock.assert_is_holding(&drainer);
     scoped_ptr_t<real_feed_t> destroy;
     rwlock_in_line_t spot(&feeds_lock, access_t::write);
     spot.write_signal()->wait_lazily_unordered();
-    auto feed_it = feeds.find(uuid);
+    auto feed_it = feeds.find(key);
     // The feed might have disappeared because it may have been detached while
     // we held the lock, in which case we don't need to do anything.  The feed
     // might also have gotten a new subscriber, in which case we don't want to
@@ -2537,7 +2728,7 @@ void client_t::maybe_remove_feed(
 }
 
 scoped_ptr_t<real_feed_t> client_t::detach_feed(
-    const auto_drainer_t::lock_t &lock, const uuid_u &uuid) {
+    const auto_drainer_t::lock_t &lock, const feed_key_t &key) {
     assert_thread();
     lock.assert_is_holding(&drainer);
     scoped_ptr_t<real_feed_t> ret;
@@ -2545,7 +2736,7 @@ scoped_ptr_t<real_feed_t> client_t::detach_feed(
     spot.write_signal()->wait_lazily_unordered();
     // The feed might have been removed in `maybe_remove_feed`, in which case
     // there's nothing to detach.
-    auto feed_it = feeds.find(uuid);
+    auto feed_it = feeds.find(key);
     if (feed_it != feeds.end()) {
         ret.swap(feed_it->second);
         feeds.erase(feed_it);
@@ -6,6 +6,7 @@
 #include <exception>
 #include <functional>
 #include <map>
+#include <memory>
 #include <string>
 #include <vector>
 #include <utility>
@@ -14,6 +15,7 @@
 #include <boost/variant.hpp>
 
 #include "btree/keys.hpp"
+#include "concurrency/new_mutex.hpp"
 #include "concurrency/promise.hpp"
 #include "concurrency/rwlock.hpp"
 #include "containers/counted.hpp"
@@ -58,11 +60,14 @@ typedef std::pair<const std::string, std::pair<datum_t, datum_t> > const_item_t;
 std::vector<item_t> mangle_sort_truncate_stream(
     stream_t &&stream, is_primary_t is_primary, sorting_t sorting, size_t n);
 
+// Returns `boost::none` if `ops` filter out `val`, or if one of them fails on it.
+// In the latter case `*failed_out` is set, if it's given.
 boost::optional<datum_t> apply_ops(
     const datum_t &val,
     const std::vector<scoped_ptr_t<op_t> > &ops,
     env_t *env,
-    const datum_t &key) THROWS_NOTHING;
+    const datum_t &key,
+    bool *failed_out = NULL) THROWS_NOTHING;
 
 struct msg_t {
     struct limit_start_t {
@@ -92,6 +97,18 @@ struct msg_t {
         datum_t old_val, new_val;
         RDB_DECLARE_ME_SERIALIZABLE(change_t);
     };
+    // A change that the shard already ran through the transforms the client
+    // pushed down (see `changefeed_subscribe_t`).  A value that the transforms
+    // filter out is `null`, the way the client reports it.
+    struct transformed_change_t {
+        change_t change;
+        RDB_DECLARE_ME_SERIALIZABLE(transformed_change_t);
+    };
+    // Takes the place of a change that the transforms the client pushed down
+    // filtered out, so that the client doesn't wait for its stamp.
+    struct skip_t {
+        RDB_DECLARE_ME_SERIALIZABLE(skip_t);
+    };
     struct stop_t {
         RDB_DECLARE_ME_SERIALIZABLE(stop_t);
     };
@@ -112,15 +129,30 @@ struct msg_t {
     }
 
     // Starts with STOP to avoid doing work for default initialization.
-    boost::variant<stop_t, change_t, limit_start_t, limit_change_t, limit_stop_t> op;
+    boost::variant<stop_t, change_t, limit_start_t, limit_change_t, limit_stop_t,
+                   transformed_change_t, skip_t> op;
 };
 
 RDB_DECLARE_SERIALIZABLE(msg_t);
 
+struct stamped_msg_t {
+    stamped_msg_t() { }
+    stamped_msg_t(uuid_u _server_uuid, uint64_t _stamp, msg_t _submsg)
+        : server_uuid(std::move(_server_uuid)),
+          stamp(_stamp),
+          submsg(std::move(_submsg)) { }
+    uuid_u server_uuid;
+    uint64_t stamp;
+    msg_t submsg;
+};
+
+RDB_DECLARE_SERIALIZABLE_FOR_CLUSTER(stamped_msg_t);
+
 class real_feed_t;
-struct stamped_msg_t;
 
-typedef mailbox_addr_t<void(stamped_msg_t)> client_addr_t;
+// A `server_t` coalesces the messages it sends a client into batches.  All the
+// messages in a batch come from the same `server_t`.
+typedef mailbox_addr_t<void(std::vector<stamped_msg_t>)> client_addr_t;
 
 struct keyspec_t {
     struct range_t {
@@ -173,12 +205,17 @@ RDB_DECLARE_SERIALIZABLE_FOR_CLUSTER(keyspec_t::point_t);
 // should call `new_stream`.  The `client_t` will give it back a stream of rows.
 // The `client_t` does this by maintaining an internal map from table UUIDs to
 // `real_feed_t`s.  (It does this so that there is at most one `real_feed_t` per
-// <table, client> pair, to prevent redundant cluster messages.)  The actual
-// logic for subscribing to a changefeed server and distributing writes to
-// streams can be found in the `real_feed_t` class.
+// <table, client> pair, to prevent redundant cluster messages.)  The exception
+// is range subscriptions with transforms, which push their transforms down to
+// the shards and so get a `real_feed_t` per <table, transforms> pair instead.
+// The actual logic for subscribing to a changefeed server and distributing
+// writes to streams can be found in the `real_feed_t` class.
 class client_t : public home_thread_mixin_t {
 public:
     typedef client_addr_t addr_t;
+    // The table, and the serialized transforms and optargs the feed pushes down
+    // (empty if it doesn't push anything down).
+    typedef std::pair<namespace_id_t, std::vector<char> > feed_key_t;
     client_t(
         mailbox_manager_t *_manager,
         const std::function<
@@ -198,9 +235,9 @@ public:
         const std::string &table_name,
         const keyspec_t::spec_t &spec);
     void maybe_remove_feed(
-        const auto_drainer_t::lock_t &lock, const namespace_id_t &uuid);
+        const auto_drainer_t::lock_t &lock, const feed_key_t &key);
     scoped_ptr_t<real_feed_t> detach_feed(
-        const auto_drainer_t::lock_t &lock, const namespace_id_t &uuid);
+        const auto_drainer_t::lock_t &lock, const feed_key_t &key);
 private:
     friend class subscription_t;
     mailbox_manager_t *const manager;
@@ -209,7 +246,7 @@ private:
             const namespace_id_t &,
             signal_t *)
         > const namespace_source;
-    std::map<namespace_id_t, scoped_ptr_t<real_feed_t> > feeds;
+    std::map<feed_key_t, scoped_ptr_t<real_feed_t> > feeds;
     // This lock manages access to the `feeds` map.  The `feeds` map needs to be
     // read whenever `new_stream` is called, and needs to be written to whenever
     // `new_stream` is called with a table not already in the `feeds` map, or
@@ -424,7 +461,13 @@ public:
         limit_addr_t;
     explicit server_t(mailbox_manager_t *_manager);
     ~server_t();
-    void add_client(const client_t::addr_t &addr, region_t region);
+    // `transforms` are the transforms the client pushed down, which we apply to
+    // every change before sending it (see `flush_cb`).
+    void add_client(const client_t::addr_t &addr,
+                    region_t region,
+                    rdb_context_t *ctx,
+                    std::map<std::string, wire_func_t> optargs,
+                    const std::vector<transform_variant_t> &transforms);
     void add_limit_client(
         const client_t::addr_t &addr,
         const region_t &region,
@@ -460,6 +503,14 @@ private:
                                uuid_u uuid);
     void add_client_cb(signal_t *stopped, client_t::addr_t addr);
 
+    // The transforms a client pushed down, and the environment we evaluate them
+    // in.  `mutex` keeps two batches from being transformed at the same time.
+    struct pushed_down_ops_t {
+        scoped_ptr_t<env_t> env;
+        std::vector<scoped_ptr_t<op_t> > ops;
+        new_mutex_t mutex;
+    };
+
     // The UUID of the server, used so that `real_feed_t`s can enforce on ordering on
     // changefeed messages on a per-server basis (and drop changefeed messages
     // from before their own creation timestamp on a per-server basis).
@@ -479,6 +530,15 @@ private:
                      bool(const boost::optional<std::string> &,
                           const boost::optional<std::string> &)> > limit_clients;
         scoped_ptr_t<rwlock_t> limit_clients_lock;
+        // The transforms pushed down by the client, if it pushed any down.
+        // `flush_cb` uses them after letting go of `clients_lock`, so they're
+        // shared with it.
+        std::shared_ptr<pushed_down_ops_t> ops;
+        // Messages that have been stamped but not sent yet.  They're sent in one
+        // batch by `flush_cb`, or (if the client didn't push any transforms
+        // down) as soon as there are `MAX_BATCH_SIZE` of them.
+        std::vector<stamped_msg_t> batch;
+        bool flush_scheduled;
     };
     std::map<client_t::addr_t, client_info_t> clients;
 
@@ -492,6 +552,14 @@ private:
     void send_one_with_lock(const auto_drainer_t::lock_t &lock,
                             std::pair<const client_t::addr_t, client_info_t> *client,
                             msg_t msg);
+    // Sends the messages batched up for `client` as they are, without applying
+    // any transforms.  You need a read lock on `clients_lock`.
+    void flush_with_lock(std::pair<const client_t::addr_t, client_info_t> *client);
+    // Sends the messages batched up for the client at `addr`, after applying the
+    // transforms it pushed down.  This runs in its own coroutine, so the
+    // transforms are evaluated neither on the write path nor under
+    // `clients_lock`.
+    void flush_cb(auto_drainer_t::lock_t lock, client_t::addr_t addr);
 
     // Controls access to `clients`.  A `server_t` needs to read `clients` when:
     // * `send_all` is called
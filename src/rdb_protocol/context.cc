@@ -17,13 +17,21 @@ rdb_context_t::stats_t::stats_t(perfmon_collection_t *global_stats)
       queries_per_sec_membership(&qe_stats_collection,
                                  &queries_per_sec, "queries_per_sec"),
       queries_total_membership(&qe_stats_collection,
-                               &queries_total, "queries_total") { }
+                               &queries_total, "queries_total"),
+      query_latency_membership(&qe_stats_collection,
+                               &query_latency, "query_latency"),
+      read_round_trip_membership(&qe_stats_collection,
+                                 &read_round_trip, "read_round_trip"),
+      write_round_trip_membership(&qe_stats_collection,
+                                  &write_round_trip, "write_round_trip") { }
 
 rdb_context_t::rdb_context_t()
     : extproc_pool(nullptr),
       cluster_interface(nullptr),
       manager(nullptr),
       reql_http_proxy(),
+      io_backender(nullptr),
+      base_path(""),
       stats(&get_global_perfmon_collection()) { }
 
 rdb_context_t::rdb_context_t(
@@ -33,6 +41,8 @@ rdb_context_t::rdb_context_t(
       cluster_interface(_cluster_interface),
       manager(nullptr),
       reql_http_proxy(),
+      io_backender(nullptr),
+      base_path(""),
       stats(&get_global_perfmon_collection()) { }
 
 rdb_context_t::rdb_context_t(
@@ -42,12 +52,16 @@ rdb_context_t::rdb_context_t(
         boost::shared_ptr< semilattice_readwrite_view_t<auth_semilattice_metadata_t> >
             _auth_metadata,
         perfmon_collection_t *global_stats,
-        const std::string &_reql_http_proxy)
+        const std::string &_reql_http_proxy,
+        io_backender_t *_io_backender,
+        const base_path_t &_base_path)
     : extproc_pool(_extproc_pool),
       cluster_interface(_cluster_interface),
       auth_metadata(_auth_metadata),
       manager(_mailbox_manager),
       reql_http_proxy(_reql_http_proxy),
+      io_backender(_io_backender),
+      base_path(_base_path),
       stats(global_stats)
 { }
 
@@ -258,6 +258,7 @@ protected:
     virtual ~reql_cluster_interface_t() { }   // silence compiler warnings
 };
 
+class io_backender_t;
 class mailbox_manager_t;
 
 class rdb_context_t {
@@ -276,7 +277,9 @@ public:
                     semilattice_readwrite_view_t<
                         auth_semilattice_metadata_t> > _auth_metadata,
                   perfmon_collection_t *global_stats,
-                  const std::string &_reql_http_proxy);
+                  const std::string &_reql_http_proxy,
+                  io_backender_t *_io_backender,
+                  const base_path_t &_base_path);
 
     ~rdb_context_t();
 
@@ -290,6 +293,12 @@ public:
 
     const std::string reql_http_proxy;
 
+    // Unindexed `order_by`s that don't fit into memory spill to a file in the
+    // temporary directory of `base_path`.  `io_backender` is NULL if there is
+    // nowhere to spill to (e.g. on proxies).
+    io_backender_t *const io_backender;
+    const base_path_t base_path;
+
     class stats_t {
     public:
         explicit stats_t(perfmon_collection_t *global_stats);
@@ -304,6 +313,12 @@ public:
         perfmon_membership_t queries_per_sec_membership;
         perfmon_counter_t queries_total;
         perfmon_membership_t queries_total_membership;
+        perfmon_histogram_t query_latency;
+        perfmon_membership_t query_latency_membership;
+        perfmon_histogram_t read_round_trip;
+        perfmon_membership_t read_round_trip_membership;
+        perfmon_histogram_t write_round_trip;
+        perfmon_membership_t write_round_trip_membership;
     private:
         DISABLE_COPYING(stats_t);
     } stats;
@@ -16,6 +16,7 @@
 #include "containers/scoped.hpp"
 #include "rdb_protocol/env.hpp"
 #include "rdb_protocol/error.hpp"
+#include "rdb_protocol/json_parser.hpp"
 #include "rdb_protocol/pseudo_binary.hpp"
 #include "rdb_protocol/pseudo_geometry.hpp"
 #include "rdb_protocol/pseudo_literal.hpp"
@@ -406,10 +407,7 @@ datum_t datum_t::binary(datum_string_t &&_data) {
     return datum_t(construct_binary_t(), std::move(_data));
 }
 
-// two versions of these, because std::string is not necessarily null
-// terminated.
-inline void fail_if_invalid(reql_version_t reql_version, const std::string &string)
-{
+void fail_if_invalid(reql_version_t reql_version, const char *data, size_t size) {
     switch (reql_version) {
         case reql_version_t::v1_13:
         case reql_version_t::v1_14: // v1_15 is the same as v1_14
@@ -417,12 +415,12 @@ inline void fail_if_invalid(reql_version_t reql_version, const std::string &stri
         case reql_version_t::v1_16:
         case reql_version_t::v2_0_is_latest:
             utf8::reason_t reason;
-            if (!utf8::is_valid(string, &reason)) {
+            if (!utf8::is_valid(data, data + size, &reason)) {
                 int truncation_length = std::min<size_t>(reason.position, 20);
                 rfail_datum(base_exc_t::GENERIC,
                             "String `%.*s` (truncated) is not a UTF-8 string; "
                             "%s at position %zu.",
-                            truncation_length, string.c_str(), reason.explanation,
+                            truncation_length, data, reason.explanation,
                             reason.position);
             }
             break;
@@ -431,27 +429,16 @@ inline void fail_if_invalid(reql_version_t reql_version, const std::string &stri
     }
 }
 
+// two versions of these, because std::string is not necessarily null
+// terminated.
+inline void fail_if_invalid(reql_version_t reql_version, const std::string &string)
+{
+    fail_if_invalid(reql_version, string.data(), string.size());
+}
+
 inline void fail_if_invalid(reql_version_t reql_version, const char *string)
 {
-    switch (reql_version) {
-        case reql_version_t::v1_13:
-        case reql_version_t::v1_14: // v1_15 is the same as v1_14
-            break;
-        case reql_version_t::v1_16:
-        case reql_version_t::v2_0_is_latest:
-            utf8::reason_t reason;
-            if (!utf8::is_valid(string, &reason)) {
-                int truncation_length = std::min<size_t>(reason.position, 20);
-                rfail_datum(base_exc_t::GENERIC,
-                            "String `%.*s` (truncated) is not a UTF-8 string; "
-                            "%s at position %zu.",
-                            truncation_length, string, reason.explanation,
-                            reason.position);
-            }
-            break;
-        default:
-            unreachable();
-    }
+    fail_if_invalid(reql_version, string, strlen(string));
 }
 
 datum_t to_datum(cJSON *json, const configured_limits_t &limits,
@@ -1410,6 +1397,45 @@ scoped_cJSON_t datum_t::as_json() const {
     return scoped_cJSON_t(as_json_raw());
 }
 
+void datum_t::write_json(std::string *out) const {
+    switch (get_type()) {
+    case MINVAL: rfail_datum(base_exc_t::GENERIC, "Cannot convert `r.minval` to JSON.");
+    case MAXVAL: rfail_datum(base_exc_t::GENERIC, "Cannot convert `r.maxval` to JSON.");
+    case R_NULL: out->append("null"); break;
+    case R_BINARY: pseudo::write_base64_ptype_json(as_binary(), out); break;
+    case R_BOOL: out->append(as_bool() ? "true" : "false"); break;
+    case R_NUM: json_append_number(as_num(), out); break;
+    case R_STR: json_append_string(as_str().data(), as_str().size(), out); break;
+    case R_ARRAY: {
+        out->push_back('[');
+        const size_t sz = arr_size();
+        for (size_t i = 0; i < sz; ++i) {
+            if (i != 0) {
+                out->push_back(',');
+            }
+            unchecked_get(i).write_json(out);
+        }
+        out->push_back(']');
+    } break;
+    case R_OBJECT: {
+        out->push_back('{');
+        const size_t sz = obj_size();
+        for (size_t i = 0; i < sz; ++i) {
+            if (i != 0) {
+                out->push_back(',');
+            }
+            auto pair = get_pair(i);
+            json_append_string(pair.first.data(), pair.first.size(), out);
+            out->push_back(':');
+            pair.second.write_json(out);
+        }
+        out->push_back('}');
+    } break;
+    case UNINITIALIZED: // fallthru
+    default: unreachable();
+    }
+}
+
 // TODO: make BINARY, STR, and OBJECT convertible to sequence?
 counted_t<datum_stream_t>
 datum_t::as_datum_stream(const protob_t<const Backtrace> &backtrace) const {
@@ -1691,8 +1717,13 @@ datum_t to_datum(const Datum *d, const configured_limits_t &limits,
     } break;
     case Datum::R_JSON: {
         fail_if_invalid(reql_version, d->r_str());
-        scoped_cJSON_t cjson(cJSON_Parse(d->r_str().c_str()));
-        return to_datum(cjson.get(), limits, reql_version);
+        datum_t parsed;
+        const bool success = parse_json(d->r_str().c_str(), limits, reql_version,
+                                        &parsed);
+        rcheck_datum(success, base_exc_t::GENERIC,
+                     strprintf("Failed to parse `%s` as JSON.",
+                               d->r_str().substr(0, 40).c_str()));
+        return parsed;
     } break;
     case Datum::R_ARRAY: {
         datum_array_builder_t out(limits);
@@ -1801,7 +1832,7 @@ void datum_t::write_to_protobuf(Datum *d, use_json_t use_json) const {
     } break;
     case use_json_t::YES: {
         d->set_type(Datum::R_JSON);
-        d->set_r_str(as_json().PrintUnformatted());
+        write_json(d->mutable_r_str());
     } break;
     default: unreachable();
     }
@@ -2137,6 +2168,12 @@ bool datum_range_t::is_universe() const {
            right_bound_type == key_range_t::open;
 }
 
+bool datum_range_t::is_bounded() const {
+    r_sanity_check(left_bound.has() && right_bound.has());
+    return left_bound.get_type() != datum_t::type_t::MINVAL &&
+           right_bound.get_type() != datum_t::type_t::MAXVAL;
+}
+
 bool datum_range_t::contains(reql_version_t reql_version,
                              datum_t val) const {
     r_sanity_check(left_bound.has() && right_bound.has());
@@ -290,6 +290,9 @@ public:
 
     cJSON *as_json_raw() const;
     scoped_cJSON_t as_json() const;
+    // Appends the same text as `as_json().PrintUnformatted()` to `out`, without
+    // building a cJSON tree on the way.
+    void write_json(std::string *out) const;
     counted_t<datum_stream_t> as_datum_stream(
             const protob_t<const Backtrace> &backtrace) const;
 
@@ -443,6 +446,8 @@ public:
 
     bool contains(reql_version_t reql_version, datum_t val) const;
     bool is_universe() const;
+    // True if neither end of the range is `r.minval` or `r.maxval`.
+    bool is_bounded() const;
 
     RDB_DECLARE_ME_SERIALIZABLE(datum_range_t);
 
@@ -470,6 +475,9 @@ private:
 datum_t to_datum(const Datum *d, const configured_limits_t &, reql_version_t);
 datum_t to_datum(cJSON *json, const configured_limits_t &, reql_version_t);
 
+// Fails if strings must be valid UTF-8 under `reql_version` and `data` isn't.
+void fail_if_invalid(reql_version_t reql_version, const char *data, size_t size);
+
 // This should only be used to send responses to the client.
 datum_t to_datum_for_client_serialization(grouped_data_t &&gd,
                                           reql_version_t reql_version,
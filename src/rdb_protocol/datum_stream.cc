@@ -1,12 +1,19 @@
 // Copyright 2010-2013 RethinkDB, all rights reserved.
 #include "rdb_protocol/datum_stream.hpp"
 
+#include <fcntl.h>
+#include <unistd.h>
+
 #include <map>
 
+#include "arch/runtime/thread_pool.hpp"
 #include "boost_utils.hpp"
+#include "containers/archive/buffer_stream.hpp"
+#include "containers/archive/vector_stream.hpp"
 #include "rdb_protocol/batching.hpp"
 #include "rdb_protocol/env.hpp"
 #include "rdb_protocol/func.hpp"
+#include "rdb_protocol/serialize_datum.hpp"
 #include "rdb_protocol/term.hpp"
 #include "rdb_protocol/val.hpp"
 #include "utils.hpp"
@@ -928,11 +935,8 @@ bool array_datum_stream_t::is_array() const {
 // INDEXED_SORT_DATUM_STREAM_T
 indexed_sort_datum_stream_t::indexed_sort_datum_stream_t(
     counted_t<datum_stream_t> stream,
-    std::function<bool(env_t *,  // NOLINT(readability/casting)
-                       profile::sampler_t *,
-                       const datum_t &,
-                       const datum_t &)> _lt_cmp)
-    : wrapper_datum_stream_t(stream), lt_cmp(_lt_cmp), index(0) { }
+    order_by_keys_t _keys)
+    : wrapper_datum_stream_t(stream), keys(std::move(_keys)), index(0) { }
 
 std::vector<datum_t>
 indexed_sort_datum_stream_t::next_raw_batch(env_t *env, const batchspec_t &batchspec) {
@@ -954,8 +958,7 @@ indexed_sort_datum_stream_t::next_raw_batch(env_t *env, const batchspec_t &batch
             if (index >= data.size()) {
                 return ret;
             }
-            std::stable_sort(data.begin(), data.end(),
-                             std::bind(lt_cmp, env, &sampler, ph::_1, ph::_2));
+            keys.sort_rows(env, &sampler, &data);
         }
         for (; index < data.size() && !batcher.should_send_batch(); ++index) {
             batcher.note_el(data[index]);
@@ -965,6 +968,266 @@ indexed_sort_datum_stream_t::next_raw_batch(env_t *env, const batchspec_t &batch
     return ret;
 }
 
+// EXTERNAL_SORT_DATUM_STREAM_T
+
+namespace {
+
+// Spilled rows are stored as `[row, key...]`, where each key is wrapped in an array
+// so that empty keys can be stored as `[]`.
+datum_t encode_spilled_row(keyed_row_t &&keyed_row) {
+    std::vector<datum_t> encoded;
+    encoded.reserve(keyed_row.keys.size() + 1);
+    encoded.push_back(std::move(keyed_row.row));
+    for (auto it = keyed_row.keys.begin(); it != keyed_row.keys.end(); ++it) {
+        std::vector<datum_t> wrapped;
+        if (it->has()) {
+            wrapped.push_back(std::move(*it));
+        }
+        encoded.push_back(datum_t(std::move(wrapped),
+                                  datum_t::no_array_size_limit_check_t()));
+    }
+    return datum_t(std::move(encoded), datum_t::no_array_size_limit_check_t());
+}
+
+keyed_row_t decode_spilled_row(const datum_t &encoded) {
+    keyed_row_t ret;
+    ret.row = encoded.get(0);
+    ret.keys.reserve(encoded.arr_size() - 1);
+    for (size_t i = 1; i < encoded.arr_size(); ++i) {
+        const datum_t wrapped = encoded.get(i);
+        ret.keys.push_back(wrapped.arr_size() == 0 ? datum_t() : wrapped.get(0));
+    }
+    return ret;
+}
+
+// We append spilled rows to the file in chunks of at least this size.
+const size_t SPILL_WRITE_CHUNK_SIZE = MEGABYTE;
+// We read each run back in chunks of this size.  There is a buffer like that for
+// every run, so it's kept small.
+const size_t SPILL_READ_CHUNK_SIZE = 64 * KILOBYTE;
+
+// Writes all of `data` at `offset`.  Returns 0 or an errno value.
+int pwrite_all(fd_t fd, const char *data, size_t size, int64_t offset) {
+    while (size > 0) {
+        ssize_t res = pwrite(fd, data, size, offset);
+        if (res == -1) {
+            if (get_errno() == EINTR) {
+                continue;
+            }
+            return get_errno();
+        }
+        data += res;
+        size -= res;
+        offset += res;
+    }
+    return 0;
+}
+
+// Reads exactly `size` bytes at `offset`.  Returns 0 or an errno value.
+int pread_all(fd_t fd, char *data, size_t size, int64_t offset) {
+    while (size > 0) {
+        ssize_t res = pread(fd, data, size, offset);
+        if (res == -1) {
+            if (get_errno() == EINTR) {
+                continue;
+            }
+            return get_errno();
+        } else if (res == 0) {
+            // We only read back what we wrote, so the file can't be shorter.
+            return EIO;
+        }
+        data += res;
+        size -= res;
+        offset += res;
+    }
+    return 0;
+}
+
+}  // namespace
+
+external_sort_datum_stream_t::external_sort_datum_stream_t(
+        order_by_keys_t _keys,
+        const base_path_t &_base_path,
+        reql_version_t _reql_version,
+        const protob_t<const Backtrace> &bt_src)
+    : eager_datum_stream_t(bt_src),
+      keys(std::move(_keys)),
+      base_path(_base_path),
+      reql_version(_reql_version),
+      spill_size(0),
+      last_run_index(0) { }
+
+void external_sort_datum_stream_t::spill_run(std::vector<keyed_row_t> &&run) {
+    guarantee(heads.empty(), "Spilling a run after the stream was finished.");
+    if (spill_fd.get() == INVALID_FD) {
+        // The temporary directory is emptied when the server starts, so a file
+        // that survives a crash in between opening and unlinking is removed then.
+        const std::string path = base_path.path() + "/" + TEMPORARY_DIRECTORY_NAME
+            + "/order_by_" + uuid_to_str(generate_uuid());
+        int err = 0;
+        thread_pool_t::run_in_blocker_pool([&]() {
+            spill_fd.reset(open(path.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600));
+            if (spill_fd.get() == INVALID_FD) {
+                err = get_errno();
+            } else {
+                unlink(path.c_str());
+            }
+        });
+        rcheck(err == 0, base_exc_t::GENERIC,
+               strprintf("Could not create a temporary file to sort on disk: %s",
+                         errno_string(err).c_str()));
+    }
+
+    spilled_run_t spilled;
+    spilled.offset = spill_size;
+    spilled.buffer_pos = 0;
+    vector_stream_t stream;
+    std::vector<char> chunk;
+    for (auto it = run.begin(); it != run.end(); ++it) {
+        // Each row is stored as its size followed by its serialization.
+        write_message_t wm;
+        const datum_t encoded = encode_spilled_row(std::move(*it));
+        serialize_universal(&wm, static_cast<uint64_t>(datum_serialized_size(
+            encoded, check_datum_serialization_errors_t::NO)));
+        datum_serialize(&wm, encoded, check_datum_serialization_errors_t::NO);
+        int res = send_write_message(&stream, &wm);
+        guarantee(res == 0);
+        if (stream.vector().size() >= SPILL_WRITE_CHUNK_SIZE || it + 1 == run.end()) {
+            stream.swap(&chunk);
+            append_to_spill_file(&chunk);
+        }
+    }
+    spilled.end = spill_size;
+    spilled_runs.push_back(std::move(spilled));
+    run.clear();
+}
+
+void external_sort_datum_stream_t::append_to_spill_file(std::vector<char> *data) {
+    rcheck(spill_size + static_cast<int64_t>(data->size()) <= MAX_ORDER_BY_SPILL_SIZE,
+           base_exc_t::GENERIC,
+           strprintf("Sorting on disk would need more than %" PRIi64 " bytes of "
+                     "temporary space.  Use an index to order by instead.",
+                     MAX_ORDER_BY_SPILL_SIZE));
+    int err = 0;
+    thread_pool_t::run_in_blocker_pool([&]() {
+        err = pwrite_all(spill_fd.get(), data->data(), data->size(), spill_size);
+    });
+    rcheck(err == 0, base_exc_t::GENERIC,
+           strprintf("Could not write to the temporary file to sort on disk: %s",
+                     errno_string(err).c_str()));
+    spill_size += data->size();
+    data->clear();
+}
+
+void external_sort_datum_stream_t::fill_run_buffer(spilled_run_t *run, size_t size) {
+    const size_t available = run->buffer.size() - run->buffer_pos;
+    if (available >= size) {
+        return;
+    }
+    run->buffer.erase(run->buffer.begin(), run->buffer.begin() + run->buffer_pos);
+    run->buffer_pos = 0;
+    const size_t to_read = std::min<int64_t>(
+        std::max(size - available, SPILL_READ_CHUNK_SIZE), run->end - run->offset);
+    guarantee(to_read >= size - available, "Spilled run is truncated.");
+    run->buffer.resize(available + to_read);
+    int err = 0;
+    thread_pool_t::run_in_blocker_pool([&]() {
+        err = pread_all(spill_fd.get(), run->buffer.data() + available, to_read,
+                        run->offset);
+    });
+    rcheck(err == 0, base_exc_t::GENERIC,
+           strprintf("Could not read from the temporary file to sort on disk: %s",
+                     errno_string(err).c_str()));
+    run->offset += to_read;
+}
+
+void external_sort_datum_stream_t::finish(std::vector<keyed_row_t> &&_last_run) {
+    guarantee(heads.empty(), "Finishing the stream twice.");
+    last_run = std::move(_last_run);
+    heads.resize(spilled_runs.size() + 1);
+    for (size_t i = 0; i < heads.size(); ++i) {
+        advance_run(i);
+        if (heads[i].row.has()) {
+            heap.push_back(i);
+        }
+    }
+    std::make_heap(heap.begin(), heap.end(),
+                   [this](size_t a, size_t b) { return run_comes_after(a, b); });
+}
+
+void external_sort_datum_stream_t::advance_run(size_t i) {
+    if (i < spilled_runs.size()) {
+        spilled_run_t *run = &spilled_runs[i];
+        if (run->buffer_pos == run->buffer.size() && run->offset == run->end) {
+            heads[i] = keyed_row_t();
+            std::vector<char>().swap(run->buffer);
+        } else {
+            uint64_t size;
+            fill_run_buffer(run, sizeof(size));
+            buffer_read_stream_t size_stream(run->buffer.data() + run->buffer_pos,
+                                             sizeof(size));
+            archive_result_t res = deserialize_universal(&size_stream, &size);
+            guarantee_deserialization(res, "spilled order_by row size");
+            run->buffer_pos += sizeof(size);
+
+            fill_run_buffer(run, size);
+            buffer_read_stream_t stream(run->buffer.data() + run->buffer_pos, size);
+            datum_t encoded;
+            res = datum_deserialize(&stream, &encoded);
+            guarantee_deserialization(res, "spilled order_by row");
+            run->buffer_pos += size;
+            heads[i] = decode_spilled_row(encoded);
+        }
+    } else if (last_run_index < last_run.size()) {
+        heads[i] = std::move(last_run[last_run_index++]);
+    } else {
+        heads[i] = keyed_row_t();
+    }
+}
+
+bool external_sort_datum_stream_t::run_comes_after(size_t a, size_t b) const {
+    if (keys.lt(reql_version, heads[b], heads[a])) {
+        return true;
+    }
+    return !keys.lt(reql_version, heads[a], heads[b]) && b < a;
+}
+
+bool external_sort_datum_stream_t::is_exhausted() const {
+    return heap.empty() && batch_cache_exhausted();
+}
+
+feed_type_t external_sort_datum_stream_t::cfeed_type() const {
+    return feed_type_t::not_feed;
+}
+
+bool external_sort_datum_stream_t::is_infinite() const {
+    return false;
+}
+
+std::vector<datum_t>
+external_sort_datum_stream_t::next_raw_batch(env_t *env, const batchspec_t &batchspec) {
+    std::vector<datum_t> ret;
+    batcher_t batcher = batchspec.to_batcher();
+
+    profile::sampler_t sampler("Merging sorted runs.", env->trace);
+    auto comes_after = [this](size_t a, size_t b) { return run_comes_after(a, b); };
+    while (!heap.empty() && !batcher.should_send_batch()) {
+        std::pop_heap(heap.begin(), heap.end(), comes_after);
+        const size_t min = heap.back();
+        datum_t row = std::move(heads[min].row);
+        advance_run(min);
+        if (heads[min].row.has()) {
+            std::push_heap(heap.begin(), heap.end(), comes_after);
+        } else {
+            heap.pop_back();
+        }
+        batcher.note_el(row);
+        ret.push_back(std::move(row));
+        sampler.new_sample();
+    }
+    return ret;
+}
+
 // ORDERED_DISTINCT_DATUM_STREAM_T
 ordered_distinct_datum_stream_t::ordered_distinct_datum_stream_t(
     counted_t<datum_stream_t> _source) : wrapper_datum_stream_t(_source) { }
@@ -15,10 +15,12 @@
 #include "errors.hpp"
 #include <boost/optional.hpp>
 
+#include "arch/io/io_utils.hpp"
 #include "containers/counted.hpp"
 #include "containers/scoped.hpp"
 #include "rdb_protocol/context.hpp"
 #include "rdb_protocol/math_utils.hpp"
+#include "rdb_protocol/order_by.hpp"
 #include "rdb_protocol/protocol.hpp"
 #include "rdb_protocol/real_table.hpp"
 #include "rdb_protocol/shards.hpp"
@@ -223,22 +225,86 @@ class indexed_sort_datum_stream_t : public wrapper_datum_stream_t {
 public:
     indexed_sort_datum_stream_t(
         counted_t<datum_stream_t> stream, // Must be a table with a sorting applied.
-        std::function<bool(env_t *,  // NOLINT(readability/casting)
-                           profile::sampler_t *,
-                           const datum_t &,
-                           const datum_t &)> lt_cmp);
+        order_by_keys_t keys);
 private:
 virtual std::vector<datum_t>
 next_raw_batch(env_t *env, const batchspec_t &batchspec);
 
-std::function<bool(env_t *,  // NOLINT(readability/casting)
-                   profile::sampler_t *,
-                   const datum_t &,
-                   const datum_t &)> lt_cmp;
+const order_by_keys_t keys;
 size_t index;
 std::vector<datum_t> data;
 };
 
+// The most temporary disk space a single unindexed `order_by` may use.
+const int64_t MAX_ORDER_BY_SPILL_SIZE = 64 * GIGABYTE;
+
+/* `external_sort_datum_stream_t` returns the rows of an unindexed `order_by` that has
+more rows than fit into an array.  The rows are handed to it in sorted runs, all but
+the last of which are appended to a single temporary file, and it merges the runs as
+it is read. */
+class external_sort_datum_stream_t : public eager_datum_stream_t {
+public:
+    external_sort_datum_stream_t(order_by_keys_t keys,
+                                 const base_path_t &base_path,
+                                 reql_version_t reql_version,
+                                 const protob_t<const Backtrace> &bt_src);
+
+    // Writes a sorted run to the spill file.  Fails if the file would grow past
+    // `MAX_ORDER_BY_SPILL_SIZE`.
+    void spill_run(std::vector<keyed_row_t> &&run);
+    // Adds the last sorted run, which is kept in memory.  Must be called once,
+    // before the stream is read.
+    void finish(std::vector<keyed_row_t> &&last_run);
+
+    virtual bool is_exhausted() const;
+    virtual feed_type_t cfeed_type() const;
+    virtual bool is_infinite() const;
+
+private:
+    // The part of the spill file that holds a run.
+    struct spilled_run_t {
+        // The rows between `offset` and `end` haven't been read from the file yet.
+        int64_t offset;
+        int64_t end;
+        // Rows that have been read but not decoded, starting at `buffer_pos`.
+        std::vector<char> buffer;
+        size_t buffer_pos;
+    };
+
+    virtual bool is_array() const { return false; }
+    virtual datum_t as_array(env_t *) { return datum_t(); }
+    virtual std::vector<datum_t>
+    next_raw_batch(env_t *env, const batchspec_t &batchspec);
+
+    void append_to_spill_file(std::vector<char> *data);
+    // Makes sure that at least `size` unread bytes of `run` are in its buffer.
+    void fill_run_buffer(spilled_run_t *run, size_t size);
+    // Replaces `heads[i]` with the next row of run `i`, or with an empty row if the
+    // run has no rows left.
+    void advance_run(size_t i);
+    // The ordering of `heap`: true if the head of run `a` comes after that of `b`.
+    bool run_comes_after(size_t a, size_t b) const;
+
+    const order_by_keys_t keys;
+    const base_path_t base_path;
+    const reql_version_t reql_version;
+
+    // Opened on the first spill and unlinked right away, so the file is gone once
+    // the stream is destroyed, even if the server crashes.
+    scoped_fd_t spill_fd;
+    int64_t spill_size;
+    std::vector<spilled_run_t> spilled_runs;
+    std::vector<keyed_row_t> last_run;
+    size_t last_run_index;
+
+    // The next row of every run, with the in-memory run last.  Earlier runs hold
+    // earlier rows, so ties go to the run with the lowest index.
+    std::vector<keyed_row_t> heads;
+    // The runs that have rows left, as a heap whose top is the run with the
+    // smallest head.
+    std::vector<size_t> heap;
+};
+
 struct coro_info_t;
 class coro_stream_t;
 
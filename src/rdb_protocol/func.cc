@@ -1,8 +1,11 @@
 #include "rdb_protocol/func.hpp"
 
+#include <algorithm>
+
 #include "rdb_protocol/counted_term.hpp"
 #include "rdb_protocol/env.hpp"
 #include "rdb_protocol/minidriver.hpp"
+#include "rdb_protocol/pathspec.hpp"
 #include "rdb_protocol/pseudo_literal.hpp"
 #include "rdb_protocol/ql2.pb.h"
 #include "rdb_protocol/term_walker.hpp"
@@ -32,6 +35,22 @@ scoped_ptr_t<val_t> func_t::call(env_t *env,
     return call(env, make_vector(arg1, arg2), eval_flags);
 }
 
+void func_t::call_batch(env_t *env,
+                        const std::vector<datum_t> &args,
+                        std::vector<datum_t> *results_out) const {
+    for (auto it = args.begin(); it != args.end(); ++it) {
+        results_out->push_back(call(env, *it)->as_datum());
+    }
+}
+
+void func_t::filter_helper_batch(env_t *env,
+                                 const std::vector<datum_t> &args,
+                                 std::vector<bool> *results_out) const {
+    for (auto it = args.begin(); it != args.end(); ++it) {
+        results_out->push_back(filter_helper(env, *it));
+    }
+}
+
 void func_t::assert_deterministic(const char *extra_msg) const {
     rcheck(is_deterministic(),
            base_exc_t::GENERIC,
@@ -43,7 +62,9 @@ reql_func_t::reql_func_t(const protob_t<const Backtrace> backtrace,
                          std::vector<sym_t> _arg_names,
                          counted_t<const term_t> _body)
     : func_t(backtrace), captured_scope(_captured_scope),
-      arg_names(std::move(_arg_names)), body(std::move(_body)) { }
+      arg_names(std::move(_arg_names)), body(std::move(_body)) {
+    init_fast_path();
+}
 
 reql_func_t::~reql_func_t() { }
 
@@ -74,6 +95,189 @@ scoped_ptr_t<val_t> reql_func_t::call(env_t *env,
     }
 }
 
+void reql_func_t::call_batch(env_t *env,
+                             const std::vector<datum_t> &args,
+                             std::vector<datum_t> *results_out) const {
+    if (fast_path == fast_path_t::NONE) {
+        func_t::call_batch(env, args, results_out);
+        return;
+    }
+
+    // Convert the parts of the body the fast path needs once for the whole batch.
+    // If that fails, every call fails the same way, so let `call` report it.
+    bool use_fast_path = true;
+    datum_t constant;
+    scoped_ptr_t<pathspec_t> pluck_pathspec;
+    try {
+        if (fast_path == fast_path_t::COMPARE) {
+            constant = to_datum(fast_path_constant, env->limits(), env->reql_version());
+        } else if (fast_path == fast_path_t::PLUCK) {
+            std::vector<datum_t> paths;
+            for (int i = 1; i < fast_path_pluck->args_size(); ++i) {
+                paths.push_back(to_datum(&fast_path_pluck->args(i).datum(),
+                                         env->limits(),
+                                         env->reql_version()));
+            }
+            pluck_pathspec.init(new pathspec_t(datum_t(std::move(paths), env->limits()),
+                                               body.get()));
+        }
+    } catch (const base_exc_t &) {
+        use_fast_path = false;
+    }
+
+    results_out->reserve(results_out->size() + args.size());
+    for (auto it = args.begin(); it != args.end(); ++it) {
+        datum_t res;
+        if (use_fast_path) {
+            res = fast_call(env, *it, constant, pluck_pathspec.get_or_null());
+        }
+        if (!res.has()) {
+            res = func_t::call(env, *it)->as_datum();
+        }
+        results_out->push_back(res);
+    }
+}
+
+void reql_func_t::filter_helper_batch(env_t *env,
+                                      const std::vector<datum_t> &args,
+                                      std::vector<bool> *results_out) const {
+    // None of the fast path bodies is an object literal, so `filter_helper` would
+    // just take the truthiness of the result.
+    if (fast_path == fast_path_t::NONE) {
+        func_t::filter_helper_batch(env, args, results_out);
+    } else {
+        filter_helper_batch_as_bools(env, args, results_out);
+    }
+}
+
+// Returns the field name if `t` is `x(field)` or `x.get_field(field)` for the
+// variable `var`, and NULL otherwise.
+static const std::string *match_var_field(const Term &t, sym_t var) {
+    if ((t.type() != Term::GET_FIELD && t.type() != Term::BRACKET)
+        || t.args_size() != 2 || t.optargs_size() != 0) {
+        return NULL;
+    }
+    const Term &obj = t.args(0);
+    const Term &field = t.args(1);
+    if (obj.type() != Term::VAR || obj.args_size() != 1
+        || obj.args(0).type() != Term::DATUM
+        || obj.args(0).datum().type() != Datum::R_NUM
+        || obj.args(0).datum().r_num() != static_cast<double>(var.value)) {
+        return NULL;
+    }
+    if (field.type() != Term::DATUM || field.datum().type() != Datum::R_STR) {
+        return NULL;
+    }
+    return &field.datum().r_str();
+}
+
+void reql_func_t::init_fast_path() {
+    fast_path = fast_path_t::NONE;
+    fast_path_cmp = Term::EQ;
+    fast_path_constant = NULL;
+    fast_path_pluck = NULL;
+    if (arg_names.size() != 1) {
+        return;
+    }
+    const Term &t = *body->get_src();
+
+    if (const std::string *field = match_var_field(t, arg_names[0])) {
+        fast_path = fast_path_t::GET_FIELD;
+        fast_path_field = datum_string_t(*field);
+        return;
+    }
+
+    const Term::TermType type = t.type();
+    if (type == Term::EQ || type == Term::NE || type == Term::LT
+        || type == Term::LE || type == Term::GT || type == Term::GE) {
+        if (t.args_size() != 2 || t.optargs_size() != 0) {
+            return;
+        }
+        const std::string *field = match_var_field(t.args(0), arg_names[0]);
+        const Term &rhs = t.args(1);
+        if (field == NULL || rhs.type() != Term::DATUM) {
+            return;
+        }
+        const Datum::DatumType rhs_type = rhs.datum().type();
+        if (rhs_type != Datum::R_NULL && rhs_type != Datum::R_BOOL
+            && rhs_type != Datum::R_NUM && rhs_type != Datum::R_STR) {
+            return;
+        }
+        fast_path = fast_path_t::COMPARE;
+        fast_path_field = datum_string_t(*field);
+        fast_path_cmp = type;
+        fast_path_constant = &rhs.datum();
+    } else if (type == Term::PLUCK) {
+        if (t.args_size() < 2 || t.optargs_size() != 0) {
+            return;
+        }
+        const Term &obj = t.args(0);
+        if (obj.type() != Term::VAR || obj.args_size() != 1
+            || obj.args(0).type() != Term::DATUM
+            || obj.args(0).datum().type() != Datum::R_NUM
+            || obj.args(0).datum().r_num() != static_cast<double>(arg_names[0].value)) {
+            return;
+        }
+        for (int i = 1; i < t.args_size(); ++i) {
+            if (t.args(i).type() != Term::DATUM
+                || t.args(i).datum().type() != Datum::R_STR) {
+                return;
+            }
+        }
+        fast_path = fast_path_t::PLUCK;
+        fast_path_pluck = &t;
+    }
+}
+
+datum_t reql_func_t::fast_call(env_t *env,
+                               const datum_t &arg,
+                               const datum_t &constant,
+                               const pathspec_t *pluck_pathspec) const {
+    // Pseudotypes get special treatment (or errors) from these terms.
+    if (arg.get_type() != datum_t::R_OBJECT || arg.is_ptype()) {
+        return datum_t();
+    }
+    switch (fast_path) {
+    case fast_path_t::GET_FIELD:
+        return arg.get_field(fast_path_field, NOTHROW);
+    case fast_path_t::COMPARE: {
+        datum_t field = arg.get_field(fast_path_field, NOTHROW);
+        if (!field.has()) {
+            return datum_t();
+        }
+        // The constant is one of these too, so comparing them can't fail.
+        const datum_t::type_t field_type = field.get_type();
+        if (field_type != datum_t::R_NULL && field_type != datum_t::R_BOOL
+            && field_type != datum_t::R_NUM && field_type != datum_t::R_STR) {
+            return datum_t();
+        }
+        if (fast_path_cmp == Term::EQ) {
+            return datum_t::boolean(field == constant);
+        } else if (fast_path_cmp == Term::NE) {
+            return datum_t::boolean(!(field == constant));
+        }
+        const int cmp = field.cmp(env->reql_version(), constant);
+        if (fast_path_cmp == Term::LT) {
+            return datum_t::boolean(cmp < 0);
+        } else if (fast_path_cmp == Term::LE) {
+            return datum_t::boolean(cmp <= 0);
+        } else if (fast_path_cmp == Term::GT) {
+            return datum_t::boolean(cmp > 0);
+        } else if (fast_path_cmp == Term::GE) {
+            return datum_t::boolean(cmp >= 0);
+        } else {
+            unreachable();
+        }
+    }
+    case fast_path_t::PLUCK:
+        r_sanity_check(pluck_pathspec != NULL);
+        return project(arg, *pluck_pathspec, DONT_RECURSE, env->limits());
+    case fast_path_t::NONE: // fallthru
+    default:
+        unreachable();
+    }
+}
+
 boost::optional<size_t> reql_func_t::arity() const {
     return arg_names.size();
 }
@@ -124,6 +328,70 @@ scoped_ptr_t<val_t> js_func_t::call(
     }
 }
 
+void js_func_t::call_batch(env_t *env,
+                           const std::vector<datum_t> &args,
+                           std::vector<datum_t> *results_out) const {
+    try {
+        js_runner_t::req_config_t config;
+        config.timeout_ms = js_timeout_ms;
+
+        r_sanity_check(!js_source.empty());
+        // The worker can only time a batch as a whole, and each batch gets the
+        // timeout of a single call.  A batch that runs out of time is split in half
+        // and retried, so we only redo the calls of that batch, and the batches
+        // after it are sized to fit.  Once a single call runs out of time, it fails
+        // like it would in `call`.
+        size_t chunk_size = args.size();
+        size_t chunk_begin = 0;
+        std::vector<std::vector<datum_t> > args_batch;
+        std::vector<js_result_t> results;
+        while (chunk_begin < args.size()) {
+            const size_t chunk_end = std::min(args.size(), chunk_begin + chunk_size);
+            args_batch.clear();
+            for (size_t i = chunk_begin; i < chunk_end; ++i) {
+                args_batch.push_back(make_vector(args[i]));
+            }
+
+            bool finished;
+            try {
+                finished = env->get_js_runner()->call_batch(js_source, args_batch,
+                                                            config, &results);
+            } catch (const extproc_worker_exc_t &e) {
+                rfail(base_exc_t::GENERIC,
+                      "Javascript query `%s` caused a crash in a worker process.",
+                      js_source.c_str());
+            } catch (const interrupted_exc_t &e) {
+                rfail(base_exc_t::GENERIC,
+                      "JavaScript query `%s` timed out after "
+                      "%" PRIu64 ".%03" PRIu64 " seconds.",
+                      js_source.c_str(), js_timeout_ms / 1000, js_timeout_ms % 1000);
+            }
+            if (!finished) {
+                rcheck(chunk_end - chunk_begin > 1,
+                       base_exc_t::GENERIC,
+                       strprintf("JavaScript query `%s` timed out after "
+                                 "%" PRIu64 ".%03" PRIu64 " seconds.",
+                                 js_source.c_str(),
+                                 js_timeout_ms / 1000, js_timeout_ms % 1000));
+                chunk_size = (chunk_end - chunk_begin + 1) / 2;
+                continue;
+            }
+
+            results_out->reserve(results_out->size() + results.size());
+            for (auto it = results.begin(); it != results.end(); ++it) {
+                scoped_ptr_t<val_t> val(
+                    boost::apply_visitor(
+                        js_result_visitor_t(js_source, js_timeout_ms, this), *it));
+                results_out->push_back(val->as_datum());
+            }
+            chunk_begin = chunk_end;
+        }
+    } catch (const datum_exc_t &e) {
+        rfail(e.get_type(), "%s", e.what());
+        unreachable();
+    }
+}
+
 boost::optional<size_t> js_func_t::arity() const {
     return boost::none;
 }
@@ -287,21 +555,37 @@ bool js_func_t::filter_helper(env_t *env, datum_t arg) const {
     return d.as_bool();
 }
 
-bool func_t::filter_call(env_t *env, datum_t arg, counted_t<const func_t> default_filter_val) const {
-    // We have to catch every exception type and save it so we can rethrow it later
-    // So we don't trigger a coroutine wait in a catch statement
-    std::exception_ptr saved_exception;
-    base_exc_t::type_t exception_type;
+void js_func_t::filter_helper_batch(env_t *env,
+                                    const std::vector<datum_t> &args,
+                                    std::vector<bool> *results_out) const {
+    filter_helper_batch_as_bools(env, args, results_out);
+}
 
+void func_t::filter_helper_batch_as_bools(env_t *env,
+                                          const std::vector<datum_t> &args,
+                                          std::vector<bool> *results_out) const {
+    std::vector<datum_t> ds;
+    std::exception_ptr saved_exception;
     try {
-        return filter_helper(env, arg);
-    } catch (const base_exc_t &e) {
+        call_batch(env, args, &ds);
+    } catch (...) {
         saved_exception = std::current_exception();
-        exception_type = e.get_type();
     }
+    // The calls before the one that failed still count.
+    for (auto it = ds.begin(); it != ds.end(); ++it) {
+        results_out->push_back(it->as_bool());
+    }
+    if (saved_exception != std::exception_ptr()) {
+        std::rethrow_exception(saved_exception);
+    }
+}
 
-    // We can't call the default_filter_val earlier because it could block,
-    //  which would crash since we were in an exception handler
+// Handles an exception thrown by a filter function, which `filter_call` and
+// `filter_call_batch` must have caught and saved.
+bool filter_default(env_t *env,
+                    std::exception_ptr saved_exception,
+                    base_exc_t::type_t exception_type,
+                    counted_t<const func_t> default_filter_val) {
     guarantee(saved_exception != std::exception_ptr());
 
     if (exception_type == base_exc_t::NON_EXISTENCE) {
@@ -331,6 +615,56 @@ bool func_t::filter_call(env_t *env, datum_t arg, counted_t<const func_t> defaul
     std::rethrow_exception(saved_exception);
 }
 
+bool func_t::filter_call(env_t *env, datum_t arg, counted_t<const func_t> default_filter_val) const {
+    // We have to catch every exception type and save it so we can rethrow it later
+    // So we don't trigger a coroutine wait in a catch statement
+    std::exception_ptr saved_exception;
+    base_exc_t::type_t exception_type;
+
+    try {
+        return filter_helper(env, arg);
+    } catch (const base_exc_t &e) {
+        saved_exception = std::current_exception();
+        exception_type = e.get_type();
+    }
+
+    // We can't call the default_filter_val earlier because it could block,
+    //  which would crash since we were in an exception handler
+    return filter_default(env, saved_exception, exception_type, default_filter_val);
+}
+
+void func_t::filter_call_batch(env_t *env,
+                               const std::vector<datum_t> &args,
+                               counted_t<const func_t> default_filter_val,
+                               std::vector<bool> *results_out) const {
+    const size_t start = results_out->size();
+    results_out->reserve(start + args.size());
+    while (results_out->size() - start < args.size()) {
+        const size_t done = results_out->size() - start;
+        std::exception_ptr saved_exception;
+        base_exc_t::type_t exception_type;
+
+        try {
+            if (done == 0) {
+                filter_helper_batch(env, args, results_out);
+            } else {
+                std::vector<datum_t> rest(args.begin() + done, args.end());
+                filter_helper_batch(env, rest, results_out);
+            }
+            guarantee(results_out->size() - start == args.size());
+            break;
+        } catch (const base_exc_t &e) {
+            saved_exception = std::current_exception();
+            exception_type = e.get_type();
+        }
+
+        // The element after the last result is the one that failed.  As in
+        // `filter_call`, we deal with it outside of the exception handler.
+        results_out->push_back(filter_default(env, saved_exception, exception_type,
+                                              default_filter_val));
+    }
+}
+
 counted_t<const func_t> new_constant_func(datum_t obj,
                                           const protob_t<const Backtrace> &bt_src) {
     protob_t<Term> twrap = r::fun(r::expr(obj)).release_counted();
@@ -24,6 +24,7 @@ class js_runner_t;
 namespace ql {
 
 class func_visitor_t;
+class pathspec_t;
 
 class func_t : public slow_atomic_countable_t<func_t>, public pb_rcheckable_t {
 public:
@@ -49,6 +50,23 @@ public:
                      datum_t arg,
                      counted_t<const func_t> default_filter_val) const;
 
+    // Calls the function on each element of `args` in order, appending the results
+    // to `results_out`.  If a call fails, the exception propagates and
+    // `results_out` holds the results of the calls before it.  The default just
+    // calls `call` in a loop; `js_func_t` evaluates the whole batch in one round
+    // trip to the JavaScript worker.
+    virtual void call_batch(env_t *env,
+                            const std::vector<datum_t> &args,
+                            std::vector<datum_t> *results_out) const;
+
+    // Equivalent to calling `filter_call` on each element of `args`, appending the
+    // results to `results_out`.  Like `call_batch`, if a call fails `results_out`
+    // holds the results of the calls before it.
+    void filter_call_batch(env_t *env,
+                           const std::vector<datum_t> &args,
+                           counted_t<const func_t> default_filter_val,
+                           std::vector<bool> *results_out) const;
+
     // These are simple, they call the vector version of call.
     scoped_ptr_t<val_t> call(env_t *env, eval_flags_t eval_flags = NO_FLAGS) const;
     scoped_ptr_t<val_t> call(env_t *env,
@@ -62,6 +80,16 @@ public:
 protected:
     explicit func_t(const protob_t<const Backtrace> &bt_source);
 
+    // Like `call_batch`, but for `filter_helper`.
+    virtual void filter_helper_batch(env_t *env,
+                                     const std::vector<datum_t> &args,
+                                     std::vector<bool> *results_out) const;
+    // An implementation of `filter_helper_batch` for functions whose filter result
+    // is just the truthiness of `call_batch`.
+    void filter_helper_batch_as_bools(env_t *env,
+                                      const std::vector<datum_t> &args,
+                                      std::vector<bool> *results_out) const;
+
 private:
     virtual bool filter_helper(env_t *env, datum_t arg) const = 0;
 
@@ -81,6 +109,10 @@ public:
         const std::vector<datum_t> &args,
         eval_flags_t eval_flags) const;
 
+    void call_batch(env_t *env,
+                    const std::vector<datum_t> &args,
+                    std::vector<datum_t> *results_out) const;
+
     boost::optional<size_t> arity() const;
 
     bool is_deterministic() const;
@@ -92,6 +124,32 @@ public:
 private:
     template <cluster_version_t> friend class wire_func_serialization_visitor_t;
     bool filter_helper(env_t *env, datum_t arg) const;
+    void filter_helper_batch(env_t *env,
+                             const std::vector<datum_t> &args,
+                             std::vector<bool> *results_out) const;
+
+    // Bodies simple enough for `call_batch` to evaluate directly on the argument,
+    // without a scope or any term evaluation: `x(field)`, `x(field) <op> constant`
+    // and `x.pluck(field, ...)`.
+    enum class fast_path_t { NONE, GET_FIELD, COMPARE, PLUCK };
+    void init_fast_path();
+    // Returns an empty datum if `arg` doesn't fit the fast path (e.g. it's missing
+    // the field), in which case it has to go through `call` so that the errors are
+    // the usual ones.  `constant` and `pluck_pathspec` are `fast_path_constant`
+    // and `fast_path_pluck` converted for `env`.
+    datum_t fast_call(env_t *env,
+                      const datum_t &arg,
+                      const datum_t &constant,
+                      const pathspec_t *pluck_pathspec) const;
+
+    fast_path_t fast_path;
+    // For GET_FIELD and COMPARE, the field of the argument the body looks at.
+    datum_string_t fast_path_field;
+    // For COMPARE, the comparison and its right-hand side.
+    Term::TermType fast_path_cmp;
+    const Datum *fast_path_constant;
+    // For PLUCK, the `pluck` term.
+    const Term *fast_path_pluck;
 
     // Only contains the parts of the scope that `body` uses.
     var_scope_t captured_scope;
@@ -118,6 +176,10 @@ public:
                              const std::vector<datum_t> &args,
                              eval_flags_t eval_flags) const;
 
+    void call_batch(env_t *env,
+                    const std::vector<datum_t> &args,
+                    std::vector<datum_t> *results_out) const;
+
     boost::optional<size_t> arity() const;
 
     bool is_deterministic() const;
@@ -129,6 +191,9 @@ public:
 private:
     template <cluster_version_t> friend class wire_func_serialization_visitor_t;
     bool filter_helper(env_t *env, datum_t arg) const;
+    void filter_helper_batch(env_t *env,
+                             const std::vector<datum_t> &args,
+                             std::vector<bool> *results_out) const;
 
     std::string js_source;
     uint64_t js_timeout_ms;
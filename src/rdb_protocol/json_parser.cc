@@ -0,0 +1,449 @@
+// Copyright 2010-2015 RethinkDB, all rights reserved.
+#include "rdb_protocol/json_parser.hpp"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <iterator>
+#include <set>
+#include <string>
+#include <utility>
+
+#if defined(__x86_64__)
+#include <emmintrin.h>
+#define JSON_INDEXER_SSE2 1
+#if defined(__clang__) || __GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9)
+#include <immintrin.h>
+#define JSON_INDEXER_AVX2 1
+#endif
+#endif
+
+#include "http/json.hpp"
+#include "rdb_protocol/error.hpp"
+#include "rdb_protocol/pseudo_literal.hpp"
+
+namespace ql {
+
+namespace {
+
+const size_t BLOCK_SIZE = 64;
+
+// One bit per byte of a 64-byte block, with the first byte in the lowest bit.
+struct block_masks_t {
+    uint64_t backslash;
+    uint64_t quote;
+    // `{`, `}`, `[`, `]`, `:` and `,`.
+    uint64_t op;
+    // The whitespace `cJSON_Parse()` skips: space, `\t`, `\r` and `\n`.
+    uint64_t whitespace;
+};
+
+void classify_block_scalar(const char *block, block_masks_t *out) {
+    memset(out, 0, sizeof(*out));
+    for (size_t i = 0; i < BLOCK_SIZE; ++i) {
+        const uint64_t bit = static_cast<uint64_t>(1) << i;
+        switch (block[i]) {
+        case '\\': out->backslash |= bit; break;
+        case '"': out->quote |= bit; break;
+        case '{': case '}': case '[': case ']': case ':': case ',':
+            out->op |= bit; break;
+        case ' ': case '\t': case '\r': case '\n':
+            out->whitespace |= bit; break;
+        default: break;
+        }
+    }
+}
+
+#ifdef JSON_INDEXER_SSE2
+void classify_block_sse2(const char *block, block_masks_t *out) {
+    memset(out, 0, sizeof(*out));
+    for (size_t i = 0; i < BLOCK_SIZE; i += 16) {
+        const __m128i chunk
+            = _mm_loadu_si128(reinterpret_cast<const __m128i *>(block + i));
+#define EQ(c) _mm_cmpeq_epi8(chunk, _mm_set1_epi8(c))
+        const __m128i op = _mm_or_si128(
+            _mm_or_si128(_mm_or_si128(EQ('{'), EQ('}')), _mm_or_si128(EQ('['), EQ(']'))),
+            _mm_or_si128(EQ(':'), EQ(',')));
+        const __m128i whitespace = _mm_or_si128(_mm_or_si128(EQ(' '), EQ('\t')),
+                                                _mm_or_si128(EQ('\r'), EQ('\n')));
+        out->backslash |= static_cast<uint64_t>(_mm_movemask_epi8(EQ('\\'))) << i;
+        out->quote |= static_cast<uint64_t>(_mm_movemask_epi8(EQ('"'))) << i;
+#undef EQ
+        out->op |= static_cast<uint64_t>(_mm_movemask_epi8(op)) << i;
+        out->whitespace |= static_cast<uint64_t>(_mm_movemask_epi8(whitespace)) << i;
+    }
+}
+#endif  // JSON_INDEXER_SSE2
+
+#ifdef JSON_INDEXER_AVX2
+// The rest of the server isn't compiled for AVX2, so only this function is, and we
+// only call it after checking that the CPU supports it.
+__attribute__((target("avx2")))
+void classify_block_avx2(const char *block, block_masks_t *out) {
+    memset(out, 0, sizeof(*out));
+    for (size_t i = 0; i < BLOCK_SIZE; i += 32) {
+        const __m256i chunk
+            = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(block + i));
+#define EQ(c) _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8(c))
+#define MASK(v) static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8(v)))
+        const __m256i op = _mm256_or_si256(
+            _mm256_or_si256(_mm256_or_si256(EQ('{'), EQ('}')),
+                            _mm256_or_si256(EQ('['), EQ(']'))),
+            _mm256_or_si256(EQ(':'), EQ(',')));
+        const __m256i whitespace = _mm256_or_si256(
+            _mm256_or_si256(EQ(' '), EQ('\t')), _mm256_or_si256(EQ('\r'), EQ('\n')));
+        out->backslash |= MASK(EQ('\\')) << i;
+        out->quote |= MASK(EQ('"')) << i;
+        out->op |= MASK(op) << i;
+        out->whitespace |= MASK(whitespace) << i;
+#undef MASK
+#undef EQ
+    }
+}
+#endif  // JSON_INDEXER_AVX2
+
+// Returns the bits of the characters that are escaped by a backslash.  A backslash
+// escapes the next character unless it is escaped itself, so only the odd-length
+// runs of backslashes escape anything.  `*carry` says whether the first character
+// of the block is escaped by a run at the end of the previous block.
+uint64_t find_escaped(uint64_t backslash, uint64_t *carry) {
+    const uint64_t even_bits = UINT64_C(0x5555555555555555);
+    backslash &= ~*carry;
+    const uint64_t follows_escape = (backslash << 1) | *carry;
+    // Adding the starts of the runs that begin on odd bits to the runs carries each
+    // of them past its end; the bit it lands on then says whether the run was odd.
+    const uint64_t odd_starts = backslash & ~even_bits & ~follows_escape;
+    const uint64_t sequences_starting_on_even_bits = odd_starts + backslash;
+    *carry = sequences_starting_on_even_bits < odd_starts ? 1 : 0;
+    const uint64_t invert_mask = sequences_starting_on_even_bits << 1;
+    return (even_bits ^ invert_mask) & follows_escape;
+}
+
+// Bit `i` of the result is the XOR of bits 0 to `i` of `x`.
+uint64_t prefix_xor(uint64_t x) {
+    x ^= x << 1;
+    x ^= x << 2;
+    x ^= x << 4;
+    x ^= x << 8;
+    x ^= x << 16;
+    x ^= x << 32;
+    return x;
+}
+
+template <void (*classify)(const char *, block_masks_t *)>
+bool index_blocks(const char *json, size_t size, std::vector<size_t> *out) {
+    uint64_t escape_carry = 0;
+    // All ones if the previous block ended inside a string.
+    uint64_t in_string_carry = 0;
+    // 1 if the previous block ended with a character of a number or literal.
+    uint64_t scalar_carry = 0;
+
+    for (size_t offset = 0; offset < size; offset += BLOCK_SIZE) {
+        const char *block = json + offset;
+        char tail[BLOCK_SIZE];
+        if (size - offset < BLOCK_SIZE) {
+            // Pad the last block with whitespace, so it doesn't add anything.
+            memset(tail, ' ', BLOCK_SIZE);
+            memcpy(tail, block, size - offset);
+            block = tail;
+        }
+
+        block_masks_t masks;
+        classify(block, &masks);
+
+        const uint64_t escaped = find_escaped(masks.backslash, &escape_carry);
+        const uint64_t quote = masks.quote & ~escaped;
+        // Everything from an opening quote up to, but not including, the closing
+        // quote.
+        const uint64_t in_string = prefix_xor(quote) ^ in_string_carry;
+        in_string_carry = static_cast<uint64_t>(static_cast<int64_t>(in_string) >> 63);
+        // The insides of strings plus their closing quotes.
+        const uint64_t string_tail = in_string ^ quote;
+
+        // Numbers, literals and opening quotes, and everything else that isn't
+        // allowed outside of strings.
+        const uint64_t scalar = ~(masks.op | masks.whitespace);
+        const uint64_t nonquote_scalar = scalar & ~quote;
+        const uint64_t follows_scalar = (nonquote_scalar << 1) | scalar_carry;
+        scalar_carry = nonquote_scalar >> 63;
+
+        uint64_t structurals
+            = (masks.op | (scalar & ~follows_scalar)) & ~string_tail;
+        while (structurals != 0) {
+            out->push_back(offset + __builtin_ctzll(structurals));
+            structurals &= structurals - 1;
+        }
+    }
+
+    return in_string_carry == 0;
+}
+
+typedef bool (*indexer_fn_t)(const char *, size_t, std::vector<size_t> *);
+
+indexer_fn_t choose_indexer() {
+#ifdef JSON_INDEXER_AVX2
+    if (json_indexer_is_supported(json_indexer_t::avx2)) {
+        return &index_blocks<classify_block_avx2>;
+    }
+#endif
+#ifdef JSON_INDEXER_SSE2
+    return &index_blocks<classify_block_sse2>;
+#else
+    return &index_blocks<classify_block_scalar>;
+#endif
+}
+
+const indexer_fn_t best_indexer = choose_indexer();
+
+const char *skip_whitespace(const char *p) {
+    while (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n') ++p;
+    return p;
+}
+
+/* Stage 2.  `json_datum_builder_t` walks the structural offsets with an explicit
+stack instead of recursing, so deeply nested documents can't overflow a coroutine
+stack.  The elements of all open arrays and objects live on `values` (and the keys
+of open objects on `keys`) until the container is closed, so parsing a document only
+allocates for the datums themselves once the scratch buffers have grown. */
+class json_datum_builder_t {
+public:
+    json_datum_builder_t(const char *_json, size_t _size,
+                         const configured_limits_t &_limits,
+                         reql_version_t _reql_version)
+        : json(_json), size(_size), limits(_limits), reql_version(_reql_version),
+          pts({ pseudo::literal_string }) { }
+
+    bool parse(datum_t *out) {
+        if (!best_indexer(json, size, &structurals) || structurals.empty()) {
+            return false;
+        }
+
+        enum class state_t { value, key, after_value };
+        state_t state = state_t::value;
+        next = 0;
+        for (;;) {
+            if (state == state_t::after_value && frames.empty()) {
+                // The whole document must be a single value.
+                if (next != structurals.size()) {
+                    return false;
+                }
+                guarantee(values.size() == 1);
+                *out = std::move(values.back());
+                return true;
+            }
+            if (next == structurals.size()) {
+                return false;
+            }
+            const char *p = json + structurals[next++];
+
+            switch (state) {
+            case state_t::value: {
+                if (*p == '[' || *p == '{') {
+                    frames.push_back(frame_t(*p == '{', values.size(), keys.size()));
+                    const char close = *p == '{' ? '}' : ']';
+                    if (next < structurals.size() && json[structurals[next]] == close) {
+                        ++next;
+                        close_container();
+                        state = state_t::after_value;
+                    } else {
+                        state = *p == '{' ? state_t::key : state_t::value;
+                    }
+                } else {
+                    if (!parse_scalar(p)) {
+                        return false;
+                    }
+                    state = state_t::after_value;
+                }
+            } break;
+            case state_t::key: {
+                scratch.clear();
+                const char *end = p;
+                if (!json_parse_string(&end, &scratch) || !ends_at_next(end)) {
+                    return false;
+                }
+                fail_if_invalid(reql_version, scratch.data(), scratch.size());
+                keys.push_back(datum_string_t(scratch.size(), scratch.data()));
+                if (next == structurals.size() || json[structurals[next]] != ':') {
+                    return false;
+                }
+                ++next;
+                state = state_t::value;
+            } break;
+            case state_t::after_value: {
+                const bool is_object = frames.back().is_object;
+                if (*p == ',') {
+                    state = is_object ? state_t::key : state_t::value;
+                } else if (*p == (is_object ? '}' : ']')) {
+                    close_container();
+                } else {
+                    return false;
+                }
+            } break;
+            default: unreachable();
+            }
+        }
+    }
+
+private:
+    struct frame_t {
+        frame_t(bool _is_object, size_t _values_begin, size_t _keys_begin)
+            : is_object(_is_object), values_begin(_values_begin),
+              keys_begin(_keys_begin) { }
+        bool is_object;
+        size_t values_begin;
+        size_t keys_begin;
+    };
+
+    // Returns true if nothing but whitespace separates `end` from the next
+    // structural character (or the end of the input, if there is none).
+    bool ends_at_next(const char *end) const {
+        const char *expected = next == structurals.size()
+            ? json + size
+            : json + structurals[next];
+        return skip_whitespace(end) == expected;
+    }
+
+    bool parse_scalar(const char *p) {
+        const char *end;
+        if (strncmp(p, "null", 4) == 0) {
+            values.push_back(datum_t::null());
+            end = p + 4;
+        } else if (strncmp(p, "false", 5) == 0) {
+            values.push_back(datum_t::boolean(false));
+            end = p + 5;
+        } else if (strncmp(p, "true", 4) == 0) {
+            values.push_back(datum_t::boolean(true));
+            end = p + 4;
+        } else if (*p == '"') {
+            scratch.clear();
+            end = p;
+            if (!json_parse_string(&end, &scratch)) {
+                return false;
+            }
+            fail_if_invalid(reql_version, scratch.data(), scratch.size());
+            values.push_back(datum_t(datum_string_t(scratch.size(), scratch.data())));
+        } else if (*p == '-' || (*p >= '0' && *p <= '9')) {
+            // cJSON reads `0x...` as a 0 followed by garbage, which is never valid.
+            if (p[0] == '0' && (p[1] == 'x' || p[1] == 'X')) {
+                return false;
+            }
+            char *num_end;
+            const double d = strtod(p, &num_end);
+            if (num_end == p) {
+                return false;
+            }
+            values.push_back(datum_t(d));
+            end = num_end;
+        } else {
+            return false;
+        }
+        return ends_at_next(end);
+    }
+
+    void close_container() {
+        const frame_t frame = frames.back();
+        frames.pop_back();
+        const auto values_begin = values.begin() + frame.values_begin;
+
+        if (!frame.is_object) {
+            std::vector<datum_t> array(std::make_move_iterator(values_begin),
+                                       std::make_move_iterator(values.end()));
+            values.erase(values_begin, values.end());
+            values.push_back(datum_t(std::move(array), limits));
+            return;
+        }
+
+        const size_t count = values.size() - frame.values_begin;
+        guarantee(keys.size() - frame.keys_begin == count);
+        std::vector<std::pair<datum_string_t, datum_t> > pairs;
+        pairs.reserve(count);
+        for (size_t i = 0; i < count; ++i) {
+            pairs.push_back(std::make_pair(std::move(keys[frame.keys_begin + i]),
+                                           std::move(values[frame.values_begin + i])));
+        }
+        keys.erase(keys.begin() + frame.keys_begin, keys.end());
+        values.erase(values_begin, values.end());
+
+        std::sort(pairs.begin(), pairs.end(),
+                  [](const std::pair<datum_string_t, datum_t> &a,
+                     const std::pair<datum_string_t, datum_t> &b) {
+                      return a.first < b.first;
+                  });
+        for (size_t i = 1; i < pairs.size(); ++i) {
+            rcheck_datum(!(pairs[i - 1].first == pairs[i].first), base_exc_t::GENERIC,
+                         strprintf("Duplicate key `%s` in JSON.",
+                                   pairs[i].first.to_std().c_str()));
+        }
+        values.push_back(datum_t(std::move(pairs), pts));
+    }
+
+    const char *const json;
+    const size_t size;
+    const configured_limits_t &limits;
+    const reql_version_t reql_version;
+    const std::set<std::string> pts;
+
+    std::vector<size_t> structurals;
+    size_t next;
+
+    std::vector<frame_t> frames;
+    std::vector<datum_t> values;
+    std::vector<datum_string_t> keys;
+    std::string scratch;
+};
+
+}  // namespace
+
+bool parse_json(const char *json,
+                const configured_limits_t &limits,
+                reql_version_t reql_version,
+                datum_t *out) {
+    json_datum_builder_t builder(json, strlen(json), limits, reql_version);
+    return builder.parse(out);
+}
+
+bool json_indexer_is_supported(json_indexer_t indexer) {
+    switch (indexer) {
+    case json_indexer_t::scalar:
+        return true;
+    case json_indexer_t::sse2:
+#ifdef JSON_INDEXER_SSE2
+        return true;
+#else
+        return false;
+#endif
+    case json_indexer_t::avx2:
+#ifdef JSON_INDEXER_AVX2
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2");
+#else
+        return false;
+#endif
+    default:
+        unreachable();
+    }
+}
+
+bool find_json_structurals(json_indexer_t indexer,
+                           const char *json, size_t size,
+                           std::vector<size_t> *out) {
+    guarantee(json_indexer_is_supported(indexer));
+    switch (indexer) {
+    case json_indexer_t::scalar:
+        return index_blocks<classify_block_scalar>(json, size, out);
+#ifdef JSON_INDEXER_SSE2
+    case json_indexer_t::sse2:
+        return index_blocks<classify_block_sse2>(json, size, out);
+#endif
+#ifdef JSON_INDEXER_AVX2
+    case json_indexer_t::avx2:
+        return index_blocks<classify_block_avx2>(json, size, out);
+#endif
+    default:
+        unreachable();
+    }
+}
+
+}  // namespace ql
@@ -0,0 +1,53 @@
+// Copyright 2010-2015 RethinkDB, all rights reserved.
+#ifndef RDB_PROTOCOL_JSON_PARSER_HPP_
+#define RDB_PROTOCOL_JSON_PARSER_HPP_
+
+#include <stddef.h>
+
+#include <vector>
+
+#include "rdb_protocol/datum.hpp"
+
+namespace ql {
+
+/* `parse_json` turns JSON text into a datum in one pass, without building a cJSON
+tree first.  It works in two stages:
+
+ 1. The structural indexer classifies the input 64 bytes at a time with SIMD
+    compares and uses the resulting bit masks to find the offset of every
+    structural character (`{}[]:,`) and of every value that isn't a container,
+    skipping over the insides of strings.
+ 2. The datum builder walks those offsets, decodes the values and builds the
+    datums bottom-up, reusing the same scratch buffers for the whole document.
+
+It accepts the same JSON that `cJSON_Parse()` does and produces the same datum that
+`to_datum(cJSON *, ...)` would, except that it rejects unterminated strings and
+unpaired UTF-16 surrogates. */
+
+// Parses the NUL-terminated `json` into `*out`.  Returns false if it isn't valid
+// JSON.  Throws if it is valid JSON but not a valid datum, e.g. because an object
+// has duplicate keys or a string isn't valid UTF-8.
+MUST_USE bool parse_json(const char *json,
+                         const configured_limits_t &limits,
+                         reql_version_t reql_version,
+                         datum_t *out);
+
+// The implementations of stage 1.  `parse_json` picks the fastest one the CPU
+// supports; they are exposed so the unit tests can check that they agree.
+enum class json_indexer_t {
+    scalar,
+    sse2,
+    avx2
+};
+
+bool json_indexer_is_supported(json_indexer_t indexer);
+
+// Appends the offsets of the structural characters and value starts in the first
+// `size` bytes of `json` to `out`.  Returns false if `json` ends inside a string.
+MUST_USE bool find_json_structurals(json_indexer_t indexer,
+                                    const char *json, size_t size,
+                                    std::vector<size_t> *out);
+
+}  // namespace ql
+
+#endif  // RDB_PROTOCOL_JSON_PARSER_HPP_
@@ -0,0 +1,82 @@
+// Copyright 2010-2015 RethinkDB, all rights reserved.
+#include "rdb_protocol/order_by.hpp"
+
+#include <algorithm>
+
+#include "rdb_protocol/env.hpp"
+#include "rdb_protocol/error.hpp"
+#include "rdb_protocol/func.hpp"
+#include "rdb_protocol/profile.hpp"
+#include "rdb_protocol/val.hpp"
+
+namespace ql {
+
+order_by_keys_t::order_by_keys_t(
+        std::vector<std::pair<sorting_t, counted_t<const func_t> > > &&_comparisons)
+    : comparisons(std::move(_comparisons)) { }
+
+keyed_row_t order_by_keys_t::make_keyed_row(env_t *env, datum_t row) const {
+    keyed_row_t ret;
+    ret.keys.reserve(comparisons.size());
+    for (auto it = comparisons.begin(); it != comparisons.end(); ++it) {
+        datum_t key;
+        try {
+            key = it->second->call(env, row)->as_datum();
+        } catch (const base_exc_t &e) {
+            if (e.get_type() != base_exc_t::NON_EXISTENCE) {
+                throw;
+            }
+        }
+        ret.keys.push_back(std::move(key));
+    }
+    ret.row = std::move(row);
+    return ret;
+}
+
+bool order_by_keys_t::lt(reql_version_t reql_version,
+                         const keyed_row_t &l, const keyed_row_t &r) const {
+    for (size_t i = 0; i < comparisons.size(); ++i) {
+        const bool descending = comparisons[i].first == sorting_t::DESCENDING;
+        const datum_t &lval = l.keys[i];
+        const datum_t &rval = r.keys[i];
+        if (!lval.has() && !rval.has()) {
+            continue;
+        }
+        if (!lval.has()) {
+            return !descending;
+        }
+        if (!rval.has()) {
+            return descending;
+        }
+        int cmp_res = lval.cmp(reql_version, rval);
+        if (cmp_res == 0) {
+            continue;
+        }
+        return (cmp_res < 0) != descending;
+    }
+    return false;
+}
+
+void order_by_keys_t::sort(reql_version_t reql_version,
+                           std::vector<keyed_row_t> *rows) const {
+    std::stable_sort(rows->begin(), rows->end(),
+                     [&](const keyed_row_t &l, const keyed_row_t &r) {
+                         return lt(reql_version, l, r);
+                     });
+}
+
+void order_by_keys_t::sort_rows(env_t *env, profile::sampler_t *sampler,
+                                std::vector<datum_t> *rows) const {
+    std::vector<keyed_row_t> keyed_rows;
+    keyed_rows.reserve(rows->size());
+    for (auto it = rows->begin(); it != rows->end(); ++it) {
+        keyed_rows.push_back(make_keyed_row(env, std::move(*it)));
+        sampler->new_sample();
+    }
+    sort(env->reql_version(), &keyed_rows);
+    for (size_t i = 0; i < keyed_rows.size(); ++i) {
+        (*rows)[i] = std::move(keyed_rows[i].row);
+    }
+}
+
+}  // namespace ql
@@ -0,0 +1,57 @@
+// Copyright 2010-2015 RethinkDB, all rights reserved.
+#ifndef RDB_PROTOCOL_ORDER_BY_HPP_
+#define RDB_PROTOCOL_ORDER_BY_HPP_
+
+#include <utility>
+#include <vector>
+
+#include "btree/keys.hpp"
+#include "containers/counted.hpp"
+#include "rdb_protocol/datum.hpp"
+
+namespace profile {
+class sampler_t;
+}  // namespace profile
+
+namespace ql {
+
+class env_t;
+class func_t;
+
+// A row together with the keys `order_by` sorts it by.  A key is empty if the
+// function that computes it threw a non-existence error.
+struct keyed_row_t {
+    std::vector<datum_t> keys;
+    datum_t row;
+};
+
+/* `order_by_keys_t` evaluates the key functions of an `order_by` once per row, so
+sorting doesn't have to call them again on every comparison. */
+class order_by_keys_t {
+public:
+    explicit order_by_keys_t(
+        std::vector<std::pair<sorting_t, counted_t<const func_t> > > &&_comparisons);
+
+    bool empty() const { return comparisons.empty(); }
+
+    keyed_row_t make_keyed_row(env_t *env, datum_t row) const;
+
+    // Empty keys sort before everything else, or after everything else for
+    // descending keys.
+    bool lt(reql_version_t reql_version,
+            const keyed_row_t &l, const keyed_row_t &r) const;
+
+    // Sorts `rows` by their keys, keeping rows with equal keys in order.
+    void sort(reql_version_t reql_version, std::vector<keyed_row_t> *rows) const;
+
+    // Evaluates the keys of `rows` and sorts them the same way.
+    void sort_rows(env_t *env, profile::sampler_t *sampler,
+                   std::vector<datum_t> *rows) const;
+
+private:
+    std::vector<std::pair<sorting_t, counted_t<const func_t> > > comparisons;
+};
+
+}  // namespace ql
+
+#endif  // RDB_PROTOCOL_ORDER_BY_HPP_
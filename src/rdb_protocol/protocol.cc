@@ -138,7 +138,7 @@ void post_construct_and_drain_queue(
     THROWS_NOTHING
 {
     std::set<uuid_u> sindexes_to_bring_up_to_date;
-    parallel_traversal_progress_t progress_tracker;
+    traversal_progress_combiner_t progress_tracker;
     std::vector<map_insertion_sentry_t<
         store_t::sindex_context_map_t::key_type,
         store_t::sindex_context_map_t::mapped_type> > sindex_context_sentries;
@@ -922,6 +922,25 @@ bool read_t::route_to_primary() const THROWS_NOTHING {
     return boost::apply_visitor(route_to_primary_visitor_t(), read);
 }
 
+struct response_traffic_class_visitor_t
+    : public boost::static_visitor<cluster_traffic_class_t> {
+    cluster_traffic_class_t operator()(const rget_read_t &) const {
+        return cluster_traffic_class_t::bulk;
+    }
+    cluster_traffic_class_t operator()(const intersecting_geo_read_t &) const {
+        return cluster_traffic_class_t::bulk;
+    }
+    template <class T>
+    cluster_traffic_class_t operator()(const T &) const {
+        return cluster_traffic_class_t::replication;
+    }
+};
+
+// Only range reads, whose responses can be arbitrarily large, use `bulk`.
+cluster_traffic_class_t read_t::response_traffic_class() const THROWS_NOTHING {
+    return boost::apply_visitor(response_traffic_class_visitor_t(), read);
+}
+
 
 
 /* write_t::get_region() implementation */
@@ -1284,7 +1303,8 @@ RDB_IMPL_SERIALIZABLE_3_FOR_CLUSTER(
 RDB_IMPL_SERIALIZABLE_0_FOR_CLUSTER(sindex_list_t);
 RDB_IMPL_SERIALIZABLE_2_FOR_CLUSTER(sindex_status_t, sindexes, region);
 
-RDB_IMPL_SERIALIZABLE_2_FOR_CLUSTER(changefeed_subscribe_t, addr, region);
+RDB_IMPL_SERIALIZABLE_4_FOR_CLUSTER(
+    changefeed_subscribe_t, addr, region, transforms, optargs);
 RDB_IMPL_SERIALIZABLE_5_FOR_CLUSTER(
     changefeed_limit_subscribe_t, addr, uuid, spec, table, region);
 RDB_IMPL_SERIALIZABLE_2_FOR_CLUSTER(changefeed_stamp_t, addr, region);
@@ -1329,4 +1349,5 @@ RDB_IMPL_SERIALIZABLE_2_FOR_CLUSTER(backfill_chunk_t::delete_key_t, key, recency
 RDB_IMPL_SERIALIZABLE_1_FOR_CLUSTER(backfill_chunk_t::delete_range_t, range);
 RDB_IMPL_SERIALIZABLE_1_FOR_CLUSTER(backfill_chunk_t::key_value_pairs_t, backfill_atoms);
 RDB_IMPL_SERIALIZABLE_1_FOR_CLUSTER(backfill_chunk_t::sindexes_t, sindexes);
+RDB_IMPL_SERIALIZABLE_1_FOR_CLUSTER(backfill_chunk_t::checkpoint_t, range);
 RDB_IMPL_SERIALIZABLE_1_FOR_CLUSTER(backfill_chunk_t, val);
@@ -477,10 +477,16 @@ RDB_DECLARE_SERIALIZABLE_FOR_CLUSTER(sindex_status_t);
 
 struct changefeed_subscribe_t {
     changefeed_subscribe_t() { }
-    explicit changefeed_subscribe_t(ql::changefeed::client_t::addr_t _addr)
-        : addr(_addr), region(region_t::universe()) { }
+    changefeed_subscribe_t(ql::changefeed::client_t::addr_t _addr,
+                           std::vector<ql::transform_variant_t> _transforms,
+                           std::map<std::string, ql::wire_func_t> _optargs)
+        : addr(_addr), region(region_t::universe()),
+          transforms(std::move(_transforms)), optargs(std::move(_optargs)) { }
     ql::changefeed::client_t::addr_t addr;
     region_t region;
+    // Applied by the shards to every change before it's sent to `addr`.
+    std::vector<ql::transform_variant_t> transforms;
+    std::map<std::string, ql::wire_func_t> optargs;
 };
 RDB_DECLARE_SERIALIZABLE_FOR_CLUSTER(changefeed_subscribe_t);
 
@@ -567,6 +573,10 @@ struct read_t {
 
     // Returns true if this read should be sent to every replica.
     bool all_read() const THROWS_NOTHING { return boost::get<sindex_status_t>(&read); }
+
+    // The traffic class to send the response to this read over.  Range reads can
+    // have large responses, which shouldn't hold up the ones to point reads.
+    cluster_traffic_class_t response_traffic_class() const THROWS_NOTHING;
 };
 RDB_DECLARE_SERIALIZABLE_FOR_CLUSTER(read_t);
 
@@ -867,7 +877,18 @@ struct backfill_chunk_t {
             : sindexes(_sindexes) { }
     };
 
-    typedef boost::variant<delete_range_t, delete_key_t, key_value_pairs_t, sindexes_t> value_t;
+    /* Tells the backfillee that `range` is complete: once the chunks that came
+    before this one are applied, every key in it is at the backfill's end point.
+    Only ordered backfills send these; the backfillee persists them so that an
+    interrupted backfill can resume after `range`. */
+    struct checkpoint_t {
+        region_t range;
+        checkpoint_t() { }
+        explicit checkpoint_t(const region_t& _range) : range(_range) { }
+    };
+
+    typedef boost::variant<delete_range_t, delete_key_t, key_value_pairs_t, sindexes_t,
+                           checkpoint_t> value_t;
 
     backfill_chunk_t() { }
     explicit backfill_chunk_t(const value_t &_val) : val(_val) { }
@@ -886,12 +907,17 @@ struct backfill_chunk_t {
     static backfill_chunk_t sindexes(const std::map<std::string, secondary_index_t> &sindexes) {
         return backfill_chunk_t(sindexes_t(sindexes));
     }
+
+    static backfill_chunk_t checkpoint(const region_t& range) {
+        return backfill_chunk_t(checkpoint_t(range));
+    }
 };
 
 RDB_DECLARE_SERIALIZABLE_FOR_CLUSTER(backfill_chunk_t::delete_key_t);
 RDB_DECLARE_SERIALIZABLE_FOR_CLUSTER(backfill_chunk_t::delete_range_t);
 RDB_DECLARE_SERIALIZABLE_FOR_CLUSTER(backfill_chunk_t::key_value_pairs_t);
 RDB_DECLARE_SERIALIZABLE_FOR_CLUSTER(backfill_chunk_t::sindexes_t);
+RDB_DECLARE_SERIALIZABLE_FOR_CLUSTER(backfill_chunk_t::checkpoint_t);
 RDB_DECLARE_SERIALIZABLE_FOR_CLUSTER(backfill_chunk_t);
 
 
@@ -1,6 +1,8 @@
 // Copyright 2010-2014 RethinkDB, all rights reserved.
 #include "rdb_protocol/pseudo_binary.hpp"
 
+#include <string.h>
+
 #include "errors.hpp"
 
 #include "utils.hpp"
@@ -148,6 +150,20 @@ scoped_cJSON_t encode_base64_ptype(const datum_string_t &data) {
     return res;
 }
 
+void write_base64_ptype_json(const datum_string_t &data, std::string *out) {
+    out->push_back('{');
+    json_append_string(datum_t::reql_type_string.data(),
+                       datum_t::reql_type_string.size(), out);
+    out->push_back(':');
+    json_append_string(binary_string, strlen(binary_string), out);
+    out->push_back(',');
+    json_append_string(data_key, strlen(data_key), out);
+    out->push_back(':');
+    const std::string encoded_data = encode_base64(data);
+    json_append_string(encoded_data.data(), encoded_data.size(), out);
+    out->push_back('}');
+}
+
 // Given a `r.binary` pseudotype with base64 encoding, decodes it into a raw data string
 datum_string_t decode_base64_ptype(
         const std::vector<std::pair<datum_string_t, datum_t> > &ptype) {
@@ -93,15 +93,20 @@ query_cache_t::const_iterator query_cache_t::end() const {
     return queries.end();
 }
 
+void query_cache_t::check_token_unused(int64_t token) const {
+    if (queries.find(token) != queries.end() ||
+        prepared_queries.find(token) != prepared_queries.end()) {
+        throw query_cache_exc_t(Response::CLIENT_ERROR,
+            strprintf("ERROR: duplicate token %" PRIi64, token), backtrace_t());
+    }
+}
+
 scoped_ptr_t<query_cache_t::ref_t> query_cache_t::create(
         int64_t token,
         protob_t<Query> original_query,
         use_json_t use_json,
         signal_t *interruptor) {
-    if (queries.find(token) != queries.end()) {
-        throw query_cache_exc_t(Response::CLIENT_ERROR,
-            strprintf("ERROR: duplicate token %" PRIi64, token), backtrace_t());
-    }
+    check_token_unused(token);
 
     counted_t<const term_t> root_term;
     std::map<std::string, wire_func_t> global_optargs;
@@ -121,6 +126,119 @@ scoped_ptr_t<query_cache_t::ref_t> query_cache_t::create(
     scoped_ptr_t<entry_t> entry(new entry_t(original_query,
                                             std::move(global_optargs),
                                             std::move(root_term)));
+    return add_entry(token, std::move(entry), use_json, interruptor);
+}
+
+// Returns true if `t` uses `r.now()`, which is replaced by the current time when
+// the query is preprocessed.
+bool contains_now_term(const Term &t) {
+    if (t.type() == Term::NOW) {
+        return true;
+    }
+    for (int i = 0; i < t.args_size(); ++i) {
+        if (contains_now_term(t.args(i))) {
+            return true;
+        }
+    }
+    for (int i = 0; i < t.optargs_size(); ++i) {
+        if (contains_now_term(t.optargs(i).val())) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void query_cache_t::prepare(int64_t token, protob_t<Query> original_query) {
+    check_token_unused(token);
+    if (prepared_queries.size() >= MAX_PREPARED_QUERIES) {
+        throw query_cache_exc_t(Response::CLIENT_ERROR,
+            strprintf("Too many prepared queries on this connection (the limit is "
+                      "%zu).  STOP one of them before preparing another.",
+                      MAX_PREPARED_QUERIES),
+            backtrace_t());
+    }
+
+    prepared_query_t prepared;
+    prepared.original_query = original_query;
+    try {
+        // Each EXECUTE would see the time of the PREPARE, so we refuse instead.
+        bool uses_now = contains_now_term(original_query->query());
+        for (int i = 0; i < original_query->global_optargs_size(); ++i) {
+            uses_now |= contains_now_term(original_query->global_optargs(i).val());
+        }
+        if (uses_now) {
+            rfail_toplevel(base_exc_t::GENERIC,
+                           "A prepared query cannot use `r.now()`.  Pass the time "
+                           "as an argument to EXECUTE instead.");
+        }
+
+        // Parsing the global optargs also pre-processes the query
+        prepared.global_optargs = parse_global_optargs(original_query);
+
+        Term *t = original_query->mutable_query();
+        if (t->type() != Term::FUNC) {
+            rfail_toplevel(base_exc_t::GENERIC,
+                           "A prepared query must be a function.");
+        }
+        compile_env_t compile_env((var_visibility_t()));
+        counted_t<func_term_t> func_term
+            = make_counted<func_term_t>(&compile_env, original_query.make_child(t));
+        prepared.func = func_term->eval_to_func(var_scope_t());
+    } catch (const exc_t &e) {
+        throw query_cache_exc_t(Response::COMPILE_ERROR, e.what(), e.backtrace());
+    } catch (const datum_exc_t &e) {
+        throw query_cache_exc_t(Response::COMPILE_ERROR, e.what(), backtrace_t());
+    }
+
+    auto insert_res = prepared_queries.insert(std::make_pair(token, prepared));
+    guarantee(insert_res.second);
+}
+
+scoped_ptr_t<query_cache_t::ref_t> query_cache_t::execute(
+        int64_t token,
+        protob_t<Query> execute_query,
+        use_json_t use_json,
+        signal_t *interruptor) {
+    check_token_unused(token);
+
+    auto it = prepared_queries.find(execute_query->prepared_token());
+    if (it == prepared_queries.end()) {
+        throw query_cache_exc_t(Response::CLIENT_ERROR,
+            strprintf("Token %" PRIi64 " is not a prepared query.",
+                      execute_query->prepared_token()),
+            backtrace_t());
+    }
+
+    // The function was compiled with the PREPARE query's global optargs.  Only
+    // `noreply`, which `run` reads straight from the query, may differ.
+    for (int i = 0; i < execute_query->global_optargs_size(); ++i) {
+        const std::string &key = execute_query->global_optargs(i).key();
+        if (key != "noreply") {
+            throw query_cache_exc_t(Response::COMPILE_ERROR,
+                strprintf("Global optarg `%s` must be passed to PREPARE, not EXECUTE.",
+                          key.c_str()),
+                backtrace_t());
+        }
+    }
+
+    std::map<std::string, wire_func_t> global_optargs = it->second.global_optargs;
+    scoped_ptr_t<entry_t> entry(new entry_t(it->second.original_query,
+                                            std::move(global_optargs),
+                                            counted_t<const term_t>()));
+    entry->prepared_func = it->second.func;
+    entry->execute_query = execute_query;
+    return add_entry(token, std::move(entry), use_json, interruptor);
+}
+
+bool query_cache_t::unprepare(int64_t token) {
+    return prepared_queries.erase(token) == 1;
+}
+
+scoped_ptr_t<query_cache_t::ref_t> query_cache_t::add_entry(
+        int64_t token,
+        scoped_ptr_t<entry_t> &&entry,
+        use_json_t use_json,
+        signal_t *interruptor) {
     scoped_ptr_t<ref_t> ref(new ref_t(this,
                                       token,
                                       entry.get(),
@@ -234,6 +352,7 @@ void query_cache_t::ref_t::fill_response(Response *res) {
         if (entry->state == entry_t::state_t::START) {
             run(&env, res);
             entry->root_term.reset();
+            entry->prepared_func.reset();
         }
 
         if (entry->state == entry_t::state_t::STREAM) {
@@ -268,7 +387,19 @@ void query_cache_t::ref_t::run(env_t *env, Response *res) {
 
     scope_env_t scope_env(env, var_scope_t());
 
-    scoped_ptr_t<val_t> val = entry->root_term->eval(&scope_env);
+    scoped_ptr_t<val_t> val;
+    if (entry->prepared_func.has()) {
+        std::vector<datum_t> args;
+        args.reserve(entry->execute_query->prepared_args_size());
+        for (int i = 0; i < entry->execute_query->prepared_args_size(); ++i) {
+            args.push_back(to_datum(&entry->execute_query->prepared_args(i),
+                                    env->limits(),
+                                    env->reql_version()));
+        }
+        val = entry->prepared_func->call(env, args);
+    } else {
+        val = entry->root_term->eval(&scope_env);
+    }
     if (val->get_type().is_convertible(val_t::type_t::DATUM)) {
         res->set_type(Response::SUCCESS_ATOM);
         val->as_datum().write_to_protobuf(res->add_response(), use_json);
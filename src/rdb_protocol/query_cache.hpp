@@ -21,6 +21,7 @@
 #include "containers/object_buffer.hpp"
 #include "rdb_protocol/term.hpp"
 #include "rdb_protocol/datum_stream.hpp"
+#include "rdb_protocol/func.hpp"
 #include "rdb_protocol/ql2.pb.h"
 
 namespace ql {
@@ -60,6 +61,10 @@ private:
     DISABLE_COPYING(query_id_t);
 };
 
+// The most prepared functions a connection can keep at once.  Each one holds on to
+// its compiled terms until the client STOPs it, so they need a bound.
+const size_t MAX_PREPARED_QUERIES = 1024;
+
 class query_cache_t : public home_thread_mixin_t {
     struct entry_t;
 public:
@@ -118,6 +123,23 @@ public:
                             use_json_t use_json,
                             signal_t *interruptor);
 
+    // Compiles the function in a PREPARE query and keeps it under `token`, so that
+    // EXECUTE queries can run it without parsing and compiling it again.  Throws if
+    // the connection already has `MAX_PREPARED_QUERIES` prepared functions, or if
+    // the query uses `r.now()`.
+    void prepare(int64_t token, protob_t<Query> original_query);
+
+    // Like `create`, but for an EXECUTE query, which runs a prepared function.
+    // Throws if the query has global optargs other than `noreply`.
+    scoped_ptr_t<ref_t> execute(int64_t token,
+                                protob_t<Query> execute_query,
+                                use_json_t use_json,
+                                signal_t *interruptor);
+
+    // Forgets the prepared function with the given token.  Returns false if there
+    // is none.
+    bool unprepare(int64_t token);
+
     void noreply_wait(const query_id_t &query_id,
                       int64_t token,
                       signal_t *interruptor);
@@ -142,6 +164,12 @@ private:
         // This will be empty if the root term has already been run
         counted_t<const term_t> root_term;
 
+        // For EXECUTE queries, the prepared function to call instead of running
+        // `root_term`, and the query holding its arguments.  `original_query` is
+        // the PREPARE query.
+        counted_t<const func_t> prepared_func;
+        protob_t<Query> execute_query;
+
         // This will be empty until the root term has been evaluated
         // If this resulted in a stream, this will not be empty until the
         // stream is finished
@@ -156,12 +184,27 @@ private:
         DISABLE_COPYING(entry_t);
     };
 
+    struct prepared_query_t {
+        protob_t<Query> original_query;
+        std::map<std::string, wire_func_t> global_optargs;
+        counted_t<const func_t> func;
+    };
+
+    // Throws if `token` is already used by a query or a prepared function.
+    void check_token_unused(int64_t token) const;
+
+    scoped_ptr_t<ref_t> add_entry(int64_t token,
+                                  scoped_ptr_t<entry_t> &&entry,
+                                  use_json_t use_json,
+                                  signal_t *interruptor);
+
     static void async_destroy_entry(entry_t *entry);
 
     rdb_context_t *const rdb_ctx;
     ip_and_port_t client_addr_port;
     return_empty_normal_batches_t return_empty_normal_batches;
     std::map<int64_t, scoped_ptr_t<entry_t> > queries;
+    std::map<int64_t, prepared_query_t> prepared_queries;
 
     // Used for noreply waiting, this contains all allocated-but-incomplete query ids
     friend class query_id_t;
@@ -41,6 +41,7 @@ void rdb_query_server_t::run_query(ql::query_id_t &&query_id,
                                    signal_t *interruptor) {
     guarantee(query_cache != NULL);
     guarantee(interruptor != NULL);
+    const ticks_t start_time = get_ticks();
     try {
         scoped_perfmon_counter_t client_active(&rdb_ctx->stats.clients_active); // TODO: make this correct for parallelized queries
         guarantee(rdb_ctx->cluster_interface);
@@ -61,4 +62,5 @@ void rdb_query_server_t::run_query(ql::query_id_t &&query_id,
 
     rdb_ctx->stats.queries_per_sec.record();
     ++rdb_ctx->stats.queries_total;
+    rdb_ctx->stats.query_latency.record(get_ticks() - start_time);
 }
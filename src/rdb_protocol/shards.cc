@@ -890,13 +890,32 @@ private:
     virtual void lst_transform(
         env_t *env, datums_t *lst, const datum_t &) {
         try {
-            for (auto it = lst->begin(); it != lst->end(); ++it) {
-                *it = f->call(env, *it)->as_datum();
-            }
+            // `call_batch` lets a JavaScript function evaluate the whole list in
+            // one round trip to the worker process.
+            datums_t results;
+            results.reserve(lst->size());
+            f->call_batch(env, *lst, &results);
+            lst->swap(results);
         } catch (const datum_exc_t &e) {
             throw exc_t(e, f->backtrace().get(), 1);
         }
     }
+    virtual bool is_rowwise() const { return true; }
+    virtual size_t apply_rowwise(env_t *env,
+                                 datums_t *rows,
+                                 std::exception_ptr *exc_out) {
+        datums_t results;
+        results.reserve(rows->size());
+        try {
+            f->call_batch(env, *rows, &results);
+        } catch (const datum_exc_t &e) {
+            *exc_out = std::make_exception_ptr(exc_t(e, f->backtrace().get(), 1));
+        } catch (const exc_t &e) {
+            *exc_out = std::current_exception();
+        }
+        std::move(results.begin(), results.end(), rows->begin());
+        return results.size();
+    }
     counted_t<const func_t> f;
 };
 
@@ -944,8 +963,10 @@ private:
         auto it = lst->begin();
         auto loc = it;
         try {
-            for (it = lst->begin(); it != lst->end(); ++it) {
-                if (f->filter_call(env, *it, default_val)) {
+            std::vector<bool> keep;
+            f->filter_call_batch(env, *lst, default_val, &keep);
+            for (size_t i = 0; it != lst->end(); ++it, ++i) {
+                if (keep[i]) {
                     std::swap(*loc, *it);
                     ++loc;
                 }
@@ -955,6 +976,26 @@ private:
         }
         lst->erase(loc, lst->end());
     }
+    virtual bool is_rowwise() const { return true; }
+    virtual size_t apply_rowwise(env_t *env,
+                                 datums_t *rows,
+                                 std::exception_ptr *exc_out) {
+        std::vector<bool> keep;
+        keep.reserve(rows->size());
+        try {
+            f->filter_call_batch(env, *rows, default_val, &keep);
+        } catch (const datum_exc_t &e) {
+            *exc_out = std::make_exception_ptr(exc_t(e, f->backtrace().get(), 1));
+        } catch (const exc_t &e) {
+            *exc_out = std::current_exception();
+        }
+        for (size_t i = 0; i < keep.size(); ++i) {
+            if (!keep[i]) {
+                (*rows)[i] = datum_t();
+            }
+        }
+        return keep.size();
+    }
     counted_t<const func_t> f, default_val;
 };
 
@@ -3,6 +3,7 @@
 #define RDB_PROTOCOL_SHARDS_HPP_
 
 #include <algorithm>
+#include <exception>
 #include <limits>
 #include <map>
 #include <utility>
@@ -342,6 +343,19 @@ public:
                             groups_t *groups,
                             // sindex_val may be NULL
                             const datum_t &sindex_val) = 0;
+
+    // `map` and `filter` turn every row into at most one row without looking at
+    // the row's group, its secondary index value or any other row, so they can
+    // also be applied to many ungrouped rows at once with `apply_rowwise`.
+    virtual bool is_rowwise() const { return false; }
+    // Replaces each row with its result, or with an empty `datum_t` if it's
+    // filtered out.  Stops at the first row that fails, storing the exception in
+    // `exc_out`.  Returns the number of rows that were transformed.
+    virtual size_t apply_rowwise(env_t *,
+                                 datums_t *,
+                                 std::exception_ptr *) {
+        unreachable();
+    }
 };
 
 struct limit_read_t {
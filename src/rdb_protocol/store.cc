@@ -6,6 +6,7 @@
 #include "concurrency/cross_thread_signal.hpp"
 #include "concurrency/cross_thread_watchable.hpp"
 #include "concurrency/wait_any.hpp"
+#include "config/args.hpp"
 #include "containers/archive/vector_stream.hpp"
 #include "containers/cow_ptr.hpp"
 #include "rdb_protocol/btree.hpp"
@@ -265,11 +266,25 @@ void do_read(ql::env_t *env,
     }
 }
 
+// Returns true if `rget` is likely to read a large part of the table, either
+// because it's open-ended or because it reads everything for a terminal.
+bool is_scan(const rget_read_t &rget) {
+    if (rget.batchspec.get_batch_type() == ql::batch_type_t::TERMINAL) {
+        return true;
+    }
+    if (rget.sindex) {
+        return !rget.sindex->original_range.is_bounded();
+    }
+    return rget.region.inner.left == store_key_t::min()
+        || rget.region.inner.right.unbounded;
+}
+
 // TODO: get rid of this extra response_t copy on the stack
 struct rdb_read_visitor_t : public boost::static_visitor<void> {
     void operator()(const changefeed_subscribe_t &s) {
         guarantee(store->changefeed_server.has());
-        store->changefeed_server->add_client(s.addr, s.region);
+        store->changefeed_server->add_client(
+            s.addr, s.region, ctx, s.optargs, s.transforms);
         response->response = changefeed_subscribe_response_t();
         auto res = boost::get<changefeed_subscribe_response_t>(&response->response);
         guarantee(res != NULL);
@@ -478,6 +493,14 @@ struct rdb_read_visitor_t : public boost::static_visitor<void> {
             rassert(rget.optargs.size() != 0);
         }
 
+        // A large range read touches most of its leaf nodes only once, so it
+        // shouldn't push the pages that point reads keep using out of the cache.
+        // Small bounded reads (like an sindex `get_all`) are left alone so that
+        // their pages can still be promoted.
+        if (is_scan(rget)) {
+            superblock->expose_buf().txn()->set_access_hint(cache_access_hint_t::scan);
+        }
+
         ql::env_t ql_env(ctx, ql::return_empty_normal_batches_t::NO,
                          interruptor, rget.optargs, trace);
 
@@ -921,8 +944,11 @@ struct rdb_backfill_callback_impl_t : public rdb_backfill_callback_t {
 public:
     typedef backfill_chunk_t chunk_t;
 
-    explicit rdb_backfill_callback_impl_t(chunk_fun_callback_t *_chunk_fun_cb)
-        : chunk_fun_cb(_chunk_fun_cb) { }
+    // `_region` is the region that we are backfilling. Checkpoints apply only to
+    // its hash range.
+    rdb_backfill_callback_impl_t(chunk_fun_callback_t *_chunk_fun_cb,
+                                 const region_t &_region)
+        : chunk_fun_cb(_chunk_fun_cb), region(_region) { }
     ~rdb_backfill_callback_impl_t() { }
 
     void on_delete_range(const key_range_t &range,
@@ -946,6 +972,13 @@ public:
         chunk_fun_cb->send_chunk(chunk_t::sindexes(sindexes), interruptor);
     }
 
+    void on_checkpoint(const key_range_t &range,
+                       signal_t *interruptor) THROWS_ONLY(interrupted_exc_t) {
+        chunk_fun_cb->send_chunk(
+            chunk_t::checkpoint(region_t(region.beg, region.end, range)),
+            interruptor);
+    }
+
 protected:
     store_key_t to_store_key(const btree_key_t *key) {
         return store_key_t(key->size, key->contents);
@@ -953,24 +986,23 @@ protected:
 
 private:
     chunk_fun_callback_t *chunk_fun_cb;
+    const region_t region;
 
     DISABLE_COPYING(rdb_backfill_callback_impl_t);
 };
 
 void call_rdb_backfill(int i, btree_slice_t *btree,
                        const std::vector<std::pair<region_t, state_timestamp_t> > &regions,
-                       rdb_backfill_callback_t *callback,
+                       chunk_fun_callback_t *chunk_fun_cb,
                        refcount_superblock_t *superblock,
                        buf_lock_t *sindex_block,
                        traversal_progress_combiner_t *progress,
                        signal_t *interruptor) THROWS_NOTHING {
-    parallel_traversal_progress_t *p = new parallel_traversal_progress_t;
-    scoped_ptr_t<traversal_progress_t> p_owned(p);
-    progress->add_constituent(&p_owned);
     repli_timestamp_t timestamp = regions[i].second.to_repli_timestamp();
+    rdb_backfill_callback_impl_t callback(chunk_fun_cb, regions[i].first);
     try {
-        rdb_backfill(btree, regions[i].first.inner, timestamp, callback,
-                     superblock, sindex_block, p, interruptor);
+        rdb_backfill(btree, regions[i].first.inner, timestamp, &callback,
+                     superblock, sindex_block, progress, interruptor);
     } catch (const interrupted_exc_t &) {
         /* do nothing; `protocol_send_backfill()` will notice that interruptor
         has been pulsed */
@@ -985,11 +1017,10 @@ void store_t::protocol_send_backfill(const region_map_t<state_timestamp_t> &star
                                      signal_t *interruptor)
     THROWS_ONLY(interrupted_exc_t) {
     with_priority_t p(CORO_PRIORITY_BACKFILL_SENDER);
-    rdb_backfill_callback_impl_t callback(chunk_fun_cb);
     std::vector<std::pair<region_t, state_timestamp_t> > regions(start_point.begin(), start_point.end());
     refcount_superblock_t refcount_wrapper(superblock, regions.size());
     pmap(regions.size(), std::bind(&call_rdb_backfill, ph::_1,
-                                   btree.get(), regions, &callback,
+                                   btree.get(), regions, chunk_fun_cb,
                                    &refcount_wrapper, sindex_block, progress,
                                    interruptor));
 
@@ -1019,14 +1050,22 @@ struct rdb_receive_backfill_visitor_t : public boost::static_visitor<void> {
                                    btree_slice_t *_btree,
                                    txn_t *_txn,
                                    scoped_ptr_t<real_superblock_t> &&_superblock,
+                                   bool _backfill_covers_store,
                                    signal_t *_interruptor) :
         store(_store), btree(_btree), txn(_txn), superblock(std::move(_superblock)),
+        backfill_covers_store(_backfill_covers_store),
         interruptor(_interruptor),
         sindex_block(superblock->expose_buf(),
                      superblock->get_sindex_block_id(),
                      access_t::write) { }
 
     void operator()(const backfill_chunk_t::delete_key_t &delete_key) {
+        if (deletion_is_past_bulk_load(delete_key.key)) {
+            superblock.reset();
+            return;
+        }
+        finish_bulk_load_if_any();
+
         point_delete_response_t response;
         std::vector<rdb_modification_report_t> mod_reports(1);
         mod_reports[0].primary_key = delete_key.key;
@@ -1039,6 +1078,12 @@ struct rdb_receive_backfill_visitor_t : public boost::static_visitor<void> {
     }
 
     void operator()(const backfill_chunk_t::delete_range_t &delete_range) {
+        if (deletion_is_past_bulk_load(delete_range.range.inner.left)) {
+            superblock.reset();
+            return;
+        }
+        finish_bulk_load_if_any();
+
         rdb_protocol::range_key_tester_t tester(&delete_range.range);
         rdb_live_deletion_context_t deletion_context;
         std::vector<rdb_modification_report_t> mod_reports;
@@ -1059,6 +1104,25 @@ struct rdb_receive_backfill_visitor_t : public boost::static_visitor<void> {
     }
 
     void operator()(const backfill_chunk_t::key_value_pairs_t &kv) {
+        if (can_bulk_load(kv.backfill_atoms)) {
+            if (!store->backfill_bulk_loader.has()) {
+                store->start_backfill_bulk_load(&sindex_block);
+            }
+            // We hold on to the superblock until we are done, because it's what
+            // keeps the next chunk from using the loader at the same time.
+            for (const backfill_atom_t &atom : kv.backfill_atoms) {
+                store->backfill_bulk_loader->append(txn, atom);
+            }
+            // Rooting the tree in every transaction means that a crash can't leave
+            // any of the loaded nodes unreachable.
+            store->backfill_bulk_loader->checkpoint(superblock.get());
+            superblock.reset();
+            btree->stats.pm_keys_set.record(kv.backfill_atoms.size());
+            btree->stats.pm_total_keys_set += kv.backfill_atoms.size();
+            return;
+        }
+        finish_bulk_load_if_any();
+
         std::vector<rdb_modification_report_t> mod_reports(kv.backfill_atoms.size());
         {
             auto_drainer_t drainer;
@@ -1081,6 +1145,8 @@ struct rdb_receive_backfill_visitor_t : public boost::static_visitor<void> {
     }
 
     void operator()(const backfill_chunk_t::sindexes_t &s) {
+        finish_bulk_load_if_any();
+
         // Release the superblock. We don't need it for this.
         superblock.reset();
 
@@ -1114,7 +1180,52 @@ struct rdb_receive_backfill_visitor_t : public boost::static_visitor<void> {
         }
     }
 
+    void operator()(const backfill_chunk_t::checkpoint_t &) {
+        unreachable("The backfillee applies checkpoints to the metainfo.");
+    }
+
 private:
+    /* A backfill from a node that we share no history with sends all of its keys in
+    ascending order (see `rdb_backfill()`). If our btree is empty when such a
+    backfill starts, we build it bottom-up from the chunks with
+    `store->backfill_bulk_loader` instead of inserting the keys one by one. The
+    secondary indexes are post constructed once the btree is complete. Whatever
+    doesn't fit into that pattern ends the bulk load, after which the chunks are
+    applied the usual way.
+    The btree must stay out of everybody else's reach until the bulk load is done,
+    and its secondary indexes are unusable in the meantime. That's only the case if
+    the backfill covers everything the store can contain (see
+    `backfill_covers_store()`): then no other region of the store can be serving
+    queries. */
+    bool can_bulk_load(const std::vector<backfill_atom_t> &atoms) {
+        if (!store->backfill_bulk_loader.has()
+            && (!backfill_covers_store
+                || superblock->get_root_block_id() != NULL_BLOCK_ID)) {
+            return false;
+        }
+        for (size_t i = 1; i < atoms.size(); ++i) {
+            if (!(atoms[i - 1].key < atoms[i].key)) {
+                return false;
+            }
+        }
+        return atoms.empty()
+            || !store->backfill_bulk_loader.has()
+            || store->backfill_bulk_loader->is_after_last_key(atoms[0].key);
+    }
+
+    // While we are bulk loading, the btree has no keys other than the loaded ones,
+    // and all of them come before `key`. So there is nothing to delete from `key` on.
+    bool deletion_is_past_bulk_load(const store_key_t &key) {
+        return store->backfill_bulk_loader.has()
+            && store->backfill_bulk_loader->is_after_last_key(key);
+    }
+
+    void finish_bulk_load_if_any() {
+        if (store->backfill_bulk_loader.has()) {
+            store->finish_backfill_bulk_load(superblock.get(), &sindex_block);
+        }
+    }
+
     void update_sindexes(const std::vector<rdb_modification_report_t> &mod_reports) {
         store->update_sindexes(txn,
                                &sindex_block,
@@ -1126,23 +1237,88 @@ private:
     btree_slice_t *btree;
     txn_t *txn;
     scoped_ptr_t<real_superblock_t> superblock;
+    bool backfill_covers_store;
     signal_t *interruptor;
     buf_lock_t sindex_block;
 
     DISABLE_COPYING(rdb_receive_backfill_visitor_t);
 };
 
+/* A store holds a single CPU shard of its table: `multistore_ptr_t` only ever writes
+the keys of `cpu_sharding_subspace(i, num_stores)` to its `i`th store. So although
+the store's region is the universe, a backfill which covers the whole key range of a
+CPU shard covers everything that can be in the store. Stores which are used without
+CPU sharding (as in some tests) are only covered by a backfill of the universe,
+which is a superset of every CPU shard. */
+bool backfill_covers_store(const region_t &backfill_region) {
+    for (int i = 0; i < CPU_SHARDING_FACTOR; ++i) {
+        if (region_is_superset(
+                backfill_region,
+                rdb_protocol::cpu_sharding_subspace(i, CPU_SHARDING_FACTOR))) {
+            return true;
+        }
+    }
+    return false;
+}
+
 void store_t::protocol_receive_backfill(scoped_ptr_t<real_superblock_t> &&_superblock,
                                         signal_t *interruptor,
+                                        const region_t &backfill_region,
                                         const backfill_chunk_t &chunk) {
     scoped_ptr_t<real_superblock_t> superblock(std::move(_superblock));
     rdb_receive_backfill_visitor_t v(this, btree.get(),
                                      superblock->expose_buf().txn(),
                                      std::move(superblock),
+                                     backfill_covers_store(backfill_region),
                                      interruptor);
     boost::apply_visitor(v, chunk.val);
 }
 
+void store_t::start_backfill_bulk_load(buf_lock_t *sindex_block)
+        THROWS_ONLY(interrupted_exc_t) {
+    assert_thread();
+    guarantee(!backfill_bulk_loader.has());
+
+    // The secondary indexes are as empty as the primary btree, but the bulk loader
+    // doesn't update them. We replace them by new ones that are marked as not post
+    // constructed, so that nobody reads from them and a post construction that
+    // started while the primary btree was empty can't mark them as ready.
+    std::map<sindex_name_t, secondary_index_t> sindexes;
+    get_secondary_indexes(sindex_block, &sindexes);
+    for (auto it = sindexes.begin(); it != sindexes.end(); ++it) {
+        if (!it->first.being_deleted) {
+            bool success = drop_sindex(it->first, sindex_block);
+            guarantee(success);
+            success = add_sindex(it->first, it->second.opaque_definition, sindex_block);
+            guarantee(success);
+        }
+    }
+    update_outdated_sindex_list(sindex_block);
+
+    backfill_bulk_loader.init(new rdb_backfill_bulk_loader_t(cache->max_block_size()));
+}
+
+void store_t::finish_backfill_bulk_load(superblock_t *superblock,
+                                        buf_lock_t *sindex_block) {
+    assert_thread();
+    guarantee(backfill_bulk_loader.has());
+    backfill_bulk_loader->finish(superblock);
+    backfill_bulk_loader.reset();
+
+    std::set<sindex_name_t> sindexes_to_post_construct;
+    std::map<sindex_name_t, secondary_index_t> sindexes;
+    get_secondary_indexes(sindex_block, &sindexes);
+    for (auto it = sindexes.begin(); it != sindexes.end(); ++it) {
+        if (!it->first.being_deleted && !it->second.post_construction_complete) {
+            sindexes_to_post_construct.insert(it->first);
+        }
+    }
+    if (!sindexes_to_post_construct.empty()) {
+        rdb_protocol::bring_sindexes_up_to_date(sindexes_to_post_construct, this,
+                                                sindex_block);
+    }
+}
+
 void store_t::delayed_clear_sindex(
         secondary_index_t sindex,
         auto_drainer_t::lock_t store_keepalive)
@@ -34,6 +34,7 @@ class cache_conn_t;
 class cache_t;
 class internal_disk_backed_queue_t;
 class io_backender_t;
+class rdb_backfill_bulk_loader_t;
 class real_superblock_t;
 class sindex_superblock_t;
 class superblock_t;
@@ -147,6 +148,7 @@ public:
         THROWS_ONLY(interrupted_exc_t);
 
     void receive_backfill(
+            const region_t &backfill_region,
             const backfill_chunk_t &chunk,
             write_token_t *token,
             signal_t *interruptor)
@@ -156,6 +158,9 @@ public:
     void throttle_backfill_chunk(signal_t *interruptor)
         THROWS_ONLY(interrupted_exc_t);
 
+    void finish_backfill(write_token_t *token, signal_t *interruptor)
+        THROWS_ONLY(interrupted_exc_t);
+
     void reset_data(
             const binary_blob_t &zero_version,
             const region_t &subregion,
@@ -313,8 +318,17 @@ public:
 
     void protocol_receive_backfill(scoped_ptr_t<real_superblock_t> &&superblock,
                                    signal_t *interruptor,
+                                   const region_t &backfill_region,
                                    const backfill_chunk_t &chunk);
 
+    // Start and end building the primary btree with `backfill_bulk_loader`. Ending
+    // it makes the loaded btree the root of `superblock` and post constructs the
+    // secondary indexes.
+    void start_backfill_bulk_load(buf_lock_t *sindex_block)
+        THROWS_ONLY(interrupted_exc_t);
+    void finish_backfill_bulk_load(superblock_t *superblock,
+                                   buf_lock_t *sindex_block);
+
     void get_metainfo_internal(real_superblock_t *superblock,
                                region_map_t<binary_blob_t> *out)
         const THROWS_NOTHING;
@@ -389,7 +403,7 @@ public:
     namespace_id_t const &get_table_id() const;
 
     typedef std::map<
-        uuid_u, std::pair<microtime_t, parallel_traversal_progress_t const *>
+        uuid_u, std::pair<microtime_t, traversal_progress_t const *>
     > sindex_context_map_t;
     sindex_context_map_t *get_sindex_context_map();
 
@@ -411,6 +425,14 @@ public:
 
     std::map<uuid_u, scoped_ptr_t<btree_slice_t> > secondary_index_slices;
 
+    // Set while a backfill builds the primary btree of this store, which was empty
+    // when the backfill started, with bulk loading. See `receive_backfill()`. Every
+    // chunk roots the loaded btree, so if the store is destroyed in the middle of
+    // it, the btree keeps what was loaded. Its secondary indexes are still marked
+    // as not post constructed then, so they get rebuilt when the store is loaded
+    // again (see `help_construct_bring_sindexes_up_to_date()`).
+    scoped_ptr_t<rdb_backfill_bulk_loader_t> backfill_bulk_loader;
+
     std::vector<internal_disk_backed_queue_t *> sindex_queues;
     new_mutex_t sindex_queue_mutex;
 
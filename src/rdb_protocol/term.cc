@@ -258,11 +258,26 @@ void run(query_id_t &&query_id,
         } break;
         case Query_QueryType_STOP: {
             maybe_release_query_id(std::move(query_id), q);
-            scoped_ptr_t<query_cache_t::ref_t> query_ref =
-                query_cache->get(token, use_json, interruptor);
-            query_ref->terminate();
+            // Stopping a prepared query's token releases it.
+            if (!query_cache->unprepare(token)) {
+                scoped_ptr_t<query_cache_t::ref_t> query_ref =
+                    query_cache->get(token, use_json, interruptor);
+                query_ref->terminate();
+            }
             res->set_type(Response::SUCCESS_SEQUENCE);
         } break;
+        case Query_QueryType_PREPARE: {
+            maybe_release_query_id(std::move(query_id), q);
+            query_cache->prepare(token, q);
+            res->set_type(Response::SUCCESS_ATOM);
+            datum_t::null().write_to_protobuf(res->add_response(), use_json);
+        } break;
+        case Query_QueryType_EXECUTE: {
+            maybe_release_query_id(std::move(query_id), q);
+            scoped_ptr_t<query_cache_t::ref_t> query_ref =
+                query_cache->execute(token, q, use_json, interruptor);
+            query_ref->fill_response(res);
+        } break;
         case Query_QueryType_NOREPLY_WAIT: {
             query_cache->noreply_wait(query_id, token, interruptor);
             res->set_type(Response::WAIT_COMPLETE);
@@ -0,0 +1,659 @@
+// Copyright 2010-2015 RethinkDB, all rights reserved.
+#include "rdb_protocol/terms/terms.hpp"
+
+#include <exception>
+#include <iterator>
+#include <limits>
+#include <map>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "concurrency/pmap.hpp"
+#include "containers/disk_backed_queue.hpp"
+#include "containers/uuid.hpp"
+#include "perfmon/core.hpp"
+#include "rdb_protocol/context.hpp"
+#include "rdb_protocol/datum_stream.hpp"
+#include "rdb_protocol/error.hpp"
+#include "rdb_protocol/func.hpp"
+#include "rdb_protocol/minidriver.hpp"
+#include "rdb_protocol/op.hpp"
+#include "rdb_protocol/pseudo_geometry.hpp"
+#include "rdb_protocol/ql2_extensions.pb.h"
+#include "rdb_protocol/rdb_protocol_json.hpp"
+#include "rdb_protocol/term_walker.hpp"
+
+namespace ql {
+
+// The number of `get_all` reads `eq_join` runs at once.
+const int64_t EQ_JOIN_MAX_PARALLEL_LOOKUPS = 64;
+
+// The number of left rows a join writes to or reads from its spill file at once.
+const size_t JOIN_SPILL_BATCH_SIZE = 1000;
+
+datum_t make_join_pair(datum_t left, datum_t right) {
+    datum_object_builder_t pair;
+    pair.overwrite("left", std::move(left));
+    if (right.has()) {
+        pair.overwrite("right", std::move(right));
+    }
+    return std::move(pair).to_datum();
+}
+
+/* `eq_join_datum_stream_t` reads the left sequence a batch at a time, evaluates the
+join key of every row in the batch and then looks up the rows of all the distinct
+keys in parallel, rather than doing one `get_all` after the other. */
+class eq_join_datum_stream_t : public wrapper_datum_stream_t {
+public:
+    eq_join_datum_stream_t(counted_t<datum_stream_t> left,
+                           counted_t<const func_t> _left_key,
+                           counted_t<table_t> _right,
+                           const std::string &_index)
+        : wrapper_datum_stream_t(left),
+          left_key(std::move(_left_key)),
+          right(std::move(_right)),
+          index(_index) { }
+
+private:
+    std::vector<datum_t>
+    next_raw_batch(env_t *env, const batchspec_t &batchspec) {
+        std::vector<datum_t> ret;
+        while (ret.size() == 0) {
+            std::vector<datum_t> batch = source->next_batch(env, batchspec);
+            if (batch.size() == 0) {
+                break;
+            }
+
+            // `row_keys[i]` is the index into `keys` of the key of `batch[i]`, or
+            // `NO_KEY` if the row doesn't join with anything.
+            const size_t NO_KEY = std::numeric_limits<size_t>::max();
+            std::vector<datum_t> keys;
+            std::vector<size_t> row_keys(batch.size(), NO_KEY);
+            {
+                profile::sampler_t sampler("Evaluating eq_join keys.", env->trace);
+                std::map<datum_t, size_t, optional_datum_less_t> key_indexes(
+                    optional_datum_less_t(env->reql_version()));
+                for (size_t i = 0; i < batch.size(); ++i) {
+                    datum_t key = eval_key(env, batch[i]);
+                    sampler.new_sample();
+                    if (!key.has()) {
+                        continue;
+                    }
+                    auto res = key_indexes.insert(std::make_pair(key, keys.size()));
+                    if (res.second) {
+                        keys.push_back(key);
+                    }
+                    row_keys[i] = res.first->second;
+                }
+            }
+
+            std::vector<std::vector<datum_t> > matches(keys.size());
+            look_up(env, keys, &matches);
+
+            for (size_t i = 0; i < batch.size(); ++i) {
+                if (row_keys[i] == NO_KEY) {
+                    continue;
+                }
+                const std::vector<datum_t> &rows = matches[row_keys[i]];
+                for (auto it = rows.begin(); it != rows.end(); ++it) {
+                    ret.push_back(make_join_pair(batch[i], *it));
+                }
+            }
+        }
+        return ret;
+    }
+
+    // Returns the key to look up for `row`, or an empty datum if `row` doesn't join
+    // with anything: if it's `null`, or if evaluating its key fails with a
+    // non-existence error.
+    datum_t eval_key(env_t *env, const datum_t &row) const {
+        if (row.get_type() == datum_t::R_NULL) {
+            return datum_t();
+        }
+        datum_t key;
+        try {
+            key = left_key->call(env, row)->as_datum();
+        } catch (const base_exc_t &e) {
+            if (e.get_type() != base_exc_t::NON_EXISTENCE) {
+                throw;
+            }
+            return datum_t();
+        }
+        rcheck(!key.is_ptype(pseudo::geometry_string),
+               base_exc_t::GENERIC,
+               "Cannot use a geospatial index with `eq_join`.");
+        return key;
+    }
+
+    // Reads the right rows of every key in `keys`, several keys at a time.
+    void look_up(env_t *env,
+                 const std::vector<datum_t> &keys,
+                 std::vector<std::vector<datum_t> > *rows_out) {
+        if (keys.empty()) {
+            return;
+        }
+        profile::starter_t starter("Looking up eq_join rows.", env->trace);
+        // The lookups can't share `env`'s trace because they run in parallel, so
+        // they get an environment of their own, as in `union_datum_stream_t`.
+        scoped_ptr_t<profile::trace_t> trace;
+        scoped_ptr_t<profile::disabler_t> disabler;
+        if (env->trace != nullptr) {
+            trace = make_scoped<profile::trace_t>();
+            disabler = make_scoped<profile::disabler_t>(trace.get());
+        }
+        env_t lookup_env(env->get_rdb_ctx(),
+                         env->return_empty_normal_batches,
+                         env->interruptor,
+                         env->get_all_optargs(),
+                         trace.has() ? trace.get() : nullptr);
+
+        std::vector<std::exception_ptr> errors(keys.size());
+        throttled_pmap(keys.size(), [&](int64_t i) {
+            try {
+                counted_t<datum_stream_t> stream
+                    = right->get_all(&lookup_env, keys[i], index, backtrace());
+                for (;;) {
+                    std::vector<datum_t> rows
+                        = stream->next_batch(&lookup_env, batchspec_t::all());
+                    if (rows.size() == 0) {
+                        break;
+                    }
+                    std::move(rows.begin(), rows.end(),
+                              std::back_inserter((*rows_out)[i]));
+                }
+            } catch (...) {
+                errors[i] = std::current_exception();
+            }
+        }, EQ_JOIN_MAX_PARALLEL_LOOKUPS);
+        for (auto it = errors.begin(); it != errors.end(); ++it) {
+            if (*it) {
+                std::rethrow_exception(*it);
+            }
+        }
+    }
+
+    const counted_t<const func_t> left_key;
+    const counted_t<table_t> right;
+    const std::string index;
+};
+
+enum class join_type_t { INNER, OUTER };
+
+/* `join_datum_stream_t` implements `inner_join` and `outer_join`.  It reads the right
+sequence in chunks of up to `array_limit` rows and streams the left rows past each
+chunk in turn.  If the join condition is an equality between a function of the left
+row and a function of the right row, each chunk is indexed by the right function, so
+that a left row is only compared with the right rows it matches; otherwise every pair
+of rows is tested.
+
+If the right sequence fits into a single chunk, the rows come out in the same order
+as from a nested loop.  Otherwise the left rows are written to a temporary file as
+they go past each chunk but the last, so that the next chunk can be joined with
+them, and the result is grouped by chunk. */
+class join_datum_stream_t : public eager_datum_stream_t {
+public:
+    // Joins the rows for which `predicate(left, right)` is true.
+    join_datum_stream_t(env_t *env,
+                        join_type_t _type,
+                        counted_t<datum_stream_t> _left,
+                        counted_t<datum_stream_t> _right,
+                        counted_t<const func_t> _predicate,
+                        const protob_t<const Backtrace> &bt_src)
+        : eager_datum_stream_t(bt_src),
+          type(_type),
+          left(std::move(_left)),
+          right(std::move(_right)),
+          predicate(std::move(_predicate)),
+          chunk_index(optional_datum_less_t(env->reql_version())) {
+        init();
+    }
+
+    // Joins the rows for which `left_key(left) == right_key(right)`.
+    join_datum_stream_t(env_t *env,
+                        join_type_t _type,
+                        counted_t<datum_stream_t> _left,
+                        counted_t<datum_stream_t> _right,
+                        counted_t<const func_t> _left_key,
+                        counted_t<const func_t> _right_key,
+                        const protob_t<const Backtrace> &bt_src)
+        : eager_datum_stream_t(bt_src),
+          type(_type),
+          left(std::move(_left)),
+          right(std::move(_right)),
+          left_key(std::move(_left_key)),
+          right_key(std::move(_right_key)),
+          chunk_index(optional_datum_less_t(env->reql_version())) {
+        init();
+    }
+
+    virtual bool is_exhausted() const {
+        return done && batch_cache_exhausted();
+    }
+    virtual feed_type_t cfeed_type() const {
+        return feed_type_t::not_feed;
+    }
+    virtual bool is_infinite() const {
+        return left->is_infinite();
+    }
+
+private:
+    // A left row on its way past the current chunk.
+    struct probe_row_t {
+        datum_t row;
+        // The value of `left_key`, once it has been evaluated.
+        datum_t key;
+        // Whether the row has matched a right row in an earlier chunk.
+        bool matched;
+    };
+
+    void init() {
+        rcheck(!right->is_infinite(), base_exc_t::GENERIC,
+               "Cannot use an infinite stream as the right side of a join.");
+        done = false;
+        chunk_loaded = false;
+        more_chunks = false;
+        right_batch_index = 0;
+        probe_index = 0;
+        spill_stats.init(new perfmon_collection_t);
+    }
+
+    virtual bool is_array() const {
+        return left->is_array();
+    }
+    virtual datum_t as_array(env_t *env) {
+        return is_array() ? eager_datum_stream_t::as_array(env) : datum_t();
+    }
+
+    virtual std::vector<datum_t>
+    next_raw_batch(env_t *env, const batchspec_t &batchspec) {
+        std::vector<datum_t> ret;
+        batcher_t batcher = batchspec.to_batcher();
+
+        profile::sampler_t sampler("Joining.", env->trace);
+        while (!done && !batcher.should_send_batch()) {
+            if (probe_index == probe_batch.size()) {
+                if (!read_probe_batch(env, batchspec)) {
+                    finish_pass(env);
+                }
+                continue;
+            }
+            probe_row_t *probe = &probe_batch[probe_index++];
+            join_row(env, probe, &ret, &batcher);
+            sampler.new_sample();
+        }
+        flush_spill();
+        return ret;
+    }
+
+    // Refills `probe_batch` with the next left rows of this pass.  Returns false at
+    // the end of the pass.
+    bool read_probe_batch(env_t *env, const batchspec_t &batchspec) {
+        probe_batch.clear();
+        probe_index = 0;
+        if (!spilled_in.has()) {
+            std::vector<datum_t> rows = left->next_batch(env, batchspec);
+            if (rows.size() == 0) {
+                return false;
+            }
+            // We don't touch the right sequence until there is a left row, like
+            // the nested loop this replaces.
+            if (!chunk_loaded) {
+                load_chunk(env);
+            }
+            probe_batch.reserve(rows.size());
+            for (auto it = rows.begin(); it != rows.end(); ++it) {
+                probe_row_t probe;
+                probe.row = std::move(*it);
+                probe.matched = false;
+                probe_batch.push_back(std::move(probe));
+            }
+        } else {
+            while (probe_batch.size() < JOIN_SPILL_BATCH_SIZE && !spilled_in->empty()) {
+                datum_t encoded;
+                spilled_in->pop(&encoded);
+                probe_batch.push_back(decode_probe_row(encoded));
+            }
+        }
+        return probe_batch.size() != 0;
+    }
+
+    // Ends a pass over the left rows and starts the next one, if there are right
+    // rows left.
+    void finish_pass(env_t *env) {
+        flush_spill();
+        if (!more_chunks) {
+            done = true;
+            spilled_in.reset();
+            return;
+        }
+        spilled_in = std::move(spilled_out);
+        load_chunk(env);
+    }
+
+    // Reads the next chunk of the right sequence into memory.
+    void load_chunk(env_t *env) {
+        chunk.clear();
+        chunk_index.clear();
+        chunk_loaded = true;
+
+        const size_t limit = env->limits().array_size_limit();
+        const batchspec_t batchspec = batchspec_t::user(batch_type_t::NORMAL, env);
+        profile::sampler_t sampler("Reading the right side of a join.", env->trace);
+        for (;;) {
+            if (right_batch_index == right_batch.size()) {
+                right_batch = right->next_batch(env, batchspec);
+                right_batch_index = 0;
+                if (right_batch.size() == 0) {
+                    more_chunks = false;
+                    break;
+                }
+            }
+            if (chunk.size() == limit) {
+                more_chunks = true;
+                break;
+            }
+            datum_t row = std::move(right_batch[right_batch_index++]);
+            if (right_key.has()) {
+                chunk_index[right_key->call(env, row)->as_datum()].push_back(row);
+            }
+            chunk.push_back(std::move(row));
+            sampler.new_sample();
+        }
+
+        if (more_chunks) {
+            rdb_context_t *rdb_ctx = env->get_rdb_ctx();
+            // The same error we give for arrays that are too big.
+            rcheck(rdb_ctx != NULL && rdb_ctx->io_backender != NULL,
+                   base_exc_t::GENERIC,
+                   strprintf("Array over size limit `%zu`.", limit).c_str());
+            spilled_out.init(new disk_backed_queue_t<datum_t>(
+                rdb_ctx->io_backender,
+                serializer_filepath_t(rdb_ctx->base_path,
+                                      "join_" + uuid_to_str(generate_uuid())),
+                spill_stats.get()));
+        }
+    }
+
+    // Joins `probe` with the current chunk and appends the results to `out`.
+    void join_row(env_t *env, probe_row_t *probe,
+                  std::vector<datum_t> *out, batcher_t *batcher) {
+        if (right_key.has()) {
+            if (!chunk_index.empty()) {
+                if (!probe->key.has()) {
+                    probe->key = left_key->call(env, probe->row)->as_datum();
+                }
+                auto it = chunk_index.find(probe->key);
+                if (it != chunk_index.end()) {
+                    for (auto jt = it->second.begin(); jt != it->second.end(); ++jt) {
+                        emit(make_join_pair(probe->row, *jt), out, batcher);
+                    }
+                    probe->matched = true;
+                }
+            }
+        } else {
+            for (auto it = chunk.begin(); it != chunk.end(); ++it) {
+                if (predicate->call(env, probe->row, *it)->as_bool()) {
+                    emit(make_join_pair(probe->row, *it), out, batcher);
+                    probe->matched = true;
+                }
+            }
+        }
+
+        if (more_chunks) {
+            spill_buffer.push_back(encode_probe_row(std::move(*probe)));
+            if (spill_buffer.size() == JOIN_SPILL_BATCH_SIZE) {
+                flush_spill();
+            }
+        } else if (type == join_type_t::OUTER && !probe->matched) {
+            emit(make_join_pair(probe->row, datum_t()), out, batcher);
+        }
+    }
+
+    void emit(datum_t &&d, std::vector<datum_t> *out, batcher_t *batcher) {
+        batcher->note_el(d);
+        out->push_back(std::move(d));
+    }
+
+    void flush_spill() {
+        if (!spill_buffer.empty()) {
+            spilled_out->push(spill_buffer);
+            spill_buffer.clear();
+        }
+    }
+
+    // Spilled left rows are stored as `[row, matched]` or `[row, matched, key]`.
+    static datum_t encode_probe_row(probe_row_t &&probe) {
+        std::vector<datum_t> encoded;
+        encoded.push_back(std::move(probe.row));
+        encoded.push_back(datum_t::boolean(probe.matched));
+        if (probe.key.has()) {
+            encoded.push_back(std::move(probe.key));
+        }
+        return datum_t(std::move(encoded), datum_t::no_array_size_limit_check_t());
+    }
+
+    static probe_row_t decode_probe_row(const datum_t &encoded) {
+        probe_row_t probe;
+        probe.row = encoded.get(0);
+        probe.matched = encoded.get(1).as_bool();
+        if (encoded.arr_size() > 2) {
+            probe.key = encoded.get(2);
+        }
+        return probe;
+    }
+
+    const join_type_t type;
+    const counted_t<datum_stream_t> left;
+    const counted_t<datum_stream_t> right;
+    // Either `predicate` or both `left_key` and `right_key` are set.
+    const counted_t<const func_t> predicate;
+    const counted_t<const func_t> left_key;
+    const counted_t<const func_t> right_key;
+
+    bool done;
+
+    // The current chunk of right rows, and an index of them by `right_key`.
+    std::vector<datum_t> chunk;
+    std::map<datum_t, std::vector<datum_t>, optional_datum_less_t> chunk_index;
+    bool chunk_loaded;
+    // Whether there are right rows after the current chunk.
+    bool more_chunks;
+    // The rows we have read from `right` that aren't in a chunk yet.
+    std::vector<datum_t> right_batch;
+    size_t right_batch_index;
+
+    std::vector<probe_row_t> probe_batch;
+    size_t probe_index;
+
+    // `spill_stats` must outlive the spill files.
+    scoped_ptr_t<perfmon_collection_t> spill_stats;
+    // The left rows of the current pass, if it isn't the first, and of the next.
+    scoped_ptr_t<disk_backed_queue_t<datum_t> > spilled_in;
+    scoped_ptr_t<disk_backed_queue_t<datum_t> > spilled_out;
+    std::vector<datum_t> spill_buffer;
+};
+
+// Adds the variables `t` refers to to `vars`.  Returns false if `t` uses `r.row`,
+// which we can't resolve here.
+bool collect_vars(const Term &t, std::set<int64_t> *vars) {
+    if (t.type() == Term::IMPLICIT_VAR) {
+        return false;
+    }
+    if (t.type() == Term::VAR) {
+        if (t.args_size() != 1
+            || t.args(0).type() != Term::DATUM
+            || t.args(0).datum().type() != Datum::R_NUM) {
+            return false;
+        }
+        vars->insert(static_cast<int64_t>(t.args(0).datum().r_num()));
+        return true;
+    }
+    for (int i = 0; i < t.args_size(); ++i) {
+        if (!collect_vars(t.args(i), vars)) {
+            return false;
+        }
+    }
+    for (int i = 0; i < t.optargs_size(); ++i) {
+        if (!collect_vars(t.optargs(i).val(), vars)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Reads the argument names of the literal function `func`.
+bool get_func_args(const Term &func, std::vector<int64_t> *args_out) {
+    if (func.type() != Term::FUNC || func.args_size() != 2) {
+        return false;
+    }
+    const Term &vars = func.args(0);
+    if (vars.type() == Term::DATUM && vars.datum().type() == Datum::R_ARRAY) {
+        for (int i = 0; i < vars.datum().r_array_size(); ++i) {
+            if (vars.datum().r_array(i).type() != Datum::R_NUM) {
+                return false;
+            }
+            args_out->push_back(static_cast<int64_t>(vars.datum().r_array(i).r_num()));
+        }
+    } else if (vars.type() == Term::MAKE_ARRAY) {
+        for (int i = 0; i < vars.args_size(); ++i) {
+            if (vars.args(i).type() != Term::DATUM
+                || vars.args(i).datum().type() != Datum::R_NUM) {
+                return false;
+            }
+            args_out->push_back(static_cast<int64_t>(vars.args(i).datum().r_num()));
+        }
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// Returns the one-argument function `function(var) { return body; }`, with the
+// backtrace of `func`.
+protob_t<const Term> make_key_func(const Term &func, int64_t var, const Term &body) {
+    protob_t<Term> ret = make_counted_term();
+    {
+        std::vector<r::reql_t> vars;
+        vars.emplace_back(static_cast<double>(var));
+        r::reql_t f(Term::FUNC, std::move(vars), r::expr(body));
+        ret->Swap(&f.get());
+    }
+    propagate_backtrace(ret.get(), &func.GetExtension(ql2::extension::backtrace));
+    return ret;
+}
+
+// If `func` is a literal function `function(l, r) { return f(l) == g(r); }` (or
+// `g(r) == f(l)`), sets `*left_out` and `*right_out` to `f` and `g`.
+bool make_join_key_funcs(const Term &func,
+                         protob_t<const Term> *left_out,
+                         protob_t<const Term> *right_out) {
+    std::vector<int64_t> args;
+    if (!get_func_args(func, &args) || args.size() != 2 || args[0] == args[1]) {
+        return false;
+    }
+    const Term &body = func.args(1);
+    if (body.type() != Term::EQ || body.args_size() != 2 || body.optargs_size() != 0) {
+        return false;
+    }
+
+    std::set<int64_t> vars[2];
+    for (int i = 0; i < 2; ++i) {
+        if (!collect_vars(body.args(i), &vars[i])) {
+            return false;
+        }
+    }
+    for (int i = 0; i < 2; ++i) {
+        const std::set<int64_t> &l = vars[i];
+        const std::set<int64_t> &r = vars[1 - i];
+        if (l.count(args[0]) == 1 && l.count(args[1]) == 0
+            && r.count(args[1]) == 1 && r.count(args[0]) == 0) {
+            *left_out = make_key_func(func, args[0], body.args(i));
+            *right_out = make_key_func(func, args[1], body.args(1 - i));
+            return true;
+        }
+    }
+    return false;
+}
+
+class join_term_t : public grouped_seq_op_term_t {
+public:
+    join_term_t(compile_env_t *env, const protob_t<const Term> &term,
+                join_type_t _type)
+        : grouped_seq_op_term_t(env, term, argspec_t(3)), type(_type) {
+        protob_t<const Term> left_src, right_src;
+        if (make_join_key_funcs(term->args(2), &left_src, &right_src)) {
+            counted_t<const term_t> l = compile_term(env, left_src);
+            counted_t<const term_t> r = compile_term(env, right_src);
+            // A non-deterministic key could differ between the comparisons the
+            // nested loop would make, so we only index deterministic ones.
+            if (l->is_deterministic() && r->is_deterministic()) {
+                left_key = l;
+                right_key = r;
+            }
+        }
+    }
+
+private:
+    virtual scoped_ptr_t<val_t> eval_impl(scope_env_t *env, args_t *args,
+                                          eval_flags_t) const {
+        counted_t<datum_stream_t> left = args->arg(env, 0)->as_seq(env->env);
+        counted_t<datum_stream_t> right = args->arg(env, 1)->as_seq(env->env);
+        counted_t<datum_stream_t> stream;
+        if (left_key.has()) {
+            stream = make_counted<join_datum_stream_t>(
+                env->env, type, left, right,
+                left_key->eval(env)->as_func(), right_key->eval(env)->as_func(),
+                backtrace());
+        } else {
+            stream = make_counted<join_datum_stream_t>(
+                env->env, type, left, right, args->arg(env, 2)->as_func(),
+                backtrace());
+        }
+        return new_val(env->env, stream);
+    }
+
+    virtual const char *name() const {
+        return type == join_type_t::INNER ? "inner_join" : "outer_join";
+    }
+
+    const join_type_t type;
+    // Set if the join condition is an equality we can index on.
+    counted_t<const term_t> left_key;
+    counted_t<const term_t> right_key;
+};
+
+class eq_join_term_t : public grouped_seq_op_term_t {
+public:
+    eq_join_term_t(compile_env_t *env, const protob_t<const Term> &term)
+        : grouped_seq_op_term_t(env, term, argspec_t(3), optargspec_t({ "index" })) { }
+private:
+    virtual scoped_ptr_t<val_t> eval_impl(scope_env_t *env, args_t *args,
+                                          eval_flags_t) const {
+        counted_t<datum_stream_t> left = args->arg(env, 0)->as_seq(env->env);
+        counted_t<const func_t> left_key
+            = args->arg(env, 1)->as_func(GET_FIELD_SHORTCUT);
+        counted_t<table_t> right = args->arg(env, 2)->as_table();
+        scoped_ptr_t<val_t> index = args->optarg(env, "index");
+        std::string index_str = index ? index->as_str().to_std() : right->get_pkey();
+        return new_val(env->env, make_counted<eq_join_datum_stream_t>(
+                           left, left_key, right, index_str));
+    }
+    virtual const char *name() const { return "eq_join"; }
+};
+
+counted_t<term_t> make_inner_join_term(
+    compile_env_t *env, const protob_t<const Term> &term) {
+    return make_counted<join_term_t>(env, term, join_type_t::INNER);
+}
+counted_t<term_t> make_outer_join_term(
+    compile_env_t *env, const protob_t<const Term> &term) {
+    return make_counted<join_term_t>(env, term, join_type_t::OUTER);
+}
+counted_t<term_t> make_eq_join_term(
+    compile_env_t *env, const protob_t<const Term> &term) {
+    return make_counted<eq_join_term_t>(env, term);
+}
+
+}  // namespace ql
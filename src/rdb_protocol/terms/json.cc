@@ -1,4 +1,5 @@
 // Copyright 2010-2013 RethinkDB, all rights reserved.
+#include "rdb_protocol/json_parser.hpp"
 #include "rdb_protocol/op.hpp"
 #include "rdb_protocol/term.hpp"
 #include "rdb_protocol/terms/terms.hpp"
@@ -11,19 +12,17 @@ public:
 
     scoped_ptr_t<val_t> eval_impl(scope_env_t *env, args_t *args, eval_flags_t) const {
         const datum_string_t &data = args->arg(env, 0)->as_str();
-        // TODO (daniel): This causes copying, which might reduce performance and
-        // wastes memory. Change the cJSON interface to take a length.
-        // Or maybe store datum_string_ts with a null byte appended, though that
-        // would suck.
+        // `parse_json` needs a NUL-terminated string.
         const std::string std_data = data.to_std();
-        scoped_cJSON_t cjson(cJSON_Parse(std_data.c_str()));
-        rcheck(cjson.get() != NULL, base_exc_t::GENERIC,
+        datum_t parsed;
+        const bool success = parse_json(std_data.c_str(), env->env->limits(),
+                                        env->env->reql_version(), &parsed);
+        rcheck(success, base_exc_t::GENERIC,
                strprintf("Failed to parse \"%s\" as JSON.",
                  (data.size() > 40
                   ? (std_data.substr(0, 37) + "...").c_str()
                   : std_data.c_str())));
-        return new_val(to_datum(cjson.get(), env->env->limits(),
-                                env->env->reql_version()));
+        return new_val(parsed);
     }
 
     virtual const char *name() const { return "json"; }
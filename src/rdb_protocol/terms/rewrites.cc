@@ -47,110 +47,6 @@ private:
     counted_t<const term_t> real;
 };
 
-class inner_join_term_t : public rewrite_term_t {
-public:
-    inner_join_term_t(compile_env_t *env, const protob_t<const Term> &term)
-        : rewrite_term_t(env, term, argspec_t(3), rewrite) { }
-
-    static r::reql_t rewrite(protob_t<const Term> in,
-                             UNUSED const pb_rcheckable_t *bt_src,
-                             protob_t<const Term> optargs_in) {
-        const Term &left = in->args(0);
-        const Term &right = in->args(1);
-        const Term &func = in->args(2);
-        auto n = pb::dummy_var_t::INNERJOIN_N;
-        auto m = pb::dummy_var_t::INNERJOIN_M;
-
-        r::reql_t term =
-            r::expr(left).concat_map(
-                r::fun(n,
-                    r::expr(right).concat_map(
-                        r::fun(m,
-                            r::branch(
-                                r::expr(func)(r::var(n), r::var(m)),
-                                r::array(r::object(
-                                        r::optarg("left", n), r::optarg("right", m))),
-                                r::array())))));
-
-        term.copy_optargs_from_term(*optargs_in);
-        return term;
-    }
-
-    virtual const char *name() const { return "inner_join"; }
-};
-
-class outer_join_term_t : public rewrite_term_t {
-public:
-    outer_join_term_t(compile_env_t *env, const protob_t<const Term> &term) :
-        rewrite_term_t(env, term, argspec_t(3), rewrite) { }
-
-    static r::reql_t rewrite(protob_t<const Term> in,
-                             UNUSED const pb_rcheckable_t *bt_src,
-                             protob_t<const Term> optargs_in) {
-        const Term &left = in->args(0);
-        const Term &right = in->args(1);
-        const Term &func = in->args(2);
-        auto n = pb::dummy_var_t::OUTERJOIN_N;
-        auto m = pb::dummy_var_t::OUTERJOIN_M;
-        auto lst = pb::dummy_var_t::OUTERJOIN_LST;
-
-        r::reql_t inner_concat_map =
-            r::expr(right).concat_map(
-                r::fun(m,
-                    r::branch(
-                        r::expr(func)(n, m),
-                        r::array(r::object(r::optarg("left", n), r::optarg("right", m))),
-                        r::array())));
-
-        r::reql_t term =
-            r::expr(left).concat_map(
-                r::fun(n,
-                    std::move(inner_concat_map).coerce_to("ARRAY").do_(lst,
-                        r::branch(
-                            r::expr(lst).count() > 0,
-                            lst,
-                            r::array(r::object(r::optarg("left", n)))))));
-
-        term.copy_optargs_from_term(*optargs_in);
-        return term;
-    }
-
-    virtual const char *name() const { return "outer_join"; }
-};
-
-class eq_join_term_t : public rewrite_term_t {
-public:
-    eq_join_term_t(compile_env_t *env, const protob_t<const Term> &term) :
-        rewrite_term_t(env, term, argspec_t(3), rewrite) { }
-private:
-
-    static r::reql_t rewrite(protob_t<const Term> in,
-                             UNUSED const pb_rcheckable_t *bt_src,
-                             protob_t<const Term> optargs_in) {
-        const Term &left = in->args(0);
-        const Term &left_attr = in->args(1);
-        const Term &right = in->args(2);
-
-        auto row = pb::dummy_var_t::EQJOIN_ROW;
-        auto v = pb::dummy_var_t::EQJOIN_V;
-
-        r::reql_t get_all =
-            r::expr(right).get_all(
-                r::expr(left_attr)(row, r::optarg("_SHORTCUT_", GET_FIELD_SHORTCUT)));
-        get_all.copy_optargs_from_term(*optargs_in);
-        return r::expr(left).concat_map(
-            r::fun(row,
-                   r::branch(
-                       r::null() == row,
-                       r::array(),
-                       std::move(get_all).default_(r::array()).map(
-                           r::fun(v, r::object(r::optarg("left", row),
-                                               r::optarg("right", v)))))));
-
-    }
-    virtual const char *name() const { return "eq_join"; }
-};
-
 class delete_term_t : public rewrite_term_t {
 public:
     delete_term_t(compile_env_t *env, const protob_t<const Term> &term)
@@ -266,18 +162,6 @@ counted_t<term_t> make_skip_term(
     compile_env_t *env, const protob_t<const Term> &term) {
     return make_counted<skip_term_t>(env, term);
 }
-counted_t<term_t> make_inner_join_term(
-    compile_env_t *env, const protob_t<const Term> &term) {
-    return make_counted<inner_join_term_t>(env, term);
-}
-counted_t<term_t> make_outer_join_term(
-    compile_env_t *env, const protob_t<const Term> &term) {
-    return make_counted<outer_join_term_t>(env, term);
-}
-counted_t<term_t> make_eq_join_term(
-    compile_env_t *env, const protob_t<const Term> &term) {
-    return make_counted<eq_join_term_t>(env, term);
-}
 counted_t<term_t> make_update_term(
     compile_env_t *env, const protob_t<const Term> &term) {
     return make_counted<update_term_t>(env, term);
@@ -4,14 +4,12 @@
 #include <string>
 #include <utility>
 
-#include "errors.hpp"
-#include <boost/bind.hpp>
-
 #include "rdb_protocol/datum_stream.hpp"
 #include "rdb_protocol/error.hpp"
 #include "rdb_protocol/func.hpp"
 #include "rdb_protocol/minidriver.hpp"
 #include "rdb_protocol/op.hpp"
+#include "rdb_protocol/order_by.hpp"
 #include "rdb_protocol/pb_utils.hpp"
 #include "rdb_protocol/term_walker.hpp"
 
@@ -53,77 +51,23 @@ public:
         : op_term_t(env, term, argspec_t(1, -1),
           optargspec_t({"index"})), src_term(term) { }
 private:
-    enum order_direction_t { ASC, DESC };
-    class lt_cmp_t {
-    public:
-        typedef bool result_type;
-        explicit lt_cmp_t(
-            std::vector<std::pair<order_direction_t, counted_t<const func_t> > > _comparisons)
-            : comparisons(std::move(_comparisons)) { }
-
-        bool operator()(env_t *env,
-                        profile::sampler_t *sampler,
-                        datum_t l,
-                        datum_t r) const {
-            sampler->new_sample();
-            for (auto it = comparisons.begin(); it != comparisons.end(); ++it) {
-                datum_t lval;
-                datum_t rval;
-                try {
-                    lval = it->second->call(env, l)->as_datum();
-                } catch (const base_exc_t &e) {
-                    if (e.get_type() != base_exc_t::NON_EXISTENCE) {
-                        throw;
-                    }
-                }
-
-                try {
-                    rval = it->second->call(env, r)->as_datum();
-                } catch (const base_exc_t &e) {
-                    if (e.get_type() != base_exc_t::NON_EXISTENCE) {
-                        throw;
-                    }
-                }
-
-                if (!lval.has() && !rval.has()) {
-                    continue;
-                }
-                if (!lval.has()) {
-                    return true != (it->first == DESC);
-                }
-                if (!rval.has()) {
-                    return false != (it->first == DESC);
-                }
-                int cmp_res = lval.cmp(env->reql_version(), rval);
-                if (cmp_res == 0) {
-                    continue;
-                }
-                return (cmp_res < 0) != (it->first == DESC);
-            }
-
-            return false;
-        }
-
-    private:
-        const std::vector<std::pair<order_direction_t, counted_t<const func_t> > >
-            comparisons;
-    };
-
     virtual scoped_ptr_t<val_t>
     eval_impl(scope_env_t *env, args_t *args, eval_flags_t) const {
-        std::vector<std::pair<order_direction_t, counted_t<const func_t> > > comparisons;
+        std::vector<std::pair<sorting_t, counted_t<const func_t> > > comparisons;
         for (size_t i = 1; i < args->num_args(); ++i) {
             if (get_src()->args(i).type() == Term::DESC) {
                 comparisons.push_back(
                     std::make_pair(
-                        DESC, args->arg(env, i)->as_func(GET_FIELD_SHORTCUT)));
+                        sorting_t::DESCENDING,
+                        args->arg(env, i)->as_func(GET_FIELD_SHORTCUT)));
             } else {
                 comparisons.push_back(
                     std::make_pair(
-                        ASC, args->arg(env, i)->as_func(GET_FIELD_SHORTCUT)));
+                        sorting_t::ASCENDING,
+                        args->arg(env, i)->as_func(GET_FIELD_SHORTCUT)));
             }
         }
-        lt_cmp_t lt_cmp(comparisons);
+        order_by_keys_t keys(std::move(comparisons));
 
         counted_t<table_slice_t> tbl_slice;
         counted_t<datum_stream_t> seq;
@@ -142,7 +86,7 @@ private:
         if (seq.has() && seq->is_exhausted()){
             /* Do nothing for empty sequence */
             if (!index.has()) {
-                rcheck(!comparisons.empty(), base_exc_t::GENERIC,
+                rcheck(!keys.empty(), base_exc_t::GENERIC,
                        "Must specify something to order by.");
             }
         /* Add a sorting to the table if we're doing indexed sorting. */
@@ -164,9 +108,9 @@ private:
             r_sanity_check(sorting != sorting_t::UNORDERED);
             std::string index_str = index->as_str().to_std();
             tbl_slice = tbl_slice->with_sorting(index_str, sorting);
-            if (!comparisons.empty()) {
+            if (!keys.empty()) {
                 seq = make_counted<indexed_sort_datum_stream_t>(
-                    tbl_slice->as_seq(env->env, backtrace()), lt_cmp);
+                    tbl_slice->as_seq(env->env, backtrace()), std::move(keys));
             } else {
                 return new_val(tbl_slice);
             }
@@ -174,25 +118,9 @@ private:
             if (!seq.has()) {
                 seq = tbl_slice->as_seq(env->env, backtrace());
             }
-            rcheck(!comparisons.empty(), base_exc_t::GENERIC,
+            rcheck(!keys.empty(), base_exc_t::GENERIC,
                    "Must specify something to order by.");
-            std::vector<datum_t> to_sort;
-            batchspec_t batchspec = batchspec_t::user(batch_type_t::TERMINAL, env->env);
-            for (;;) {
-                std::vector<datum_t> data
-                    = seq->next_batch(env->env, batchspec);
-                if (data.size() == 0) {
-                    break;
-                }
-                std::move(data.begin(), data.end(), std::back_inserter(to_sort));
-                rcheck_array_size(to_sort, env->env->limits(), base_exc_t::GENERIC);
-            }
-            profile::sampler_t sampler("Sorting in-memory.", env->env->trace);
-            auto fn = boost::bind(lt_cmp, env->env, &sampler, _1, _2);
-            std::stable_sort(to_sort.begin(), to_sort.end(), fn);
-            seq = make_counted<array_datum_stream_t>(
-                datum_t(std::move(to_sort), env->env->limits()),
-                backtrace());
+            seq = sort_unindexed(env->env, seq, std::move(keys));
         }
         return tbl_slice.has()
             ? new_val(make_counted<selection_t>(tbl_slice->get_tbl(), seq))
@@ -202,6 +130,62 @@ private:
     virtual const char *name() const { return "orderby"; }
 
 private:
+    // Reads all of `seq` and evaluates the keys of each row once.  If there are
+    // more rows than fit into an array, sorted runs of them are spilled to disk and
+    // merged as the result is read.
+    counted_t<datum_stream_t> sort_unindexed(env_t *env,
+                                             counted_t<datum_stream_t> seq,
+                                             order_by_keys_t &&keys) const {
+        const size_t run_size = env->limits().array_size_limit();
+        rdb_context_t *rdb_ctx = env->get_rdb_ctx();
+        const bool can_spill = rdb_ctx != NULL && rdb_ctx->io_backender != NULL;
+
+        std::vector<keyed_row_t> run;
+        counted_t<external_sort_datum_stream_t> spilled;
+        batchspec_t batchspec = batchspec_t::user(batch_type_t::TERMINAL, env);
+        {
+            profile::sampler_t sampler("Evaluating sort keys.", env->trace);
+            for (;;) {
+                std::vector<datum_t> data = seq->next_batch(env, batchspec);
+                if (data.size() == 0) {
+                    break;
+                }
+                for (auto it = data.begin(); it != data.end(); ++it) {
+                    if (run.size() == run_size) {
+                        // The same error we give for arrays that are too big.
+                        rcheck(can_spill, base_exc_t::GENERIC,
+                               strprintf("Array over size limit `%zu`.",
+                                         run_size).c_str());
+                        if (!spilled.has()) {
+                            spilled = make_counted<external_sort_datum_stream_t>(
+                                keys, rdb_ctx->base_path, env->reql_version(),
+                                backtrace());
+                        }
+                        keys.sort(env->reql_version(), &run);
+                        spilled->spill_run(std::move(run));
+                        run.clear();
+                    }
+                    run.push_back(keys.make_keyed_row(env, std::move(*it)));
+                    sampler.new_sample();
+                }
+            }
+        }
+
+        profile::sampler_t sampler("Sorting in-memory.", env->trace);
+        keys.sort(env->reql_version(), &run);
+        if (spilled.has()) {
+            spilled->finish(std::move(run));
+            return spilled;
+        }
+        std::vector<datum_t> sorted;
+        sorted.reserve(run.size());
+        for (auto it = run.begin(); it != run.end(); ++it) {
+            sorted.push_back(std::move(it->row));
+        }
+        return make_counted<array_datum_stream_t>(
+            datum_t(std::move(sorted), env->limits()), backtrace());
+    }
+
     protob_t<const Term> src_term;
 };
 
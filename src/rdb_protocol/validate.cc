@@ -49,12 +49,21 @@
 
 void validate_pb(const Query &q) {
     check_type(Query, q);
-    if (q.type() == Query::START) {
+    if (q.type() == Query::START || q.type() == Query::PREPARE) {
         check_has(q, has_query, "query");
         validate_pb(q.query());
     } else {
         check_not_has(q, has_query, "query");
     }
+    if (q.type() == Query::EXECUTE) {
+        check_has(q, has_prepared_token, "prepared_token");
+        for (int i = 0; i < q.prepared_args_size(); ++i) {
+            validate_pb(q.prepared_args(i));
+        }
+    } else {
+        check_not_has(q, has_prepared_token, "prepared_token");
+        check_empty(q, prepared_args_size, "prepared_args");
+    }
     check_has(q, has_token, "token");
     for (int i = 0; i < q.global_optargs_size(); ++i) {
         validate_pb(q.global_optargs(i).val());
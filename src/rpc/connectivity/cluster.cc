@@ -26,11 +26,14 @@
 // Number of messages after which the message handling loop yields
 #define MESSAGE_HANDLER_MAX_BATCH_SIZE           8
 
-// The cluster communication protocol version.
+// The cluster communication protocol version. The handshake changed in 2.0.1, when
+// we started to open several TCP connections to every peer, but the serialization
+// format didn't, so it's still `cluster_version_t::v2_0`. We turn away peers that
+// speak 2.0, because they can't follow the new handshake.
 static_assert(cluster_version_t::CLUSTER == cluster_version_t::v2_0_is_latest,
               "We need to update CLUSTER_VERSION_STRING when we add a new cluster "
               "version.");
-#define CLUSTER_VERSION_STRING "2.0"
+#define CLUSTER_VERSION_STRING "2.0.1"
 
 const std::string connectivity_cluster_t::cluster_proto_header("RethinkDB cluster\n");
 const std::string connectivity_cluster_t::cluster_version_string(CLUSTER_VERSION_STRING);
@@ -113,8 +116,10 @@ const std::string connectivity_cluster_t::cluster_build_mode("debug");
 
 void connectivity_cluster_t::connection_t::kill_connection() {
     /* `heartbeat_manager_t` assumes this doesn't block as long as it's called on the
-    home thread. */
+    home thread of `streams[0]`. We only close `streams[0]`; once `handle()` notices,
+    it closes the other streams. */
     guarantee(!is_loopback(), "Attempted to kill connection to myself.");
+    keepalive_tcp_conn_stream_t *conn = streams[0].conn;
     on_thread_t thread_switcher(conn->home_thread());
 
     if (conn->is_read_open()) {
@@ -125,11 +130,13 @@ void connectivity_cluster_t::connection_t::kill_connection() {
     }
 }
 
-connectivity_cluster_t::connection_t::connection_t(run_t *p,
-                                              peer_id_t id,
-                                              keepalive_tcp_conn_stream_t *c,
-                                              const peer_address_t &a) THROWS_NOTHING :
-    conn(c), peer_address(a),
+connectivity_cluster_t::connection_t::connection_t(
+        run_t *p,
+        peer_id_t id,
+        const std::vector<keepalive_tcp_conn_stream_t *> &conns,
+        const peer_address_t &a) THROWS_NOTHING :
+    peer_address(a),
+    streams(conns.size()),
     pm_collection(),
     pm_bytes_sent(secs_to_ticks(1), true),
     pm_collection_membership(&p->parent->connectivity_collection, &pm_collection,
@@ -138,6 +145,9 @@ connectivity_cluster_t::connection_t::connection_t(run_t *p,
     parent(p), peer_id(id),
     drainers()
 {
+    for (size_t i = 0; i < conns.size(); ++i) {
+        streams[i].conn = conns[i];
+    }
     pmap(get_num_threads(), [this](int thread_id) {
         on_thread_t thread_switcher((threadnum_t(thread_id)));
         parent->parent->connections.get()->set_key_no_equals(
@@ -154,8 +164,30 @@ connectivity_cluster_t::connection_t::~connection_t() THROWS_NOTHING {
         drainers.get()->drain();
     });
 
-    /* The drainers have been destroyed, so nothing can be holding the `send_mutex`. */
-    guarantee(!send_mutex.is_locked());
+    /* The drainers have been destroyed, so nothing can be holding a `send_mutex`. */
+    for (size_t i = 0; i < streams.size(); ++i) {
+        guarantee(!streams[i].send_mutex.is_locked());
+    }
+}
+
+connectivity_cluster_t::connection_t::stream_t *
+connectivity_cluster_t::connection_t::get_stream(cluster_traffic_class_t traffic_class) {
+    guarantee(!is_loopback());
+    const size_t index = static_cast<size_t>(traffic_class);
+    return &streams[std::min(index, streams.size() - 1)];
+}
+
+connectivity_cluster_t::run_t::stream_set_t::stream_set_t(size_t num_streams) :
+    conns(num_streams, NULL),
+    threads(num_streams, INVALID_THREAD),
+    num_attached(1),
+    num_rethreaded(1),
+    num_finished(1),
+    connection(NULL) { }
+
+connectivity_cluster_t::run_t::stream_set_t::~stream_set_t() {
+    /* Make the coroutines that hold locks on `drainer` let go of them. */
+    closing.pulse_if_not_already_pulsed();
 }
 
 // Helper function for the `run_t` constructor's initialization list
@@ -227,7 +259,8 @@ connectivity_cluster_t::run_t::run_t(connectivity_cluster_t *p,
     `connection_map` on each thread and notifying any listeners that we're now
     connected to ourself. The destructor will remove us from the
     `connection_map` and again notify any listeners. */
-    connection_to_ourself(this, parent->me, NULL, routing_table[parent->me]),
+    connection_to_ourself(this, parent->me, std::vector<keepalive_tcp_conn_stream_t *>(),
+                          routing_table[parent->me]),
 
     listener(new tcp_listener_t(
         cluster_listener_socket.get(),
@@ -404,11 +437,11 @@ public:
         peer_str(peer_str_),
         timer(HEARTBEAT_INTERVAL_MS, this)
     {
-        connection->conn->set_keepalive_callback(this);
+        connection->streams[0].conn->set_keepalive_callback(this);
     }
 
     ~heartbeat_manager_t() {
-        connection->conn->set_keepalive_callback(NULL);
+        connection->streams[0].conn->set_keepalive_callback(NULL);
     }
 
     /* These are called by the `keepalive_tcp_conn_stream_t`. */
@@ -722,42 +755,16 @@ void fail_handshake(keepalive_tcp_conn_stream_t *conn,
     }
 }
 
-// We log error conditions as follows:
-// - silent: network error; conflict between parallel connections
-// - warning: invalid header
-// - error: id or address don't match expected id or address; deserialization range error; unknown error
-// In all cases we close the connection and quit.
-void connectivity_cluster_t::run_t::handle(
-        /* `conn` should remain valid until `handle()` returns.
-         * `handle()` does not take ownership of `conn`. */
+bool connectivity_cluster_t::run_t::exchange_handshake(
         keepalive_tcp_conn_stream_t *conn,
-        boost::optional<peer_id_t> expected_id,
-        boost::optional<peer_address_t> expected_address,
-        auto_drainer_t::lock_t drainer_lock,
-        bool *successful_join) THROWS_NOTHING
-{
-    parent->assert_thread();
-
-    /* TODO: If the other peer mysteriously stops talking to us, but doesn't close the
-    connection, during the initialization process but before we construct the
-    `heartbeat_manager_t`, then we might get stuck. Maybe we should add a timeout? It
-    could just be a `signal_timer_t` that is wired into `conn_closer_1` but not
-    `conn_closer_2`. */
-
-    // Get the name of our peer, for error reporting.
-    ip_and_port_t peer_addr;
-    std::string peerstr = "(unknown)";
-    if (conn->get_underlying_conn()->getpeername(&peer_addr))
-        peerstr = peer_addr.to_string();
-    const char *peername = peerstr.c_str();
-
-    // Make sure that if we're ordered to shut down, any pending read
-    // or write gets interrupted.
-    cluster_conn_closing_subscription_t conn_closer_1(conn);
-    conn_closer_1.reset(drainer_lock.get_drain_signal());
-
-    // Each side sends a header followed by its own ID and address, then receives and checks the
-    // other side's.
+        const char *peername,
+        const stream_request_t &our_stream,
+        cluster_version_t *resolved_version_out,
+        peer_id_t *other_id_out,
+        std::set<host_and_port_t> *other_peer_addr_hosts_out,
+        stream_request_t *other_stream_out) {
+    // Each side sends a header followed by its own ID and address, then receives and
+    // checks the other side's.
     {
         write_message_t wm;
         wm.append(cluster_proto_header.c_str(), cluster_proto_header.length());
@@ -776,7 +783,7 @@ void connectivity_cluster_t::run_t::handle(
         serialize_universal(&wm, parent->me);
         serialize_universal(&wm, routing_table[parent->me].hosts());
         if (send_write_message(conn, &wm)) {
-            return; // network error.
+            return false; // network error.
         }
     }
 
@@ -788,27 +795,26 @@ void connectivity_cluster_t::run_t::handle(
         for (uint64_t i = 0; i < cluster_proto_header.length(); i += r) {
             r = conn->read(buffer, std::min(buffer_size, int64_t(cluster_proto_header.length() - i)));
             if (-1 == r) {
-                return; // network error.
+                return false; // network error.
             }
             rassert(r >= 0);
             // If EOF or remote_header does not match header, terminate connection.
             if (0 == r || memcmp(cluster_proto_header.c_str() + i, buffer, r) != 0) {
                 logWRN("Received invalid clustering header from %s, closing connection -- something might be connecting to the wrong port.", peername);
-                return;
+                return false;
             }
         }
     }
 
     // Check version number (e.g. 1.9.0-466-gadea67)
-    cluster_version_t resolved_version;
     {
         std::string remote_version_string;
 
         if (!deserialize_compatible_string(conn, &remote_version_string, peername)) {
-            return;
+            return false;
         }
 
-        if (!resolve_protocol_version(remote_version_string, &resolved_version)) {
+        if (!resolve_protocol_version(remote_version_string, resolved_version_out)) {
             auto reason = handshake_result_t::error(
                 handshake_result_code_t::UNRECOGNIZED_VERSION,
                 strprintf("local: %s, remote: %s",
@@ -824,11 +830,11 @@ void connectivity_cluster_t::run_t::handle(
                 }
             }
             fail_handshake(conn, peername, reason, handshake_error_supported);
-            return;
+            return false;
         }
 
         // In the future we'll need to support multiple cluster versions.
-        guarantee(resolved_version == cluster_version_t::CLUSTER);
+        guarantee(*resolved_version_out == cluster_version_t::CLUSTER);
     }
 
     // Check bitsize (e.g. 32bit or 64bit)
@@ -836,7 +842,7 @@ void connectivity_cluster_t::run_t::handle(
         std::string remote_arch_bitsize;
 
         if (!deserialize_compatible_string(conn, &remote_arch_bitsize, peername)) {
-            return;
+            return false;
         }
 
         if (remote_arch_bitsize != cluster_arch_bitsize) {
@@ -845,7 +851,7 @@ void connectivity_cluster_t::run_t::handle(
                 strprintf("local: %s, remote: %s",
                           cluster_arch_bitsize.c_str(), remote_arch_bitsize.c_str()));
             fail_handshake(conn, peername, reason);
-            return;
+            return false;
         }
 
     }
@@ -855,7 +861,7 @@ void connectivity_cluster_t::run_t::handle(
         std::string remote_build_mode;
 
         if (!deserialize_compatible_string(conn, &remote_build_mode, peername)) {
-            return;
+            return false;
         }
 
         if (remote_build_mode != cluster_build_mode) {
@@ -864,16 +870,14 @@ void connectivity_cluster_t::run_t::handle(
                 strprintf("local: %s, remote: %s",
                           cluster_build_mode.c_str(), remote_build_mode.c_str()));
             fail_handshake(conn, peername, reason);
-            return;
+            return false;
         }
     }
 
     // Receive id, host/ports.
-    peer_id_t other_id;
-    std::set<host_and_port_t> other_peer_addr_hosts;
-    if (deserialize_universal_and_check(conn, &other_id, peername) ||
-        deserialize_universal_and_check(conn, &other_peer_addr_hosts, peername)) {
-        return;
+    if (deserialize_universal_and_check(conn, other_id_out, peername) ||
+        deserialize_universal_and_check(conn, other_peer_addr_hosts_out, peername)) {
+        return false;
     }
 
     {
@@ -881,22 +885,118 @@ void connectivity_cluster_t::run_t::handle(
         write_message_t wm;
         serialize_universal(&wm, handshake_result_t::success());
         if (send_write_message(conn, &wm)) {
-            return; // network error.
+            return false; // network error.
         }
 
         // Check if there was an issue with the connection initiation
         handshake_result_t handshake_result;
         if (deserialize_universal_and_check(conn, &handshake_result, peername)) {
-            return;
+            return false;
         }
         if (handshake_result.get_code() != handshake_result_code_t::SUCCESS) {
             logWRN("Remote node refused to connect with us, peer: %s, reason: \"%s\"",
                    peername,
                    sanitize_for_logger(handshake_result.get_error_reason()).c_str());
+            return false;
+        }
+    }
+
+    // Exchange stream requests. We only do this once both sides have accepted each
+    // other's version, so that a peer that doesn't know about them gets a proper
+    // handshake error instead of bytes it can't make sense of.
+    {
+        write_message_t wm;
+        serialize_universal(&wm, our_stream.index);
+        serialize_universal(&wm, our_stream.count);
+        if (send_write_message(conn, &wm)) {
+            return false; // network error.
+        }
+        if (deserialize_universal_and_check(conn, &other_stream_out->index, peername) ||
+            deserialize_universal_and_check(conn, &other_stream_out->count, peername)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// We log error conditions as follows:
+// - silent: network error; conflict between parallel connections
+// - warning: invalid header
+// - error: id or address don't match expected id or address; deserialization range error; unknown error
+// In all cases we close the connection and quit.
+void connectivity_cluster_t::run_t::handle(
+        /* `conn` should remain valid until `handle()` returns.
+         * `handle()` does not take ownership of `conn`. */
+        keepalive_tcp_conn_stream_t *conn,
+        boost::optional<peer_id_t> expected_id,
+        boost::optional<peer_address_t> expected_address,
+        auto_drainer_t::lock_t drainer_lock,
+        bool *successful_join) THROWS_NOTHING
+{
+    parent->assert_thread();
+
+    /* TODO: If the other peer mysteriously stops talking to us, but doesn't close the
+    connection, during the initialization process but before we construct the
+    `heartbeat_manager_t`, then we might get stuck. Maybe we should add a timeout? It
+    could just be a `signal_timer_t` that is wired into `conn_closer_1` but not
+    `conn_closer_2`. */
+
+    // Get the name of our peer, for error reporting.
+    ip_and_port_t peer_addr;
+    std::string peerstr = "(unknown)";
+    const bool know_peer_addr = conn->get_underlying_conn()->getpeername(&peer_addr);
+    if (know_peer_addr)
+        peerstr = peer_addr.to_string();
+    const char *peername = peerstr.c_str();
+
+    // Make sure that if we're ordered to shut down, any pending read
+    // or write gets interrupted.
+    cluster_conn_closing_subscription_t conn_closer_1(conn);
+    conn_closer_1.reset(drainer_lock.get_drain_signal());
+
+    /* If we opened the connection, we ask for as many streams as we are going to
+    open. If all our connections have to come from `cluster_client_port`, we can
+    only open one, because TCP couldn't tell them apart. */
+    stream_request_t our_stream;
+    our_stream.index = 0;
+    our_stream.count = CLUSTER_STREAMS_PER_PEER;
+    if (successful_join != NULL && (cluster_client_port != 0 || !know_peer_addr)) {
+        our_stream.count = 1;
+    }
+
+    cluster_version_t resolved_version;
+    peer_id_t other_id;
+    std::set<host_and_port_t> other_peer_addr_hosts;
+    stream_request_t other_stream;
+    if (!exchange_handshake(conn, peername, our_stream, &resolved_version, &other_id,
+                            &other_peer_addr_hosts, &other_stream)) {
+        return;
+    }
+
+    if (other_stream.index != 0) {
+        /* This is an additional stream for a connection that the other server has
+        opened to us. */
+        auto it = pending_streams.find(other_id);
+        if (successful_join != NULL || it == pending_streams.end()) {
+            return;
+        }
+        stream_set_t *stream_set = it->second;
+        if (other_stream.index >= stream_set->conns.size()
+                || other_stream.count != stream_set->conns.size()
+                || stream_set->conns[other_stream.index] != NULL) {
+            logERR("Received an invalid stream request from %s, closing connection.",
+                   peername);
             return;
         }
+        auto_drainer_t::lock_t stream_set_lock(&stream_set->drainer);
+        conn_closer_1.reset();
+        run_stream(conn, other_stream.index, resolved_version, stream_set,
+                   stream_set_lock);
+        return;
     }
 
+
     // Look up the ip addresses for the other host
     object_buffer_t<peer_address_t> other_peer_addr;
 
@@ -968,6 +1068,18 @@ void connectivity_cluster_t::run_t::handle(
     Then the follower sends its routing table to the leader. */
     bool we_are_leader = parent->me < other_id;
 
+    /* Both sides use the smaller of the two stream counts. */
+    const size_t num_streams = std::max<uint64_t>(
+        1, std::min(our_stream.count, other_stream.count));
+    stream_set_t stream_set(num_streams);
+    stream_set.conns[0] = conn;
+
+    /* If the other server opened the connection, it opens the additional streams as
+    soon as it has our routing table. So we must be ready to accept them before we
+    send it. */
+    object_buffer_t<map_insertion_sentry_t<peer_id_t, stream_set_t *> >
+        pending_streams_sentry;
+
     // Just saying: Still on rpc listener thread, for
     // sending/receiving routing table
     parent->assert_thread();
@@ -981,6 +1093,9 @@ void connectivity_cluster_t::run_t::handle(
                                                     &routing_table_to_send)) {
             return;
         }
+        if (successful_join == NULL && num_streams > 1) {
+            pending_streams_sentry.create(&pending_streams, other_id, &stream_set);
+        }
 
         /* We're good to go! Transmit the routing table to the follower, so it
         knows we're in. */
@@ -1014,6 +1129,9 @@ void connectivity_cluster_t::run_t::handle(
                                                     &routing_table_to_send)) {
             return;
         }
+        if (successful_join == NULL && num_streams > 1) {
+            pending_streams_sentry.create(&pending_streams, other_id, &stream_set);
+        }
 
         /* Send our routing table to the leader */
         {
@@ -1055,15 +1173,49 @@ void connectivity_cluster_t::run_t::handle(
         }
     }
 
+    if (num_streams > 1) {
+        if (successful_join != NULL) {
+            for (size_t i = 1; i < num_streams; ++i) {
+                coro_t::spawn_now_dangerously(std::bind(
+                    &connectivity_cluster_t::run_t::open_stream, this,
+                    peer_addr, other_id, i, &stream_set,
+                    auto_drainer_t::lock_t(&stream_set.drainer), drainer_lock));
+            }
+        }
+
+        signal_timer_t timeout;
+        timeout.start(CLUSTER_STREAM_SETUP_TIMEOUT_MS);
+        wait_any_t waiter(&stream_set.all_attached, &stream_set.closing, &timeout,
+                          drainer_lock.get_drain_signal());
+        waiter.wait_lazily_unordered();
+        pending_streams_sentry.reset();
+        if (!stream_set.all_attached.is_pulsed()) {
+            if (timeout.is_pulsed()) {
+                logWRN("Timed out while opening additional connections to %s, closing "
+                       "connection.", peername);
+            }
+            return;
+        }
+    }
+
+    /* Every stream gets a thread of its own, as long as there are enough threads.
+    We could pick a better way to pick a better thread, our choice now is hopefully a
+    performance non-problem. */
+    const int first_thread = rng.randint(get_num_threads());
+    for (size_t i = 0; i < num_streams; ++i) {
+        stream_set.threads[i] = threadnum_t((first_thread + i) % get_num_threads());
+    }
+    threadnum_t chosen_thread = stream_set.threads[0];
+    if (num_streams > 1) {
+        stream_set.threads_chosen.pulse();
+        stream_set.all_rethreaded.wait_lazily_unordered();
+    }
+
     /* Now that we're about to switch threads, it's not safe to try to close
     the connection from this thread anymore. This is safe because we won't do
     anything that permanently blocks before setting up `conn_closer_2`. */
     conn_closer_1.reset();
 
-    // We could pick a better way to pick a better thread, our choice
-    // now is hopefully a performance non-problem.
-    threadnum_t chosen_thread = threadnum_t(rng.randint(get_num_threads()));
-
     cross_thread_signal_t connection_thread_drain_signal(drainer_lock.get_drain_signal(), chosen_thread);
 
     rethread_tcp_conn_stream_t unregister_conn(conn, INVALID_THREAD);
@@ -1079,7 +1231,16 @@ void connectivity_cluster_t::run_t::handle(
         /* `connection_t` is the public interface of this coroutine. Its
         constructor registers it in the `connectivity_cluster_t`'s connection
         map. */
-        connection_t conn_structure(this, other_id, conn, *other_peer_addr.get());
+        connection_t conn_structure(
+            this, other_id, stream_set.conns, *other_peer_addr.get());
+
+        if (num_streams > 1) {
+            /* Let the coroutines that own the other streams start receiving
+            messages. */
+            on_thread_t thread_switcher(stream_set.home_thread());
+            stream_set.connection = &conn_structure;
+            stream_set.established.pulse();
+        }
 
         /* `heartbeat_manager` will periodically send a heartbeat message to
         other servers, and it will also close the connection if we don't
@@ -1089,49 +1250,15 @@ void connectivity_cluster_t::run_t::handle(
             auto_drainer_t::lock_t(conn_structure.drainers.get()),
             peerstr);
 
-        /* Main message-handling loop: read messages off the connection until
-        it's closed, which may be due to network events, or the other end
-        shutting down, or us shutting down. */
-        try {
-            int messages_handled_since_yield = 0;
-            while (true) {
-                message_tag_t tag;
-                archive_result_t res = deserialize_universal(conn, &tag);
-                if (bad(res)) { throw fake_archive_exc_t(); }
-
-                /* Ignore messages tagged with the heartbeat tag. The
-                `keepalive_tcp_conn_stream_t` will have already notified the
-                `heartbeat_manager_t` as soon as the heartbeat arrived. */
-                if (tag != heartbeat_tag) {
-                    cluster_message_handler_t *handler = parent->message_handlers[tag];
-                    guarantee(handler != NULL, "Got a message for an unfamiliar tag. "
-                        "Apparently we aren't compatible with the cluster on the other "
-                        "end.");
-
-                    /* If you really want to support old cluster versions, the
-                    resolved_version should be passed into the on_message() handler. */
-                    guarantee(resolved_version == cluster_version_t::CLUSTER);
-                    handler->on_message(
-                        &conn_structure,
-                        auto_drainer_t::lock_t(conn_structure.drainers.get()),
-                        conn); // might raise fake_archive_exc_t
-                }
+        receive_messages(&conn_structure, conn, resolved_version);
 
-                ++messages_handled_since_yield;
-                if (messages_handled_since_yield >= MESSAGE_HANDLER_MAX_BATCH_SIZE) {
-                    coro_t::yield();
-                    messages_handled_since_yield = 0;
-                }
-            }
-        } catch (const fake_archive_exc_t &) {
-            /* The exception broke us out of the loop, and that's what we
-            wanted. This could either be because we lost contact with the peer
-            or because the cluster is shutting down and `close_conn()` got
-            called. */
-        }
-
-        if (conn->is_read_open()) {
-            logWRN("Received invalid data on a cluster connection. Disconnecting.");
+        if (num_streams > 1) {
+            /* Close the other streams and wait until the coroutines that read from
+            them are done with `conn_structure`. `stream_set`'s destructor lets them
+            go once `conn_structure` is gone. */
+            on_thread_t thread_switcher(stream_set.home_thread());
+            stream_set.closing.pulse_if_not_already_pulsed();
+            stream_set.all_finished.wait_lazily_unordered();
         }
 
         /* The `conn_structure` destructor removes us from the connection map. It also
@@ -1140,6 +1267,164 @@ void connectivity_cluster_t::run_t::handle(
     }
 }
 
+
+void connectivity_cluster_t::run_t::open_stream(
+        ip_and_port_t address,
+        peer_id_t expected_id,
+        size_t index,
+        stream_set_t *stream_set,
+        auto_drainer_t::lock_t stream_set_lock,
+        auto_drainer_t::lock_t drainer_lock) THROWS_NOTHING {
+    parent->assert_thread();
+    const std::string peerstr = address.to_string();
+    wait_any_t interruptor(&stream_set->closing, drainer_lock.get_drain_signal());
+    try {
+        /* `handle()` only asks for additional streams if `cluster_client_port`
+        isn't set, so we let the OS pick the local port. */
+        keepalive_tcp_conn_stream_t conn(address.ip(), address.port().value(),
+                                         &interruptor);
+        cluster_conn_closing_subscription_t conn_closer_1(&conn);
+        conn_closer_1.reset(&interruptor);
+
+        stream_request_t our_stream;
+        our_stream.index = index;
+        our_stream.count = stream_set->conns.size();
+        cluster_version_t resolved_version;
+        peer_id_t other_id;
+        std::set<host_and_port_t> other_peer_addr_hosts;
+        stream_request_t other_stream;
+        if (exchange_handshake(&conn, peerstr.c_str(), our_stream, &resolved_version,
+                               &other_id, &other_peer_addr_hosts, &other_stream)
+                && other_id == expected_id) {
+            conn_closer_1.reset();
+            run_stream(&conn, index, resolved_version, stream_set, stream_set_lock);
+            return;
+        }
+    } catch (const tcp_conn_t::connect_failed_exc_t &) {
+        /* Ignore */
+    } catch (const interrupted_exc_t &) {
+        /* Ignore */
+    }
+
+    /* The connection can't come up without this stream, so there's no point in
+    letting `handle()` wait for the others. */
+    stream_set->closing.pulse_if_not_already_pulsed();
+}
+
+void connectivity_cluster_t::run_t::run_stream(
+        keepalive_tcp_conn_stream_t *conn,
+        size_t index,
+        cluster_version_t resolved_version,
+        stream_set_t *stream_set,
+        const auto_drainer_t::lock_t &stream_set_lock) THROWS_NOTHING {
+    stream_set->assert_thread();
+    guarantee(stream_set->conns[index] == NULL);
+    stream_set->conns[index] = conn;
+    if (++stream_set->num_attached == stream_set->conns.size()) {
+        stream_set->all_attached.pulse();
+    }
+
+    {
+        cluster_conn_closing_subscription_t conn_closer_1(conn);
+        conn_closer_1.reset(&stream_set->closing);
+        wait_any_t waiter(&stream_set->threads_chosen, &stream_set->closing);
+        waiter.wait_lazily_unordered();
+    }
+    /* Once `handle()` has picked the threads, it waits for every stream to get to
+    its thread, so we must move even if the connection is already closing. */
+    if (!stream_set->threads_chosen.is_pulsed()) {
+        return;
+    }
+
+    /* After picking the threads, `handle()` always goes on to create the
+    `connection_t`. */
+    const threadnum_t thread = stream_set->threads[index];
+    cross_thread_signal_t established_on_thread(&stream_set->established, thread);
+    cross_thread_signal_t closing_on_thread(&stream_set->closing, thread);
+
+    rethread_tcp_conn_stream_t unregister_conn(conn, INVALID_THREAD);
+    on_thread_t conn_threader(thread);
+    rethread_tcp_conn_stream_t reregister_conn(conn, get_thread_id());
+
+    cluster_conn_closing_subscription_t conn_closer_2(conn);
+    conn_closer_2.reset(&closing_on_thread);
+
+    {
+        on_thread_t thread_switcher(stream_set->home_thread());
+        if (++stream_set->num_rethreaded == stream_set->conns.size()) {
+            stream_set->all_rethreaded.pulse();
+        }
+    }
+
+    established_on_thread.wait_lazily_unordered();
+
+    /* `handle()` doesn't destroy the `connection_t` before we are done with it. */
+    receive_messages(stream_set->connection, conn, resolved_version);
+
+    /* If this stream went down, the rest of the connection has to go down too. */
+    stream_set->connection->kill_connection();
+
+    {
+        on_thread_t thread_switcher(stream_set->home_thread());
+        if (++stream_set->num_finished == stream_set->conns.size()) {
+            stream_set->all_finished.pulse();
+        }
+
+        /* Senders might use `conn` until the `connection_t` is gone. */
+        stream_set_lock.get_drain_signal()->wait_lazily_unordered();
+    }
+}
+
+void connectivity_cluster_t::run_t::receive_messages(
+        connection_t *connection,
+        keepalive_tcp_conn_stream_t *conn,
+        cluster_version_t resolved_version) THROWS_NOTHING {
+    /* Main message-handling loop: read messages off the connection until
+    it's closed, which may be due to network events, or the other end
+    shutting down, or us shutting down. */
+    try {
+        int messages_handled_since_yield = 0;
+        while (true) {
+            message_tag_t tag;
+            archive_result_t res = deserialize_universal(conn, &tag);
+            if (bad(res)) { throw fake_archive_exc_t(); }
+
+            /* Ignore messages tagged with the heartbeat tag. The
+            `keepalive_tcp_conn_stream_t` will have already notified the
+            `heartbeat_manager_t` as soon as the heartbeat arrived. */
+            if (tag != heartbeat_tag) {
+                cluster_message_handler_t *handler = parent->message_handlers[tag];
+                guarantee(handler != NULL, "Got a message for an unfamiliar tag. "
+                    "Apparently we aren't compatible with the cluster on the other "
+                    "end.");
+
+                /* If you really want to support old cluster versions, the
+                resolved_version should be passed into the on_message() handler. */
+                guarantee(resolved_version == cluster_version_t::CLUSTER);
+                handler->on_message(
+                    connection,
+                    auto_drainer_t::lock_t(connection->drainers.get()),
+                    conn); // might raise fake_archive_exc_t
+            }
+
+            ++messages_handled_since_yield;
+            if (messages_handled_since_yield >= MESSAGE_HANDLER_MAX_BATCH_SIZE) {
+                coro_t::yield();
+                messages_handled_since_yield = 0;
+            }
+        }
+    } catch (const fake_archive_exc_t &) {
+        /* The exception broke us out of the loop, and that's what we
+        wanted. This could either be because we lost contact with the peer
+        or because the cluster is shutting down and `close_conn()` got
+        called. */
+    }
+
+    if (conn->is_read_open()) {
+        logWRN("Received invalid data on a cluster connection. Disconnecting.");
+    }
+}
+
 connectivity_cluster_t::connectivity_cluster_t() THROWS_NOTHING :
     me(peer_id_t(generate_uuid())),
     current_run(NULL),
@@ -1148,6 +1433,7 @@ connectivity_cluster_t::connectivity_cluster_t() THROWS_NOTHING :
 {
     for (int i = 0; i < max_message_tag; i++) {
         message_handlers[i] = NULL;
+        traffic_classes[i] = cluster_traffic_class_t::control;
     }
 }
 
@@ -1229,55 +1515,99 @@ void connectivity_cluster_t::send_message(connection_t *connection,
         message_handlers[tag]->on_local_message(connection, connection_keepalive,
             std::move(buffer_data));
     } else {
-        on_thread_t threader(connection->conn->home_thread());
+        /* Rather than hopping over to the stream's thread and writing the message on
+        our own, we queue it up with the other messages that coroutines on this thread
+        are sending over the same stream. One coroutine writes out everything that is
+        queued at once; see `flush_outbound_queue()`. The message is serialized exactly
+        once, above, and `buffer` stays alive until `written` is pulsed. */
+        cond_t written;
+        connection_t::stream_t *stream = connection->get_stream(traffic_classes[tag]);
+        connection_t::outbound_queue_t *queue = stream->outbound_queues.get();
+        connection_t::outbound_message_t message;
+        message.tag = tag;
+        message.data = &buffer.vector();
+        message.written = &written;
+        queue->messages.push_back(message);
+        if (!queue->flushing) {
+            queue->flushing = true;
+            coro_t::spawn_sometime(std::bind(
+                &connectivity_cluster_t::flush_outbound_queue, this,
+                stream, connection_keepalive));
+        }
+        written.wait_lazily_unordered();
+    }
 
-        /* Acquire the send-mutex so we don't collide with other things trying
-        to send on the same connection. */
-        mutex_t::acq_t acq(&connection->send_mutex);
+    connection->pm_bytes_sent.record(bytes_sent);
+}
+
+void connectivity_cluster_t::flush_outbound_queue(
+        connection_t::stream_t *stream,
+        UNUSED auto_drainer_t::lock_t connection_keepalive) {
+    connection_t::outbound_queue_t *queue = stream->outbound_queues.get();
+    guarantee(queue->flushing);
+    std::vector<connection_t::outbound_message_t> batch;
+    while (!queue->messages.empty()) {
+        /* Whatever gets queued while we are writing out `batch` goes into the next
+        batch. */
+        batch.clear();
+        batch.swap(queue->messages);
 
-        /* Write the tag to the network */
         {
+            on_thread_t threader(stream->conn->home_thread());
+
+            /* Acquire the send-mutex so we don't collide with other threads
+            trying to send on the same stream. */
+            mutex_t::acq_t acq(&stream->send_mutex);
+
+            /* Write the tags and the messages themselves to the network, with one
+            system call and without copying the messages. */
             // All cluster versions use a uint8_t tag here.
-            write_message_t wm;
             static_assert(std::is_same<message_tag_t, uint8_t>::value,
                           "We expect to be serializing a uint8_t -- if this has "
                           "changed, the cluster communication format has changed and "
                           "you need to ask yourself whether live cluster upgrades work."
                           );
-            serialize_universal(&wm, tag);
-            int res = send_write_message(connection->conn, &wm);
-            if (res == -1) {
-                if (connection->conn->is_read_open()) {
-                    connection->conn->shutdown_read();
-                }
-                return;
+            std::vector<iovec> iov;
+            iov.reserve(2 * batch.size());
+            int64_t expected_size = 0;
+            for (const connection_t::outbound_message_t &message : batch) {
+                iovec tag_iov;
+                tag_iov.iov_base = const_cast<message_tag_t *>(&message.tag);
+                tag_iov.iov_len = sizeof(message_tag_t);
+                iov.push_back(tag_iov);
+                iovec data_iov;
+                data_iov.iov_base = const_cast<char *>(message.data->data());
+                data_iov.iov_len = message.data->size();
+                iov.push_back(data_iov);
+                expected_size += sizeof(message_tag_t) + message.data->size();
             }
-        }
 
-        /* Write the message itself to the network */
-        {
-            int64_t res = connection->conn->write(buffer.vector().data(),
-                                                  buffer.vector().size());
+            int64_t res = stream->conn->writev(iov.data(), iov.size());
             if (res == -1) {
-                /* Close the other half of the connection to make sure that
-                   `connectivity_cluster_t::run_t::handle()` notices that something is
-                   up */
-                if (connection->conn->is_read_open()) {
-                    connection->conn->shutdown_read();
+                /* Close the other half of the stream to make sure that the coroutine
+                   that reads from it notices that something is up and takes down
+                   the whole connection */
+                if (stream->conn->is_read_open()) {
+                    stream->conn->shutdown_read();
                 }
-                return;
             } else {
-                guarantee(res == static_cast<int64_t>(buffer.vector().size()));
+                guarantee(res == expected_size);
             }
         }
-    }
 
-    connection->pm_bytes_sent.record(bytes_sent);
+        /* Back on the senders' thread. If the write failed, the messages are lost
+        just like they would be if the connection had gone away a moment earlier. */
+        for (const connection_t::outbound_message_t &message : batch) {
+            message.written->pulse();
+        }
+    }
+    queue->flushing = false;
 }
 
 cluster_message_handler_t::cluster_message_handler_t(
         connectivity_cluster_t *cm,
-        connectivity_cluster_t::message_tag_t t) :
+        connectivity_cluster_t::message_tag_t t,
+        cluster_traffic_class_t traffic_class) :
     connectivity_cluster(cm), tag(t)
 {
     guarantee(!connectivity_cluster->current_run);
@@ -1286,12 +1616,14 @@ cluster_message_handler_t::cluster_message_handler_t(
         connectivity_cluster_t::heartbeat_tag);
     rassert(connectivity_cluster->message_handlers[tag] == NULL);
     connectivity_cluster->message_handlers[tag] = this;
+    connectivity_cluster->traffic_classes[tag] = traffic_class;
 }
 
 cluster_message_handler_t::~cluster_message_handler_t() {
     guarantee(!connectivity_cluster->current_run);
     rassert(connectivity_cluster->message_handlers[tag] == this);
     connectivity_cluster->message_handlers[tag] = NULL;
+    connectivity_cluster->traffic_classes[tag] = cluster_traffic_class_t::control;
 }
 
 void cluster_message_handler_t::on_local_message(
@@ -10,14 +10,17 @@
 
 #include "arch/types.hpp"
 #include "concurrency/auto_drainer.hpp"
+#include "concurrency/cond_var.hpp"
 #include "concurrency/mutex.hpp"
 #include "concurrency/one_per_thread.hpp"
 #include "concurrency/watchable_map.hpp"
 #include "containers/archive/tcp_conn_stream.hpp"
 #include "containers/map_sentries.hpp"
+#include "containers/scoped.hpp"
 #include "perfmon/perfmon.hpp"
 #include "rpc/connectivity/peer_id.hpp"
 #include "utils.hpp"
+#include "version.hpp"
 
 namespace boost {
 template <class> class optional;
@@ -35,6 +38,22 @@ public:
     virtual void write(write_stream_t *stream) = 0;
 };
 
+/* Every message tag belongs to a traffic class, which determines which of the TCP
+connections to a peer carries its messages. This way a large message in one class (say,
+a backfill chunk) doesn't hold up the messages of another class (say, heartbeats) that
+are queued behind it. If there are fewer connections than classes, the last connection
+carries the remaining classes. */
+enum class cluster_traffic_class_t {
+    /* Heartbeats, directory and semilattice metadata */
+    control = 0,
+    /* Mailbox messages: queries, writes and their acknowledgements */
+    replication = 1,
+    /* Mailbox messages that may take a while to get through: backfill chunks and
+    responses to range reads (see `raw_mailbox_t` and
+    `read_t::response_traffic_class()`) */
+    bulk = 2
+};
+
 /* `connectivity_cluster_t` is responsible for establishing connections with other
 servers and communicating with them. It's the foundation of the entire clustering
 system. However, it's very low-level; most code will instead use the directory or mailbox
@@ -44,14 +63,30 @@ Clustering is based around the concept of a "connection", as represented by
 `connectivity_cluster_t::connection_t`. When the `cluster_t::run_t` is constructed, we
 automatically create a `connection_t` to ourself, the "loopback connection". We also
 accept TCP connections on some port. When we get a TCP connection, we perform a
-handshake; if this succeeds, then we create a `connection_t` to represent the new
-connection. Once a connection is established, messages can be sent across it in both
-directions. Every message is guaranteed to eventually arrive unless the connection goes
-down. Messages cannot be duplicated.
-
-Can messages be reordered? I think the current implementation doesn't ever reorder
-messages, but don't rely on this guarantee. However, some old code may rely on this
-guarantee (I'm not sure) so don't break this property without checking first. */
+handshake; if this succeeds, then the side that opened the TCP connection opens up to
+`CLUSTER_STREAMS_PER_PEER - 1` more, which attach themselves to the first one. Once all
+of them are up, we create a `connection_t` to represent the new connection. Once a
+connection is established, messages can be sent across it in both directions. Every
+message is guaranteed to eventually arrive unless the connection goes down. Messages
+cannot be duplicated.
+
+Can messages be reordered? Messages with the same tag are never reordered, because
+they all travel over the same TCP connection. Messages with different tags can be
+reordered if their tags belong to different traffic classes. Before there were several
+connections nothing was ever reordered, so before you give a tag its own class, check
+that nobody relies on its messages arriving in order with those of other tags. For the
+users we have:
+ - The directory and semilattice managers only rely on the order of their own
+   messages: the directory puts updates in order with a `fifo_enforcer_sink_t`, and the
+   semilattice deltas assume that they arrive in order with the full metadata sent on
+   connect, which has the same tag.
+ - The mailbox manager hands each message to its own coroutine, which may switch
+   threads before it runs the mailbox's callback, so even mailbox messages with the
+   same tag could already overtake each other. Code that needs mailbox messages in
+   order (writes, backfill chunks) puts them in order with a `fifo_enforcer_t`.
+ - Nobody waits for a message of one tag before acting on a message of another. For
+   example, mailbox addresses that show up in the directory belong to mailboxes that
+   existed before they were published. */
 
 class connectivity_cluster_t :
     public home_thread_mixin_debug_only_t
@@ -101,7 +136,7 @@ public:
 
         /* Returns `true` if this is the loopback connection */
         bool is_loopback() {
-            return conn == NULL;
+            return streams.size() == 0;
         }
 
         /* Drops the connection. */
@@ -111,21 +146,51 @@ public:
         friend class connectivity_cluster_t;
 
         /* The constructor registers us in every thread's `connections` map, thereby
-        notifying event subscribers. */
-        connection_t(run_t *, peer_id_t, keepalive_tcp_conn_stream_t *,
+        notifying event subscribers. `conns` holds the TCP connections to the peer,
+        starting with the one that carries `cluster_traffic_class_t::control`. Each of
+        them must already be on the thread it's going to stay on. `conns` is empty for
+        the loopback connection. */
+        connection_t(run_t *, peer_id_t,
+                const std::vector<keepalive_tcp_conn_stream_t *> &conns,
                 const peer_address_t &peer) THROWS_NOTHING;
         ~connection_t() THROWS_NOTHING;
 
-        /* NULL for the loopback connection (i.e. our "connection" to ourself) */
-        keepalive_tcp_conn_stream_t *conn;
-
         /* `connection_t` contains the addresses so that we can call
         `get_peers_list()` on any thread. Otherwise, we would have to go
         cross-thread to access the routing table. */
         peer_address_t peer_address;
 
-        /* Unused for our connection to ourself */
-        mutex_t send_mutex;
+        /* Messages that coroutines on one thread are waiting to send over one of the
+        TCP connections. Each queue is only ever accessed on its own thread, so it needs
+        no locking. The first message that finds its queue idle spawns a coroutine that
+        carries everything queued by then over to the TCP connection's thread in a
+        single hop and writes it with a single `writev()`; it keeps doing that until the
+        queue is empty. */
+        struct outbound_message_t {
+            message_tag_t tag;
+            const std::vector<char> *data;
+            cond_t *written;
+        };
+        struct outbound_queue_t {
+            outbound_queue_t() : flushing(false) { }
+            std::vector<outbound_message_t> messages;
+            bool flushing;
+        };
+
+        /* One of the TCP connections to the peer. */
+        struct stream_t {
+            keepalive_tcp_conn_stream_t *conn;
+            mutex_t send_mutex;
+            one_per_thread_t<outbound_queue_t> outbound_queues;
+        };
+
+        /* Returns the stream that carries messages of the given class. */
+        stream_t *get_stream(cluster_traffic_class_t traffic_class);
+
+        /* Empty for our connection to ourself. `streams[0]` carries the heartbeats, so
+        it's the one that `kill_connection()` closes; the coroutine that reads from it
+        then closes the others. */
+        scoped_array_t<stream_t> streams;
 
         perfmon_collection_t pm_collection;
         perfmon_sampler_t pm_bytes_sent;
@@ -186,6 +251,42 @@ public:
             DISABLE_COPYING(variable_setter_t);
         };
 
+        /* What each side of a TCP connection tells the other about which stream it is.
+        The side that opened the connection sets `index` to the stream's position in
+        `connection_t::streams`; the other side always sends zero. `count` is the number
+        of streams the sender is willing to use. */
+        struct stream_request_t {
+            uint64_t index;
+            uint64_t count;
+        };
+
+        /* `stream_set_t` coordinates the coroutines that own the streams of one
+        connection. It lives in the `handle()` call for the first stream; the coroutines
+        that own the other streams hold locks on its `drainer`. `handle()` only starts
+        draining it after it has destroyed the `connection_t`, because until then
+        senders might still be using the other streams. It's only accessed on the
+        `run_t`'s thread. */
+        class stream_set_t : public home_thread_mixin_t {
+        public:
+            explicit stream_set_t(size_t num_streams);
+            ~stream_set_t();
+
+            std::vector<keepalive_tcp_conn_stream_t *> conns;
+            std::vector<threadnum_t> threads;
+            size_t num_attached, num_rethreaded, num_finished;
+
+            /* Pulsed by the coroutines that own the streams. `all_finished` means that
+            they are done receiving messages. */
+            cond_t all_attached, all_rethreaded, all_finished;
+
+            /* Pulsed by `handle()` once it has picked `threads`, once it has created
+            `connection`, and when the connection is over (or failed to come up). */
+            cond_t threads_chosen, established, closing;
+            connection_t *connection;
+
+            auto_drainer_t drainer;
+        };
+
         void on_new_connection(const scoped_ptr_t<tcp_conn_descriptor_t> &nconn,
                 auto_drainer_t::lock_t lock) THROWS_NOTHING;
 
@@ -216,13 +317,49 @@ public:
         It handles the handshake, exchanging node maps, sending out the
         connect-notification, receiving messages from the peer until it
         disconnects or we are shut down, and sending out the
-        disconnect-notification. */
+        disconnect-notification. If the other server opened `c` as an additional
+        stream for an existing connection, `handle()` passes it on to
+        `run_stream()`. */
         void handle(keepalive_tcp_conn_stream_t *c,
             boost::optional<peer_id_t> expected_id,
             boost::optional<peer_address_t> expected_address,
             auto_drainer_t::lock_t,
             bool *successful_join) THROWS_NOTHING;
 
+        /* Sends our side of the handshake and checks the other side's. Returns `false`
+        if the connection should be closed. */
+        bool exchange_handshake(keepalive_tcp_conn_stream_t *conn,
+                                const char *peername,
+                                const stream_request_t &our_stream,
+                                cluster_version_t *resolved_version_out,
+                                peer_id_t *other_id_out,
+                                std::set<host_and_port_t> *other_peer_addr_hosts_out,
+                                stream_request_t *other_stream_out);
+
+        /* `open_stream()` is spawned by `handle()` for each additional stream when we
+        are the side that opened the connection. */
+        void open_stream(ip_and_port_t address,
+                         peer_id_t expected_id,
+                         size_t index,
+                         stream_set_t *stream_set,
+                         auto_drainer_t::lock_t stream_set_lock,
+                         auto_drainer_t::lock_t drainer_lock) THROWS_NOTHING;
+
+        /* Adds an additional stream to `stream_set`, moves it to the thread that
+        `handle()` picks for it and then reads messages off of it until the
+        connection goes down. */
+        void run_stream(keepalive_tcp_conn_stream_t *conn,
+                        size_t index,
+                        cluster_version_t resolved_version,
+                        stream_set_t *stream_set,
+                        const auto_drainer_t::lock_t &stream_set_lock) THROWS_NOTHING;
+
+        /* Passes the messages that arrive on `conn` to the message handlers until
+        `conn` is closed. */
+        void receive_messages(connection_t *connection,
+                              keepalive_tcp_conn_stream_t *conn,
+                              cluster_version_t resolved_version) THROWS_NOTHING;
+
         connectivity_cluster_t *parent;
 
         /* `attempt_table` is a table of all the host:port pairs we're currently
@@ -240,6 +377,10 @@ public:
         `parent->thread_info.get()->connection_map`. */
         std::map<peer_id_t, peer_address_t> routing_table;
 
+        /* `pending_streams` has an entry for each connection that another server has
+        opened to us and that is still waiting for its additional streams. */
+        std::map<peer_id_t, stream_set_t *> pending_streams;
+
         /* Writes to `routing_table` are protected by this mutex so we never get
         redundant connections to the same peer. */
         mutex_t new_connection_mutex;
@@ -292,6 +433,11 @@ private:
 
     class heartbeat_manager_t;
 
+    /* Writes out the calling thread's `outbound_queues` entry of `stream` until it is
+    empty. */
+    void flush_outbound_queue(connection_t::stream_t *stream,
+                              auto_drainer_t::lock_t connection_keepalive);
+
     /* `me` is our `peer_id_t`. */
     const peer_id_t me;
 
@@ -306,6 +452,7 @@ private:
     one_per_thread_t<watchable_map_var_t<peer_id_t, connection_pair_t> > connections;
 
     cluster_message_handler_t *message_handlers[max_message_tag];
+    cluster_traffic_class_t traffic_classes[max_message_tag];
 
 #ifndef NDEBUG
     rng_t debug_rng;
@@ -331,9 +478,12 @@ public:
     connectivity_cluster_t::message_tag_t get_message_tag() { return tag; }
 
 protected:
-    /* Registers the message handler with the cluster */
+    /* Registers the message handler with the cluster. Messages with this tag are
+    sent over the connection for `traffic_class`. */
     cluster_message_handler_t(connectivity_cluster_t *connectivity_cluster,
-                              connectivity_cluster_t::message_tag_t tag);
+                              connectivity_cluster_t::message_tag_t tag,
+                              cluster_traffic_class_t traffic_class =
+                                  cluster_traffic_class_t::control);
     virtual ~cluster_message_handler_t();
 
     /* This can be called on any thread. */
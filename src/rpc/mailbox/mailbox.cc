@@ -15,10 +15,12 @@
 /* raw_mailbox_t */
 
 raw_mailbox_t::address_t::address_t() :
-    peer(peer_id_t()), thread(-1), mailbox_id(0) { }
+    peer(peer_id_t()), thread(-1), mailbox_id(0),
+    traffic_class(cluster_traffic_class_t::replication) { }
 
 raw_mailbox_t::address_t::address_t(const address_t &a) :
-    peer(a.peer), thread(a.thread), mailbox_id(a.mailbox_id) { }
+    peer(a.peer), thread(a.thread), mailbox_id(a.mailbox_id),
+    traffic_class(a.traffic_class) { }
 
 bool raw_mailbox_t::address_t::is_nil() const {
     return peer.is_nil();
@@ -33,11 +35,16 @@ std::string raw_mailbox_t::address_t::human_readable() const {
     return strprintf("%s:%d:%" PRIu64, uuid_to_str(peer.get_uuid()).c_str(), thread, mailbox_id);
 }
 
-raw_mailbox_t::raw_mailbox_t(mailbox_manager_t *m, mailbox_read_callback_t *_callback) :
+raw_mailbox_t::raw_mailbox_t(mailbox_manager_t *m, mailbox_read_callback_t *_callback,
+                             cluster_traffic_class_t _traffic_class) :
     manager(m),
     mailbox_id(manager->register_mailbox(this)),
+    traffic_class(_traffic_class),
     callback(_callback) {
     guarantee(callback != nullptr);
+    guarantee(traffic_class == cluster_traffic_class_t::replication
+              || traffic_class == cluster_traffic_class_t::bulk,
+              "Mailbox messages can only travel in the replication or bulk class.");
 }
 
 raw_mailbox_t::~raw_mailbox_t() {
@@ -60,6 +67,7 @@ raw_mailbox_t::address_t raw_mailbox_t::get_address() const {
     a.peer = manager->get_connectivity_cluster()->get_me();
     a.thread = home_thread().threadnum;
     a.mailbox_id = mailbox_id;
+    a.traffic_class = traffic_class;
     return a;
 }
 
@@ -109,7 +117,9 @@ void send(mailbox_manager_t *src, raw_mailbox_t::address_t dest,
         mailbox_write_callback_t *callback) {
     guarantee(src);
     guarantee(!dest.is_nil());
-    new_semaphore_acq_t acq(src->semaphores.get(), 1);
+    const bool bulk = dest.traffic_class == cluster_traffic_class_t::bulk;
+    new_semaphore_acq_t acq(
+        bulk ? src->bulk_semaphores.get() : src->semaphores.get(), 1);
     acq.acquisition_signal()->wait();
     connectivity_cluster_t::connection_t *connection;
     auto_drainer_t::lock_t connection_keepalive;
@@ -119,17 +129,44 @@ void send(mailbox_manager_t *src, raw_mailbox_t::address_t dest,
     }
     raw_mailbox_writer_t writer(dest.thread, dest.mailbox_id, callback);
     src->get_connectivity_cluster()->send_message(connection, connection_keepalive,
-        src->get_message_tag(), &writer);
+        bulk ? src->bulk_message_handler.get_message_tag() : src->get_message_tag(),
+        &writer);
 }
 
 static const int MAX_OUTSTANDING_MAILBOX_WRITES_PER_THREAD = 4;
 
 mailbox_manager_t::mailbox_manager_t(connectivity_cluster_t *connectivity_cluster,
+        connectivity_cluster_t::message_tag_t message_tag,
+        connectivity_cluster_t::message_tag_t bulk_message_tag) :
+    cluster_message_handler_t(connectivity_cluster, message_tag,
+                              cluster_traffic_class_t::replication),
+    bulk_message_handler(this, bulk_message_tag),
+    semaphores(MAX_OUTSTANDING_MAILBOX_WRITES_PER_THREAD),
+    bulk_semaphores(MAX_OUTSTANDING_MAILBOX_WRITES_PER_THREAD)
+    { }
+
+mailbox_manager_t::bulk_message_handler_t::bulk_message_handler_t(
+        mailbox_manager_t *_parent,
         connectivity_cluster_t::message_tag_t message_tag) :
-    cluster_message_handler_t(connectivity_cluster, message_tag),
-    semaphores(MAX_OUTSTANDING_MAILBOX_WRITES_PER_THREAD)
+    cluster_message_handler_t(_parent->get_connectivity_cluster(), message_tag,
+                              cluster_traffic_class_t::bulk),
+    parent(_parent)
     { }
 
+void mailbox_manager_t::bulk_message_handler_t::on_message(
+        connectivity_cluster_t::connection_t *connection,
+        auto_drainer_t::lock_t connection_keepalive,
+        read_stream_t *stream) {
+    parent->on_message(connection, connection_keepalive, stream);
+}
+
+void mailbox_manager_t::bulk_message_handler_t::on_local_message(
+        connectivity_cluster_t::connection_t *connection,
+        auto_drainer_t::lock_t connection_keepalive,
+        std::vector<char> &&data) {
+    parent->on_local_message(connection, connection_keepalive, std::move(data));
+}
+
 mailbox_manager_t::mailbox_table_t::mailbox_table_t() {
     next_mailbox_id = (UINT64_MAX / get_num_threads()) * get_thread_id().threadnum;
 }
@@ -15,6 +15,10 @@
 
 class mailbox_manager_t;
 
+ARCHIVE_PRIM_MAKE_RANGED_SERIALIZABLE(cluster_traffic_class_t, int8_t,
+                                      cluster_traffic_class_t::control,
+                                      cluster_traffic_class_t::bulk);
+
 /* `mailbox_t` is a receiver of messages. Construct it with a callback function
 to handle messages it receives. To send messages to the mailbox, call the
 `get_address()` method and then call `send()` on the address it returns. */
@@ -56,6 +60,8 @@ private:
 
     const id_t mailbox_id;
 
+    const cluster_traffic_class_t traffic_class;
+
     /* `callback` will be set to `nullptr` after `begin_shutdown()` is called. This is
     both a way of ensuring that no new callbacks are spawned and of making sure that
     the destructor won't call `begin_shutdown()` again. */
@@ -92,7 +98,7 @@ public:
 
         RDB_MAKE_ME_EQUALITY_COMPARABLE_3(raw_mailbox_t::address_t, peer, thread, mailbox_id);
 
-        RDB_MAKE_ME_SERIALIZABLE_3(address_t, peer, thread, mailbox_id);
+        RDB_MAKE_ME_SERIALIZABLE_4(address_t, peer, thread, mailbox_id, traffic_class);
 
     private:
         friend void send(mailbox_manager_t *, raw_mailbox_t::address_t, mailbox_write_callback_t *callback);
@@ -107,9 +113,19 @@ public:
 
         /* The ID of the mailbox */
         id_t mailbox_id;
+
+        /* The traffic class that messages to the mailbox travel in */
+        cluster_traffic_class_t traffic_class;
     };
 
-    raw_mailbox_t(mailbox_manager_t *, mailbox_read_callback_t *callback);
+    /* Messages to the mailbox travel in `traffic_class`, which must be either
+    `replication` or `bulk`. Mailboxes that receive large messages, like backfill chunks
+    and range read responses, should use `bulk` so they don't hold up everything else.
+    Small, latency-sensitive replies like point read responses stay in `replication`,
+    or they would queue up behind the large messages. */
+    raw_mailbox_t(mailbox_manager_t *, mailbox_read_callback_t *callback,
+                  cluster_traffic_class_t traffic_class =
+                      cluster_traffic_class_t::replication);
 
     /* Note that `~raw_mailbox_t()` will block until all of the callbacks have finished
     running. */
@@ -131,12 +147,15 @@ void send(mailbox_manager_t *src,
           mailbox_write_callback_t *callback);
 
 /* `mailbox_manager_t` is a `cluster_message_handler_t` that takes care
-of actually routing messages to mailboxes. */
+of actually routing messages to mailboxes. Messages to `replication` mailboxes use
+`message_tag`; messages to `bulk` mailboxes use `bulk_message_tag`, because the traffic
+class belongs to the tag. */
 
 class mailbox_manager_t : public cluster_message_handler_t {
 public:
     mailbox_manager_t(connectivity_cluster_t *connectivity_cluster,
-                      connectivity_cluster_t::message_tag_t message_tag);
+                      connectivity_cluster_t::message_tag_t message_tag,
+                      connectivity_cluster_t::message_tag_t bulk_message_tag);
 
 private:
     friend struct raw_mailbox_t;
@@ -152,10 +171,28 @@ private:
     };
     one_per_thread_t<mailbox_table_t> mailbox_tables;
 
+    /* Hands the messages for `bulk` mailboxes to the `mailbox_manager_t`. */
+    class bulk_message_handler_t : public cluster_message_handler_t {
+    public:
+        bulk_message_handler_t(mailbox_manager_t *parent,
+                               connectivity_cluster_t::message_tag_t message_tag);
+    private:
+        void on_message(connectivity_cluster_t::connection_t *connection,
+                        auto_drainer_t::lock_t connection_keepalive,
+                        read_stream_t *stream);
+        void on_local_message(connectivity_cluster_t::connection_t *connection,
+                              auto_drainer_t::lock_t connection_keepalive,
+                              std::vector<char> &&data);
+        mailbox_manager_t *parent;
+    };
+    bulk_message_handler_t bulk_message_handler;
+
     /* We must acquire one of these semaphores whenever we want to send a message over a
     mailbox. This prevents mailbox messages from starving directory and semilattice
-    messages. */
+    messages. `bulk` mailboxes have their own, so that a slow backfill doesn't take up
+    the slots of the queries. */
     one_per_thread_t<new_semaphore_t> semaphores;
+    one_per_thread_t<new_semaphore_t> bulk_semaphores;
 
     raw_mailbox_t::id_t generate_mailbox_id();
 
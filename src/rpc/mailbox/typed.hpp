@@ -102,8 +102,10 @@ public:
     typedef mailbox_addr_t< void() > address_t;
 
     mailbox_t(mailbox_manager_t *manager,
-              const std::function< void(signal_t *)> &f) :
-        reader(this), fun(f), mailbox(manager, &reader)
+              const std::function< void(signal_t *)> &f,
+              cluster_traffic_class_t traffic_class =
+                  cluster_traffic_class_t::replication) :
+        reader(this), fun(f), mailbox(manager, &reader, traffic_class)
         { }
 
     void begin_shutdown() {
@@ -165,8 +167,10 @@ public:
     typedef mailbox_addr_t< void(arg0_t) > address_t;
 
     mailbox_t(mailbox_manager_t *manager,
-              const std::function< void(signal_t *, arg0_t)> &f) :
-        reader(this), fun(f), mailbox(manager, &reader)
+              const std::function< void(signal_t *, arg0_t)> &f,
+              cluster_traffic_class_t traffic_class =
+                  cluster_traffic_class_t::replication) :
+        reader(this), fun(f), mailbox(manager, &reader, traffic_class)
         { }
 
     void begin_shutdown() {
@@ -235,8 +239,10 @@ public:
     typedef mailbox_addr_t< void(arg0_t, arg1_t) > address_t;
 
     mailbox_t(mailbox_manager_t *manager,
-              const std::function< void(signal_t *, arg0_t, arg1_t)> &f) :
-        reader(this), fun(f), mailbox(manager, &reader)
+              const std::function< void(signal_t *, arg0_t, arg1_t)> &f,
+              cluster_traffic_class_t traffic_class =
+                  cluster_traffic_class_t::replication) :
+        reader(this), fun(f), mailbox(manager, &reader, traffic_class)
         { }
 
     void begin_shutdown() {
@@ -310,8 +316,10 @@ public:
     typedef mailbox_addr_t< void(arg0_t, arg1_t, arg2_t) > address_t;
 
     mailbox_t(mailbox_manager_t *manager,
-              const std::function< void(signal_t *, arg0_t, arg1_t, arg2_t)> &f) :
-        reader(this), fun(f), mailbox(manager, &reader)
+              const std::function< void(signal_t *, arg0_t, arg1_t, arg2_t)> &f,
+              cluster_traffic_class_t traffic_class =
+                  cluster_traffic_class_t::replication) :
+        reader(this), fun(f), mailbox(manager, &reader, traffic_class)
         { }
 
     void begin_shutdown() {
@@ -390,8 +398,10 @@ public:
     typedef mailbox_addr_t< void(arg0_t, arg1_t, arg2_t, arg3_t) > address_t;
 
     mailbox_t(mailbox_manager_t *manager,
-              const std::function< void(signal_t *, arg0_t, arg1_t, arg2_t, arg3_t)> &f) :
-        reader(this), fun(f), mailbox(manager, &reader)
+              const std::function< void(signal_t *, arg0_t, arg1_t, arg2_t, arg3_t)> &f,
+              cluster_traffic_class_t traffic_class =
+                  cluster_traffic_class_t::replication) :
+        reader(this), fun(f), mailbox(manager, &reader, traffic_class)
         { }
 
     void begin_shutdown() {
@@ -475,8 +485,10 @@ public:
     typedef mailbox_addr_t< void(arg0_t, arg1_t, arg2_t, arg3_t, arg4_t) > address_t;
 
     mailbox_t(mailbox_manager_t *manager,
-              const std::function< void(signal_t *, arg0_t, arg1_t, arg2_t, arg3_t, arg4_t)> &f) :
-        reader(this), fun(f), mailbox(manager, &reader)
+              const std::function< void(signal_t *, arg0_t, arg1_t, arg2_t, arg3_t, arg4_t)> &f,
+              cluster_traffic_class_t traffic_class =
+                  cluster_traffic_class_t::replication) :
+        reader(this), fun(f), mailbox(manager, &reader, traffic_class)
         { }
 
     void begin_shutdown() {
@@ -565,8 +577,10 @@ public:
     typedef mailbox_addr_t< void(arg0_t, arg1_t, arg2_t, arg3_t, arg4_t, arg5_t) > address_t;
 
     mailbox_t(mailbox_manager_t *manager,
-              const std::function< void(signal_t *, arg0_t, arg1_t, arg2_t, arg3_t, arg4_t, arg5_t)> &f) :
-        reader(this), fun(f), mailbox(manager, &reader)
+              const std::function< void(signal_t *, arg0_t, arg1_t, arg2_t, arg3_t, arg4_t, arg5_t)> &f,
+              cluster_traffic_class_t traffic_class =
+                  cluster_traffic_class_t::replication) :
+        reader(this), fun(f), mailbox(manager, &reader, traffic_class)
         { }
 
     void begin_shutdown() {
@@ -660,8 +674,10 @@ public:
     typedef mailbox_addr_t< void(arg0_t, arg1_t, arg2_t, arg3_t, arg4_t, arg5_t, arg6_t) > address_t;
 
     mailbox_t(mailbox_manager_t *manager,
-              const std::function< void(signal_t *, arg0_t, arg1_t, arg2_t, arg3_t, arg4_t, arg5_t, arg6_t)> &f) :
-        reader(this), fun(f), mailbox(manager, &reader)
+              const std::function< void(signal_t *, arg0_t, arg1_t, arg2_t, arg3_t, arg4_t, arg5_t, arg6_t)> &f,
+              cluster_traffic_class_t traffic_class =
+                  cluster_traffic_class_t::replication) :
+        reader(this), fun(f), mailbox(manager, &reader, traffic_class)
         { }
 
     void begin_shutdown() {
@@ -760,8 +776,10 @@ public:
     typedef mailbox_addr_t< void(arg0_t, arg1_t, arg2_t, arg3_t, arg4_t, arg5_t, arg6_t, arg7_t) > address_t;
 
     mailbox_t(mailbox_manager_t *manager,
-              const std::function< void(signal_t *, arg0_t, arg1_t, arg2_t, arg3_t, arg4_t, arg5_t, arg6_t, arg7_t)> &f) :
-        reader(this), fun(f), mailbox(manager, &reader)
+              const std::function< void(signal_t *, arg0_t, arg1_t, arg2_t, arg3_t, arg4_t, arg5_t, arg6_t, arg7_t)> &f,
+              cluster_traffic_class_t traffic_class =
+                  cluster_traffic_class_t::replication) :
+        reader(this), fun(f), mailbox(manager, &reader, traffic_class)
         { }
 
     void begin_shutdown() {
@@ -865,8 +883,10 @@ public:
     typedef mailbox_addr_t< void(arg0_t, arg1_t, arg2_t, arg3_t, arg4_t, arg5_t, arg6_t, arg7_t, arg8_t) > address_t;
 
     mailbox_t(mailbox_manager_t *manager,
-              const std::function< void(signal_t *, arg0_t, arg1_t, arg2_t, arg3_t, arg4_t, arg5_t, arg6_t, arg7_t, arg8_t)> &f) :
-        reader(this), fun(f), mailbox(manager, &reader)
+              const std::function< void(signal_t *, arg0_t, arg1_t, arg2_t, arg3_t, arg4_t, arg5_t, arg6_t, arg7_t, arg8_t)> &f,
+              cluster_traffic_class_t traffic_class =
+                  cluster_traffic_class_t::replication) :
+        reader(this), fun(f), mailbox(manager, &reader, traffic_class)
         { }
 
     void begin_shutdown() {
@@ -975,8 +995,10 @@ public:
     typedef mailbox_addr_t< void(arg0_t, arg1_t, arg2_t, arg3_t, arg4_t, arg5_t, arg6_t, arg7_t, arg8_t, arg9_t) > address_t;
 
     mailbox_t(mailbox_manager_t *manager,
-              const std::function< void(signal_t *, arg0_t, arg1_t, arg2_t, arg3_t, arg4_t, arg5_t, arg6_t, arg7_t, arg8_t, arg9_t)> &f) :
-        reader(this), fun(f), mailbox(manager, &reader)
+              const std::function< void(signal_t *, arg0_t, arg1_t, arg2_t, arg3_t, arg4_t, arg5_t, arg6_t, arg7_t, arg8_t, arg9_t)> &f,
+              cluster_traffic_class_t traffic_class =
+                  cluster_traffic_class_t::replication) :
+        reader(this), fun(f), mailbox(manager, &reader, traffic_class)
         { }
 
     void begin_shutdown() {
@@ -1090,8 +1112,10 @@ public:
     typedef mailbox_addr_t< void(arg0_t, arg1_t, arg2_t, arg3_t, arg4_t, arg5_t, arg6_t, arg7_t, arg8_t, arg9_t, arg10_t) > address_t;
 
     mailbox_t(mailbox_manager_t *manager,
-              const std::function< void(signal_t *, arg0_t, arg1_t, arg2_t, arg3_t, arg4_t, arg5_t, arg6_t, arg7_t, arg8_t, arg9_t, arg10_t)> &f) :
-        reader(this), fun(f), mailbox(manager, &reader)
+              const std::function< void(signal_t *, arg0_t, arg1_t, arg2_t, arg3_t, arg4_t, arg5_t, arg6_t, arg7_t, arg8_t, arg9_t, arg10_t)> &f,
+              cluster_traffic_class_t traffic_class =
+                  cluster_traffic_class_t::replication) :
+        reader(this), fun(f), mailbox(manager, &reader, traffic_class)
         { }
 
     void begin_shutdown() {
@@ -1210,8 +1234,10 @@ public:
     typedef mailbox_addr_t< void(arg0_t, arg1_t, arg2_t, arg3_t, arg4_t, arg5_t, arg6_t, arg7_t, arg8_t, arg9_t, arg10_t, arg11_t) > address_t;
 
     mailbox_t(mailbox_manager_t *manager,
-              const std::function< void(signal_t *, arg0_t, arg1_t, arg2_t, arg3_t, arg4_t, arg5_t, arg6_t, arg7_t, arg8_t, arg9_t, arg10_t, arg11_t)> &f) :
-        reader(this), fun(f), mailbox(manager, &reader)
+              const std::function< void(signal_t *, arg0_t, arg1_t, arg2_t, arg3_t, arg4_t, arg5_t, arg6_t, arg7_t, arg8_t, arg9_t, arg10_t, arg11_t)> &f,
+              cluster_traffic_class_t traffic_class =
+                  cluster_traffic_class_t::replication) :
+        reader(this), fun(f), mailbox(manager, &reader, traffic_class)
         { }
 
     void begin_shutdown() {
@@ -1335,8 +1361,10 @@ public:
     typedef mailbox_addr_t< void(arg0_t, arg1_t, arg2_t, arg3_t, arg4_t, arg5_t, arg6_t, arg7_t, arg8_t, arg9_t, arg10_t, arg11_t, arg12_t) > address_t;
 
     mailbox_t(mailbox_manager_t *manager,
-              const std::function< void(signal_t *, arg0_t, arg1_t, arg2_t, arg3_t, arg4_t, arg5_t, arg6_t, arg7_t, arg8_t, arg9_t, arg10_t, arg11_t, arg12_t)> &f) :
-        reader(this), fun(f), mailbox(manager, &reader)
+              const std::function< void(signal_t *, arg0_t, arg1_t, arg2_t, arg3_t, arg4_t, arg5_t, arg6_t, arg7_t, arg8_t, arg9_t, arg10_t, arg11_t, arg12_t)> &f,
+              cluster_traffic_class_t traffic_class =
+                  cluster_traffic_class_t::replication) :
+        reader(this), fun(f), mailbox(manager, &reader, traffic_class)
         { }
 
     void begin_shutdown() {
@@ -1465,8 +1493,10 @@ public:
     typedef mailbox_addr_t< void(arg0_t, arg1_t, arg2_t, arg3_t, arg4_t, arg5_t, arg6_t, arg7_t, arg8_t, arg9_t, arg10_t, arg11_t, arg12_t, arg13_t) > address_t;
 
     mailbox_t(mailbox_manager_t *manager,
-              const std::function< void(signal_t *, arg0_t, arg1_t, arg2_t, arg3_t, arg4_t, arg5_t, arg6_t, arg7_t, arg8_t, arg9_t, arg10_t, arg11_t, arg12_t, arg13_t)> &f) :
-        reader(this), fun(f), mailbox(manager, &reader)
+              const std::function< void(signal_t *, arg0_t, arg1_t, arg2_t, arg3_t, arg4_t, arg5_t, arg6_t, arg7_t, arg8_t, arg9_t, arg10_t, arg11_t, arg12_t, arg13_t)> &f,
+              cluster_traffic_class_t traffic_class =
+                  cluster_traffic_class_t::replication) :
+        reader(this), fun(f), mailbox(manager, &reader, traffic_class)
         { }
 
     void begin_shutdown() {
@@ -21,6 +21,29 @@ void semilattice_join(std::map<key_t, value_t> *a, const std::map<key_t, value_t
     }
 }
 
+/* `semilattice_map_delta(a, b)` returns the entries of `b` that are missing from `a`
+or different from the corresponding entry in `a`. If `a` is less than or equal to
+`b`, joining the result into `a` gives `b`. This is used to build deltas of
+metadata that consists of maps. */
+template<class key_t, class value_t>
+std::map<key_t, value_t> semilattice_map_delta(const std::map<key_t, value_t> &a,
+                                               const std::map<key_t, value_t> &b) {
+    std::map<key_t, value_t> delta;
+    typename std::map<key_t, value_t>::const_iterator it_a = a.begin();
+    for (typename std::map<key_t, value_t>::const_iterator it_b = b.begin();
+         it_b != b.end();
+         ++it_b) {
+        while (it_a != a.end() && it_a->first < it_b->first) {
+            ++it_a;
+        }
+        if (it_a == a.end() || it_b->first < it_a->first
+            || !(it_a->second == it_b->second)) {
+            delta.insert(delta.end(), *it_b);
+        }
+    }
+    return delta;
+}
+
 }   /* namespace std */
 
 #endif /* RPC_SEMILATTICE_JOINS_MAP_HPP_ */
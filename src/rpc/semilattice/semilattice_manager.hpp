@@ -29,6 +29,18 @@ constraints:
     such that `metadata_t` is a semilattice and `semilattice_join(a, b)` sets
     `*a` to the semilattice-join of `*a` and `b`.
 
+4. There must exist a function:
+
+        metadata_t semilattice_delta(const metadata_t &old_value,
+                                     const metadata_t &new_value);
+
+    such that joining its result into `old_value` gives `new_value` whenever
+    `old_value` is less than or equal to `new_value`. The result should be as
+    small as the type allows; it's what we send to peers when the metadata
+    changes. Peers get the full metadata once, when they connect, and after that
+    only these deltas. That's enough because messages on a connection arrive in
+    order and a reconnect starts over with the full metadata.
+
 Currently it's not thread-safe at all; all accesses to the metadata must be on
 the home thread of the `semilattice_manager_t`. */
 
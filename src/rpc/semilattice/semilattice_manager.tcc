@@ -68,7 +68,13 @@ void semilattice_manager_t<metadata_t>::root_view_t::join(const metadata_t &adde
     parent->assert_thread();
 
     metadata_version_t new_version = ++parent->metadata_version;
+    metadata_t old_metadata = parent->metadata;
     parent->join_metadata_locally(added_metadata);
+    /* `added_metadata` usually is the whole metadata with one table or database
+    changed, because that's what the views build. Peers only need the part that
+    actually changed. Even if nothing changed, we still send the (empty) delta so
+    that peers learn about `new_version`, which `sync_to()` waits for. */
+    metadata_t delta = semilattice_delta(old_metadata, parent->metadata);
 
     /* Distribute changes to all peers we can currently see. If we can't
     currently see a peer, that's OK; it will hear about the metadata change when
@@ -83,8 +89,8 @@ void semilattice_manager_t<metadata_t>::root_view_t::join(const metadata_t &adde
         coro_t::spawn_sometime(
             [this, parent_keepalive /* important to capture */,
              connection, connection_keepalive /* important to capture */,
-             new_version, added_metadata]() {
-                metadata_writer_t writer(added_metadata, new_version);
+             new_version, delta]() {
+                metadata_writer_t writer(delta, new_version);
                 new_semaphore_acq_t acq(&parent->semaphore, 1);
                 acq.acquisition_signal()->wait();
                 parent->get_connectivity_cluster()->send_message(connection,
@@ -0,0 +1,98 @@
+// Copyright 2010-2015 RethinkDB, all rights reserved.
+#include "serializer/log/block_compression.hpp"
+
+#include <lz4.h>
+
+#include "config/args.hpp"
+#include "math.hpp"
+#include "serializer/buf_ptr.hpp"
+
+namespace {
+
+const size_t COMPRESSED_BLOCK_OVERHEAD
+    = sizeof(ls_buf_data_t) + sizeof(compressed_block_header_t);
+
+}  // namespace
+
+block_id_t stored_block_id(const ser_buffer_t *buf) {
+    return buf->ser_header.block_id & ~COMPRESSED_BLOCK_FLAG;
+}
+
+bool block_is_compressed(const ser_buffer_t *buf) {
+    return (buf->ser_header.block_id & COMPRESSED_BLOCK_FLAG) != 0;
+}
+
+block_size_t stored_block_size(const ser_buffer_t *buf, block_size_t disk_block_size) {
+    if (!block_is_compressed(buf)) {
+        return disk_block_size;
+    }
+    const compressed_block_header_t *header
+        = reinterpret_cast<const compressed_block_header_t *>(buf->cache_data);
+    return block_size_t::unsafe_make(header->ser_block_size);
+}
+
+bool compress_block(block_compression_t compression,
+                    const ser_buffer_t *buf, block_size_t block_size,
+                    block_id_t block_id, buf_ptr_t *out) {
+    if (compression == block_compression_t::none) {
+        return false;
+    }
+    guarantee(compression == block_compression_t::lz4);
+    rassert((block_id & COMPRESSED_BLOCK_FLAG) == 0);
+
+    // Blocks are laid out on disk at DEVICE_BLOCK_SIZE boundaries, so compression
+    // only pays off if it saves at least one DEVICE_BLOCK_SIZE unit.
+    const uint32_t aligned_size = buf_ptr_t::compute_aligned_block_size(block_size);
+    if (aligned_size <= DEVICE_BLOCK_SIZE) {
+        return false;
+    }
+    const uint32_t max_disk_size = aligned_size - DEVICE_BLOCK_SIZE;
+
+    buf_ptr_t compressed
+        = buf_ptr_t::alloc_uninitialized(block_size_t::unsafe_make(max_disk_size));
+    ser_buffer_t *ser_buf = compressed.ser_buffer();
+    compressed_block_header_t *header
+        = reinterpret_cast<compressed_block_header_t *>(ser_buf->cache_data);
+    char *payload = ser_buf->cache_data + sizeof(compressed_block_header_t);
+
+    // LZ4_compress_default returns 0 if the result doesn't fit.
+    const int payload_size = LZ4_compress_default(
+        buf->cache_data, payload, block_size.value(),
+        max_disk_size - COMPRESSED_BLOCK_OVERHEAD);
+    if (payload_size <= 0) {
+        return false;
+    }
+
+    ser_buf->ser_header.block_id = block_id | COMPRESSED_BLOCK_FLAG;
+    header->ser_block_size = block_size.ser_value();
+    header->payload_size = payload_size;
+    compressed.resize_fill_zero(
+        block_size_t::unsafe_make(COMPRESSED_BLOCK_OVERHEAD + payload_size));
+
+    *out = std::move(compressed);
+    return true;
+}
+
+buf_ptr_t decompress_block(const ser_buffer_t *disk_buf, block_size_t disk_block_size) {
+    guarantee(block_is_compressed(disk_buf));
+    guarantee(disk_block_size.ser_value() >= COMPRESSED_BLOCK_OVERHEAD);
+    const compressed_block_header_t *header
+        = reinterpret_cast<const compressed_block_header_t *>(disk_buf->cache_data);
+    guarantee(header->payload_size
+              <= disk_block_size.ser_value() - COMPRESSED_BLOCK_OVERHEAD,
+              "Compressed block %" PR_BLOCK_ID " is corrupted.",
+              stored_block_id(disk_buf));
+
+    const block_size_t block_size = block_size_t::unsafe_make(header->ser_block_size);
+    buf_ptr_t ret = buf_ptr_t::alloc_uninitialized(block_size);
+    ret.ser_buffer()->ser_header.block_id = stored_block_id(disk_buf);
+    const int decompressed_size = LZ4_decompress_safe(
+        disk_buf->cache_data + sizeof(compressed_block_header_t),
+        static_cast<char *>(ret.cache_data()),
+        header->payload_size, block_size.value());
+    guarantee(decompressed_size == static_cast<int>(block_size.value()),
+              "Compressed block %" PR_BLOCK_ID " is corrupted.",
+              stored_block_id(disk_buf));
+    ret.fill_padding_zero();
+    return ret;
+}
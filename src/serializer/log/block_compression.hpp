@@ -0,0 +1,60 @@
+// Copyright 2010-2015 RethinkDB, all rights reserved.
+#ifndef SERIALIZER_LOG_BLOCK_COMPRESSION_HPP_
+#define SERIALIZER_LOG_BLOCK_COMPRESSION_HPP_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "serializer/types.hpp"
+
+class buf_ptr_t;
+
+/* Data blocks can optionally be stored compressed.  Whether new blocks get
+compressed is configured per serializer (see log_serializer_dynamic_config_t).
+Compressed blocks describe themselves, so a serializer can always read them back,
+no matter how it is configured.
+
+A compressed block looks like this on disk:
+
+    [ls_buf_data_t, with COMPRESSED_BLOCK_FLAG set in the block id]
+    [compressed_block_header_t]
+    [the block's cache data, compressed]
+
+The LBA records both the uncompressed size of the block (which is what the cache
+sees) and the number of bytes the block takes up on disk (see lba_entry_t). */
+
+enum class block_compression_t {
+    none,
+    lz4
+};
+
+struct compressed_block_header_t {
+    // The uncompressed ser block size.
+    uint32_t ser_block_size;
+    // The number of bytes of compressed data following this header.
+    uint32_t payload_size;
+} __attribute__((__packed__));
+
+static const block_id_t COMPRESSED_BLOCK_FLAG = static_cast<block_id_t>(1) << 63;
+
+// The block id stored in the block's header, with COMPRESSED_BLOCK_FLAG masked out.
+block_id_t stored_block_id(const ser_buffer_t *buf);
+
+bool block_is_compressed(const ser_buffer_t *buf);
+
+// The size the block will have once it's read back in, given the size it takes up
+// on disk.
+block_size_t stored_block_size(const ser_buffer_t *buf, block_size_t disk_block_size);
+
+// Compresses the cache data of `buf` with `compression` into `*out`, whose block
+// size is then the on-disk size of the block.  Returns false (and leaves `*out`
+// untouched) if compression is disabled or wouldn't make the block take up fewer
+// DEVICE_BLOCK_SIZE-aligned bytes on disk.
+bool compress_block(block_compression_t compression,
+                    const ser_buffer_t *buf, block_size_t block_size,
+                    block_id_t block_id, buf_ptr_t *out);
+
+// Reverses `compress_block`.  `disk_buf` must be a compressed block.
+buf_ptr_t decompress_block(const ser_buffer_t *disk_buf, block_size_t disk_block_size);
+
+#endif  // SERIALIZER_LOG_BLOCK_COMPRESSION_HPP_
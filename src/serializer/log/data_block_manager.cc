@@ -13,6 +13,7 @@
 #include "errors.hpp"
 #include "perfmon/perfmon.hpp"
 #include "serializer/buf_ptr.hpp"
+#include "serializer/log/block_compression.hpp"
 #include "serializer/log/log_serializer.hpp"
 #include "stl_utils.hpp"
 
@@ -626,7 +627,7 @@ public:
                 handled_required_block = true;
             } else {
                 const block_id_t block_id
-                    = reinterpret_cast<const ls_buf_data_t *>(current_buf)->block_id;
+                    = stored_block_id(reinterpret_cast<const ser_buffer_t *>(current_buf));
 
                 const index_block_info_t info
                     = parent->serializer->lba_index->get_block_info(block_id);
@@ -638,15 +639,27 @@ public:
                     continue;
                 }
 
-                const block_size_t block_size = block_size_t::unsafe_make(info.ser_block_size);
-                buf_ptr_t buf = buf_ptr_t::alloc_uninitialized(block_size);
-                memcpy(buf.ser_buffer(), current_buf, info.ser_block_size);
-                buf.fill_padding_zero();
-                guarantee(info.ser_block_size <= *(lower_it + 1) - *lower_it);
+                const block_size_t block_size
+                    = block_size_t::unsafe_make(info.ser_block_size);
+                const block_size_t disk_block_size
+                    = block_size_t::unsafe_make(info.disk_ser_block_size);
+                guarantee(info.disk_ser_block_size <= *(lower_it + 1) - *lower_it);
+                buf_ptr_t buf;
+                if (block_is_compressed(
+                        reinterpret_cast<const ser_buffer_t *>(current_buf))) {
+                    buf = decompress_block(
+                        reinterpret_cast<const ser_buffer_t *>(current_buf),
+                        disk_block_size);
+                } else {
+                    buf = buf_ptr_t::alloc_uninitialized(block_size);
+                    memcpy(buf.ser_buffer(), current_buf, info.ser_block_size);
+                    buf.fill_padding_zero();
+                }
 
                 counted_t<ls_block_token_pointee_t> ls_token
                     = parent->serializer->generate_block_token(current_offset,
-                                                               block_size);
+                                                               block_size,
+                                                               disk_block_size);
 
                 counted_t<standard_block_token_t> token
                     = to_standard_block_token(block_id, std::move(ls_token));
@@ -674,50 +687,83 @@ bool data_block_manager_t::should_perform_read_ahead(int64_t offset) {
 }
 
 buf_ptr_t data_block_manager_t::read(int64_t off_in, block_size_t block_size,
-                                   file_account_t *io_account) {
+                                     block_size_t disk_block_size,
+                                     file_account_t *io_account) {
     guarantee(state == state_ready);
+    buf_ptr_t ret = buf_ptr_t::alloc_uninitialized(disk_block_size);
     if (should_perform_read_ahead(off_in)) {
-        buf_ptr_t ret = buf_ptr_t::alloc_uninitialized(block_size);
-        dbm_read_ahead_t::perform_read_ahead(this, off_in, block_size.ser_value(),
+        dbm_read_ahead_t::perform_read_ahead(this, off_in, disk_block_size.ser_value(),
                                              ret.ser_buffer(), io_account, stats);
         // We have to fill the padding with zero, since only the first part of the
         // buf got memcpy'd into.
         ret.fill_padding_zero();
-        return ret;
     } else {
         if (divides(DEVICE_BLOCK_SIZE, off_in)) {
-            buf_ptr_t ret = buf_ptr_t::alloc_uninitialized(block_size);
             co_read(dbfile, off_in, ret.aligned_block_size(),
                     ret.ser_buffer(), io_account);
             stats->bytes_read(ret.aligned_block_size());
             // Blocks are written DEVICE_BLOCK_SIZE-aligned -- so the block on disk
             // should have been written with zero padding.
             ret.assert_padding_zero();
-            return ret;
         } else {
             int64_t floor_off_in = floor_aligned(off_in, DEVICE_BLOCK_SIZE);
-            int64_t ceil_off_end = ceil_aligned(off_in + block_size.ser_value(),
+            int64_t ceil_off_end = ceil_aligned(off_in + disk_block_size.ser_value(),
                                                 DEVICE_BLOCK_SIZE);
             scoped_malloc_t<char> buf(malloc_aligned(ceil_off_end - floor_off_in,
                                                      DEVICE_BLOCK_SIZE));
             co_read(dbfile, floor_off_in, ceil_off_end - floor_off_in,
                     buf.get(), io_account);
 
-            buf_ptr_t ret = buf_ptr_t::alloc_uninitialized(block_size);
             memcpy(ret.ser_buffer(), buf.get() + (off_in - floor_off_in),
-                   block_size.ser_value());
+                   disk_block_size.ser_value());
             stats->bytes_read(ret.aligned_block_size());
             // We have to fill the padding to zero, in this case.
             ret.fill_padding_zero();
-            return ret;
         }
     }
+
+    if (block_is_compressed(ret.ser_buffer())) {
+        ret = decompress_block(ret.ser_buffer(), disk_block_size);
+    }
+    guarantee(ret.block_size() == block_size);
+    return ret;
 }
 
 std::vector<counted_t<ls_block_token_pointee_t> >
 data_block_manager_t::many_writes(const std::vector<buf_write_info_t> &writes,
                                   file_account_t *io_account,
                                   iocallback_t *cb) {
+    const block_compression_t compression = serializer->dynamic_config.compression;
+
+    std::vector<disk_write_t> disk_writes;
+    disk_writes.reserve(writes.size());
+    std::vector<buf_ptr_t> compressed_bufs;
+    for (auto it = writes.begin(); it != writes.end(); ++it) {
+        it->buf->ser_header.block_id = it->block_id;
+
+        buf_ptr_t compressed;
+        if (compress_block(compression, it->buf, it->block_size, it->block_id,
+                           &compressed)) {
+            ++stats->pm_serializer_compressed_blocks_written;
+            disk_writes.push_back(disk_write_t{compressed.ser_buffer(),
+                                               it->block_size,
+                                               compressed.block_size(),
+                                               compressed.ser_buffer()->ser_header.block_id});
+            compressed_bufs.push_back(std::move(compressed));
+        } else {
+            disk_writes.push_back(disk_write_t{it->buf, it->block_size, it->block_size,
+                                               it->block_id});
+        }
+    }
+
+    return write_to_disk(disk_writes, std::move(compressed_bufs), io_account, cb);
+}
+
+std::vector<counted_t<ls_block_token_pointee_t> >
+data_block_manager_t::write_to_disk(const std::vector<disk_write_t> &writes,
+                                    std::vector<buf_ptr_t> &&compressed_bufs,
+                                    file_account_t *io_account,
+                                    iocallback_t *cb) {
     // These tokens are grouped by extent.  You can do a contiguous write in each
     // extent.
     std::vector<std::vector<counted_t<ls_block_token_pointee_t> > > token_groups
@@ -739,6 +785,9 @@ data_block_manager_t::many_writes(const std::vector<buf_write_info_t> &writes,
 
         size_t ops_remaining;
         iocallback_t *cb;
+        // Compressed copies of the blocks, which must stay around until they have
+        // been written.
+        std::vector<buf_ptr_t> compressed_bufs;
     };
 
     intermediate_cb_t *const intermediate_cb = new intermediate_cb_t;
@@ -746,13 +795,14 @@ data_block_manager_t::many_writes(const std::vector<buf_write_info_t> &writes,
     // intermediate_cb->on_io_complete later.
     intermediate_cb->ops_remaining = token_groups.size() + 1;
     intermediate_cb->cb = cb;
+    intermediate_cb->compressed_bufs = std::move(compressed_bufs);
 
     size_t write_number = 0;
     for (size_t i = 0; i < token_groups.size(); ++i) {
 
         const int64_t front_offset = token_groups[i].front()->offset();
         const int64_t back_offset = token_groups[i].back()->offset()
-            + gc_entry_t::aligned_value(token_groups[i].back()->block_size());
+            + gc_entry_t::aligned_value(token_groups[i].back()->disk_block_size());
 
         guarantee(divides(DEVICE_BLOCK_SIZE, front_offset));
 
@@ -765,14 +815,14 @@ data_block_manager_t::many_writes(const std::vector<buf_write_info_t> &writes,
 
         for (size_t j = 0; j < token_groups[i].size(); ++j) {
             const int64_t j_offset = token_groups[i][j]->offset();
-            const block_size_t j_block_size = token_groups[i][j]->block_size();
+            const block_size_t j_block_size = token_groups[i][j]->disk_block_size();
             guarantee(j_offset == last_written_offset);
             const size_t j_aligned_size = gc_entry_t::aligned_value(j_block_size);
             total_aligned_size += j_aligned_size;
 
             // The behavior of gimme_some_new_offsets is supposed to retain order, so
             // we expect writes[write_number] to have the currently-relevant write.
-            guarantee(writes[write_number].block_size == j_block_size);
+            guarantee(writes[write_number].disk_block_size == j_block_size);
 
             iovecs[j].iov_base = writes[write_number].buf;
             iovecs[j].iov_len = j_aligned_size;
@@ -1199,19 +1249,25 @@ void data_block_manager_t::write_gcs(const std::vector<gc_write_t> &writes,
         // Step 1: Write buffers to disk and assemble index operations
         ASSERT_NO_CORO_WAITING;
 
-        std::vector<buf_write_info_t> the_writes;
+        // The blocks are moved as they are on disk, so compressed blocks stay
+        // compressed.
+        std::vector<disk_write_t> the_writes;
         the_writes.reserve(writes.size());
         for (size_t i = 0; i < writes.size(); ++i) {
+            const block_size_t block_size
+                = stored_block_size(writes[i].buf, writes[i].block_size);
             old_block_tokens.push_back(serializer->generate_block_token(writes[i].old_offset,
+                                                                        block_size,
                                                                         writes[i].block_size));
 
-            the_writes.push_back(buf_write_info_t(writes[i].buf,
-                                                  writes[i].block_size,
-                                                  writes[i].buf->ser_header.block_id));
+            the_writes.push_back(disk_write_t{writes[i].buf,
+                                              block_size,
+                                              writes[i].block_size,
+                                              writes[i].buf->ser_header.block_id});
         }
 
-        new_block_tokens = many_writes(the_writes, choose_gc_io_account(),
-                                       &block_write_cond);
+        new_block_tokens = write_to_disk(the_writes, std::vector<buf_ptr_t>(),
+                                         choose_gc_io_account(), &block_write_cond);
 
         guarantee(new_block_tokens.size() == writes.size());
     }
@@ -1236,7 +1292,7 @@ void data_block_manager_t::write_gcs(const std::vector<gc_write_t> &writes,
                 = gc_state->current_entry->block_index(writes[i].old_offset);
 
             if (gc_state->current_entry->block_referenced_by_index(block_index)) {
-                block_id_t block_id = writes[i].buf->ser_header.block_id;
+                block_id_t block_id = stored_block_id(writes[i].buf);
 
                 index_write_ops.push_back(
                         index_write_op_t(block_id,
@@ -1332,7 +1388,7 @@ void data_block_manager_t::actually_shutdown() {
 }
 
 std::vector<std::vector<counted_t<ls_block_token_pointee_t> > >
-data_block_manager_t::gimme_some_new_offsets(const std::vector<buf_write_info_t> &writes) {
+data_block_manager_t::gimme_some_new_offsets(const std::vector<disk_write_t> &writes) {
     ASSERT_NO_CORO_WAITING;
 
     // Start a new extent if necessary.
@@ -1350,7 +1406,7 @@ data_block_manager_t::gimme_some_new_offsets(const std::vector<buf_write_info_t>
     for (auto it = writes.begin(); it != writes.end(); ++it) {
         uint32_t relative_offset = valgrind_undefined<uint32_t>(UINT32_MAX);
         unsigned int block_index = valgrind_undefined<unsigned int>(UINT_MAX);
-        if (!active_extent->new_offset(it->block_size,
+        if (!active_extent->new_offset(it->disk_block_size,
                                        &relative_offset, &block_index)) {
             // Move the active_extent gc_entry_t to the young extent queue (if it's
             // not already empty), and make a new gc_entry_t.
@@ -1366,7 +1422,7 @@ data_block_manager_t::gimme_some_new_offsets(const std::vector<buf_write_info_t>
             }
 
             ++stats->pm_serializer_data_extents_allocated;
-            const bool succeeded = active_extent->new_offset(it->block_size,
+            const bool succeeded = active_extent->new_offset(it->disk_block_size,
                                                              &relative_offset,
                                                              &block_index);
             guarantee(succeeded);
@@ -1382,7 +1438,8 @@ data_block_manager_t::gimme_some_new_offsets(const std::vector<buf_write_info_t>
         active_extent->was_written = true;
         active_extent->mark_live_tokenwise(block_index);
 
-        tokens.push_back(serializer->generate_block_token(offset, it->block_size));
+        tokens.push_back(serializer->generate_block_token(offset, it->block_size,
+                                                          it->disk_block_size));
     }
 
     if (!tokens.empty()) {
@@ -46,7 +46,7 @@ public:
     void start_existing(file_t *dbfile, data_block_manager::metablock_mixin_t *last_metablock);
 
     buf_ptr_t read(int64_t off_in, block_size_t block_size,
-                 file_account_t *io_account);
+                   block_size_t disk_block_size, file_account_t *io_account);
 
     /* exposed gc api */
     /* mark a buffer as garbage */
@@ -80,14 +80,31 @@ public:
                 file_account_t *io_account,
                 iocallback_t *cb);
 
-    std::vector<std::vector<counted_t<ls_block_token_pointee_t> > >
-    gimme_some_new_offsets(const std::vector<buf_write_info_t> &writes);
-
     bool is_gc_active() const;
 
 private:
     void actually_shutdown();
 
+    /* A block as it is going to be laid out on disk.  `buf` is `disk_block_size`
+    bytes long and is either the block itself or its compressed form, in which case
+    `disk_block_size` is smaller than `block_size`.  `block_id` is the id stored in
+    the block's header, including COMPRESSED_BLOCK_FLAG. */
+    struct disk_write_t {
+        ser_buffer_t *buf;
+        block_size_t block_size;
+        block_size_t disk_block_size;
+        block_id_t block_id;
+    };
+
+    std::vector<counted_t<ls_block_token_pointee_t> >
+    write_to_disk(const std::vector<disk_write_t> &writes,
+                  std::vector<buf_ptr_t> &&compressed_bufs,
+                  file_account_t *io_account,
+                  iocallback_t *cb);
+
+    std::vector<std::vector<counted_t<ls_block_token_pointee_t> > >
+    gimme_some_new_offsets(const std::vector<disk_write_t> &writes);
+
     struct gc_state_t : public intrusive_list_node_t<gc_state_t>{
     public:
         // The entry we're currently GCing.
@@ -101,8 +118,10 @@ private:
     };
 
     struct gc_write_t {
+        // The block as it was read from disk; it might be compressed.
         ser_buffer_t *buf;
         int64_t old_offset;
+        // The number of bytes the block takes up on disk.
         block_size_t block_size;
         gc_write_t(ser_buffer_t *b, int64_t _old_offset,
                    block_size_t _block_size)
@@ -61,7 +61,7 @@ void lba_disk_extent_t::read_step_2(read_info_t *info, in_memory_index_t *index)
         lba_entry_t *e = &extent->entries[i];
         if (!lba_entry_t::is_padding(e)) {
             index->set_block_info(e->block_id, e->recency, e->offset,
-                                  e->ser_block_size);
+                                  e->ser_block_size, e->disk_ser_block_size());
         }
     }
 
@@ -64,12 +64,14 @@ struct lba_entry_t {
     // (It probably assumes that sizeof(lba_entry_t) evenly divides
     // DEVICE_BLOCK_SIZE).
 
-    // Put the zero-padding at the beginning of the LBA entry.  We could use this, or
-    // the first 16 bits, perhaps, as a version flag.
-    uint32_t zero_reserved;
-
-    // This could be a uint16_t if you wanted it to be, as long as block sizes are
-    // all less than or equal to 4K (which is less than 64K).
+    // Zero, unless the block is stored compressed (see block_compression.hpp), in
+    // which case it's the number of bytes the block takes up on disk.  (This used
+    // to be zero padding, so older files read as having no compressed blocks.)
+    uint32_t compressed_ser_block_size;
+
+    // The uncompressed size of the block.  This could be a uint16_t if you wanted
+    // it to be, as long as block sizes are all less than or equal to 4K (which is
+    // less than 64K).
     uint32_t ser_block_size;
 
     block_id_t block_id;
@@ -80,10 +82,13 @@ struct lba_entry_t {
     flagged_off64_t offset;
 
     static lba_entry_t make(block_id_t block_id, repli_timestamp_t recency,
-                            flagged_off64_t offset, uint32_t ser_block_size) {
+                            flagged_off64_t offset, uint32_t ser_block_size,
+                            uint32_t disk_ser_block_size) {
         guarantee(ser_block_size != 0 || !offset.has_value());
+        guarantee(disk_ser_block_size <= ser_block_size);
         lba_entry_t entry;
-        entry.zero_reserved = 0;
+        entry.compressed_ser_block_size
+            = disk_ser_block_size == ser_block_size ? 0 : disk_ser_block_size;
         entry.ser_block_size = ser_block_size;
         entry.block_id = block_id;
         entry.recency = recency;
@@ -91,12 +96,17 @@ struct lba_entry_t {
         return entry;
     }
 
+    // The number of bytes the block takes up on disk.
+    uint32_t disk_ser_block_size() const {
+        return compressed_ser_block_size == 0 ? ser_block_size : compressed_ser_block_size;
+    }
+
     static bool is_padding(const lba_entry_t *entry) {
         return entry->block_id == PADDING_BLOCK_ID  && entry->offset.is_padding();
     }
 
     static lba_entry_t make_padding_entry() {
-        return make(PADDING_BLOCK_ID, repli_timestamp_t::invalid, flagged_off64_t::padding(), 0);
+        return make(PADDING_BLOCK_ID, repli_timestamp_t::invalid, flagged_off64_t::padding(), 0, 0);
     }
 } __attribute__((__packed__));
 
@@ -11,25 +11,33 @@ struct index_block_info_t {
     index_block_info_t()
         : offset(flagged_off64_t::unused()),
           recency(repli_timestamp_t::invalid),
-          ser_block_size(0) { }
+          ser_block_size(0),
+          disk_ser_block_size(0) { }
 
     index_block_info_t(flagged_off64_t _offset,
                        repli_timestamp_t _recency,
-                       uint32_t _ser_block_size)
+                       uint32_t _ser_block_size,
+                       uint32_t _disk_ser_block_size)
         : offset(_offset),
           recency(_recency),
-          ser_block_size(_ser_block_size) { }
+          ser_block_size(_ser_block_size),
+          disk_ser_block_size(_disk_ser_block_size) { }
 
     // For two_level_array_t.
     bool operator==(const index_block_info_t &other) const {
         return offset == other.offset &&
             recency == other.recency &&
-            ser_block_size == other.ser_block_size;
+            ser_block_size == other.ser_block_size &&
+            disk_ser_block_size == other.disk_ser_block_size;
     }
 
     flagged_off64_t offset;
     repli_timestamp_t recency;
+    // The uncompressed size of the block.
     uint32_t ser_block_size;
+    // The number of bytes the block takes up on disk.  Smaller than
+    // `ser_block_size` if the block is stored compressed.
+    uint32_t disk_ser_block_size;
 } __attribute__((__packed__));
 
 
@@ -46,7 +54,8 @@ public:
 
     index_block_info_t get_block_info(block_id_t id);
     void set_block_info(block_id_t id, repli_timestamp_t recency,
-                        flagged_off64_t offset, uint32_t ser_block_size);
+                        flagged_off64_t offset, uint32_t ser_block_size,
+                        uint32_t disk_ser_block_size);
 
 };
 
@@ -105,7 +105,8 @@ public:
                         e->block_id,
                         e->recency,
                         e->offset,
-                        e->ser_block_size);
+                        e->ser_block_size,
+                        e->disk_ser_block_size());
             }
 
             owner->state = lba_list_t::state_ready;
@@ -154,6 +155,10 @@ block_size_t lba_list_t::get_block_size(block_id_t block) {
     return block_size_t::unsafe_make(get_block_info(block).ser_block_size);
 }
 
+block_size_t lba_list_t::get_disk_block_size(block_id_t block) {
+    return block_size_t::unsafe_make(get_block_info(block).disk_ser_block_size);
+}
+
 repli_timestamp_t lba_list_t::get_block_recency(block_id_t block) {
     return get_block_info(block).recency;
 }
@@ -180,10 +185,12 @@ segmented_vector_t<repli_timestamp_t> lba_list_t::get_block_recencies(block_id_t
 
 void lba_list_t::set_block_info(block_id_t block, repli_timestamp_t recency,
                                 flagged_off64_t offset, uint32_t ser_block_size,
+                                uint32_t disk_ser_block_size,
                                 file_account_t *io_account, extent_transaction_t *txn) {
     rassert(state == state_ready || state == state_gc_shutting_down);
 
-    in_memory_index.set_block_info(block, recency, offset, ser_block_size);
+    in_memory_index.set_block_info(block, recency, offset, ser_block_size,
+                                   disk_ser_block_size);
 
     // If the inline LBA is full, free it up first by moving its entries to
     // the LBA extents
@@ -192,7 +199,7 @@ void lba_list_t::set_block_info(block_id_t block, repli_timestamp_t recency,
         rassert(!check_inline_lba_full());
     }
     // Then store the entry inline
-    add_inline_entry(block, recency, offset, ser_block_size);
+    add_inline_entry(block, recency, offset, ser_block_size, disk_ser_block_size);
 }
 
 bool lba_list_t::check_inline_lba_full() const {
@@ -230,6 +237,7 @@ void lba_list_t::move_inline_entries_to_extents(file_account_t *io_account, exte
                 e.recency,
                 e.offset,
                 e.ser_block_size,
+                e.disk_ser_block_size(),
                 io_account,
                 txn);
     }
@@ -238,11 +246,13 @@ void lba_list_t::move_inline_entries_to_extents(file_account_t *io_account, exte
 }
 
 void lba_list_t::add_inline_entry(block_id_t block, repli_timestamp_t recency,
-                                flagged_off64_t offset, uint32_t ser_block_size) {
+                                flagged_off64_t offset, uint32_t ser_block_size,
+                                uint32_t disk_ser_block_size) {
 
     rassert(!check_inline_lba_full());
     inline_lba_entries[inline_lba_entries_count++] =
-            lba_entry_t::make(block, recency, offset, ser_block_size);
+            lba_entry_t::make(block, recency, offset, ser_block_size,
+                              disk_ser_block_size);
 }
 
 class lba_syncer_t :
@@ -318,11 +328,12 @@ void lba_list_t::gc(int lba_shard, auto_drainer_t::lock_t) {
     for (block_id_t id = lba_shard; id < end_id; id += LBA_SHARD_FACTOR) {
         flagged_off64_t off = get_block_offset(id);
         if (off.has_value()) {
-            uint32_t ser_block_size = get_ser_block_size(id);
+            const index_block_info_t info = get_block_info(id);
             disk_structures[lba_shard]->add_entry(id,
-                                                  get_block_recency(id),
+                                                  info.recency,
                                                   off,
-                                                  ser_block_size,
+                                                  info.ser_block_size,
+                                                  info.disk_ser_block_size,
                                                   gc_io_account.get(),
                                                   txns.back().get());
         }
@@ -46,6 +46,9 @@ public:
     flagged_off64_t get_block_offset(block_id_t block);
     uint32_t get_ser_block_size(block_id_t block);
     block_size_t get_block_size(block_id_t block);
+    // The size the block takes up on disk, which differs from `get_block_size` for
+    // compressed blocks.
+    block_size_t get_disk_block_size(block_id_t block);
     repli_timestamp_t get_block_recency(block_id_t block);
     segmented_vector_t<repli_timestamp_t> get_block_recencies(block_id_t first,
                                                               block_id_t step);
@@ -62,6 +65,7 @@ public:
 
     void set_block_info(block_id_t block, repli_timestamp_t recency,
                         flagged_off64_t offset, uint32_t ser_block_size,
+                        uint32_t disk_ser_block_size,
                         file_account_t *io_account,
                         extent_transaction_t *txn);
 
@@ -116,7 +120,8 @@ private:
     bool check_inline_lba_full() const;
     void move_inline_entries_to_extents(file_account_t *io_account, extent_transaction_t *txn);
     void add_inline_entry(block_id_t block, repli_timestamp_t recency,
-                                flagged_off64_t offset, uint32_t ser_block_size);
+                                flagged_off64_t offset, uint32_t ser_block_size,
+                                uint32_t disk_ser_block_size);
 
     lba_disk_structure_t *disk_structures[LBA_SHARD_FACTOR];
 
@@ -135,6 +135,7 @@ log_serializer_stats_t::log_serializer_stats_t(perfmon_collection_t *parent)
       pm_serializer_data_extents_gced(),
       pm_serializer_old_garbage_block_bytes(),
       pm_serializer_old_total_block_bytes(),
+      pm_serializer_compressed_blocks_written(),
       pm_serializer_lba_gcs(),
       parent_collection_membership(parent, &serializer_collection, "serializer"),
       stats_membership(&serializer_collection,
@@ -155,6 +156,7 @@ log_serializer_stats_t::log_serializer_stats_t(perfmon_collection_t *parent)
           &pm_serializer_data_extents_gced, "serializer_data_extents_gced",
           &pm_serializer_old_garbage_block_bytes, "serializer_old_garbage_block_bytes",
           &pm_serializer_old_total_block_bytes, "serializer_old_total_block_bytes",
+          &pm_serializer_compressed_blocks_written, "serializer_compressed_blocks_written",
           &pm_serializer_lba_gcs, "serializer_lba_gcs")
 { }
 
@@ -307,7 +309,7 @@ struct ls_start_existing_fsm_t :
                 flagged_off64_t offset = ser->lba_index->get_block_offset(num_blocks_reconstructed);
                 if (offset.has_value()) {
                     ser->data_block_manager->mark_live(offset.get_value(),
-                        ser->lba_index->get_block_size(num_blocks_reconstructed));
+                        ser->lba_index->get_disk_block_size(num_blocks_reconstructed));
                 }
                 ++batch;
                 if (batch >= LBA_RECONSTRUCTION_BATCH_SIZE) {
@@ -444,7 +446,7 @@ buf_ptr_t log_serializer_t::block_read(const counted_t<ls_block_token_pointee_t>
     stats->pm_serializer_block_reads.begin(&pm_time);
 
     buf_ptr_t ret = data_block_manager->read(token->offset_, token->block_size(),
-                                           io_account);
+                                             token->disk_block_size(), io_account);
 
     stats->pm_serializer_block_reads.end(&pm_time);
     return ret;
@@ -489,7 +491,9 @@ void log_serializer_t::index_write(new_mutex_in_line_t *mutex_acq,
              ++write_op_it) {
             const index_write_op_t &op = *write_op_it;
             flagged_off64_t offset = lba_index->get_block_offset(op.block_id);
-            uint32_t ser_block_size = lba_index->get_ser_block_size(op.block_id);
+            index_block_info_t info = lba_index->get_block_info(op.block_id);
+            uint32_t ser_block_size = info.ser_block_size;
+            uint32_t disk_ser_block_size = info.disk_ser_block_size;
 
             if (op.token) {
                 // Update the offset pointed to, and mark garbage/liveness as necessary.
@@ -505,12 +509,15 @@ void log_serializer_t::index_write(new_mutex_in_line_t *mutex_acq,
                 if (token.has()) {
                     offset = flagged_off64_t::make(token->offset_);
                     ser_block_size = token->block_size().ser_value();
+                    disk_ser_block_size = token->disk_block_size().ser_value();
 
                     /* mark the life */
-                    data_block_manager->mark_live(offset.get_value(), token->block_size());
+                    data_block_manager->mark_live(offset.get_value(),
+                                                  token->disk_block_size());
                 } else {
                     offset = flagged_off64_t::unused();
                     ser_block_size = 0;
+                    disk_ser_block_size = 0;
                 }
             }
 
@@ -518,7 +525,7 @@ void log_serializer_t::index_write(new_mutex_in_line_t *mutex_acq,
                 : lba_index->get_block_recency(op.block_id);
 
             lba_index->set_block_info(op.block_id, recency,
-                                      offset, ser_block_size,
+                                      offset, ser_block_size, disk_ser_block_size,
                                       index_writes_io_account.get(), &txn);
         }
     }
@@ -626,9 +633,11 @@ void log_serializer_t::write_metablock_sans_pipelining(const signal_t *safe_to_w
 }
 
 counted_t<ls_block_token_pointee_t>
-log_serializer_t::generate_block_token(int64_t offset, block_size_t block_size) {
+log_serializer_t::generate_block_token(int64_t offset, block_size_t block_size,
+                                       block_size_t disk_block_size) {
     assert_thread();
-    counted_t<ls_block_token_pointee_t> ret(new ls_block_token_pointee_t(this, offset, block_size));
+    counted_t<ls_block_token_pointee_t> ret(
+        new ls_block_token_pointee_t(this, offset, block_size, disk_block_size));
     return ret;
 }
 
@@ -765,7 +774,9 @@ counted_t<ls_block_token_pointee_t> log_serializer_t::index_read(block_id_t bloc
 
     index_block_info_t info = lba_index->get_block_info(block_id);
     if (info.offset.has_value()) {
-        return generate_block_token(info.offset.get_value(), block_size_t::unsafe_make(info.ser_block_size));
+        return generate_block_token(info.offset.get_value(),
+                                    block_size_t::unsafe_make(info.ser_block_size),
+                                    block_size_t::unsafe_make(info.disk_ser_block_size));
     } else {
         return counted_t<ls_block_token_pointee_t>();
     }
@@ -943,9 +954,11 @@ bool log_serializer_t::should_perform_read_ahead() {
 
 ls_block_token_pointee_t::ls_block_token_pointee_t(log_serializer_t *serializer,
                                                    int64_t initial_offset,
-                                                   block_size_t initial_block_size)
+                                                   block_size_t initial_block_size,
+                                                   block_size_t initial_disk_block_size)
     : serializer_(serializer), ref_count_(0),
-      block_size_(initial_block_size), offset_(initial_offset) {
+      block_size_(initial_block_size), disk_block_size_(initial_disk_block_size),
+      offset_(initial_offset) {
     serializer_->assert_thread();
     serializer_->register_block_token(this, initial_offset);
 }
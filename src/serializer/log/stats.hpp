@@ -35,6 +35,7 @@ struct log_serializer_stats_t {
     perfmon_counter_t pm_serializer_data_extents_gced;
     perfmon_counter_t pm_serializer_old_garbage_block_bytes;
     perfmon_counter_t pm_serializer_old_total_block_bytes;
+    perfmon_counter_t pm_serializer_compressed_blocks_written;
 
     /* used in serializer/log/lba/lba_list.cc */
     perfmon_counter_t pm_serializer_lba_gcs;
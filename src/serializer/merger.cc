@@ -12,11 +12,21 @@
 
 
 merger_serializer_t::merger_serializer_t(scoped_ptr_t<serializer_t> _inner,
-                                         int _max_active_writes) :
+                                         int _max_active_writes,
+                                         perfmon_collection_t *perfmon_collection,
+                                         int64_t group_commit_window_ms) :
     inner(std::move(_inner)),
     block_writes_io_account(make_io_account(MERGER_BLOCK_WRITE_IO_PRIORITY)),
+    outstanding_index_writes(0),
+    outstanding_block_write_bytes(0),
+    pm_group_commit_index_writes(secs_to_ticks(1), false),
+    pm_group_commit_bytes(secs_to_ticks(1), false),
+    stats_membership(perfmon_collection,
+        &pm_group_commit_index_writes, "merger_group_commit_index_writes",
+        &pm_group_commit_bytes, "merger_group_commit_bytes"),
     write_committer(std::bind(&merger_serializer_t::do_index_write, this),
-                    _max_active_writes) { }
+                    _max_active_writes,
+                    group_commit_window_ms) { }
 
 merger_serializer_t::~merger_serializer_t() {
     assert_thread();
@@ -32,6 +42,7 @@ void merger_serializer_t::index_write(new_mutex_in_line_t *mutex_acq,
     for (auto op = write_ops.begin(); op != write_ops.end(); ++op) {
         push_index_write_op(*op);
     }
+    ++outstanding_index_writes;
 
     // The caller is definitely "in line" for this merger serializer -- subsequent
     // index_write calls will get logically committed after ours.
@@ -41,6 +52,26 @@ void merger_serializer_t::index_write(new_mutex_in_line_t *mutex_acq,
     write_committer.sync();
 }
 
+std::vector<counted_t<standard_block_token_t> >
+merger_serializer_t::block_writes(const std::vector<buf_write_info_t> &write_infos,
+                                  UNUSED file_account_t *io_account,
+                                  iocallback_t *cb) {
+    assert_thread();
+    for (auto it = write_infos.begin(); it != write_infos.end(); ++it) {
+        outstanding_block_write_bytes += it->block_size.ser_value();
+    }
+    // Enough data has piled up that waiting for more wouldn't save much.
+    if (outstanding_block_write_bytes >= MERGER_GROUP_COMMIT_MAX_BYTES) {
+        write_committer.close_group_window();
+    }
+
+    // Currently, we do not merge block writes, only index writes.
+    // However we do use a common file account for all of them, which
+    // reduces random disk seeks that would arise from trying to interleave
+    // writes from the individual accounts further down in the i/o layer.
+    return inner->block_writes(write_infos, block_writes_io_account.get(), cb);
+}
+
 void merger_serializer_t::do_index_write() {
     assert_thread();
 
@@ -56,6 +87,11 @@ void merger_serializer_t::do_index_write() {
             write_ops.push_back(op_pair->second);
         }
         outstanding_index_write_ops.clear();
+
+        pm_group_commit_index_writes.record(outstanding_index_writes);
+        pm_group_commit_bytes.record(outstanding_block_write_bytes);
+        outstanding_index_writes = 0;
+        outstanding_block_write_bytes = 0;
     }
 
     new_mutex_in_line_t mutex_acq(&inner_index_write_mutex);
@@ -9,7 +9,9 @@
 #include "buffer_cache/types.hpp"
 #include "concurrency/new_mutex.hpp"
 #include "concurrency/throttled_committer.hpp"
+#include "config/args.hpp"
 #include "containers/scoped.hpp"
+#include "perfmon/perfmon.hpp"
 #include "serializer/buf_ptr.hpp"
 #include "serializer/serializer.hpp"
 
@@ -26,11 +28,21 @@
  * for all block_writes, so reduce the amount of random disk seeks that can
  * occur when writes from multiple different accounts get interleaved (see
  * https://github.com/rethinkdb/rethinkdb/issues/3348 )
+ *
+ * When no index write is active and the previous one was shared by several
+ * transactions, the next one waits for a short group commit window
+ * (MERGER_GROUP_COMMIT_WINDOW_MS, cut short once MERGER_GROUP_COMMIT_MAX_BYTES of
+ * blocks have been written), so that hard durability transactions coming in from
+ * different shards at about the same time share a single index write and a single
+ * fdatasync.  A transaction writing on its own doesn't wait.
  */
 
 class merger_serializer_t : public serializer_t {
 public:
-    merger_serializer_t(scoped_ptr_t<serializer_t> _inner, int _max_active_writes);
+    merger_serializer_t(scoped_ptr_t<serializer_t> _inner,
+                        int _max_active_writes,
+                        perfmon_collection_t *perfmon_collection,
+                        int64_t group_commit_window_ms = MERGER_GROUP_COMMIT_WINDOW_MS);
     ~merger_serializer_t();
 
 
@@ -95,13 +107,7 @@ public:
     std::vector<counted_t<standard_block_token_t> >
     block_writes(const std::vector<buf_write_info_t> &write_infos,
                  UNUSED file_account_t *io_account,
-                 iocallback_t *cb) {
-        // Currently, we do not merge block writes, only index writes.
-        // However we do use a common file account for all of them, which
-        // reduces random disk seeks that would arise from trying to interleave
-        // writes from the individual accounts further down in the i/o layer.
-        return inner->block_writes(write_infos, block_writes_io_account.get(), cb);
-    }
+                 iocallback_t *cb);
 
     /* The size, in bytes, of each serializer block */
     max_block_size_t max_block_size() const { return inner->max_block_size(); }
@@ -134,6 +140,15 @@ private:
     // A map of outstanding index write operations, indexed by block id
     std::map<block_id_t, index_write_op_t> outstanding_index_write_ops;
 
+    // How many index_write calls and how many bytes of block writes are going to
+    // end up in the next index write.
+    int64_t outstanding_index_writes;
+    int64_t outstanding_block_write_bytes;
+
+    perfmon_sampler_t pm_group_commit_index_writes;
+    perfmon_sampler_t pm_group_commit_bytes;
+    perfmon_multi_membership_t stats_membership;
+
     throttled_committer_t write_committer;
 
     DISABLE_COPYING(merger_serializer_t);
@@ -120,7 +120,11 @@ class log_serializer_t;
 class ls_block_token_pointee_t {
 public:
     int64_t offset() const { return offset_; }
+    // The size of the block as seen by the cache.
     block_size_t block_size() const { return block_size_; }
+    // The number of bytes the block takes up on disk.  Smaller than `block_size()`
+    // if the block is stored compressed.
+    block_size_t disk_block_size() const { return disk_block_size_; }
 
 private:
     friend class log_serializer_t;
@@ -131,13 +135,16 @@ private:
 
     ls_block_token_pointee_t(log_serializer_t *serializer,
                              int64_t initial_offset,
-                             block_size_t initial_ser_block_size);
+                             block_size_t initial_ser_block_size,
+                             block_size_t initial_disk_block_size);
 
     log_serializer_t *serializer_;
     intptr_t ref_count_;
 
     // The block's size.
     block_size_t block_size_;
+    // The block's size on disk.
+    block_size_t disk_block_size_;
 
     // The block's offset on disk.
     int64_t offset_;
@@ -130,12 +130,14 @@ public:
     }
 
     void receive_backfill(
+            const region_t &backfill_region,
             const backfill_chunk_t &chunk,
             write_token_t *token,
             signal_t *interruptor)
             THROWS_ONLY(interrupted_exc_t) {
         home_thread_mixin_t::assert_thread();
-        store_view->receive_backfill(chunk, token, interruptor);
+        rassert(region_is_superset(get_region(), backfill_region));
+        store_view->receive_backfill(backfill_region, chunk, token, interruptor);
     }
 
     void throttle_backfill_chunk(signal_t *interruptor)
@@ -144,6 +146,12 @@ public:
         store_view->throttle_backfill_chunk(interruptor);
     }
 
+    void finish_backfill(write_token_t *token, signal_t *interruptor)
+            THROWS_ONLY(interrupted_exc_t) {
+        home_thread_mixin_t::assert_thread();
+        store_view->finish_backfill(token, interruptor);
+    }
+
     void reset_data(
             const binary_blob_t &zero_version,
             const region_t &subregion,
@@ -90,12 +90,17 @@ public:
             THROWS_ONLY(interrupted_exc_t) = 0;
 
 
-    /* Applies a backfill data chunk sent by `send_backfill()`. If
+    /* Applies a backfill data chunk sent by `send_backfill()`. `backfill_region` is
+    the region that the whole backfill covers. If
     `interrupted_exc_t` is thrown, the state of the database is undefined
     except that doing a second backfill must put it into a valid state.
+    Checkpoint chunks aren't passed to the store; the backfillee writes them to
+    the metainfo with `set_metainfo()`, which must make every chunk that was
+    received before it durable along with the metainfo.
     [May block]
     */
     virtual void receive_backfill(
+            const region_t &backfill_region,
             const backfill_chunk_t &chunk,
             write_token_t *token,
             signal_t *interruptor)
@@ -106,6 +111,14 @@ public:
     virtual void throttle_backfill_chunk(signal_t *interruptor)
         THROWS_ONLY(interrupted_exc_t) = 0;
 
+    /* Called after every chunk of a backfill has been passed to
+    `receive_backfill()`, and before the backfill's end point is written to the
+    metainfo. Applies whatever the store put off while receiving the chunks.
+    [May block]
+    */
+    virtual void finish_backfill(write_token_t *token, signal_t *interruptor)
+        THROWS_ONLY(interrupted_exc_t) = 0;
+
     /* Deletes every key in the region, and sets the metainfo for that region to
     `zero_version`.
     [Precondition] region_is_superset(region, subregion)
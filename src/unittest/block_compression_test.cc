@@ -0,0 +1,65 @@
+// Copyright 2010-2015 RethinkDB, all rights reserved.
+#include <stdlib.h>
+#include <string.h>
+
+#include <string>
+
+#include "config/args.hpp"
+#include "serializer/buf_ptr.hpp"
+#include "serializer/log/block_compression.hpp"
+#include "unittest/gtest.hpp"
+
+namespace unittest {
+
+void check_compressed_block(const std::string &contents) {
+    const block_size_t block_size = block_size_t::make_from_cache(contents.size());
+    buf_ptr_t buf = buf_ptr_t::alloc_uninitialized(block_size);
+    memcpy(buf.cache_data(), contents.data(), contents.size());
+    buf.fill_padding_zero();
+
+    buf_ptr_t compressed;
+    ASSERT_FALSE(compress_block(block_compression_t::none, buf.ser_buffer(),
+                                block_size, 17, &compressed));
+    ASSERT_TRUE(compress_block(block_compression_t::lz4, buf.ser_buffer(),
+                               block_size, 17, &compressed));
+    EXPECT_LT(compressed.aligned_block_size(), buf.aligned_block_size());
+
+    const ser_buffer_t *disk_buf = compressed.ser_buffer();
+    EXPECT_TRUE(block_is_compressed(disk_buf));
+    EXPECT_EQ(17u, stored_block_id(disk_buf));
+    EXPECT_EQ(block_size, stored_block_size(disk_buf, compressed.block_size()));
+
+    buf_ptr_t decompressed = decompress_block(disk_buf, compressed.block_size());
+    ASSERT_EQ(block_size, decompressed.block_size());
+    EXPECT_FALSE(block_is_compressed(decompressed.ser_buffer()));
+    EXPECT_EQ(17u, decompressed.ser_buffer()->ser_header.block_id);
+    EXPECT_EQ(0, memcmp(contents.data(), decompressed.cache_data(),
+                        contents.size()));
+}
+
+TEST(BlockCompressionTest, CompressedBlock) {
+    check_compressed_block(std::string(4000, 'q'));
+
+    std::string mixed;
+    while (mixed.size() < 4000) {
+        mixed += strprintf("{\"id\": %d, \"name\": \"row\"}", random() % 37);
+    }
+    check_compressed_block(mixed);
+}
+
+TEST(BlockCompressionTest, IncompressibleBlock) {
+    const block_size_t block_size = block_size_t::make_from_cache(4000);
+    buf_ptr_t buf = buf_ptr_t::alloc_uninitialized(block_size);
+    char *data = static_cast<char *>(buf.cache_data());
+    for (uint32_t i = 0; i < block_size.value(); ++i) {
+        data[i] = static_cast<char>(random() & 0xff);
+    }
+    buf.fill_padding_zero();
+
+    buf_ptr_t compressed;
+    EXPECT_FALSE(compress_block(block_compression_t::lz4, buf.ser_buffer(),
+                                block_size, 17, &compressed));
+    EXPECT_FALSE(block_is_compressed(buf.ser_buffer()));
+}
+
+}  // namespace unittest
@@ -0,0 +1,140 @@
+// Copyright 2010-2015 RethinkDB, all rights reserved.
+#include "unittest/gtest.hpp"
+
+#include <functional>
+
+#include "btree/bulk_load.hpp"
+#include "unittest/btree_utils.hpp"
+
+namespace unittest {
+
+// Appends the keys `begin` up to `end` to `loader`, in one transaction.
+void bulk_load_keys(test_btree_t *btree, btree_bulk_loader_t *loader,
+                    int begin, int end,
+                    const std::function<repli_timestamp_t(int)> &recency_of) {
+    txn_t txn(btree->cache_conn(), write_durability_t::SOFT,
+              repli_timestamp_t::distant_past, end - begin);
+    for (int i = begin; i < end; ++i) {
+        store_key_t key(strprintf("key %08d", i));
+        loader->append(&txn, key.btree_key(), test_value(i).data(), recency_of(i));
+    }
+    loader->release_nodes();
+}
+
+repli_timestamp_t distant_past_recency(int) {
+    return repli_timestamp_t::distant_past;
+}
+
+TPTEST(BtreeBulkLoad, LoadAndRead) {
+    // Enough keys for the tree to get two levels of internal nodes.
+    const int NUM_KEYS = 50000;
+    const int KEYS_PER_TXN = 1000;
+
+    test_btree_t btree;
+
+    btree_bulk_loader_t loader(btree.sizer(), repli_timestamp_t::distant_past);
+    for (int i = 0; i < NUM_KEYS; i += KEYS_PER_TXN) {
+        bulk_load_keys(&btree, &loader, i, i + KEYS_PER_TXN, &distant_past_recency);
+    }
+    ASSERT_EQ(NUM_KEYS, loader.num_pairs());
+
+    {
+        scoped_ptr_t<txn_t> txn;
+        scoped_ptr_t<real_superblock_t> superblock;
+        btree.get_superblock_for_writing(&superblock, &txn);
+        loader.finish(superblock.get());
+    }
+
+    for (int i = -1; i <= NUM_KEYS; i += 7) {
+        // `i == -1` and `i == NUM_KEYS` are keys right outside of the loaded range.
+        std::string value;
+        const bool found = btree.find(store_key_t(strprintf("key %08d", i)), &value);
+        if (i >= 0 && i < NUM_KEYS) {
+            ASSERT_TRUE(found);
+            EXPECT_EQ(test_value(i), value);
+        } else {
+            EXPECT_FALSE(found);
+        }
+    }
+
+    EXPECT_EQ(NUM_KEYS, btree.get_population());
+}
+
+TPTEST(BtreeBulkLoad, Recencies) {
+    const int NUM_KEYS = 20000;
+    const int KEYS_PER_TXN = 1000;
+
+    test_btree_t btree;
+
+    // The recencies don't ascend with the keys, like the ones of a backfill.
+    auto recency_of = [](int i) {
+        repli_timestamp_t recency;
+        recency.longtime = 1 + (i * 7919) % NUM_KEYS;
+        return recency;
+    };
+
+    btree_bulk_loader_t loader(btree.sizer(), repli_timestamp_t::distant_past);
+    repli_timestamp_t max_recency = repli_timestamp_t::distant_past;
+    for (int i = 0; i < NUM_KEYS; i += KEYS_PER_TXN) {
+        bulk_load_keys(&btree, &loader, i, i + KEYS_PER_TXN, recency_of);
+    }
+    for (int i = 0; i < NUM_KEYS; ++i) {
+        max_recency = superceding_recency(max_recency, recency_of(i));
+    }
+
+    {
+        scoped_ptr_t<txn_t> txn;
+        scoped_ptr_t<real_superblock_t> superblock;
+        btree.get_superblock_for_writing(&superblock, &txn);
+        loader.finish(superblock.get());
+    }
+
+    EXPECT_EQ(max_recency, btree.get_root_recency());
+
+    // A backfill skips nodes that are older than what it's looking for, so every
+    // leaf must be at least as recent as its pairs.
+    for (int i = 0; i < NUM_KEYS; i += 13) {
+        repli_timestamp_t leaf_recency;
+        ASSERT_TRUE(btree.find(store_key_t(strprintf("key %08d", i)), nullptr,
+                               &leaf_recency));
+        EXPECT_LE(recency_of(i).longtime, leaf_recency.longtime);
+    }
+}
+
+TPTEST(BtreeBulkLoad, Checkpoints) {
+    const int NUM_KEYS = 50000;
+    const int KEYS_PER_TXN = 1000;
+    const int TXNS_PER_CHECKPOINT = 7;
+
+    test_btree_t btree;
+
+    // Checks that the tree has exactly the first `num_loaded` keys.
+    auto check_tree = [&](int num_loaded) {
+        for (int i = 0; i <= num_loaded; i += std::max(1, num_loaded / 100)) {
+            ASSERT_EQ(i < num_loaded,
+                      btree.find(store_key_t(strprintf("key %08d", i)), nullptr));
+        }
+        EXPECT_EQ(num_loaded, btree.get_population());
+    };
+
+    auto with_superblock = [&](const std::function<void(superblock_t *)> &fun) {
+        scoped_ptr_t<txn_t> txn;
+        scoped_ptr_t<real_superblock_t> superblock;
+        btree.get_superblock_for_writing(&superblock, &txn);
+        fun(superblock.get());
+    };
+
+    btree_bulk_loader_t loader(btree.sizer(), repli_timestamp_t::distant_past);
+    for (int i = 0; i < NUM_KEYS; i += KEYS_PER_TXN) {
+        bulk_load_keys(&btree, &loader, i, i + KEYS_PER_TXN, &distant_past_recency);
+        if ((i / KEYS_PER_TXN) % TXNS_PER_CHECKPOINT == 0) {
+            with_superblock([&](superblock_t *sb) { loader.checkpoint(sb); });
+            check_tree(i + KEYS_PER_TXN);
+        }
+    }
+
+    with_superblock([&](superblock_t *sb) { loader.finish(sb); });
+    check_tree(NUM_KEYS);
+}
+
+}  // namespace unittest
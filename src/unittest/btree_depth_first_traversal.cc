@@ -0,0 +1,109 @@
+// Copyright 2010-2015 RethinkDB, all rights reserved.
+#include "unittest/gtest.hpp"
+
+#include <algorithm>
+#include <vector>
+
+#include "btree/depth_first_traversal.hpp"
+#include "concurrency/interruptor.hpp"
+#include "config/args.hpp"
+#include "unittest/btree_utils.hpp"
+
+namespace unittest {
+
+// Enough keys for the tree to get two levels of internal nodes.
+const int NUM_KEYS = 50000;
+
+// Collects the keys it sees, and stops after `stop_after` of them if that's nonzero,
+// either by returning `YES` or, if `throw_at_stop` is set, by throwing
+// `interrupted_exc_t` like a traversal that got interrupted.
+class collect_keys_cb_t : public depth_first_traversal_callback_t {
+public:
+    collect_keys_cb_t(cache_t *_cache, size_t _read_ahead_nodes,
+                      size_t _stop_after = 0, bool _throw_at_stop = false)
+        : max_read_ahead_blocks(0), cache(_cache),
+          read_ahead_nodes(_read_ahead_nodes), stop_after(_stop_after),
+          throw_at_stop(_throw_at_stop) { }
+
+    done_traversing_t handle_pair(scoped_key_value_t &&keyvalue) {
+        keys.push_back(store_key_t(keyvalue.key()));
+        max_read_ahead_blocks = std::max(max_read_ahead_blocks,
+                                         cache->read_ahead_blocks());
+        if (keys.size() == stop_after) {
+            if (throw_at_stop) {
+                throw interrupted_exc_t();
+            }
+            return done_traversing_t::YES;
+        }
+        return done_traversing_t::NO;
+    }
+
+    size_t get_max_read_ahead_nodes() {
+        return read_ahead_nodes;
+    }
+
+    std::vector<store_key_t> keys;
+    // The most blocks that were being read ahead while we were handling a pair.
+    int64_t max_read_ahead_blocks;
+
+private:
+    cache_t *cache;
+    size_t read_ahead_nodes;
+    size_t stop_after;
+    bool throw_at_stop;
+};
+
+void traverse(test_btree_t *btree, collect_keys_cb_t *cb, direction_t direction) {
+    scoped_ptr_t<txn_t> txn;
+    scoped_ptr_t<real_superblock_t> superblock;
+    get_btree_superblock_and_txn_for_reading(btree->cache_conn(), CACHE_SNAPSHOTTED_NO,
+                                             &superblock, &txn);
+    btree_depth_first_traversal(superblock.get(), key_range_t::universe(), cb,
+                                direction, release_superblock_t::RELEASE);
+}
+
+TPTEST(BtreeDepthFirstTraversal, ReadAheadSeesSameKeys) {
+    test_btree_t btree;
+    btree.load_keys(NUM_KEYS);
+
+    for (direction_t direction : { FORWARD, BACKWARD }) {
+        collect_keys_cb_t plain(btree.cache(), 0);
+        traverse(&btree, &plain, direction);
+        ASSERT_EQ(static_cast<size_t>(NUM_KEYS), plain.keys.size());
+        EXPECT_EQ(0, plain.max_read_ahead_blocks);
+
+        collect_keys_cb_t reading_ahead(btree.cache(), BTREE_MAX_READ_AHEAD_NODES);
+        traverse(&btree, &reading_ahead, direction);
+        EXPECT_TRUE(plain.keys == reading_ahead.keys);
+        EXPECT_LT(0, reading_ahead.max_read_ahead_blocks);
+        EXPECT_GE(CACHE_READ_AHEAD_BUDGET_BLOCKS, reading_ahead.max_read_ahead_blocks);
+
+        // Every block that was read ahead has been accounted for again.
+        EXPECT_EQ(0, btree.cache()->read_ahead_blocks());
+    }
+}
+
+TPTEST(BtreeDepthFirstTraversal, ReadAheadReleasedOnEarlyStop) {
+    test_btree_t btree;
+    btree.load_keys(NUM_KEYS);
+
+    // The siblings that were read ahead of the last leaf are never used.
+    collect_keys_cb_t cb(btree.cache(), BTREE_MAX_READ_AHEAD_NODES, 100);
+    traverse(&btree, &cb, FORWARD);
+    EXPECT_EQ(100u, cb.keys.size());
+    EXPECT_LT(0, cb.max_read_ahead_blocks);
+    EXPECT_EQ(0, btree.cache()->read_ahead_blocks());
+}
+
+TPTEST(BtreeDepthFirstTraversal, ReadAheadReleasedOnInterruption) {
+    test_btree_t btree;
+    btree.load_keys(NUM_KEYS);
+
+    collect_keys_cb_t cb(btree.cache(), BTREE_MAX_READ_AHEAD_NODES, 100, true);
+    EXPECT_THROW(traverse(&btree, &cb, BACKWARD), interrupted_exc_t);
+    EXPECT_EQ(100u, cb.keys.size());
+    EXPECT_LT(0, cb.max_read_ahead_blocks);
+    EXPECT_EQ(0, btree.cache()->read_ahead_blocks());
+}
+
+}  // namespace unittest
@@ -0,0 +1,93 @@
+// Copyright 2010-2015 RethinkDB, all rights reserved.
+#include "unittest/gtest.hpp"
+
+#include "btree/operations.hpp"
+#include "unittest/btree_utils.hpp"
+
+namespace unittest {
+
+/* Writes sorted runs of keys the way `rdb_batched_replace()` does, descending from
+the root only when the next key doesn't belong into the current leaf node. */
+TPTEST(BtreeOperations, WriteInSameLeaf) {
+    const int NUM_KEYS = 20000;
+    const int KEYS_PER_TXN = 1000;
+
+    test_btree_t btree;
+    test_value_deleter_t deleter;
+
+    // Sets the keys `begin`, `begin + step`, ... below `end`, or deletes them if
+    // `erase` is true. Returns how often we had to descend from the root.
+    auto write_keys = [&](int begin, int end, int step, bool erase) -> int {
+        scoped_ptr_t<txn_t> txn;
+        scoped_ptr_t<real_superblock_t> superblock;
+        btree.get_superblock_for_writing(&superblock, &txn);
+        int descents = 0;
+        int i = begin;
+        while (i < end) {
+            promise_t<superblock_t *> superblock_promise;
+            {
+                keyvalue_location_t kv_location;
+                store_key_t key(strprintf("key %08d", i));
+                find_keyvalue_location_for_write(btree.sizer(), superblock.release(),
+                                                 key.btree_key(), &deleter,
+                                                 &kv_location, btree.stats(), nullptr,
+                                                 &superblock_promise);
+                ++descents;
+                store_key_t last_key;
+                do {
+                    if (erase) {
+                        kv_location.value.reset();
+                    } else {
+                        std::string value = test_value(i);
+                        scoped_malloc_t<void> buffer(
+                            btree.sizer()->max_possible_size());
+                        memcpy(buffer.get(), value.data(), value.size());
+                        kv_location.value = std::move(buffer);
+                    }
+                    null_key_modification_callback_t null_cb;
+                    apply_keyvalue_change(btree.sizer(), &kv_location, key.btree_key(),
+                                          repli_timestamp_t::distant_past,
+                                          &deleter, &null_cb);
+                    last_key = key;
+                    i += step;
+                    key = store_key_t(strprintf("key %08d", i));
+                } while (i < end
+                         && find_keyvalue_location_in_same_leaf(
+                             btree.sizer(), last_key.btree_key(), key.btree_key(),
+                             &kv_location));
+            }
+            superblock.init(
+                static_cast<real_superblock_t *>(superblock_promise.wait()));
+        }
+        return descents;
+    };
+
+    // Inserting the keys in order splits the leaf nodes, and then the internal
+    // nodes, as we go.
+    for (int i = 0; i < NUM_KEYS; i += 2 * KEYS_PER_TXN) {
+        EXPECT_LT(write_keys(i, i + 2 * KEYS_PER_TXN, 2, false), KEYS_PER_TXN / 10);
+    }
+    // Fill in the gaps between the keys.
+    for (int i = 1; i < NUM_KEYS; i += 2 * KEYS_PER_TXN) {
+        EXPECT_LT(write_keys(i, i + 2 * KEYS_PER_TXN, 2, false), KEYS_PER_TXN / 10);
+    }
+    // Deleting most of the keys makes the leaf nodes underfull, so they get merged.
+    for (int i = 0; i < NUM_KEYS; i += KEYS_PER_TXN) {
+        write_keys(i, i + KEYS_PER_TXN - 1, 1, true);
+    }
+
+    for (int i = -1; i <= NUM_KEYS; ++i) {
+        std::string value;
+        const bool found = btree.find(store_key_t(strprintf("key %08d", i)), &value);
+        if (i >= 0 && i < NUM_KEYS && i % KEYS_PER_TXN == KEYS_PER_TXN - 1) {
+            ASSERT_TRUE(found);
+            EXPECT_EQ(test_value(i), value);
+        } else {
+            EXPECT_FALSE(found);
+        }
+    }
+
+    EXPECT_EQ(NUM_KEYS / KEYS_PER_TXN, btree.get_population());
+}
+
+}  // namespace unittest
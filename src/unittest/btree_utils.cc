@@ -0,0 +1,118 @@
+// Copyright 2010-2015 RethinkDB, all rights reserved.
+#include "unittest/btree_utils.hpp"
+
+#include <algorithm>
+
+#include "btree/bulk_load.hpp"
+#include "containers/binary_blob.hpp"
+
+namespace unittest {
+
+std::string test_value(int i) {
+    std::string value = strprintf("value %d", i);
+    return std::string(1, static_cast<char>(value.size())) + value;
+}
+
+test_btree_t::test_btree_t() :
+    io_backender_(file_direct_io_mode_t::buffered_desired),
+    file_opener_(temp_file_.name(), &io_backender_),
+    balancer_(GIGABYTE),
+    stats_(NULL, "") {
+    standard_serializer_t::create(
+        &file_opener_,
+        standard_serializer_t::static_config_t());
+
+    serializer_.init(new standard_serializer_t(
+        standard_serializer_t::dynamic_config_t(),
+        &file_opener_,
+        &get_global_perfmon_collection()));
+
+    cache_.init(new cache_t(serializer_.get(), &balancer_,
+                            &get_global_perfmon_collection()));
+    cache_conn_.init(new cache_conn_t(cache_.get()));
+    sizer_.init(new test_value_sizer_t(cache_->max_block_size()));
+
+    txn_t txn(cache_conn_.get(), write_durability_t::HARD,
+              repli_timestamp_t::distant_past, 1);
+    buf_lock_t sb_lock(&txn, SUPERBLOCK_ID, alt_create_t::create);
+    real_superblock_t superblock(std::move(sb_lock));
+    btree_slice_t::init_real_superblock(&superblock,
+                                        std::vector<char>(), binary_blob_t());
+}
+
+void test_btree_t::get_superblock_for_writing(
+        scoped_ptr_t<real_superblock_t> *superblock_out,
+        scoped_ptr_t<txn_t> *txn_out) {
+    get_btree_superblock_and_txn_for_writing(cache_conn_.get(), nullptr,
+                                             write_access_t::write, 1,
+                                             repli_timestamp_t::distant_past,
+                                             write_durability_t::SOFT,
+                                             superblock_out, txn_out);
+}
+
+void test_btree_t::load_keys(int num_keys) {
+    const int keys_per_txn = 1000;
+    btree_bulk_loader_t loader(sizer_.get(), repli_timestamp_t::distant_past);
+    for (int i = 0; i < num_keys; i += keys_per_txn) {
+        const int end = std::min(num_keys, i + keys_per_txn);
+        txn_t txn(cache_conn_.get(), write_durability_t::SOFT,
+                  repli_timestamp_t::distant_past, end - i);
+        for (int j = i; j < end; ++j) {
+            store_key_t key(strprintf("key %08d", j));
+            loader.append(&txn, key.btree_key(), test_value(j).data(),
+                          repli_timestamp_t::distant_past);
+        }
+        loader.release_nodes();
+    }
+
+    scoped_ptr_t<txn_t> txn;
+    scoped_ptr_t<real_superblock_t> superblock;
+    get_superblock_for_writing(&superblock, &txn);
+    loader.finish(superblock.get());
+}
+
+bool test_btree_t::find(const store_key_t &key, std::string *value_out,
+                        repli_timestamp_t *leaf_recency_out) {
+    scoped_ptr_t<txn_t> txn;
+    scoped_ptr_t<real_superblock_t> superblock;
+    get_btree_superblock_and_txn_for_reading(cache_conn_.get(), CACHE_SNAPSHOTTED_NO,
+                                             &superblock, &txn);
+    keyvalue_location_t kv_location;
+    find_keyvalue_location_for_read(sizer_.get(), superblock.get(), key.btree_key(),
+                                    &kv_location, &stats_, nullptr);
+    if (!kv_location.there_originally_was_value) {
+        return false;
+    }
+    if (value_out != nullptr) {
+        const char *value = static_cast<const char *>(kv_location.value.get());
+        *value_out = std::string(value, sizer_->size(value));
+    }
+    if (leaf_recency_out != nullptr) {
+        *leaf_recency_out = kv_location.buf.get_recency();
+    }
+    return true;
+}
+
+repli_timestamp_t test_btree_t::get_root_recency() {
+    scoped_ptr_t<txn_t> txn;
+    scoped_ptr_t<real_superblock_t> superblock;
+    get_btree_superblock_and_txn_for_reading(cache_conn_.get(), CACHE_SNAPSHOTTED_NO,
+                                             &superblock, &txn);
+    buf_lock_t root(superblock->expose_buf(),
+                    superblock->get_root_block_id(), access_t::read);
+    return root.get_recency();
+}
+
+int64_t test_btree_t::get_population() {
+    scoped_ptr_t<txn_t> txn;
+    scoped_ptr_t<real_superblock_t> superblock;
+    get_btree_superblock_and_txn_for_reading(cache_conn_.get(), CACHE_SNAPSHOTTED_NO,
+                                             &superblock, &txn);
+    buf_lock_t stat_block(superblock->expose_buf(),
+                          superblock->get_stat_block_id(), access_t::read);
+    buf_read_t stat_block_read(&stat_block);
+    return static_cast<const btree_statblock_t *>(
+        stat_block_read.get_data_read())->population;
+}
+
+}  // namespace unittest
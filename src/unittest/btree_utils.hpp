@@ -0,0 +1,101 @@
+// Copyright 2010-2015 RethinkDB, all rights reserved.
+#ifndef UNITTEST_BTREE_UTILS_HPP_
+#define UNITTEST_BTREE_UTILS_HPP_
+
+#include <string>
+
+#include "arch/io/disk.hpp"
+#include "btree/operations.hpp"
+#include "btree/reql_specific.hpp"
+#include "buffer_cache/cache_balancer.hpp"
+#include "containers/scoped.hpp"
+#include "serializer/config.hpp"
+#include "unittest/unittest_utils.hpp"
+
+namespace unittest {
+
+// Values are a length byte followed by that many bytes.
+class test_value_sizer_t : public value_sizer_t {
+public:
+    explicit test_value_sizer_t(max_block_size_t bs) : block_size_(bs) { }
+
+    int size(const void *value) const {
+        return 1 + *static_cast<const uint8_t *>(value);
+    }
+
+    bool fits(const void *value, int length_available) const {
+        return length_available > 0 && size(value) <= length_available;
+    }
+
+    int max_possible_size() const {
+        return 256;
+    }
+
+    block_magic_t btree_leaf_magic() const {
+        block_magic_t magic = { { 'b', 'l', 'L', 'F' } };
+        return magic;
+    }
+
+    max_block_size_t block_size() const { return block_size_; }
+
+private:
+    max_block_size_t block_size_;
+
+    DISABLE_COPYING(test_value_sizer_t);
+};
+
+class test_value_deleter_t : public value_deleter_t {
+public:
+    test_value_deleter_t() { }
+    void delete_value(buf_parent_t, const void *) const { }
+};
+
+// Returns the value that the tests store under the `i`th key.
+std::string test_value(int i);
+
+/* `test_btree_t` sets up a serializer and a cache on a temporary file and creates an
+empty B-tree in it, whose values are the ones `test_value_sizer_t` understands. */
+class test_btree_t {
+public:
+    test_btree_t();
+
+    cache_t *cache() { return cache_.get(); }
+    cache_conn_t *cache_conn() { return cache_conn_.get(); }
+    test_value_sizer_t *sizer() { return sizer_.get(); }
+    btree_stats_t *stats() { return &stats_; }
+
+    void get_superblock_for_writing(scoped_ptr_t<real_superblock_t> *superblock_out,
+                                    scoped_ptr_t<txn_t> *txn_out);
+
+    /* Fills the empty tree with the keys "key %08d" for `0 <= i < num_keys`, with
+    `test_value(i)` as their values. */
+    void load_keys(int num_keys);
+
+    /* Returns `false` if `key` isn't in the tree. Otherwise sets `*value_out` to its
+    value and `*leaf_recency_out` to the recency of the leaf node it's in, unless they
+    are `nullptr`. */
+    bool find(const store_key_t &key, std::string *value_out,
+              repli_timestamp_t *leaf_recency_out = nullptr);
+
+    repli_timestamp_t get_root_recency();
+
+    // Returns the population in the stat block.
+    int64_t get_population();
+
+private:
+    temp_file_t temp_file_;
+    io_backender_t io_backender_;
+    filepath_file_opener_t file_opener_;
+    scoped_ptr_t<standard_serializer_t> serializer_;
+    dummy_cache_balancer_t balancer_;
+    scoped_ptr_t<cache_t> cache_;
+    scoped_ptr_t<cache_conn_t> cache_conn_;
+    scoped_ptr_t<test_value_sizer_t> sizer_;
+    btree_stats_t stats_;
+
+    DISABLE_COPYING(test_btree_t);
+};
+
+}  // namespace unittest
+
+#endif /* UNITTEST_BTREE_UTILS_HPP_ */
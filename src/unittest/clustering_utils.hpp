@@ -220,7 +220,7 @@ inline std::string mc_key_gen() {
 class simple_mailbox_cluster_t {
 public:
     simple_mailbox_cluster_t() :
-        mailbox_manager(&connectivity_cluster, 'M'),
+        mailbox_manager(&connectivity_cluster, 'M', 'B'),
         connectivity_cluster_run(&connectivity_cluster,
                                  get_unittest_addresses(),
                                  peer_address_t(),
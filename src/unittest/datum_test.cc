@@ -172,6 +172,39 @@ TEST(DatumTest, ArraySerialization) {
     }
 }
 
+void test_datum_json(const ql::datum_t &datum) {
+    std::string json;
+    datum.write_json(&json);
+    ASSERT_EQ(datum.as_json().PrintUnformatted(), json);
+}
+
+TEST(DatumTest, WriteJson) {
+    test_datum_json(ql::datum_t::null());
+    test_datum_json(ql::datum_t::boolean(true));
+    test_datum_json(ql::datum_t::boolean(false));
+    test_datum_json(ql::datum_t(0.0));
+    test_datum_json(ql::datum_t(-0.0));
+    test_datum_json(ql::datum_t(1.1));
+    test_datum_json(ql::datum_t(-123456789.0));
+    test_datum_json(ql::datum_t(std::numeric_limits<double>::max()));
+    test_datum_json(ql::datum_t(datum_string_t("")));
+    test_datum_json(ql::datum_t(datum_string_t("quote \" backslash \\ tab \t \x01 \xc3\xa9")));
+    test_datum_json(ql::datum_t::binary(datum_string_t(std::string(100, '\xff'))));
+    test_datum_json(ql::datum_t(
+        std::vector<ql::datum_t>{
+            ql::datum_t::null(),
+            ql::datum_t(2.5),
+            ql::datum_t(std::vector<ql::datum_t>(), ql::configured_limits_t::unlimited)},
+        ql::configured_limits_t::unlimited));
+    test_datum_json(ql::datum_t(
+        std::map<datum_string_t, ql::datum_t>{
+            std::make_pair(datum_string_t("a"), ql::datum_t(1.0)),
+            std::make_pair(datum_string_t("b\n"), ql::datum_t(datum_string_t("c"))),
+            std::make_pair(datum_string_t("nested"), ql::datum_t(
+                std::map<datum_string_t, ql::datum_t>{
+                    std::make_pair(datum_string_t("x"), ql::datum_t::null())}))}));
+}
+
 // Tests serialization with different offset sizes, up to 32 bit
 // (64 bit not tested here, because that would use too much memory for a unit test)
 TEST(DatumTest, OffsetScaling) {
@@ -74,6 +74,35 @@ TEST(DiskBackedQueue, BigVals) {
     unittest::run_in_thread_pool(&run_big_values_test, 2);
 }
 
+void run_batched_push_test() {
+    io_backender_t io_backender(file_direct_io_mode_t::buffered_desired);
+
+    const serializer_filepath_t serializer_path = dbq_serializer_path();
+
+    disk_backed_queue_t<int> queue(&io_backender, serializer_path, &get_global_perfmon_collection());
+
+    for (int batch = 0; batch < 10; ++batch) {
+        std::vector<int> ints;
+        for (int i = 0; i < 100; ++i) {
+            ints.push_back(batch * 100 + i);
+        }
+        queue.push(ints);
+        EXPECT_EQ(static_cast<int64_t>((batch + 1) * 100), queue.size());
+    }
+
+    for (int i = 0; i < 1000; ++i) {
+        ASSERT_FALSE(queue.empty());
+        int x;
+        queue.pop(&x);
+        EXPECT_EQ(i, x);
+    }
+    EXPECT_TRUE(queue.empty());
+}
+
+TEST(DiskBackedQueue, BatchedPush) {
+    unittest::run_in_thread_pool(&run_batched_push_test, 2);
+}
+
 static void randomly_delay(int, signal_t *) {
     nap(randint(100));
 }
@@ -55,7 +55,7 @@ TEST(DiskFormatTest, LbaMetablockMixinT) {
 }
 
 TEST(DiskFormatTest, LbaEntryT) {
-    EXPECT_EQ(0u, offsetof(lba_entry_t, zero_reserved));
+    EXPECT_EQ(0u, offsetof(lba_entry_t, compressed_ser_block_size));
     EXPECT_EQ(4u, offsetof(lba_entry_t, ser_block_size));
     EXPECT_EQ(8u, offsetof(lba_entry_t, block_id));
     EXPECT_EQ(16u, offsetof(lba_entry_t, recency));
@@ -68,11 +68,16 @@ TEST(DiskFormatTest, LbaEntryT) {
     ASSERT_TRUE(lba_entry_t::is_padding(&ent));
     flagged_off64_t real = flagged_off64_t::unused();
     real = flagged_off64_t::make(1);
-    ent = lba_entry_t::make(1, repli_timestamp_t::invalid, real, 1234);
+    ent = lba_entry_t::make(1, repli_timestamp_t::invalid, real, 1234, 1234);
     ASSERT_FALSE(lba_entry_t::is_padding(&ent));
+    EXPECT_EQ(0u, ent.compressed_ser_block_size);
+    EXPECT_EQ(1234u, ent.disk_ser_block_size());
+    ent = lba_entry_t::make(1, repli_timestamp_t::invalid, real, 1234, 600);
+    EXPECT_EQ(600u, ent.compressed_ser_block_size);
+    EXPECT_EQ(600u, ent.disk_ser_block_size());
     flagged_off64_t deleteblock = flagged_off64_t::unused();
     deleteblock = flagged_off64_t::make(1);
-    ent = lba_entry_t::make(1, repli_timestamp_t::invalid, deleteblock, 1234);
+    ent = lba_entry_t::make(1, repli_timestamp_t::invalid, deleteblock, 1234, 1234);
     ASSERT_FALSE(lba_entry_t::is_padding(&ent));
 }
 
@@ -0,0 +1,157 @@
+// Copyright 2010-2015 RethinkDB, all rights reserved.
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <string>
+#include <vector>
+
+#include "http/json.hpp"
+#include "rdb_protocol/datum.hpp"
+#include "rdb_protocol/error.hpp"
+#include "rdb_protocol/json_parser.hpp"
+#include "time.hpp"
+#include "unittest/gtest.hpp"
+
+namespace unittest {
+
+bool parse_json_datum(const std::string &json, ql::datum_t *out) {
+    return ql::parse_json(json.c_str(), ql::configured_limits_t(),
+                          reql_version_t::LATEST, out);
+}
+
+// Checks that `parse_json` agrees with `cJSON_Parse` followed by `to_datum`.
+void check_same_as_cjson(const std::string &json) {
+    SCOPED_TRACE(json);
+    scoped_cJSON_t cjson(cJSON_Parse(json.c_str()));
+    ql::datum_t parsed;
+    const bool success = parse_json_datum(json, &parsed);
+    ASSERT_EQ(cjson.get() != NULL, success);
+    if (success) {
+        ASSERT_EQ(ql::to_datum(cjson.get(), ql::configured_limits_t(),
+                               reql_version_t::LATEST),
+                  parsed);
+    }
+}
+
+TEST(JsonParserTest, SameAsCJSON) {
+    const char *documents[] = {
+        "null", "true", "false", "0", "-0", "1.5", "-2.25e10", "1E-3", "01",
+        "\"\"", "\"abc\"", "\"a\\\"b\\\\c\\/d\\b\\f\\n\\r\\t\\q\"",
+        "\"\\u00e9\\u4e2d\\uD83D\\uDE00\"", "\"\xc3\xa9\"",
+        "[]", "{}", " [ ] ", "[1,2,3]", "[[[]],[{}]]", "[null,true,false]",
+        "{\"a\":1,\"b\":[2,{\"c\":\"d\"}]}", " { \"b\" : 1 , \"a\" : 2 } ",
+        "\t\r\n[\n1\t,\r2 ]\n",
+        "{\"$reql_type$\":\"LITERAL\",\"value\":1}",
+        "{\"a\\\\\":\"\\\\\",\"b\\\\\\\"\":\"}\"}",
+        // Invalid documents.
+        "", " ", "nul", "nullx", "truefalse", "[1,]", "[,1]", "[1 2]", "{\"a\"}",
+        "{\"a\":}", "{\"a\" 1}", "{1:2}", "{\"a\":1,}", "[", "]", "[1]]", "[1]x",
+        "1 2", "0x10", "-", "+1", ".5", "[1\"a\"]", "\"a\"\"b\"", "[\"a\"b]",
+        "\"\\u0000\"", "\"\\uDC00\"", "\"\\u12\"", "[\f1]", "{\"a\":1}}",
+        "'a'",
+    };
+    for (size_t i = 0; i < sizeof(documents) / sizeof(documents[0]); ++i) {
+        check_same_as_cjson(documents[i]);
+    }
+
+    // Documents that span several blocks of the structural indexer, with strings
+    // and backslash runs crossing block boundaries.
+    for (size_t padding = 0; padding < 70; ++padding) {
+        check_same_as_cjson(strprintf("{\"%s\":[\"%s\\\\\\\"x\",1.25,{}],\"b\":\"%s\\\\\"}",
+                                      std::string(padding, 'k').c_str(),
+                                      std::string(padding * 3, 'v').c_str(),
+                                      std::string(padding, ',').c_str()));
+        check_same_as_cjson(std::string(padding, ' ') + "[" + std::string(padding, '1')
+                            + "," + std::string(padding, ' ') + "true]");
+    }
+}
+
+TEST(JsonParserTest, Rejects) {
+    ql::datum_t parsed;
+    // cJSON accepts these two.
+    EXPECT_FALSE(parse_json_datum("\"abc", &parsed));
+    EXPECT_FALSE(parse_json_datum("\"\\uD800\"", &parsed));
+
+    EXPECT_THROW(parse_json_datum("{\"a\":1,\"b\":2,\"a\":3}", &parsed),
+                 ql::base_exc_t);
+    EXPECT_THROW(parse_json_datum("\"\xff\"", &parsed), ql::base_exc_t);
+    EXPECT_THROW(parse_json_datum("-1e999", &parsed), ql::base_exc_t);
+    std::string too_long = "[0";
+    for (int i = 0; i < 100000; ++i) {
+        too_long += ",0";
+    }
+    too_long += "]";
+    EXPECT_THROW(parse_json_datum(too_long, &parsed), ql::base_exc_t);
+}
+
+TEST(JsonParserTest, DeepNesting) {
+    const size_t depth = 10000;
+    ql::datum_t parsed;
+    ASSERT_TRUE(parse_json_datum(std::string(depth, '[') + std::string(depth, ']'),
+                                 &parsed));
+    EXPECT_FALSE(parse_json_datum(std::string(depth, '[') + std::string(depth - 1, ']'),
+                                  &parsed));
+}
+
+TEST(JsonParserTest, IndexersAgree) {
+    const char alphabet[] = "\"\\\\\\{}[]:, \tnx1";
+    std::string json;
+    for (int i = 0; i < 10000; ++i) {
+        json.push_back(alphabet[random() % (sizeof(alphabet) - 1)]);
+    }
+
+    for (size_t size = 0; size <= json.size(); size += 1 + size / 2) {
+        std::vector<size_t> expected;
+        const bool expected_success = ql::find_json_structurals(
+            ql::json_indexer_t::scalar, json.data(), size, &expected);
+        for (ql::json_indexer_t indexer : { ql::json_indexer_t::sse2,
+                                            ql::json_indexer_t::avx2 }) {
+            if (!ql::json_indexer_is_supported(indexer)) {
+                continue;
+            }
+            std::vector<size_t> actual;
+            EXPECT_EQ(expected_success, ql::find_json_structurals(
+                indexer, json.data(), size, &actual));
+            EXPECT_EQ(expected, actual);
+        }
+    }
+}
+
+// Not a real test; this compares the speed of `parse_json` with that of the cJSON
+// path it replaces.  It's disabled so that it doesn't slow down the unit tests;
+// run it with `--gtest_also_run_disabled_tests`.
+TEST(JsonParserTest, DISABLED_Benchmark) {
+    std::string json = "[";
+    for (int i = 0; i < 20000; ++i) {
+        if (i != 0) json += ",";
+        json += strprintf("{\"id\":%d,\"name\":\"row number %d\",\"score\":%d.5,"
+                          "\"tags\":[\"a\",\"b\\n\",\"\\u00e9\"],\"ok\":true}",
+                          i, i, i * 7);
+    }
+    json += "]";
+
+    const int iterations = 10;
+    ql::datum_t expected;
+    ticks_t start = get_ticks();
+    for (int i = 0; i < iterations; ++i) {
+        scoped_cJSON_t cjson(cJSON_Parse(json.c_str()));
+        ASSERT_TRUE(cjson.get() != NULL);
+        expected = ql::to_datum(cjson.get(), ql::configured_limits_t(),
+                                reql_version_t::LATEST);
+    }
+    const double cjson_secs = ticks_to_secs(get_ticks() - start);
+
+    ql::datum_t parsed;
+    start = get_ticks();
+    for (int i = 0; i < iterations; ++i) {
+        ASSERT_TRUE(parse_json_datum(json, &parsed));
+    }
+    const double parse_json_secs = ticks_to_secs(get_ticks() - start);
+    ASSERT_EQ(expected, parsed);
+
+    const double mb = static_cast<double>(json.size() * iterations) / (1024 * 1024);
+    printf("cJSON_Parse + to_datum: %.1f MB/s, parse_json: %.1f MB/s\n",
+           mb / cjson_secs, mb / parse_json_secs);
+}
+
+}  // namespace unittest
@@ -0,0 +1,96 @@
+// Copyright 2010-2015 RethinkDB, all rights reserved.
+#include "protob/json_shim.hpp"
+#include "rdb_protocol/ql2.pb.h"
+#include "unittest/gtest.hpp"
+
+namespace unittest {
+
+TEST(JsonShimTest, ParseQuery) {
+    Query q;
+    ASSERT_TRUE(json_shim::parse_json_pb(
+        &q, 7,
+        "[1, [15, [[14, [\"db\"]], \"tbl\"], {\"use_outdated\": true}],"
+        " {\"noreply\": false, \"db\": [14, [\"test\"]]}]"));
+    EXPECT_EQ(7, q.token());
+    EXPECT_TRUE(q.accepts_r_json());
+    EXPECT_EQ(Query::START, q.type());
+
+    const Term &table = q.query();
+    EXPECT_EQ(Term::TABLE, table.type());
+    ASSERT_EQ(2, table.args_size());
+    EXPECT_EQ(Term::DB, table.args(0).type());
+    ASSERT_EQ(1, table.args(0).args_size());
+    EXPECT_EQ(Term::DATUM, table.args(0).args(0).type());
+    EXPECT_EQ("db", table.args(0).args(0).datum().r_str());
+    EXPECT_EQ(Term::DATUM, table.args(1).type());
+    EXPECT_EQ("tbl", table.args(1).datum().r_str());
+    ASSERT_EQ(1, table.optargs_size());
+    EXPECT_EQ("use_outdated", table.optargs(0).key());
+    EXPECT_EQ(Datum::R_BOOL, table.optargs(0).val().datum().type());
+
+    ASSERT_EQ(2, q.global_optargs_size());
+    EXPECT_EQ("noreply", q.global_optargs(0).key());
+    EXPECT_EQ("db", q.global_optargs(1).key());
+    EXPECT_EQ(Term::DB, q.global_optargs(1).val().type());
+}
+
+TEST(JsonShimTest, ParseDatums) {
+    Query q;
+    ASSERT_TRUE(json_shim::parse_json_pb(
+        &q, 1,
+        "[1, {\"a\": [2, [1.5, null, \"\\u00e9\\ud83d\\ude00\\n\"]],"
+        " \"b\": {\"c\": false}}]"));
+    const Term &obj = q.query();
+    EXPECT_EQ(Term::MAKE_OBJ, obj.type());
+    ASSERT_EQ(2, obj.optargs_size());
+
+    const Term &arr = obj.optargs(0).val();
+    ASSERT_EQ(Term::MAKE_ARRAY, arr.type());
+    ASSERT_EQ(3, arr.args_size());
+    EXPECT_EQ(1.5, arr.args(0).datum().r_num());
+    EXPECT_EQ(Datum::R_NULL, arr.args(1).datum().type());
+    EXPECT_EQ("\xc3\xa9\xf0\x9f\x98\x80\n", arr.args(2).datum().r_str());
+
+    const Term &nested = obj.optargs(1).val();
+    EXPECT_EQ(Term::MAKE_OBJ, nested.type());
+    ASSERT_EQ(1, nested.optargs_size());
+    EXPECT_FALSE(nested.optargs(0).val().datum().r_bool());
+}
+
+TEST(JsonShimTest, ParseExecute) {
+    Query q;
+    ASSERT_TRUE(json_shim::parse_json_pb(
+        &q, 3, "[6, 2, [5, [1, \"a\"], {\"b\": null}], {\"noreply\": true}]"));
+    EXPECT_EQ(3, q.token());
+    EXPECT_EQ(Query::EXECUTE, q.type());
+    EXPECT_FALSE(q.has_query());
+    EXPECT_EQ(2, q.prepared_token());
+
+    // Arguments are plain values, not terms.
+    ASSERT_EQ(3, q.prepared_args_size());
+    EXPECT_EQ(5, q.prepared_args(0).r_num());
+    EXPECT_EQ(Datum::R_ARRAY, q.prepared_args(1).type());
+    ASSERT_EQ(2, q.prepared_args(1).r_array_size());
+    EXPECT_EQ("a", q.prepared_args(1).r_array(1).r_str());
+    EXPECT_EQ(Datum::R_OBJECT, q.prepared_args(2).type());
+
+    ASSERT_EQ(1, q.global_optargs_size());
+    EXPECT_EQ("noreply", q.global_optargs(0).key());
+
+    EXPECT_FALSE(json_shim::parse_json_pb(&q, 3, "[6, 2.5, []]"));
+    EXPECT_FALSE(json_shim::parse_json_pb(&q, 3, "[6, 2, {}]"));
+}
+
+TEST(JsonShimTest, RejectsMalformedQueries) {
+    Query q;
+    const char *bad[] = {
+        "", "[1, [15, []]", "[1, 2] x", "[1.5]", "[\"1\"]", "[1, [1, 2]]",
+        "[1, [1, [], [2]]]", "[1, \"abc]", "[1, \"\\u0000\"]", "[1, \"\\ud83d\"]",
+        "[1, {\"a\" 1}]", "[1, ]", "[1, 0x10]"
+    };
+    for (size_t i = 0; i < sizeof(bad) / sizeof(bad[0]); ++i) {
+        EXPECT_FALSE(json_shim::parse_json_pb(&q, 1, bad[i])) << bad[i];
+    }
+}
+
+}  // namespace unittest
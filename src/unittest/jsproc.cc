@@ -51,6 +51,37 @@ SPAWNER_TEST(JSProc, CallTimeout) {
     ASSERT_FALSE(js_runner.connected());
 }
 
+SPAWNER_TEST(JSProc, CallBatchTimeout) {
+    extproc_pool_t extproc_pool(1);
+    js_runner_t js_runner;
+    ql::configured_limits_t limits;
+
+    js_runner.begin(&extproc_pool, NULL, limits);
+
+    const std::string loop_source =
+        "(function (x) { if (x == 1) { for (var y = 0; y < 4e10; y++) {} } return x; })";
+
+    js_runner_t::req_config_t config;
+    config.timeout_ms = 10000;
+
+    js_result_t result = js_runner.eval(loop_source, config);
+    ASSERT_TRUE(boost::get<js_id_t>(&result) != NULL);
+
+    config.timeout_ms = 10;
+
+    std::vector<std::vector<ql::datum_t> > args_batch;
+    for (int i = 0; i < 3; ++i) {
+        args_batch.push_back(
+            std::vector<ql::datum_t>(1, ql::datum_t(static_cast<double>(i))));
+    }
+
+    // The batch doesn't tell us which call took too long.
+    std::vector<js_result_t> results;
+    ASSERT_FALSE(js_runner.call_batch(loop_source, args_batch, config, &results));
+    ASSERT_TRUE(results.empty());
+    ASSERT_FALSE(js_runner.connected());
+}
+
 void run_datum_test(const std::string &source_code, ql::datum_t *res_out) {
     extproc_pool_t extproc_pool(1);
     js_runner_t js_runner;
@@ -146,6 +177,46 @@ SPAWNER_TEST(JSProc, BrokenFunction) {
     ASSERT_TRUE(error != NULL);
 }
 
+SPAWNER_TEST(JSProc, CallBatch) {
+    extproc_pool_t extproc_pool(1);
+    js_runner_t js_runner;
+    ql::configured_limits_t limits;
+
+    js_runner.begin(&extproc_pool, NULL, limits);
+
+    const std::string source_code =
+        "(function (x) { if (x == 3) { throw 'three'; } return x * 2; })";
+
+    js_runner_t::req_config_t config;
+    config.timeout_ms = 10000;
+
+    std::vector<std::vector<ql::datum_t> > args_batch;
+    for (int i = 0; i < 5; ++i) {
+        args_batch.push_back(
+            std::vector<ql::datum_t>(1, ql::datum_t(static_cast<double>(i))));
+    }
+    std::vector<js_result_t> results;
+    ASSERT_TRUE(js_runner.call_batch(source_code, args_batch, config, &results));
+    ASSERT_TRUE(js_runner.connected());
+
+    // The batch stops at the call that throws.
+    ASSERT_EQ(4u, results.size());
+    for (int i = 0; i < 3; ++i) {
+        ql::datum_t *res_datum = boost::get<ql::datum_t>(&results[i]);
+        ASSERT_TRUE(res_datum != NULL);
+        ASSERT_EQ(i * 2, res_datum->as_int());
+    }
+    ASSERT_TRUE(boost::get<std::string>(&results[3]) != NULL);
+
+    // The worker is still usable after a batch.
+    args_batch.resize(3);
+    ASSERT_TRUE(js_runner.call_batch(source_code, args_batch, config, &results));
+    ASSERT_EQ(3u, results.size());
+    ql::datum_t *res_datum = boost::get<ql::datum_t>(&results[2]);
+    ASSERT_TRUE(res_datum != NULL);
+    ASSERT_EQ(4, res_datum->as_int());
+}
+
 SPAWNER_TEST(JSProc, InvalidFunction) {
     extproc_pool_t extproc_pool(1);
     js_runner_t js_runner;
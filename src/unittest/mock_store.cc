@@ -276,6 +276,7 @@ bool mock_store_t::send_backfill(
 }
 
 void mock_store_t::receive_backfill(
+        UNUSED const region_t &backfill_region,
         const backfill_chunk_t &chunk,
         write_token_t *token,
         signal_t *interruptor) THROWS_ONLY(interrupted_exc_t) {
@@ -304,6 +305,13 @@ void mock_store_t::receive_backfill(
 void mock_store_t::throttle_backfill_chunk(UNUSED signal_t *signal)
         THROWS_ONLY(interrupted_exc_t) { }
 
+void mock_store_t::finish_backfill(write_token_t *token, signal_t *interruptor)
+        THROWS_ONLY(interrupted_exc_t) {
+    object_buffer_t<fifo_enforcer_sink_t::exit_write_t>::destruction_sentinel_t destroyer(&token->main_write_token);
+
+    wait_interruptible(token->main_write_token.get(), interruptor);
+}
+
 void mock_store_t::reset_data(
         const binary_blob_t &zero_version,
         const region_t &subregion,
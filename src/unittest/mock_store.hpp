@@ -67,6 +67,7 @@ public:
         THROWS_ONLY(interrupted_exc_t);
 
     void receive_backfill(
+            const region_t &backfill_region,
             const backfill_chunk_t &chunk,
             write_token_t *token,
             signal_t *interruptor)
@@ -75,6 +76,9 @@ public:
     void throttle_backfill_chunk(signal_t *interruptor)
         THROWS_ONLY(interrupted_exc_t);
 
+    void finish_backfill(write_token_t *token, signal_t *interruptor)
+        THROWS_ONLY(interrupted_exc_t);
+
     void reset_data(
             const binary_blob_t &zero_version,
             const region_t &subregion,
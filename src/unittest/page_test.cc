@@ -4,6 +4,7 @@
 #include "buffer_cache/page_cache.hpp"
 #include "buffer_cache/alt.hpp"
 #include "buffer_cache/cache_balancer.hpp"
+#include "config/args.hpp"
 #include "concurrency/auto_drainer.hpp"
 #include "concurrency/pmap.hpp"
 #include "containers/scoped.hpp"
@@ -105,8 +106,9 @@ public:
 class test_acq_t : public page_acq_t {
 public:
     test_acq_t() : page_acq_t() { }
-    void init(page_t *page, page_cache_t *page_cache) {
-        page_acq_t::init(page, page_cache, page_cache->default_reads_account());
+    void init(page_t *page, page_cache_t *page_cache,
+              cache_access_hint_t hint = cache_access_hint_t::normal) {
+        page_acq_t::init(page, page_cache, page_cache->default_reads_account(), hint);
     }
 
     void *get_buf_write() {
@@ -315,6 +317,79 @@ TPTEST(PageTest, WriteWaitForFlush, 4) {
     pmap(2, std::bind(&WriteWaitForFlush_cases, &s, &page_cache, ph::_1));
 }
 
+// Creates `count` blocks, without marking them as accessed.
+std::vector<block_id_t> create_blocks(test_cache_t *cache, size_t count) {
+    std::vector<block_id_t> block_ids;
+    auto txn = make_scoped<test_txn_t>(cache);
+    for (size_t i = 0; i < count; ++i) {
+        current_test_acq_t acq(txn.get(), alt_create_t::create);
+        block_ids.push_back(acq.block_id());
+        test_acq_t page_acq;
+        page_acq.init(acq.current_page_for_write(), cache, cache_access_hint_t::scan);
+        memset(page_acq.get_buf_write(), 0, cache->max_block_size().value());
+    }
+    cache->flush(std::move(txn));
+    return block_ids;
+}
+
+void read_block(test_cache_t *cache, block_id_t block_id,
+                cache_access_hint_t hint) {
+    auto txn = make_scoped<test_txn_t>(cache);
+    {
+        current_test_acq_t acq(txn.get(), block_id, access_t::read);
+        test_acq_t page_acq;
+        page_acq.init(acq.current_page_for_read(), cache, hint);
+        page_acq.buf_ready_signal()->wait();
+    }
+    cache->flush(std::move(txn));
+}
+
+// Checks whether the block's page is in memory, without loading it.
+bool block_is_loaded(test_cache_t *cache, block_id_t block_id) {
+    auto txn = make_scoped<test_txn_t>(cache);
+    bool loaded;
+    {
+        current_test_acq_t acq(txn.get(), block_id, access_t::read);
+        loaded = acq.current_page_for_read()->is_loaded();
+    }
+    cache->flush(std::move(txn));
+    return loaded;
+}
+
+TPTEST(PageTest, ScanDoesNotEvictProtected, 4) {
+    mock_ser_t mock;
+    const size_t cache_pages = 64;
+    dummy_cache_balancer_t balancer(cache_pages * DEFAULT_BTREE_BLOCK_SIZE);
+    test_cache_t page_cache(mock.ser.get(), &balancer, mock.throttler.get());
+
+    const std::vector<block_id_t> hot = create_blocks(&page_cache, 8);
+    const std::vector<block_id_t> scanned = create_blocks(&page_cache, 4 * cache_pages);
+
+    // The second normal access promotes a page to the protected segment.
+    for (int i = 0; i < 2; ++i) {
+        for (block_id_t block_id : hot) {
+            read_block(&page_cache, block_id, cache_access_hint_t::normal);
+        }
+    }
+    for (block_id_t block_id : hot) {
+        ASSERT_TRUE(block_is_loaded(&page_cache, block_id));
+    }
+
+    // A scan over four times as many pages as fit in the cache only ever evicts
+    // probationary pages.
+    for (block_id_t block_id : scanned) {
+        read_block(&page_cache, block_id, cache_access_hint_t::scan);
+    }
+    size_t scanned_loaded = 0;
+    for (block_id_t block_id : scanned) {
+        scanned_loaded += block_is_loaded(&page_cache, block_id) ? 1 : 0;
+    }
+    EXPECT_LT(scanned_loaded, cache_pages);
+    for (block_id_t block_id : hot) {
+        EXPECT_TRUE(block_is_loaded(&page_cache, block_id));
+    }
+}
+
 class bigger_test_t {
 public:
     explicit bigger_test_t(uint64_t _memory_limit)
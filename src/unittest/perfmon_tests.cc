@@ -4,6 +4,7 @@
 #include <math.h>
 
 #include <cmath>  // for std::isnan -- read the comment below.
+#include <limits>
 
 #include "perfmon/perfmon.hpp"
 #include "unittest/gtest.hpp"
@@ -57,4 +58,57 @@ TEST(PerfmonTest, StddevComputation) {
     }
 }
 
+TEST(PerfmonTest, HistogramBuckets) {
+    // Every duration falls into a bucket whose range includes it, and the buckets
+    // are laid out in increasing order.
+    ticks_t previous_max = 0;
+    for (size_t i = 0; i < latency_histogram_t::NUM_BUCKETS; ++i) {
+        const ticks_t max = latency_histogram_t::bucket_max_duration(i);
+        if (i > 0) {
+            ASSERT_LT(previous_max, max);
+            ASSERT_EQ(i, latency_histogram_t::bucket_for_duration(previous_max + 1));
+        }
+        ASSERT_EQ(i, latency_histogram_t::bucket_for_duration(max));
+        // A bucket is never wider than 1/16 of the durations it holds.
+        ASSERT_LE((max - previous_max) * 16, std::max<ticks_t>(max, 16));
+        previous_max = max;
+    }
+    EXPECT_EQ(latency_histogram_t::NUM_BUCKETS - 1,
+              latency_histogram_t::bucket_for_duration(
+                  std::numeric_limits<ticks_t>::max()));
+}
+
+TEST(PerfmonTest, HistogramPercentiles) {
+    latency_histogram_t histogram;
+    EXPECT_EQ(0u, histogram.count());
+    EXPECT_EQ(0u, histogram.percentile(0.5));
+
+    // 1..10000 microseconds.
+    for (ticks_t i = 1; i <= 10000; ++i) {
+        histogram.record(i * 1000);
+    }
+    EXPECT_EQ(10000u, histogram.count());
+    const double reldiff = 1.0 / 16;
+    EXPECT_NEAR(5000000, histogram.percentile(0.5), 5000000 * reldiff);
+    EXPECT_NEAR(9900000, histogram.percentile(0.99), 9900000 * reldiff);
+    EXPECT_GE(histogram.percentile(0.99), 9900000u);
+    EXPECT_EQ(10000000u, histogram.percentile(1.0));
+
+    // Merging two halves gives the same histogram, also through `to_datum`.
+    latency_histogram_t low, high, merged, merged_datums;
+    for (ticks_t i = 1; i <= 10000; ++i) {
+        (i <= 5000 ? &low : &high)->record(i * 1000);
+    }
+    merged.merge(low);
+    merged.merge(high);
+    ASSERT_TRUE(merged_datums.merge_datum(low.to_datum(true)));
+    ASSERT_TRUE(merged_datums.merge_datum(high.to_datum(true)));
+    for (double q : { 0.1, 0.5, 0.9, 0.99, 0.999, 1.0 }) {
+        EXPECT_EQ(histogram.percentile(q), merged.percentile(q));
+        EXPECT_EQ(histogram.percentile(q), merged_datums.percentile(q));
+    }
+
+    EXPECT_FALSE(merged_datums.merge_datum(histogram.to_datum(false)));
+}
+
 }  // namespace unittest
@@ -0,0 +1,128 @@
+// Copyright 2010-2015 RethinkDB, all rights reserved.
+#include "concurrency/cond_var.hpp"
+#include "protob/json_shim.hpp"
+#include "rdb_protocol/context.hpp"
+#include "rdb_protocol/counted_term.hpp"
+#include "rdb_protocol/query_cache.hpp"
+#include "unittest/gtest.hpp"
+#include "unittest/unittest_utils.hpp"
+
+namespace unittest {
+
+ql::protob_t<Query> parse_query(int64_t token, const std::string &json) {
+    ql::protob_t<Query> query = ql::make_counted_query();
+    guarantee(json_shim::parse_json_pb(query.get(), token, json.c_str()));
+    return query;
+}
+
+// A PREPARE query for `function(x, y) { return x + y; }`.
+const char *const prepare_add_json =
+    "[5, [69, [[2, [1, 2]], [24, [[10, [1]], [10, [2]]]]]]]";
+
+TPTEST(QueryCacheTest, PrepareAndExecute) {
+    rdb_context_t ctx;
+    ql::query_cache_t query_cache(&ctx, ip_and_port_t(),
+                                  ql::return_empty_normal_batches_t::NO);
+    cond_t interruptor;
+
+    query_cache.prepare(1, parse_query(1, prepare_add_json));
+
+    // The same prepared function can be executed more than once.
+    for (int64_t token = 2; token < 4; ++token) {
+        scoped_ptr_t<ql::query_cache_t::ref_t> ref = query_cache.execute(
+            token, parse_query(token, strprintf("[6, 1, [%" PRIi64 ", 10]]", token)),
+            ql::use_json_t::NO, &interruptor);
+        Response res;
+        ref->fill_response(&res);
+        EXPECT_EQ(Response::SUCCESS_ATOM, res.type());
+        ASSERT_EQ(1, res.response_size());
+        EXPECT_EQ(token + 10, res.response(0).r_num());
+    }
+
+    // The token of a prepared function is taken until it's released.
+    EXPECT_THROW(query_cache.prepare(1, parse_query(1, prepare_add_json)),
+                 ql::query_cache_exc_t);
+    EXPECT_TRUE(query_cache.unprepare(1));
+    EXPECT_FALSE(query_cache.unprepare(1));
+}
+
+TPTEST(QueryCacheTest, ExecuteUnknownToken) {
+    rdb_context_t ctx;
+    ql::query_cache_t query_cache(&ctx, ip_and_port_t(),
+                                  ql::return_empty_normal_batches_t::NO);
+    cond_t interruptor;
+
+    try {
+        query_cache.execute(2, parse_query(2, "[6, 1, [1, 2]]"),
+                            ql::use_json_t::NO, &interruptor);
+        ADD_FAILURE() << "Executing an unknown token should fail.";
+    } catch (const ql::query_cache_exc_t &e) {
+        EXPECT_EQ(Response::CLIENT_ERROR, e.type);
+    }
+}
+
+TPTEST(QueryCacheTest, PrepareLimit) {
+    rdb_context_t ctx;
+    ql::query_cache_t query_cache(&ctx, ip_and_port_t(),
+                                  ql::return_empty_normal_batches_t::NO);
+
+    const int64_t limit = ql::MAX_PREPARED_QUERIES;
+    for (int64_t token = 0; token < limit; ++token) {
+        query_cache.prepare(token, parse_query(token, prepare_add_json));
+    }
+    try {
+        query_cache.prepare(limit, parse_query(limit, prepare_add_json));
+        ADD_FAILURE() << "Preparing past the limit should fail.";
+    } catch (const ql::query_cache_exc_t &e) {
+        EXPECT_EQ(Response::CLIENT_ERROR, e.type);
+    }
+
+    // Releasing a prepared function makes room for another one.
+    EXPECT_TRUE(query_cache.unprepare(0));
+    query_cache.prepare(limit, parse_query(limit, prepare_add_json));
+}
+
+TPTEST(QueryCacheTest, PrepareNow) {
+    rdb_context_t ctx;
+    ql::query_cache_t query_cache(&ctx, ip_and_port_t(),
+                                  ql::return_empty_normal_batches_t::NO);
+
+    // `function(x) { return r.now(); }` would return the PREPARE time forever.
+    try {
+        query_cache.prepare(1, parse_query(1, "[5, [69, [[2, [1]], [103, []]]]]"));
+        ADD_FAILURE() << "Preparing a query that uses r.now() should fail.";
+    } catch (const ql::query_cache_exc_t &e) {
+        EXPECT_EQ(Response::COMPILE_ERROR, e.type);
+    }
+
+    // The token is still free.
+    query_cache.prepare(1, parse_query(1, prepare_add_json));
+}
+
+TPTEST(QueryCacheTest, ExecuteGlobalOptargs) {
+    rdb_context_t ctx;
+    ql::query_cache_t query_cache(&ctx, ip_and_port_t(),
+                                  ql::return_empty_normal_batches_t::NO);
+    cond_t interruptor;
+
+    query_cache.prepare(1, parse_query(1, prepare_add_json));
+
+    try {
+        query_cache.execute(
+            2, parse_query(2, "[6, 1, [1, 2], {\"db\": [14, [\"other\"]]}]"),
+            ql::use_json_t::NO, &interruptor);
+        ADD_FAILURE() << "EXECUTE with a `db` optarg should fail.";
+    } catch (const ql::query_cache_exc_t &e) {
+        EXPECT_EQ(Response::COMPILE_ERROR, e.type);
+    }
+
+    // `noreply` is still allowed.
+    scoped_ptr_t<ql::query_cache_t::ref_t> ref = query_cache.execute(
+        3, parse_query(3, "[6, 1, [1, 2], {\"noreply\": false}]"),
+        ql::use_json_t::NO, &interruptor);
+    Response res;
+    ref->fill_response(&res);
+    EXPECT_EQ(Response::SUCCESS_ATOM, res.type());
+}
+
+}  // namespace unittest
@@ -4,9 +4,12 @@
 #include "arch/io/disk.hpp"
 #include "arch/runtime/coroutines.hpp"
 #include "arch/timing.hpp"
+#include "backfill_progress.hpp"
+#include "btree/backfill.hpp"
 #include "btree/operations.hpp"
 #include "btree/reql_specific.hpp"
 #include "buffer_cache/cache_balancer.hpp"
+#include "config/args.hpp"
 #include "containers/archive/boost_types.hpp"
 #include "containers/archive/vector_stream.hpp"
 #include "containers/uuid.hpp"
@@ -20,6 +23,7 @@
 #include "rdb_protocol/sym.hpp"
 #include "stl_utils.hpp"
 #include "serializer/config.hpp"
+#include "unittest/clustering_utils.hpp"
 #include "unittest/gtest.hpp"
 #include "unittest/unittest_utils.hpp"
 
@@ -28,7 +32,17 @@
 
 namespace unittest {
 
-void insert_rows(int start, int finish, store_t *store) {
+// The row with primary key `i`.  `padding` makes the row bigger, so that fewer rows
+// fit into a leaf node.
+std::string row_json(int i, size_t padding) {
+    if (padding == 0) {
+        return strprintf("{\"id\" : %d, \"sid\" : %d}", i, i * i);
+    }
+    return strprintf("{\"id\" : %d, \"sid\" : %d, \"pad\" : \"%s\"}",
+                     i, i * i, std::string(padding, 'x').c_str());
+}
+
+void insert_rows(int start, int finish, store_t *store, size_t padding = 0) {
     ql::configured_limits_t limits;
 
     guarantee(start <= finish);
@@ -44,7 +58,7 @@ void insert_rows(int start, int finish, store_t *store) {
             &token, &txn, &superblock, &dummy_interruptor);
         block_id_t sindex_block_id = superblock->get_sindex_block_id();
 
-        std::string data = strprintf("{\"id\" : %d, \"sid\" : %d}", i, i * i);
+        std::string data = row_json(i, padding);
         point_write_response_t response;
 
         store_key_t pk(ql::datum_t(static_cast<double>(i)).print_primary());
@@ -203,10 +217,12 @@ void spawn_writes_and_bring_sindexes_up_to_date(store_t *store,
 }
 
 void _check_keys_are_present(store_t *store,
-        sindex_name_t sindex_name) {
+        sindex_name_t sindex_name,
+        int num_keys = TOTAL_KEYS_TO_INSERT,
+        size_t padding = 0) {
     cond_t dummy_interruptor;
     ql::configured_limits_t limits;
-    for (int i = 0; i < TOTAL_KEYS_TO_INSERT; ++i) {
+    for (int i = 0; i < num_keys; ++i) {
         read_token_t token;
         store->new_read_token(&token);
 
@@ -262,7 +278,7 @@ void _check_keys_are_present(store_t *store,
         ASSERT_TRUE(stream != NULL);
         ASSERT_EQ(1ul, stream->size());
 
-        std::string expected_data = strprintf("{\"id\" : %d, \"sid\" : %d}", i, i * i);
+        std::string expected_data = row_json(i, padding);
         scoped_cJSON_t expected_value(cJSON_Parse(expected_data.c_str()));
         ASSERT_EQ(ql::to_datum(expected_value.get(), limits, reql_version_t::LATEST),
                   stream->front().data);
@@ -398,6 +414,71 @@ TPTEST(RDBBtree, SindexPostConstruct) {
     check_keys_are_present(&store, sindex_name);
 }
 
+TPTEST(RDBBtree, SindexPostConstructMultiLevel) {
+    recreate_temporary_directory(base_path_t("."));
+    temp_file_t temp_file;
+
+    io_backender_t io_backender(file_direct_io_mode_t::buffered_desired);
+    dummy_cache_balancer_t balancer(GIGABYTE);
+
+    filepath_file_opener_t file_opener(temp_file.name(), &io_backender);
+    standard_serializer_t::create(
+        &file_opener,
+        standard_serializer_t::static_config_t());
+
+    standard_serializer_t serializer(
+        standard_serializer_t::dynamic_config_t(),
+        &file_opener,
+        &get_global_perfmon_collection());
+
+    store_t store(
+            &serializer,
+            &balancer,
+            "unit_test_store",
+            true,
+            &get_global_perfmon_collection(),
+            NULL,
+            &io_backender,
+            base_path_t("."),
+            scoped_ptr_t<outdated_index_report_t>(),
+            generate_uuid());
+
+    // With the padding only about a dozen rows fit into a leaf node, so the tree
+    // has hundreds of leaves and an internal root.
+    const int num_keys = 5000;
+    const size_t padding = 200;
+    insert_rows(0, num_keys, &store, padding);
+
+    {
+        cond_t dummy_interruptor;
+        read_token_t token;
+        store.new_read_token(&token);
+        scoped_ptr_t<txn_t> txn;
+        scoped_ptr_t<real_superblock_t> super_block;
+        store.acquire_superblock_for_read(
+                &token, &txn, &super_block, &dummy_interruptor, true);
+        // Post construction traverses these ranges concurrently.
+        ASSERT_LT(1u, split_for_post_construction(
+                          super_block.get(), SINDEX_POST_CONSTRUCTION_RANGES).size());
+    }
+
+    sindex_name_t sindex_name = create_sindex(&store);
+    bring_sindexes_up_to_date(&store, sindex_name);
+
+    // Every row must end up in the index exactly once, no matter which range
+    // traversal visited it.
+    bool checked = false;
+    for (int i = 0; i < MAX_RETRIES_FOR_SINDEX_POSTCONSTRUCT && !checked; ++i) {
+        try {
+            _check_keys_are_present(&store, sindex_name, num_keys, padding);
+            checked = true;
+        } catch (const sindex_not_ready_exc_t &) {
+            nap(500);
+        }
+    }
+    ASSERT_TRUE(checked);
+}
+
 TPTEST(RDBBtree, SindexEraseRange) {
     recreate_temporary_directory(base_path_t("."));
     temp_file_t temp_file;
@@ -560,4 +641,379 @@ TPTEST(RDBBtree, SindexInterruptionViaStoreDelete) {
     store.reset();
 }
 
+uint64_t count_primary_range(store_t *store, const key_range_t &range) {
+    cond_t dummy_interruptor;
+    read_token_t token;
+    store->new_read_token(&token);
+
+    scoped_ptr_t<txn_t> txn;
+    scoped_ptr_t<real_superblock_t> super_block;
+    store->acquire_superblock_for_read(
+            &token, &txn, &super_block,
+            &dummy_interruptor, true);
+
+    rget_read_response_t res;
+    ql::env_t dummy_env(&dummy_interruptor,
+                        ql::return_empty_normal_batches_t::NO,
+                        reql_version_t::LATEST);
+    rdb_rget_slice(
+        store->btree.get(),
+        range,
+        super_block.get(),
+        &dummy_env,
+        ql::batchspec_t::default_for(ql::batch_type_t::TERMINAL),
+        std::vector<ql::transform_variant_t>(),
+        boost::optional<ql::terminal_variant_t>(ql::count_wire_func_t()),
+        sorting_t::UNORDERED,
+        &res,
+        release_superblock_t::RELEASE);
+
+    auto counts = boost::get<ql::grouped_t<uint64_t> >(&res.result);
+    guarantee(counts != NULL);
+    if (counts->size() == 0) {
+        return 0;
+    }
+    guarantee(counts->size() == 1);
+    return counts->begin(ql::grouped::order_doesnt_matter_t())->second;
+}
+
+TPTEST(RDBBtree, PrimaryCount) {
+    recreate_temporary_directory(base_path_t("."));
+    temp_file_t temp_file;
+
+    io_backender_t io_backender(file_direct_io_mode_t::buffered_desired);
+    dummy_cache_balancer_t balancer(GIGABYTE);
+
+    filepath_file_opener_t file_opener(temp_file.name(), &io_backender);
+    standard_serializer_t::create(
+        &file_opener,
+        standard_serializer_t::static_config_t());
+
+    standard_serializer_t serializer(
+        standard_serializer_t::dynamic_config_t(),
+        &file_opener,
+        &get_global_perfmon_collection());
+
+    store_t store(
+            &serializer,
+            &balancer,
+            "unit_test_store",
+            true,
+            &get_global_perfmon_collection(),
+            NULL,
+            &io_backender,
+            base_path_t("."),
+            scoped_ptr_t<outdated_index_report_t>(),
+            generate_uuid());
+
+    EXPECT_EQ(0u, count_primary_range(&store, key_range_t::universe()));
+
+    insert_rows(0, TOTAL_KEYS_TO_INSERT, &store);
+
+    EXPECT_EQ(static_cast<uint64_t>(TOTAL_KEYS_TO_INSERT),
+              count_primary_range(&store, key_range_t::universe()));
+
+    store_key_t first_key(ql::datum_t(0.0).print_primary());
+    EXPECT_EQ(static_cast<uint64_t>(TOTAL_KEYS_TO_INSERT - 1),
+              count_primary_range(&store,
+                                  key_range_t(key_range_t::open, first_key,
+                                              key_range_t::none, store_key_t())));
+}
+
+ql::datum_t read_row(store_t *store, int i) {
+    cond_t dummy_interruptor;
+    read_token_t token;
+    store->new_read_token(&token);
+
+    scoped_ptr_t<txn_t> txn;
+    scoped_ptr_t<real_superblock_t> super_block;
+    store->acquire_superblock_for_read(
+            &token, &txn, &super_block,
+            &dummy_interruptor, true);
+
+    point_read_response_t response;
+    rdb_get(store_key_t(ql::datum_t(static_cast<double>(i)).print_primary()),
+            store->btree.get(), super_block.get(), &response,
+            static_cast<profile::trace_t *>(NULL));
+    return response.data;
+}
+
+/* Applies the chunks of a backfill to `dest` the way the backfillee does, recording
+checkpoints in the metainfo at `end_version`. If `interrupt_at_checkpoint` is set, it
+waits out a checkpoint interval after the first pairs, so that the sender sends a
+checkpoint, and then interrupts the backfill through `interruptor`.
+`backfill_region` is the region of the whole backfill, as the backfillee would pass
+it to the store. */
+class test_backfillee_t : public send_backfill_callback_t {
+public:
+    test_backfillee_t(store_t *_dest, const version_t &_end_version,
+                      bool _interrupt_at_checkpoint, cond_t *_interruptor,
+                      const region_t &_backfill_region = region_t::universe())
+        : bulk_loaded(false), dest(_dest), end_version(_end_version),
+          interrupt_at_checkpoint(_interrupt_at_checkpoint),
+          interruptor(_interruptor), backfill_region(_backfill_region) { }
+
+    void send_chunk(const backfill_chunk_t &chunk, signal_t *chunk_interruptor)
+            THROWS_ONLY(interrupted_exc_t) {
+        write_token_t token;
+        dest->new_write_token(&token);
+
+        const backfill_chunk_t::checkpoint_t *checkpoint =
+            boost::get<backfill_chunk_t::checkpoint_t>(&chunk.val);
+        if (checkpoint != NULL) {
+            dest->set_metainfo(
+                region_map_t<binary_blob_t>(
+                    checkpoint->range,
+                    binary_blob_t(version_range_t(end_version))),
+                order_token_t::ignore, &token, chunk_interruptor);
+            checkpoints.push_back(checkpoint->range);
+            if (interrupt_at_checkpoint) {
+                interruptor->pulse_if_not_already_pulsed();
+                throw interrupted_exc_t();
+            }
+            return;
+        }
+
+        dest->receive_backfill(backfill_region, chunk, &token, chunk_interruptor);
+        bulk_loaded = bulk_loaded || dest->backfill_bulk_loader.has();
+
+        const backfill_chunk_t::key_value_pairs_t *kv =
+            boost::get<backfill_chunk_t::key_value_pairs_t>(&chunk.val);
+        if (kv != NULL) {
+            const bool first_pairs = sent_keys.empty();
+            for (const backfill_atom_t &atom : kv->backfill_atoms) {
+                sent_keys.push_back(atom.key);
+            }
+            if (interrupt_at_checkpoint && first_pairs) {
+                nap(BACKFILL_CHECKPOINT_INTERVAL_MS);
+            }
+        }
+    }
+
+    std::vector<store_key_t> sent_keys;
+    std::vector<region_t> checkpoints;
+    // Whether `dest` built its btree with the backfill bulk loader.
+    bool bulk_loaded;
+
+private:
+    bool should_backfill_impl(const region_map_t<binary_blob_t> &) {
+        return true;
+    }
+
+    store_t *dest;
+    version_t end_version;
+    bool interrupt_at_checkpoint;
+    cond_t *interruptor;
+    region_t backfill_region;
+};
+
+region_map_t<state_timestamp_t> get_backfill_start_point(store_t *store) {
+    cond_t dummy_interruptor;
+    read_token_t token;
+    store->new_read_token(&token);
+    region_map_t<binary_blob_t> metainfo;
+    store->do_get_metainfo(order_token_t::ignore.with_read_mode(), &token,
+                           &dummy_interruptor, &metainfo);
+    return region_map_transform<binary_blob_t, state_timestamp_t>(
+        metainfo,
+        [](const binary_blob_t &blob) {
+            return binary_blob_t::get<version_range_t>(blob).earliest.timestamp;
+        });
+}
+
+TPTEST(RDBBtree, BackfillResumesFromCheckpoint) {
+    recreate_temporary_directory(base_path_t("."));
+    io_backender_t io_backender(file_direct_io_mode_t::buffered_desired);
+    order_source_t order_source;
+    test_store_t source(&io_backender, &order_source, NULL);
+    test_store_t dest(&io_backender, &order_source, NULL);
+
+    // Enough rows for more than a dozen chunks.
+    const int num_keys = 5000;
+    const size_t padding = 200;
+    insert_rows(0, num_keys, &source.store, padding);
+
+    const version_t end_version(generate_uuid(), state_timestamp_t::zero().next());
+
+    // The first backfill gets interrupted right after its first checkpoint.
+    cond_t interruptor;
+    test_backfillee_t interrupted(&dest.store, end_version, true, &interruptor);
+    {
+        traversal_progress_combiner_t progress;
+        read_token_t token;
+        source.store.new_read_token(&token);
+        EXPECT_THROW(source.store.send_backfill(
+                         region_map_t<state_timestamp_t>(source.store.get_region(),
+                                                         state_timestamp_t::zero()),
+                         &interrupted, &progress, &token, &interruptor),
+                     interrupted_exc_t);
+    }
+    ASSERT_EQ(1u, interrupted.checkpoints.size());
+    const region_t checkpoint = interrupted.checkpoints[0];
+    ASSERT_FALSE(interrupted.sent_keys.empty());
+    ASSERT_LT(interrupted.sent_keys.size(), static_cast<size_t>(num_keys));
+    for (const store_key_t &key : interrupted.sent_keys) {
+        EXPECT_TRUE(checkpoint.inner.contains_key(key));
+    }
+
+    // The restarted backfill starts from the checkpoint's end point in the
+    // checkpointed part, so it only sends the rest.
+    region_map_t<state_timestamp_t> start_point =
+        get_backfill_start_point(&dest.store);
+    for (auto it = start_point.begin(); it != start_point.end(); ++it) {
+        EXPECT_EQ(region_is_superset(checkpoint, it->first)
+                      ? end_version.timestamp : state_timestamp_t::zero(),
+                  it->second);
+    }
+    cond_t non_interruptor;
+    test_backfillee_t resumed(&dest.store, end_version, false, NULL);
+    {
+        traversal_progress_combiner_t progress;
+        read_token_t token;
+        source.store.new_read_token(&token);
+        ASSERT_TRUE(source.store.send_backfill(start_point, &resumed, &progress,
+                                               &token, &non_interruptor));
+    }
+    for (const store_key_t &key : resumed.sent_keys) {
+        EXPECT_FALSE(checkpoint.inner.contains_key(key));
+    }
+    EXPECT_EQ(static_cast<size_t>(num_keys),
+              interrupted.sent_keys.size() + resumed.sent_keys.size());
+    {
+        write_token_t token;
+        dest.store.new_write_token(&token);
+        dest.store.finish_backfill(&token, &non_interruptor);
+    }
+
+    // The result is the same as that of an uninterrupted backfill.
+    EXPECT_EQ(static_cast<uint64_t>(num_keys),
+              count_primary_range(&dest.store, key_range_t::universe()));
+    for (int i = 0; i < num_keys; ++i) {
+        EXPECT_EQ(read_row(&source.store, i), read_row(&dest.store, i));
+    }
+}
+
+// Reads row `i` through the secondary index `sindex_name` on "sid". Throws
+// `sindex_not_ready_exc_t` if the index hasn't been post constructed yet.
+ql::datum_t read_row_by_sindex(store_t *store, const sindex_name_t &sindex_name,
+                               int i) {
+    cond_t dummy_interruptor;
+    read_token_t token;
+    store->new_read_token(&token);
+
+    scoped_ptr_t<txn_t> txn;
+    scoped_ptr_t<real_superblock_t> super_block;
+    store->acquire_superblock_for_read(
+            &token, &txn, &super_block,
+            &dummy_interruptor, true);
+
+    scoped_ptr_t<sindex_superblock_t> sindex_sb;
+    uuid_u sindex_uuid;
+    std::vector<char> opaque_definition;
+    bool sindex_exists = store->acquire_sindex_superblock_for_read(
+            sindex_name, "", super_block.get(), &sindex_sb,
+            &opaque_definition, &sindex_uuid);
+    guarantee(sindex_exists);
+
+    rget_read_response_t res;
+    double ii = i * i;
+    ql::env_t dummy_env(&dummy_interruptor,
+                        ql::return_empty_normal_batches_t::NO,
+                        reql_version_t::LATEST);
+    rdb_rget_slice(
+        store->get_sindex_slice(sindex_uuid),
+        rdb_protocol::sindex_key_range(
+            store_key_t(ql::datum_t(ii).print_primary()),
+            store_key_t(ql::datum_t(ii).print_primary())),
+        sindex_sb.get(),
+        &dummy_env,
+        ql::batchspec_t::default_for(ql::batch_type_t::NORMAL),
+        std::vector<ql::transform_variant_t>(),
+        boost::optional<ql::terminal_variant_t>(),
+        sorting_t::ASCENDING,
+        &res,
+        release_superblock_t::RELEASE);
+
+    auto groups = boost::get<ql::grouped_t<ql::stream_t> >(&res.result);
+    guarantee(groups != NULL);
+    if (groups->size() == 0) {
+        return ql::datum_t::null();
+    }
+    ql::stream_t *stream
+        = &groups->begin(ql::grouped::order_doesnt_matter_t())->second;
+    guarantee(stream->size() == 1);
+    return stream->front().data;
+}
+
+TPTEST(RDBBtree, BackfillBulkLoadsCpuShard) {
+    recreate_temporary_directory(base_path_t("."));
+    io_backender_t io_backender(file_direct_io_mode_t::buffered_desired);
+    order_source_t order_source;
+    test_store_t source(&io_backender, &order_source, NULL);
+    test_store_t dest(&io_backender, &order_source, NULL);
+
+    const int num_keys = 5000;
+    const size_t padding = 200;
+    insert_rows(0, num_keys, &source.store, padding);
+
+    // The empty store already has a secondary index, which the bulk load replaces
+    // and post constructs once the btree is complete.
+    sindex_name_t sindex_name = create_sindex(&dest.store);
+
+    // Like the backfillee of a CPU shard, which backfills the part of the universe
+    // that its store can contain.
+    const region_t shard = rdb_protocol::cpu_sharding_subspace(0, CPU_SHARDING_FACTOR);
+    const version_t end_version(generate_uuid(), state_timestamp_t::zero().next());
+    cond_t non_interruptor;
+    test_backfillee_t backfillee(&dest.store, end_version, false, NULL, shard);
+    {
+        traversal_progress_combiner_t progress;
+        read_token_t token;
+        source.store.new_read_token(&token);
+        ASSERT_TRUE(source.store.send_backfill(
+                        region_map_t<state_timestamp_t>(shard,
+                                                        state_timestamp_t::zero()),
+                        &backfillee, &progress, &token, &non_interruptor));
+    }
+    EXPECT_TRUE(backfillee.bulk_loaded);
+    {
+        write_token_t token;
+        dest.store.new_write_token(&token);
+        dest.store.finish_backfill(&token, &non_interruptor);
+    }
+    EXPECT_FALSE(dest.store.backfill_bulk_loader.has());
+
+    std::vector<int> shard_rows;
+    for (int i = 0; i < num_keys; ++i) {
+        store_key_t key(ql::datum_t(static_cast<double>(i)).print_primary());
+        if (region_contains_key(shard, key)) {
+            shard_rows.push_back(i);
+        }
+    }
+    ASSERT_FALSE(shard_rows.empty());
+    ASSERT_LT(shard_rows.size(), static_cast<size_t>(num_keys));
+    EXPECT_EQ(shard_rows.size(), backfillee.sent_keys.size());
+    EXPECT_EQ(static_cast<uint64_t>(shard_rows.size()),
+              count_primary_range(&dest.store, key_range_t::universe()));
+    for (int i : shard_rows) {
+        EXPECT_EQ(read_row(&source.store, i), read_row(&dest.store, i));
+    }
+
+    // The post construction runs in the background, so poll until it's done.
+    bool sindex_ready = false;
+    for (int retry = 0; retry < MAX_RETRIES_FOR_SINDEX_POSTCONSTRUCT && !sindex_ready;
+         ++retry) {
+        try {
+            for (int i : shard_rows) {
+                EXPECT_EQ(read_row(&source.store, i),
+                          read_row_by_sindex(&dest.store, sindex_name, i));
+            }
+            sindex_ready = true;
+        } catch (const sindex_not_ready_exc_t &) {
+            nap(100);
+        }
+    }
+    EXPECT_TRUE(sindex_ready);
+}
+
 } //namespace unittest
@@ -23,6 +23,7 @@
 #include "serializer/translator.hpp"
 #include "stl_utils.hpp"
 #include "store_subview.hpp"
+#include "unittest/clustering_utils.hpp"
 #include "unittest/dummy_namespace_interface.hpp"
 #include "unittest/gtest.hpp"
 #include "unittest/unittest_utils.hpp"
@@ -851,4 +852,88 @@ TPTEST(RDBProtocol, ArtificialChangefeeds) {
     }
 }
 
+ql::datum_t make_row(double id, double v, double d) {
+    ql::datum_object_builder_t builder;
+    builder.overwrite("id", ql::datum_t(id));
+    builder.overwrite("v", ql::datum_t(v));
+    builder.overwrite("d", ql::datum_t(d));
+    return std::move(builder).to_datum();
+}
+
+TPTEST(RDBProtocol, ChangefeedServerAppliesTransforms) {
+    using ql::changefeed::msg_t;
+    using ql::changefeed::stamped_msg_t;
+    simple_mailbox_cluster_t cluster;
+    std::vector<stamped_msg_t> received;
+    mailbox_t<void(std::vector<stamped_msg_t>)> mailbox(
+        cluster.get_mailbox_manager(),
+        [&](signal_t *, const std::vector<stamped_msg_t> &msgs) {
+            received.insert(received.end(), msgs.begin(), msgs.end());
+        });
+    ql::changefeed::server_t server(cluster.get_mailbox_manager());
+
+    // `filter(row['v'] > 1).map(row['v'] / row['d'])`
+    ql::sym_t one(1);
+    ql::protob_t<const Term> filter_body =
+        (ql::r::var(one)["v"] > ql::r::expr(1.0)).release_counted();
+    ql::protob_t<const Term> map_body =
+        (ql::r::var(one)["v"] / ql::r::var(one)["d"]).release_counted();
+    std::vector<ql::transform_variant_t> transforms{
+        ql::filter_wire_func_t(
+            ql::wire_func_t(filter_body, make_vector(one),
+                            ql::get_backtrace(filter_body)),
+            boost::optional<ql::wire_func_t>()),
+        ql::map_wire_func_t(map_body, make_vector(one),
+                            ql::get_backtrace(map_body))};
+    server.add_client(mailbox.get_address(), region_t::universe(), NULL,
+                      std::map<std::string, ql::wire_func_t>(), transforms);
+
+    auto send_change = [&](double id, ql::datum_t old_val, ql::datum_t new_val) {
+        server.send_all(
+            msg_t(msg_t::change_t{
+                    std::map<std::string, std::vector<ql::datum_t> >(),
+                    std::map<std::string, std::vector<ql::datum_t> >(),
+                    store_key_t(ql::datum_t(id).print_primary()),
+                    old_val,
+                    new_val}),
+            store_key_t(ql::datum_t(id).print_primary()));
+    };
+    // Filtered out on the shard.
+    send_change(0, ql::datum_t(), make_row(0, 0, 1));
+    // Transformed on the shard.
+    send_change(1, ql::datum_t(), make_row(1, 4, 2));
+    send_change(1, make_row(1, 4, 2), make_row(1, 0, 1));
+    // The map fails on the new value, so the shard sends the change as is.
+    send_change(2, ql::datum_t(), make_row(2, 4, 0));
+    let_stuff_happen();
+
+    ASSERT_EQ(4u, received.size());
+    std::sort(received.begin(), received.end(),
+              [](const stamped_msg_t &a, const stamped_msg_t &b) {
+                  return a.stamp < b.stamp;
+              });
+    for (size_t i = 0; i < received.size(); ++i) {
+        EXPECT_EQ(received[0].server_uuid, received[i].server_uuid);
+        EXPECT_EQ(received[0].stamp + i, received[i].stamp);
+    }
+    EXPECT_TRUE(boost::get<msg_t::skip_t>(&received[0].submsg.op) != NULL);
+
+    auto *inserted =
+        boost::get<msg_t::transformed_change_t>(&received[1].submsg.op);
+    ASSERT_TRUE(inserted != NULL);
+    EXPECT_EQ(ql::datum_t::null(), inserted->change.old_val);
+    EXPECT_EQ(ql::datum_t(2.0), inserted->change.new_val);
+
+    auto *filtered =
+        boost::get<msg_t::transformed_change_t>(&received[2].submsg.op);
+    ASSERT_TRUE(filtered != NULL);
+    EXPECT_EQ(ql::datum_t(2.0), filtered->change.old_val);
+    EXPECT_EQ(ql::datum_t::null(), filtered->change.new_val);
+
+    auto *failed = boost::get<msg_t::change_t>(&received[3].submsg.op);
+    ASSERT_TRUE(failed != NULL);
+    EXPECT_FALSE(failed->old_val.has());
+    EXPECT_EQ(make_row(2, 4, 0), failed->new_val);
+}
+
 }   /* namespace unittest */
@@ -3,6 +3,7 @@
 
 #include "arch/runtime/thread_pool.hpp"
 #include "arch/timing.hpp"
+#include "concurrency/pmap.hpp"
 #include "containers/scoped.hpp"
 #include "containers/archive/socket_stream.hpp"
 #include "unittest/clustering_utils.hpp"
@@ -21,9 +22,11 @@ class recording_test_application_t :
     public cluster_message_handler_t
 {
 public:
-    explicit recording_test_application_t(connectivity_cluster_t *cm,
-                                          connectivity_cluster_t::message_tag_t tag) :
-        cluster_message_handler_t(cm, tag),
+    recording_test_application_t(connectivity_cluster_t *cm,
+                                 connectivity_cluster_t::message_tag_t tag,
+                                 cluster_traffic_class_t traffic_class =
+                                     cluster_traffic_class_t::control) :
+        cluster_message_handler_t(cm, tag, traffic_class),
         sequence_number(0)
         { }
     void send(int message, peer_id_t peer) {
@@ -242,6 +245,83 @@ TPTEST_MULTITHREAD(RPCConnectivityTest, Ordering, 3) {
     }
 }
 
+/* `CoalescedOrdering` sends messages from several coroutines on one thread at once,
+so that they get written out in shared batches. Every message must still arrive,
+and each coroutine's messages must arrive in the order it sent them. */
+
+TPTEST_MULTITHREAD(RPCConnectivityTest, CoalescedOrdering, 3) {
+    connectivity_cluster_t c1, c2;
+    recording_test_application_t a1(&c1, 'T'), a2(&c2, 'T');
+    connectivity_cluster_t::run_t cr1(&c1, get_unittest_addresses(), peer_address_t(),
+        ANY_PORT, 0);
+    connectivity_cluster_t::run_t cr2(&c2, get_unittest_addresses(), peer_address_t(),
+        ANY_PORT, 0);
+
+    cr1.join(get_cluster_local_address(&c2));
+
+    let_stuff_happen();
+
+    const int num_senders = 10;
+    const int messages_per_sender = 100;
+    pmap(num_senders, [&](int sender) {
+        for (int i = 0; i < messages_per_sender; i++) {
+            a1.send(sender * messages_per_sender + i, c2.get_me());
+        }
+    });
+
+    let_stuff_happen();
+
+    for (int sender = 0; sender < num_senders; sender++) {
+        for (int i = 0; i < messages_per_sender - 1; i++) {
+            a2.expect_order(sender * messages_per_sender + i,
+                            sender * messages_per_sender + i + 1);
+        }
+        a2.expect(sender * messages_per_sender + messages_per_sender - 1,
+                  c1.get_me());
+    }
+}
+
+/* `TrafficClasses` sends messages of different traffic classes, which travel over
+different TCP connections, and checks that messages of the same class still arrive in
+order. */
+
+TPTEST_MULTITHREAD(RPCConnectivityTest, TrafficClasses, 3) {
+    connectivity_cluster_t c1, c2;
+    recording_test_application_t
+        control1(&c1, 'T'), control2(&c2, 'T'),
+        replication1(&c1, 'R', cluster_traffic_class_t::replication),
+        replication2(&c2, 'R', cluster_traffic_class_t::replication),
+        bulk1(&c1, 'U', cluster_traffic_class_t::bulk),
+        bulk2(&c2, 'U', cluster_traffic_class_t::bulk);
+    connectivity_cluster_t::run_t cr1(&c1, get_unittest_addresses(), peer_address_t(),
+        ANY_PORT, 0);
+    connectivity_cluster_t::run_t cr2(&c2, get_unittest_addresses(), peer_address_t(),
+        ANY_PORT, 0);
+
+    cr1.join(get_cluster_local_address(&c2));
+
+    let_stuff_happen();
+
+    for (int i = 0; i < 10; i++) {
+        control1.send(i, c2.get_me());
+        replication1.send(i, c2.get_me());
+        bulk2.send(i, c1.get_me());
+    }
+
+    let_stuff_happen();
+
+    for (int i = 0; i < 9; i++) {
+        control2.expect_order(i, i+1);
+        replication2.expect_order(i, i+1);
+        bulk1.expect_order(i, i+1);
+    }
+    control2.expect(9, c1.get_me());
+    replication2.expect(9, c1.get_me());
+    bulk1.expect(9, c2.get_me());
+    control1.expect_undelivered(0);
+    bulk2.expect_undelivered(0);
+}
+
 /* `GetConnections` confirms that the behavior of `cluster_t::get_connections()` is
 correct. */
 
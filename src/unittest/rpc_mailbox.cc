@@ -48,8 +48,10 @@ private:
 public:
     friend void send(mailbox_manager_t *, raw_mailbox_t::address_t, int);
 
-    explicit dummy_mailbox_t(mailbox_manager_t *m) :
-        reader(this), mailbox(m, &reader)
+    explicit dummy_mailbox_t(mailbox_manager_t *m,
+                             cluster_traffic_class_t traffic_class =
+                                 cluster_traffic_class_t::replication) :
+        reader(this), mailbox(m, &reader, traffic_class)
         { }
     void expect(int message) {
         EXPECT_EQ(1u, inbox.count(message));
@@ -67,7 +69,7 @@ void send(mailbox_manager_t *c, raw_mailbox_t::address_t dest, int message) {
 /* `MailboxStartStop` creates and destroys some mailboxes. */
 TPTEST(RPCMailboxTest, MailboxStartStop, 2) {
     connectivity_cluster_t c;
-    mailbox_manager_t m(&c, 'M');
+    mailbox_manager_t m(&c, 'M', 'B');
     connectivity_cluster_t::run_t r(&c, get_unittest_addresses(), peer_address_t(),
         ANY_PORT, 0);
 
@@ -82,7 +84,7 @@ TPTEST(RPCMailboxTest, MailboxStartStop, 2) {
 /* `MailboxMessage` sends messages to some mailboxes */
 TPTEST_MULTITHREAD(RPCMailboxTest, MailboxMessage, 3) {
     connectivity_cluster_t c1, c2;
-    mailbox_manager_t m1(&c1, 'M'), m2(&c2, 'M');
+    mailbox_manager_t m1(&c1, 'M', 'B'), m2(&c2, 'M', 'B');
     connectivity_cluster_t::run_t r1(&c1, get_unittest_addresses(), peer_address_t(),
         ANY_PORT, 0);
     connectivity_cluster_t::run_t r2(&c2, get_unittest_addresses(), peer_address_t(),
@@ -105,11 +107,35 @@ TPTEST_MULTITHREAD(RPCMailboxTest, MailboxMessage, 3) {
     mbox.expect(7);
 }
 
+/* `BulkMailboxMessage` sends messages to a mailbox whose messages travel in the bulk
+traffic class, both from the same node and from another one. */
+TPTEST_MULTITHREAD(RPCMailboxTest, BulkMailboxMessage, 3) {
+    connectivity_cluster_t c1, c2;
+    mailbox_manager_t m1(&c1, 'M', 'B'), m2(&c2, 'M', 'B');
+    connectivity_cluster_t::run_t r1(&c1, get_unittest_addresses(), peer_address_t(),
+        ANY_PORT, 0);
+    connectivity_cluster_t::run_t r2(&c2, get_unittest_addresses(), peer_address_t(),
+        ANY_PORT, 0);
+    r1.join(get_cluster_local_address(&c2));
+    let_stuff_happen();
+
+    dummy_mailbox_t mbox(&m1, cluster_traffic_class_t::bulk);
+    raw_mailbox_t::address_t address = mbox.mailbox.get_address();
+
+    send(&m1, address, 88555);
+    send(&m2, address, 3131);
+
+    let_stuff_happen();
+
+    mbox.expect(88555);
+    mbox.expect(3131);
+}
+
 /* `DeadMailbox` sends a message to a defunct mailbox. The expected behavior is
 for the message to be silently ignored. */
 TPTEST_MULTITHREAD(RPCMailboxTest, DeadMailbox, 3) {
     connectivity_cluster_t c1, c2;
-    mailbox_manager_t m1(&c1, 'M'), m2(&c2, 'M');
+    mailbox_manager_t m1(&c1, 'M', 'B'), m2(&c2, 'M', 'B');
     connectivity_cluster_t::run_t r1(&c1, get_unittest_addresses(), peer_address_t(),
         ANY_PORT, 0);
     connectivity_cluster_t::run_t r2(&c2, get_unittest_addresses(), peer_address_t(),
@@ -134,7 +160,7 @@ TPTEST_MULTITHREAD(RPCMailboxTest, MailboxAddressSemantics, 3) {
     EXPECT_TRUE(nil_addr.is_nil());
 
     connectivity_cluster_t c;
-    mailbox_manager_t m(&c, 'M');
+    mailbox_manager_t m(&c, 'M', 'B');
     connectivity_cluster_t::run_t r(&c, get_unittest_addresses(), peer_address_t(),
         ANY_PORT, 0);
 
@@ -152,7 +178,7 @@ void string_push_back(std::vector<std::string> *v, const std::string &pushee) {
 
 TPTEST_MULTITHREAD(RPCMailboxTest, TypedMailbox, 3) {
     connectivity_cluster_t c;
-    mailbox_manager_t m(&c, 'M');
+    mailbox_manager_t m(&c, 'M', 'B');
     connectivity_cluster_t::run_t r(&c, get_unittest_addresses(), peer_address_t(),
         ANY_PORT, 0);
 
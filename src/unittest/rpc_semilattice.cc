@@ -28,6 +28,10 @@ inline void semilattice_join(sl_int_t *a, sl_int_t b) {
     a->i |= b.i;
 }
 
+inline sl_int_t semilattice_delta(sl_int_t old_value, sl_int_t new_value) {
+    return sl_int_t(new_value.i & ~old_value.i);
+}
+
 class sl_pair_t {
 public:
     sl_pair_t(sl_int_t _x, sl_int_t _y) : x(_x), y(_y) { }
@@ -60,6 +64,30 @@ TPTEST(RPCSemilatticeTest, SingleMetadata, 2) {
     EXPECT_EQ(3u, slm.get_root_view()->get().i);
 }
 
+/* `MapDelta` checks that `semilattice_map_delta()` picks out exactly the new and
+changed entries. */
+TEST(RPCSemilatticeTest, MapDelta) {
+    std::map<int, int> old_map, new_map;
+    old_map[1] = 10;
+    old_map[2] = 20;
+    old_map[4] = 40;
+    new_map = old_map;
+    new_map[0] = 0;
+    new_map[2] = 21;
+    new_map[3] = 30;
+    new_map[5] = 50;
+
+    std::map<int, int> delta = semilattice_map_delta(old_map, new_map);
+    std::map<int, int> expected;
+    expected[0] = 0;
+    expected[2] = 21;
+    expected[3] = 30;
+    expected[5] = 50;
+    EXPECT_TRUE(expected == delta);
+
+    EXPECT_TRUE(semilattice_map_delta(new_map, new_map).empty());
+}
+
 /* `MetadataExchange` makes sure that metadata is correctly exchanged between
 nodes. */
 TPTEST(RPCSemilatticeTest, MetadataExchange, 2) {
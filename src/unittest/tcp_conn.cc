@@ -0,0 +1,101 @@
+// Copyright 2010-2015 RethinkDB, all rights reserved.
+#include <set>
+#include <string>
+#include <vector>
+
+#include "arch/io/network.hpp"
+#include "arch/types.hpp"
+#include "concurrency/cond_var.hpp"
+#include "unittest/gtest.hpp"
+#include "unittest/unittest_utils.hpp"
+
+namespace unittest {
+
+const int NUM_SMALL_MESSAGES = 1000;
+
+std::string small_message(int i) {
+    return strprintf("message %d", i);
+}
+
+std::string big_message() {
+    std::string message;
+    for (size_t i = 0; i < MEGABYTE; ++i) {
+        message += 'a' + (i % 26);
+    }
+    return message;
+}
+
+// Reads back what `write_messages` writes, mixing `read()`, `read_some()`,
+// `peek()` and `pop()`.
+void read_messages(scoped_ptr_t<tcp_conn_descriptor_t> &nconn, cond_t *done) {
+    scoped_ptr_t<tcp_conn_t> conn;
+    nconn->make_overcomplicated(&conn);
+    cond_t non_interruptor;
+
+    for (int i = 0; i < NUM_SMALL_MESSAGES; ++i) {
+        uint32_t size;
+        conn->read(&size, sizeof(size), &non_interruptor);
+        std::string message(size, '\0');
+        if (i % 2 == 0) {
+            conn->read(&message[0], size, &non_interruptor);
+        } else {
+            const_charslice slice = conn->peek(size, &non_interruptor);
+            message.assign(slice.beg, slice.end);
+            conn->pop(size, &non_interruptor);
+        }
+        EXPECT_EQ(small_message(i), message);
+    }
+
+    char c;
+    ASSERT_EQ(1u, conn->read_some(&c, 1, &non_interruptor));
+    EXPECT_EQ('!', c);
+
+    const std::string expected = big_message();
+    std::string message(expected.size(), '\0');
+    conn->read(&message[0], message.size(), &non_interruptor);
+    EXPECT_TRUE(expected == message);
+
+    done->pulse();
+}
+
+// Writes many small messages with one `writev()` (which has to split them over
+// several system calls), then a single byte, then one big message.
+void write_messages(int port) {
+    cond_t non_interruptor;
+    tcp_conn_t conn(ip_address_t("127.0.0.1"), port, &non_interruptor);
+
+    std::vector<uint32_t> sizes;
+    std::vector<std::string> messages;
+    for (int i = 0; i < NUM_SMALL_MESSAGES; ++i) {
+        messages.push_back(small_message(i));
+        sizes.push_back(messages.back().size());
+    }
+    std::vector<iovec> iov;
+    for (int i = 0; i < NUM_SMALL_MESSAGES; ++i) {
+        iovec v;
+        v.iov_base = &sizes[i];
+        v.iov_len = sizeof(sizes[i]);
+        iov.push_back(v);
+        v.iov_base = &messages[i][0];
+        v.iov_len = messages[i].size();
+        iov.push_back(v);
+    }
+    conn.writev(iov.data(), iov.size(), &non_interruptor);
+
+    conn.write_buffered("!", 1, &non_interruptor);
+
+    std::string big = big_message();
+    conn.write(big.data(), big.size(), &non_interruptor);
+}
+
+TPTEST(TcpConn, PipelinedMessages) {
+    cond_t done;
+    std::set<ip_address_t> addresses;
+    addresses.insert(ip_address_t("127.0.0.1"));
+    tcp_listener_t listener(addresses, 0,
+                            std::bind(&read_messages, ph::_1, &done));
+    write_messages(listener.get_port());
+    done.wait();
+}
+
+}  // namespace unittest
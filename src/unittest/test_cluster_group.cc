@@ -123,7 +123,7 @@ public:
  * correct blueprint. */
 reactor_test_cluster_t::reactor_test_cluster_t(int port) :
     connectivity_cluster(),
-    mailbox_manager(&connectivity_cluster, 'M'),
+    mailbox_manager(&connectivity_cluster, 'M', 'B'),
     directory_read_manager(&connectivity_cluster, 'D'),
     connectivity_cluster_run(&connectivity_cluster,
                              get_unittest_addresses(),
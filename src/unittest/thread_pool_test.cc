@@ -0,0 +1,23 @@
+// Copyright 2010-2015 RethinkDB, all rights reserved.
+#include <vector>
+
+#include "arch/runtime/thread_pool.hpp"
+#include "unittest/gtest.hpp"
+
+namespace unittest {
+
+TEST(ThreadPoolTest, ParseCpuList) {
+    EXPECT_EQ(std::vector<int>({0}), parse_cpu_list("0"));
+    EXPECT_EQ(std::vector<int>({0, 1, 2, 3}), parse_cpu_list("0-3\n"));
+    EXPECT_EQ(std::vector<int>({0, 1, 2, 8, 10, 11}), parse_cpu_list("0-2,8,10-11"));
+
+    // An empty node, e.g. one with memory but no CPUs.
+    EXPECT_EQ(std::vector<int>(), parse_cpu_list(""));
+    EXPECT_EQ(std::vector<int>(), parse_cpu_list("\n"));
+
+    // Parsing stops at anything unexpected, keeping what came before it.
+    EXPECT_EQ(std::vector<int>({4, 5}), parse_cpu_list("4-5,x"));
+    EXPECT_EQ(std::vector<int>({7}), parse_cpu_list("7,9-"));
+}
+
+}  // namespace unittest
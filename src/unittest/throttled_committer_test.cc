@@ -0,0 +1,130 @@
+// Copyright 2010-2015 RethinkDB, all rights reserved.
+#include <functional>
+
+#include "arch/timing.hpp"
+#include "concurrency/new_mutex.hpp"
+#include "concurrency/pmap.hpp"
+#include "concurrency/throttled_committer.hpp"
+#include "config/args.hpp"
+#include "serializer/buf_ptr.hpp"
+#include "serializer/config.hpp"
+#include "serializer/merger.hpp"
+#include "time.hpp"
+#include "unittest/gtest.hpp"
+#include "unittest/mock_file.hpp"
+#include "unittest/unittest_utils.hpp"
+
+namespace unittest {
+
+// Long enough that a test which ends up waiting for a whole window is obviously
+// broken, instead of just slow.
+const int64_t long_group_window_ms = 60 * 1000;
+const microtime_t short_wait_us = 10 * MILLION;
+
+TPTEST(ThrottledCommitterTest, LoneWriterDoesNotWait) {
+    int commits = 0;
+    throttled_committer_t committer([&]() { ++commits; }, 1, long_group_window_ms);
+
+    microtime_t start = current_microtime();
+    for (int i = 0; i < 3; ++i) {
+        committer.sync();
+    }
+    EXPECT_LT(current_microtime() - start, short_wait_us);
+    EXPECT_EQ(3, commits);
+}
+
+TPTEST(ThrottledCommitterTest, ConcurrentWritersShareWindow) {
+    int commits = 0;
+    throttled_committer_t committer([&]() { ++commits; nap(20); },
+                                    1, long_group_window_ms);
+
+    // The first sync gets a commit of its own (no writes overlapped yet), the other
+    // two come in while it's running and share the next one.
+    pmap(3, [&](int64_t) { committer.sync(); });
+    EXPECT_EQ(2, commits);
+
+    // Since writes did overlap, the next sync waits for others to join it.
+    microtime_t start = current_microtime();
+    pmap(3, [&](int64_t i) {
+        if (i == 0) {
+            committer.sync();
+        } else if (i == 1) {
+            nap(10);
+            committer.sync();
+        } else {
+            nap(50);
+            EXPECT_EQ(2, commits);
+            committer.close_group_window();
+        }
+    });
+    EXPECT_LT(current_microtime() - start, short_wait_us);
+    EXPECT_EQ(3, commits);
+
+    // That commit was shared, so the window opens once more. Nobody joins this
+    // time, so the window stays closed after that.
+    pmap(2, [&](int64_t i) {
+        if (i == 0) {
+            committer.sync();
+        } else {
+            nap(10);
+            EXPECT_EQ(3, commits);
+            committer.close_group_window();
+        }
+    });
+    EXPECT_EQ(4, commits);
+    start = current_microtime();
+    committer.sync();
+    EXPECT_LT(current_microtime() - start, short_wait_us);
+    EXPECT_EQ(5, commits);
+}
+
+TPTEST(ThrottledCommitterTest, MergerClosesWindowAfterMaxBytes) {
+    mock_file_opener_t file_opener;
+    standard_serializer_t::create(&file_opener,
+                                  standard_serializer_t::static_config_t());
+    merger_serializer_t ser(
+        make_scoped<standard_serializer_t>(standard_serializer_t::dynamic_config_t(),
+                                           &file_opener,
+                                           &get_global_perfmon_collection()),
+        1, &get_global_perfmon_collection(), long_group_window_ms);
+
+    auto index_write = [&]() {
+        new_mutex_in_line_t dummy_acq;
+        ser.index_write(&dummy_acq, std::vector<index_write_op_t>());
+    };
+
+    // Mock file I/O yields, so these overlap and open the group window for the
+    // next index write.
+    pmap(3, [&](int64_t) { index_write(); });
+
+    buf_ptr_t buf = buf_ptr_t::alloc_zeroed(ser.max_block_size());
+    scoped_ptr_t<file_account_t> account(ser.make_io_account(1));
+    std::vector<buf_write_info_t> infos;
+    for (block_id_t id = 0;
+         static_cast<int64_t>(infos.size()) * buf.block_size().ser_value()
+             < MERGER_GROUP_COMMIT_MAX_BYTES;
+         ++id) {
+        infos.push_back(buf_write_info_t(buf.ser_buffer(), buf.block_size(), id));
+    }
+
+    microtime_t start = current_microtime();
+    pmap(2, [&](int64_t i) {
+        if (i == 0) {
+            index_write();
+        } else {
+            // The index write above is waiting for its window now. Writing enough
+            // blocks must cut the window short.
+            struct : public iocallback_t, public cond_t {
+                void on_io_complete() {
+                    pulse();
+                }
+            } cb;
+            std::vector<counted_t<standard_block_token_t> > tokens
+                = ser.block_writes(infos, account.get(), &cb);
+            cb.wait();
+        }
+    });
+    EXPECT_LT(current_microtime() - start, short_wait_us);
+}
+
+}  // namespace unittest